@@ -0,0 +1,660 @@
+/*
+Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "live_stitch_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if _WIN32
+#include <windows.h>
+#include <psapi.h>
+#undef min
+#undef max
+#else
+#include <strings.h>
+#define _stricmp  strcasecmp
+#endif
+
+#define VERSION          "0.9.8"
+#if _WIN32
+#define PROGRAM_NAME     "loom_bench.exe"
+#else
+#define PROGRAM_NAME     "loom_bench"
+#endif
+
+//////////////////////////////////////////////////////////////////////
+//! \brief The benchmark settings.
+struct BenchSettings {
+	std::vector<vx_uint32> cameras;       // camera counts
+	std::vector<camera_lens_type> lenses; // lens types
+	std::vector<vx_uint32> outputs;       // output heights (width is 2x height)
+	vx_uint32 cameraWidth;                // camera image width
+	vx_uint32 cameraHeight;               // camera image height
+	vx_uint32 frames;                     // number of measured frames
+	vx_uint32 warmup;                     // number of frames processed before measurement
+	bool cpu;                             // use CPU kernels (*_TARGET=1 and CPU initialize)
+	bool expcomp, seamfind, multiband;    // stitch features
+	vx_uint32 expcompMode;                // exposure compensation mode 1 or 2
+	bool warpGains;                       // warp applies the exposure comp gains
+	float gainTolerance;                  // largest gain change between measured frames (0: no check)
+	bool reinitCheck;                     // update one camera with lsReinitialize and compare against a full compute
+	bool blendCheck;                      // blend an overlay and compare the outputs of the CPU and GPU alpha blend
+	vx_uint32 numBands;                   // multiband number of bands
+	const char * jsonFile;                // JSON output file (stdout if null)
+};
+
+//! \brief The benchmark result of one rig.
+struct BenchResult {
+	vx_uint32 numCamera;
+	camera_lens_type lensType;
+	vx_uint32 cameraRows, cameraColumns;
+	vx_uint32 outputWidth, outputHeight;
+	vx_status status;
+	double initMs;              // lsInitialize
+	double frameMs;             // lsScheduleFrame + lsWaitForCompletion per frame
+	ls_stage_times stage;       // average per frame
+	double baseMemoryMB;        // resident memory before the context is created
+	double peakMemoryMB;        // peak resident memory (see GetPeakMemoryMB)
+	ls_memory_usage memory;     // memory of the context by category (lsGetMemoryUsage)
+	double gainDelta;           // largest change of an exposure comp gain between consecutive measured frames
+};
+
+static const char * LensName(camera_lens_type lens)
+{
+	switch (lens) {
+	case ptgui_lens_rectilinear: return "rectilinear";
+	case ptgui_lens_fisheye_ff: return "fisheye";
+	case ptgui_lens_fisheye_circ: return "circular";
+	default: return "unknown";
+	}
+}
+
+static double GetTimeMs()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Process memory: on Linux the peak (VmHWM) is reset before each rig so that
+// every rig reports its own peak, on Windows the peak is for the whole process.
+static double ReadProcStatusMB(const char * key)
+{
+	double value = 0;
+#if !_WIN32
+	FILE * fp = fopen("/proc/self/status", "r");
+	if (fp) {
+		char line[256]; size_t len = strlen(key);
+		while (fgets(line, sizeof(line), fp)) {
+			if (!strncmp(line, key, len) && line[len] == ':') {
+				value = atof(line + len + 1) / 1024.0; // kB
+				break;
+			}
+		}
+		fclose(fp);
+	}
+#endif
+	return value;
+}
+
+static double GetResidentMemoryMB()
+{
+#if _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? pmc.WorkingSetSize / (1024.0 * 1024.0) : 0;
+#else
+	return ReadProcStatusMB("VmRSS");
+#endif
+}
+
+static double GetPeakMemoryMB()
+{
+#if _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? pmc.PeakWorkingSetSize / (1024.0 * 1024.0) : 0;
+#else
+	return ReadProcStatusMB("VmHWM");
+#endif
+}
+
+static void ResetPeakMemory()
+{
+#if !_WIN32
+	FILE * fp = fopen("/proc/self/clear_refs", "w");
+	if (fp) {
+		fputs("5", fp);
+		fclose(fp);
+	}
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+// Synthetic rig: cameras on a ring around the horizon with a top and a bottom
+// camera from 6 cameras on, and two staggered rings at +/-30 degrees pitch when
+// the ring has more than 10 cameras. The field of view covers the ring spacing
+// with 25% overlap within the range supported by the lens type.
+static void BuildRig(const BenchSettings& settings, vx_uint32 numCamera, camera_lens_type lensType, std::vector<camera_params>& par)
+{
+	vx_uint32 numPole = (numCamera >= 6) ? 2 : 0;
+	vx_uint32 numRing = numCamera - numPole;
+	vx_uint32 numRows = (numRing > 10) ? 2 : 1;
+	vx_uint32 perRow = (numRing + numRows - 1) / numRows;
+	float hfovMin = 0, hfovMax = 0;
+	if (lensType == ptgui_lens_rectilinear) { hfovMin = 60; hfovMax = 120; }
+	else if (lensType == ptgui_lens_fisheye_ff) { hfovMin = 90; hfovMax = 180; }
+	else { hfovMin = 150; hfovMax = 220; }
+	float hfov = std::min(hfovMax, std::max(hfovMin, 1.25f * 360.0f / (float)perRow));
+	float W = (float)settings.cameraWidth, H = (float)settings.cameraHeight;
+	par.assign(numCamera, camera_params());
+	for (vx_uint32 i = 0; i < numCamera; i++) {
+		camera_params& p = par[i];
+		memset(&p, 0, sizeof(p));
+		if (i < numRing) {
+			vx_uint32 row = i / perRow, col = i % perRow;
+			vx_uint32 count = std::min(perRow, numRing - row * perRow);
+			p.focal.yaw = -180.0f + 360.0f * ((float)col + 0.5f * (float)row) / (float)count;
+			p.focal.pitch = (numRows > 1) ? (row ? -30.0f : 30.0f) : 0.0f;
+		}
+		else {
+			p.focal.pitch = (i == numRing) ? 90.0f : -90.0f;
+		}
+		p.lens.lens_type = lensType;
+		p.lens.hfov = (i < numRing) ? hfov : std::max(hfov, std::min(hfovMax, 100.0f));
+		p.lens.haw = W;
+		if (lensType == ptgui_lens_fisheye_circ) {
+			p.lens.haw = H;
+			p.lens.r_crop = H * 0.5f;
+		}
+		// mild deterministic lens distortion
+		p.lens.k1 = (lensType == ptgui_lens_rectilinear) ? -0.02f : -0.05f;
+		p.lens.k2 = 0.01f;
+		p.lens.k3 = 1.0f - p.lens.k1 - p.lens.k2;
+	}
+}
+
+// Synthetic camera frames: deterministic texture (gradient with hashed noise and a moving grid)
+// and a per-camera exposure offset, so that exposure compensation and seam find have work to do.
+static void GenerateFrame(vx_uint8 * buf, vx_uint32 stride, vx_uint32 rows, vx_uint32 cols, vx_uint32 camWidth, vx_uint32 camHeight, vx_uint32 frame)
+{
+	for (vx_uint32 r = 0; r < rows; r++) {
+		for (vx_uint32 c = 0; c < cols; c++) {
+			vx_uint32 cam = r * cols + c;
+			int exposure = (int)((cam * 37) % 41) - 20;
+			for (vx_uint32 y = 0; y < camHeight; y++) {
+				vx_uint8 * dst = buf + (size_t)(r * camHeight + y) * stride + (size_t)c * camWidth * 3;
+				for (vx_uint32 x = 0; x < camWidth; x++) {
+					vx_uint32 h = (x * 73856093u) ^ (y * 19349663u) ^ (cam * 83492791u) ^ (frame * 2654435761u);
+					h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+					int grid = (((x + frame * 4) & 63) < 2 || ((y + frame * 2) & 63) < 2) ? 64 : 0;
+					int base = (int)((x * 255) / camWidth + (y * 255) / camHeight) / 2 + exposure + grid;
+					for (int ch = 0; ch < 3; ch++) {
+						int v = base + (int)((h >> (ch * 8)) & 31) - 16 + ch * 8;
+						dst[x * 3 + ch] = (vx_uint8)std::min(255, std::max(0, v));
+					}
+				}
+			}
+		}
+	}
+}
+
+// Synthetic overlay: colored hashed noise with every alpha value from transparent to opaque,
+// so that the blend of the overlay covers all of the alpha blend arithmetic.
+static void GenerateOverlay(vx_uint8 * buf, vx_uint32 stride, vx_uint32 width, vx_uint32 height)
+{
+	for (vx_uint32 y = 0; y < height; y++) {
+		vx_uint8 * dst = buf + (size_t)y * stride;
+		for (vx_uint32 x = 0; x < width; x++) {
+			vx_uint32 h = (x * 73856093u) ^ (y * 19349663u);
+			h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+			dst[x * 4 + 0] = (vx_uint8)h;
+			dst[x * 4 + 1] = (vx_uint8)(h >> 8);
+			dst[x * 4 + 2] = (vx_uint8)(h >> 16);
+			dst[x * 4 + 3] = (vx_uint8)((x + y) & 255);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Benchmark one rig
+#define BENCH_CHECK(call) { vx_status status_ = (call); if (status_ != VX_SUCCESS) { fprintf(stderr, "ERROR: %s failed (%d)\n", #call, status_); result.status = status_; goto cleanup; } }
+
+static void LogCallback(const char * message)
+{
+	fputs(message, stderr);
+}
+
+static void SetTargetEnvironment(const char * name, bool cpu)
+{
+#if _WIN32
+	_putenv_s(name, cpu ? "1" : "0");
+#else
+	setenv(name, cpu ? "1" : "0", 1);
+#endif
+}
+
+#define BENCH_OVERLAY_WIDTH   512
+#define BENCH_OVERLAY_HEIGHT  256
+
+static BenchResult RunRig(const BenchSettings& settings, vx_uint32 numCamera, camera_lens_type lensType, vx_uint32 outputHeight, std::vector<vx_uint8> * output = nullptr)
+{
+	BenchResult result = { 0 };
+	result.numCamera = numCamera;
+	result.lensType = lensType;
+	result.outputWidth = outputHeight * 2;
+	result.outputHeight = outputHeight;
+	result.status = VX_SUCCESS;
+
+	// camera buffer layout: widest grid with buffer width below 8K
+	vx_uint32 cols = 1;
+	for (vx_uint32 c = 1; c <= numCamera; c++) {
+		if ((numCamera % c) == 0 && c * settings.cameraWidth < 8192)
+			cols = c;
+	}
+	vx_uint32 rows = numCamera / cols;
+	result.cameraRows = rows;
+	result.cameraColumns = cols;
+
+	std::vector<camera_params> par;
+	BuildRig(settings, numCamera, lensType, par);
+
+	ls_context stitch = nullptr;
+	cl_command_queue cmdq = nullptr;
+	cl_mem camBuf[2] = { nullptr, nullptr }, outBuf = nullptr, overlayBuf = nullptr;
+	std::vector<vx_uint8> host;
+	size_t outSize = 0;
+	ls_stage_times sum = { 0 };
+	double t0 = 0, frameSum = 0;
+	std::vector<vx_float32> gains, prevGains;
+
+	// global attributes decide the features at context creation
+	vx_float32 attr[LIVE_STITCH_ATTR_MAX_COUNT] = { 0 };
+	BENCH_CHECK(lsGlobalGetAttributes(0, LIVE_STITCH_ATTR_MAX_COUNT, attr));
+	attr[LIVE_STITCH_ATTR_EXPCOMP] = settings.expcomp ? (vx_float32)settings.expcompMode : 0.0f;
+	attr[LIVE_STITCH_ATTR_WARP_EXPCOMP_GAINS] = settings.warpGains ? 1.0f : 0.0f;
+	attr[LIVE_STITCH_ATTR_SEAMFIND] = settings.seamfind ? 1.0f : 0.0f;
+	attr[LIVE_STITCH_ATTR_MULTIBAND] = settings.multiband ? 1.0f : 0.0f;
+	attr[LIVE_STITCH_ATTR_MULTIBAND_NUMBANDS] = (vx_float32)settings.numBands;
+	attr[LIVE_STITCH_ATTR_USE_CPU_FOR_INIT] = settings.cpu ? 1.0f : 0.0f;
+	attr[LIVE_STITCH_ATTR_ENABLE_REINITIALIZE] = settings.reinitCheck ? 1.0f : 0.0f;
+	BENCH_CHECK(lsGlobalSetAttributes(0, LIVE_STITCH_ATTR_MAX_COUNT, attr));
+
+	ResetPeakMemory();
+	result.baseMemoryMB = GetResidentMemoryMB();
+	stitch = lsCreateContext();
+	if (!stitch) { fprintf(stderr, "ERROR: lsCreateContext failed\n"); result.status = VX_FAILURE; goto cleanup; }
+	BENCH_CHECK(lsSetOutputConfig(stitch, VX_DF_IMAGE_RGB, result.outputWidth, result.outputHeight));
+	BENCH_CHECK(lsSetCameraConfig(stitch, rows, cols, VX_DF_IMAGE_RGB, settings.cameraWidth * cols, settings.cameraHeight * rows));
+	for (vx_uint32 i = 0; i < numCamera; i++) {
+		BENCH_CHECK(lsSetCameraParams(stitch, i, &par[i]));
+	}
+	if (settings.blendCheck) {
+		// a rectilinear overlay in front of the rig, below the horizon
+		camera_params p;
+		memset(&p, 0, sizeof(p));
+		p.focal.yaw = 20.0f;
+		p.focal.pitch = -15.0f;
+		p.lens.lens_type = ptgui_lens_rectilinear;
+		p.lens.hfov = 60.0f;
+		p.lens.haw = (float)BENCH_OVERLAY_WIDTH;
+		p.lens.k3 = 1.0f;
+		BENCH_CHECK(lsSetOverlayConfig(stitch, 1, 1, VX_DF_IMAGE_RGBX, BENCH_OVERLAY_WIDTH, BENCH_OVERLAY_HEIGHT));
+		BENCH_CHECK(lsSetOverlayParams(stitch, 0, &p));
+	}
+	t0 = GetTimeMs();
+	BENCH_CHECK(lsInitialize(stitch));
+	result.initMs = GetTimeMs() - t0;
+	if (settings.reinitCheck) {
+		// camera 0 is updated so that ties with the higher cameras are resolved by the incremental update:
+		// with LOOM_REINIT_CHECK set, lsReinitialize fails when its maps differ from a full compute
+		camera_params p = par[0];
+		p.focal.yaw += 1.0f;
+		p.focal.pitch -= 0.5f;
+		BENCH_CHECK(lsSetCameraParams(stitch, 0, &p));
+		BENCH_CHECK(lsReinitialize(stitch));
+	}
+
+	// synthetic camera frames in two buffers alternated per frame, output into a single buffer
+	{
+		cl_context opencl_context = nullptr;
+		BENCH_CHECK(lsGetOpenCLContext(stitch, &opencl_context));
+		cl_device_id device_id = nullptr;
+		cl_int err = clGetContextInfo(opencl_context, CL_CONTEXT_DEVICES, sizeof(device_id), &device_id, nullptr);
+		if (err) { fprintf(stderr, "ERROR: clGetContextInfo(*,CL_CONTEXT_DEVICES) failed (%d)\n", err); result.status = VX_FAILURE; goto cleanup; }
+#if defined(CL_VERSION_2_0)
+		cmdq = clCreateCommandQueueWithProperties(opencl_context, device_id, NULL, &err);
+#else
+		cmdq = clCreateCommandQueue(opencl_context, device_id, 0, &err);
+#endif
+		if (!cmdq) { fprintf(stderr, "ERROR: clCreateCommandQueue failed (%d)\n", err); result.status = VX_FAILURE; goto cleanup; }
+		vx_uint32 camStride = 0, outStride = 0;
+		BENCH_CHECK(lsGetCameraBufferStride(stitch, &camStride));
+		BENCH_CHECK(lsGetOutputBufferStride(stitch, &outStride));
+		size_t camSize = (size_t)camStride * settings.cameraHeight * rows;
+		outSize = (size_t)outStride * result.outputHeight;
+		host.resize(camSize);
+		for (int k = 0; k < 2; k++) {
+			camBuf[k] = clCreateBuffer(opencl_context, CL_MEM_READ_WRITE, camSize, NULL, &err);
+			if (!camBuf[k]) { fprintf(stderr, "ERROR: clCreateBuffer(...,%d,...) failed (%d)\n", (int)camSize, err); result.status = VX_FAILURE; goto cleanup; }
+			GenerateFrame(host.data(), camStride, rows, cols, settings.cameraWidth, settings.cameraHeight, k);
+			err = clEnqueueWriteBuffer(cmdq, camBuf[k], CL_TRUE, 0, camSize, host.data(), 0, NULL, NULL);
+			if (err) { fprintf(stderr, "ERROR: clEnqueueWriteBuffer failed (%d)\n", err); result.status = VX_FAILURE; goto cleanup; }
+		}
+		outBuf = clCreateBuffer(opencl_context, CL_MEM_READ_WRITE, outSize, NULL, &err);
+		if (!outBuf) { fprintf(stderr, "ERROR: clCreateBuffer(...,%d,...) failed (%d)\n", (int)outSize, err); result.status = VX_FAILURE; goto cleanup; }
+		if (settings.blendCheck) {
+			vx_uint32 overlayStride = 0;
+			BENCH_CHECK(lsGetOverlayBufferStride(stitch, &overlayStride));
+			size_t overlaySize = (size_t)overlayStride * BENCH_OVERLAY_HEIGHT;
+			overlayBuf = clCreateBuffer(opencl_context, CL_MEM_READ_WRITE, overlaySize, NULL, &err);
+			if (!overlayBuf) { fprintf(stderr, "ERROR: clCreateBuffer(...,%d,...) failed (%d)\n", (int)overlaySize, err); result.status = VX_FAILURE; goto cleanup; }
+			host.resize(overlaySize);
+			GenerateOverlay(host.data(), overlayStride, BENCH_OVERLAY_WIDTH, BENCH_OVERLAY_HEIGHT);
+			err = clEnqueueWriteBuffer(cmdq, overlayBuf, CL_TRUE, 0, overlaySize, host.data(), 0, NULL, NULL);
+			if (err) { fprintf(stderr, "ERROR: clEnqueueWriteBuffer failed (%d)\n", err); result.status = VX_FAILURE; goto cleanup; }
+		}
+		host.clear();
+		host.shrink_to_fit();
+	}
+	BENCH_CHECK(lsSetOutputBuffer(stitch, &outBuf));
+	if (overlayBuf) {
+		BENCH_CHECK(lsSetOverlayBuffer(stitch, &overlayBuf));
+	}
+	if (settings.expcomp) {
+		gains.resize(numCamera * ((settings.expcompMode == 2) ? 3 : 1));
+	}
+
+	// process the frames
+	for (vx_uint32 frame = 0; frame < settings.warmup + settings.frames; frame++) {
+		BENCH_CHECK(lsSetCameraBuffer(stitch, &camBuf[frame & 1]));
+		t0 = GetTimeMs();
+		BENCH_CHECK(lsScheduleFrame(stitch));
+		BENCH_CHECK(lsWaitForCompletion(stitch));
+		double t = GetTimeMs() - t0;
+		if (frame >= settings.warmup) {
+			ls_stage_times st;
+			BENCH_CHECK(lsGetStageTimes(stitch, &st));
+			sum.warp += st.warp; sum.merge += st.merge; sum.expcomp += st.expcomp;
+			sum.seamfind += st.seamfind; sum.multiband += st.multiband; sum.other += st.other; sum.total += st.total;
+			frameSum += t;
+		}
+		if (!gains.empty()) {
+			// the gains of a static scene must settle: a change between frames shows up as flicker
+			BENCH_CHECK(lsGetExpCompGains(stitch, gains.size(), gains.data()));
+			if (frame >= settings.warmup && !prevGains.empty()) {
+				for (size_t i = 0; i < gains.size(); i++)
+					result.gainDelta = std::max(result.gainDelta, (double)fabsf(gains[i] - prevGains[i]));
+			}
+			prevGains = gains;
+		}
+	}
+	if (settings.frames > 0) {
+		float s = 1.0f / (float)settings.frames;
+		result.stage.warp = sum.warp * s; result.stage.merge = sum.merge * s; result.stage.expcomp = sum.expcomp * s;
+		result.stage.seamfind = sum.seamfind * s; result.stage.multiband = sum.multiband * s;
+		result.stage.other = sum.other * s; result.stage.total = sum.total * s;
+		result.frameMs = frameSum / settings.frames;
+	}
+	BENCH_CHECK(lsGetMemoryUsage(stitch, &result.memory));
+	if (output) {
+		// output of the last frame
+		output->resize(outSize);
+		cl_int err = clEnqueueReadBuffer(cmdq, outBuf, CL_TRUE, 0, outSize, output->data(), 0, NULL, NULL);
+		if (err) { fprintf(stderr, "ERROR: clEnqueueReadBuffer failed (%d)\n", err); result.status = VX_FAILURE; goto cleanup; }
+	}
+	if (!gains.empty() && settings.gainTolerance > 0 && result.gainDelta > settings.gainTolerance) {
+		fprintf(stderr, "ERROR: exposure comp gains did not converge: change %.4f between frames (tolerance %.4f)\n", result.gainDelta, settings.gainTolerance);
+		result.status = VX_FAILURE;
+	}
+
+cleanup:
+	result.peakMemoryMB = GetPeakMemoryMB();
+	if (stitch) lsReleaseContext(&stitch);
+	for (int k = 0; k < 2; k++) if (camBuf[k]) clReleaseMemObject(camBuf[k]);
+	if (outBuf) clReleaseMemObject(outBuf);
+	if (overlayBuf) clReleaseMemObject(overlayBuf);
+	if (cmdq) clReleaseCommandQueue(cmdq);
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+// JSON output
+static void WriteJson(FILE * fp, const BenchSettings& settings, const std::vector<BenchResult>& results)
+{
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"benchmark\": \"%s\",\n", PROGRAM_NAME);
+	fprintf(fp, "  \"version\": \"%s\",\n", VERSION);
+	fprintf(fp, "  \"loomsl\": \"%s\",\n", lsGetVersion());
+	fprintf(fp, "  \"settings\": { \"target\": \"%s\", \"camera\": [%d, %d], \"format\": \"RGB\", \"frames\": %d, \"warmup\": %d, \"expcomp\": %d, \"warp_gains\": %s, \"seamfind\": %s, \"multiband\": %s, \"num_bands\": %d },\n",
+		settings.cpu ? "cpu" : "gpu", settings.cameraWidth, settings.cameraHeight, settings.frames, settings.warmup,
+		settings.expcomp ? settings.expcompMode : 0, settings.warpGains ? "true" : "false", settings.seamfind ? "true" : "false", settings.multiband ? "true" : "false", settings.numBands);
+	// merge and exposure comp (except the gain solver) have GPU kernels only: they run on the GPU with -gpu or not
+	const char * target = settings.cpu ? "cpu" : "gpu";
+	fprintf(fp, "  \"stage_target\": { \"warp\": \"%s\", \"merge\": \"gpu\", \"expcomp\": \"gpu\", \"seamfind\": \"%s\", \"multiband\": \"%s\", \"other\": \"%s\" },\n",
+		target, target, target, target);
+	fprintf(fp, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		fprintf(fp, "    { \"cameras\": %d, \"lens\": \"%s\", \"camera_grid\": [%d, %d], \"output\": [%d, %d], \"status\": %d,\n",
+			r.numCamera, LensName(r.lensType), r.cameraRows, r.cameraColumns, r.outputWidth, r.outputHeight, r.status);
+		fprintf(fp, "      \"init_ms\": %.3f, \"frame_ms\": %.3f, \"fps\": %.2f,\n", r.initMs, r.frameMs, r.frameMs > 0 ? 1000.0 / r.frameMs : 0.0);
+		fprintf(fp, "      \"stage_ms\": { \"warp\": %.3f, \"merge\": %.3f, \"expcomp\": %.3f, \"seamfind\": %.3f, \"multiband\": %.3f, \"other\": %.3f, \"total\": %.3f },\n",
+			r.stage.warp, r.stage.merge, r.stage.expcomp, r.stage.seamfind, r.stage.multiband, r.stage.other, r.stage.total);
+		fprintf(fp, "      \"memory_mb\": { \"base\": %.1f, \"peak\": %.1f },\n", r.baseMemoryMB, r.peakMemoryMB);
+		if (settings.expcomp)
+			fprintf(fp, "      \"gain_delta\": %.4f,\n", r.gainDelta);
+		const char * memoryNames[] = { "warp", "merge", "expcomp", "seamfind", "multiband", "intermediate", "loomio", "other", "total" };
+		const ls_memory_size * memory = &r.memory.warp;
+		fprintf(fp, "      \"context_mb\": {");
+		for (size_t k = 0; k < sizeof(memoryNames) / sizeof(memoryNames[0]); k++)
+			fprintf(fp, "%s \"%s\": [%.1f, %.1f]", k ? "," : "", memoryNames[k], memory[k].host / 1048576.0, memory[k].device / 1048576.0);
+		fprintf(fp, " } }%s\n", (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(fp, "  ]\n");
+	fprintf(fp, "}\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+// command-line
+static void Usage()
+{
+	printf("Usage: %s [options]\n", PROGRAM_NAME);
+	printf("  -cameras <n,...>      camera counts 2..24 (default: 2,4,8,16,24)\n");
+	printf("  -lens <type,...>      lens types rectilinear, fisheye, circular (default: all)\n");
+	printf("  -output <size,...>    output sizes 4k, 8k, 16k or height in pixels (default: 4k,8k,16k)\n");
+	printf("  -camera <W>x<H>       camera image dimensions (default: 1920x1080)\n");
+	printf("  -frames <n>           number of measured frames (default: 20)\n");
+	printf("  -warmup <n>           number of frames before measurement (default: 2)\n");
+	printf("  -gpu                  use GPU kernels (default: CPU kernels)\n");
+	printf("  -no-expcomp           disable exposure compensation\n");
+	printf("  -expcomp-mode <n>     exposure compensation mode 1 or 2 (default: 1)\n");
+	printf("  -warp-gains           warp applies the exposure comp gains\n");
+	printf("  -gain-check <t>       fail a rig if a gain changes by more than t between measured frames\n");
+	printf("  -reinit-check         fail a rig if the maps of an incremental lsReinitialize differ from a full compute\n");
+	printf("  -blend-check          blend an overlay and fail a rig if the CPU and GPU alpha blend outputs differ\n");
+	printf("  -no-seamfind          disable seam find\n");
+	printf("  -no-multiband         disable multiband blend\n");
+	printf("  -bands <n>            multiband number of bands 2..6 (default: 4)\n");
+	printf("  -json <file>          write results to file (default: stdout)\n");
+}
+
+static bool ParseList(const char * s, std::vector<std::string>& list)
+{
+	list.clear();
+	std::string item;
+	for (; ; s++) {
+		if (*s == ',' || *s == '\0') {
+			if (item.empty()) return false;
+			list.push_back(item);
+			item.clear();
+			if (*s == '\0') break;
+		}
+		else item += *s;
+	}
+	return true;
+}
+
+int main(int argc, char * argv[])
+{
+	BenchSettings settings;
+	settings.cameras = { 2, 4, 8, 16, 24 };
+	settings.lenses = { ptgui_lens_rectilinear, ptgui_lens_fisheye_ff, ptgui_lens_fisheye_circ };
+	settings.outputs = { 1920, 3840, 7680 };
+	settings.cameraWidth = 1920;
+	settings.cameraHeight = 1080;
+	settings.frames = 20;
+	settings.warmup = 2;
+	settings.cpu = true;
+	settings.expcomp = settings.seamfind = settings.multiband = true;
+	settings.numBands = 4;
+	settings.expcompMode = 1;
+	settings.warpGains = false;
+	settings.gainTolerance = 0;
+	settings.reinitCheck = false;
+	settings.blendCheck = false;
+	settings.jsonFile = nullptr;
+
+	std::vector<std::string> list;
+	for (int arg = 1; arg < argc; arg++) {
+		const char * opt = argv[arg];
+		const char * value = (arg + 1 < argc) ? argv[arg + 1] : nullptr;
+		bool hasValue = true;
+		if (!_stricmp(opt, "-help")) { Usage(); return 0; }
+		else if (!_stricmp(opt, "-gpu")) { settings.cpu = false; hasValue = false; }
+		else if (!_stricmp(opt, "-no-expcomp")) { settings.expcomp = false; hasValue = false; }
+		else if (!_stricmp(opt, "-no-seamfind")) { settings.seamfind = false; hasValue = false; }
+		else if (!_stricmp(opt, "-no-multiband")) { settings.multiband = false; hasValue = false; }
+		else if (!_stricmp(opt, "-warp-gains")) { settings.warpGains = true; hasValue = false; }
+		else if (!_stricmp(opt, "-reinit-check")) { settings.reinitCheck = true; hasValue = false; }
+		else if (!_stricmp(opt, "-blend-check")) { settings.blendCheck = true; hasValue = false; }
+		else if (!value) { fprintf(stderr, "ERROR: missing value for %s (use -help see all options)\n", opt); return -1; }
+		else if (!_stricmp(opt, "-cameras")) {
+			if (!ParseList(value, list)) { fprintf(stderr, "ERROR: invalid camera counts: %s\n", value); return -1; }
+			settings.cameras.clear();
+			for (auto& s : list) {
+				int n = atoi(s.c_str());
+				if (n < 2 || n > 24) { fprintf(stderr, "ERROR: camera count must be 2..24: %s\n", s.c_str()); return -1; }
+				settings.cameras.push_back((vx_uint32)n);
+			}
+		}
+		else if (!_stricmp(opt, "-lens")) {
+			if (!ParseList(value, list)) { fprintf(stderr, "ERROR: invalid lens types: %s\n", value); return -1; }
+			settings.lenses.clear();
+			for (auto& s : list) {
+				if (!_stricmp(s.c_str(), "rectilinear")) settings.lenses.push_back(ptgui_lens_rectilinear);
+				else if (!_stricmp(s.c_str(), "fisheye")) settings.lenses.push_back(ptgui_lens_fisheye_ff);
+				else if (!_stricmp(s.c_str(), "circular")) settings.lenses.push_back(ptgui_lens_fisheye_circ);
+				else { fprintf(stderr, "ERROR: invalid lens type: %s\n", s.c_str()); return -1; }
+			}
+		}
+		else if (!_stricmp(opt, "-output")) {
+			if (!ParseList(value, list)) { fprintf(stderr, "ERROR: invalid output sizes: %s\n", value); return -1; }
+			settings.outputs.clear();
+			for (auto& s : list) {
+				int h = 0;
+				if (!_stricmp(s.c_str(), "4k")) h = 1920;
+				else if (!_stricmp(s.c_str(), "8k")) h = 3840;
+				else if (!_stricmp(s.c_str(), "16k")) h = 7680;
+				else h = atoi(s.c_str());
+				if (h < 16 || (h % 8) != 0) { fprintf(stderr, "ERROR: invalid output size: %s\n", s.c_str()); return -1; }
+				settings.outputs.push_back((vx_uint32)h);
+			}
+		}
+		else if (!_stricmp(opt, "-camera")) {
+			if (sscanf(value, "%ux%u", &settings.cameraWidth, &settings.cameraHeight) != 2 || (settings.cameraWidth % 16) != 0 || (settings.cameraHeight % 2) != 0) {
+				fprintf(stderr, "ERROR: camera dimensions must be multiple of 16x2: %s\n", value); return -1;
+			}
+		}
+		else if (!_stricmp(opt, "-frames")) settings.frames = (vx_uint32)atoi(value);
+		else if (!_stricmp(opt, "-warmup")) settings.warmup = (vx_uint32)atoi(value);
+		else if (!_stricmp(opt, "-bands")) {
+			settings.numBands = (vx_uint32)atoi(value);
+			if (settings.numBands < 2 || settings.numBands > 6) { fprintf(stderr, "ERROR: multiband number of bands must be 2..6: %s\n", value); return -1; }
+		}
+		else if (!_stricmp(opt, "-expcomp-mode")) {
+			settings.expcompMode = (vx_uint32)atoi(value);
+			if (settings.expcompMode < 1 || settings.expcompMode > 2) { fprintf(stderr, "ERROR: exposure compensation mode must be 1 or 2: %s\n", value); return -1; }
+		}
+		else if (!_stricmp(opt, "-gain-check")) settings.gainTolerance = (float)atof(value);
+		else if (!_stricmp(opt, "-json")) settings.jsonFile = value;
+		else { fprintf(stderr, "ERROR: invalid command-line option: %s (use -help see all options)\n", opt); return -1; }
+		if (hasValue) arg++;
+	}
+
+	// log messages go to stderr so that stdout has only the JSON output
+	lsGlobalSetLogCallback(LogCallback);
+
+	// kernel targets are picked up when the kernels are created
+	const char * targets[] = { "WARP_TARGET", "SEAM_FIND_TARGET", "MULTIBAND_TARGET", "COLOR_CONVERT_TARGET", "NOISE_FILTER_TARGET", "ALPHA_BLEND_TARGET" };
+	for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+		SetTargetEnvironment(targets[i], settings.cpu);
+	if (settings.reinitCheck)
+		SetTargetEnvironment("LOOM_REINIT_CHECK", true);
+
+	std::vector<BenchResult> results;
+	for (vx_uint32 outputHeight : settings.outputs) {
+		for (camera_lens_type lensType : settings.lenses) {
+			for (vx_uint32 numCamera : settings.cameras) {
+				fprintf(stderr, "%s: %2d x %-11s -> %5dx%-5d ...", PROGRAM_NAME, numCamera, LensName(lensType), outputHeight * 2, outputHeight);
+				fflush(stderr);
+				std::vector<vx_uint8> output, outputCheck;
+				BenchResult r = RunRig(settings, numCamera, lensType, outputHeight, settings.blendCheck ? &output : nullptr);
+				if (settings.blendCheck && r.status == VX_SUCCESS) {
+					// the same rig with the alpha blend on the other target must give the same output
+					SetTargetEnvironment("ALPHA_BLEND_TARGET", !settings.cpu);
+					BenchResult rc = RunRig(settings, numCamera, lensType, outputHeight, &outputCheck);
+					SetTargetEnvironment("ALPHA_BLEND_TARGET", settings.cpu);
+					if (rc.status != VX_SUCCESS)
+						r.status = rc.status;
+					else {
+						size_t mismatch = 0;
+						for (size_t i = 0; i < output.size(); i++)
+							if (output[i] != outputCheck[i]) mismatch++;
+						if (mismatch > 0) {
+							fprintf(stderr, "ERROR: CPU and GPU alpha blend outputs differ in %d bytes\n", (int)mismatch);
+							r.status = VX_FAILURE;
+						}
+					}
+				}
+				if (r.status == VX_SUCCESS)
+					fprintf(stderr, " init %8.1f ms  frame %8.2f ms  peak %7.1f MB\n", r.initMs, r.frameMs, r.peakMemoryMB);
+				else
+					fprintf(stderr, " failed (%d)\n", r.status);
+				results.push_back(r);
+			}
+		}
+	}
+
+	FILE * fp = settings.jsonFile ? fopen(settings.jsonFile, "w") : stdout;
+	if (!fp) { fprintf(stderr, "ERROR: unable to create: %s\n", settings.jsonFile); return -1; }
+	WriteJson(fp, settings, results);
+	if (fp != stdout) fclose(fp);
+	for (const BenchResult& r : results)
+		if (r.status != VX_SUCCESS) return 1;
+	return 0;
+}
@@ -82,6 +82,7 @@ void CLoomShellParser::help(bool detailed)
 	Message("        lsSetCameraBuffer(context,&buf[#]|NULL);\n");
 	Message("        lsSetOutputBuffer(context,&buf[#]|NULL);\n");
 	Message("        lsSetOverlayBuffer(context,&buf[#]|NULL);\n");
+	Message("        lsSetPreviewBuffer(context,&buf[#]|NULL);\n");
 	Message("        showCameraBufferStride(context);\n");
 	Message("        showOutputBufferStride(context);\n");
 	Message("        showOverlayBufferStride(context);\n");
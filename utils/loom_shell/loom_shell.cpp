@@ -914,6 +914,35 @@ int CLoomShellParser::OnCommand()
 			Message("..lsSetChromaKeyBuffer: set OpenCL buffer %s[%d] for %s[%d]\n", name_buf, bufIndex, name_ls, contextIndex);
 		}
 	}
+	else if (!_stricmp(command, "lsSetPreviewBuffer")) {
+		// parse the command
+		vx_uint32 contextIndex = 0, bufIndex = 0;
+		bool useNull = false;
+		const char * invalidSyntax = "ERROR: invalid syntax: expects: lsSetPreviewBuffer(ls[#],&buf[#]|NULL)";
+		SYNTAX_CHECK(ParseSkip(s, "("));
+		SYNTAX_CHECK(ParseContextWithErrorCheck(s, contextIndex, invalidSyntax));
+		if (!_stricmp(s, ",null)")) {
+			useNull = true;
+		}
+		else {
+			SYNTAX_CHECK(ParseSkip(s, ",&"));
+			SYNTAX_CHECK(ParseIndex(s, name_buf, bufIndex, num_opencl_buf_));
+			SYNTAX_CHECK(ParseSkip(s, ")"));
+		}
+		SYNTAX_CHECK(ParseEndOfLine(s));
+		if (bufIndex >= num_opencl_buf_) return Error("ERROR: OpenCL buffer out-of-range: expects: 0..%d", num_opencl_buf_ - 1);
+		// process the command
+		if (useNull) {
+			vx_status status = lsSetPreviewBuffer(context_[contextIndex], nullptr);
+			if (status) return Error("ERROR: lsSetPreviewBuffer(%s[%d],NULL) failed (%d)", name_ls, contextIndex, status);
+			Message("..lsSetPreviewBuffer: set NULL for %s[%d]\n", name_ls, contextIndex);
+		}
+		else {
+			vx_status status = lsSetPreviewBuffer(context_[contextIndex], &opencl_buf_mem_[bufIndex]);
+			if (status) return Error("ERROR: lsSetPreviewBuffer(%s[%d],%s[%d]) failed (%d)", name_ls, contextIndex, name_buf, bufIndex, status);
+			Message("..lsSetPreviewBuffer: set OpenCL buffer %s[%d] for %s[%d]\n", name_buf, bufIndex, name_ls, contextIndex);
+		}
+	}
 	else if (!_stricmp(command, "setGlobalAttribute")) {
 		// parse the command
 		vx_uint32 attr_offset = 0; float value = 0;
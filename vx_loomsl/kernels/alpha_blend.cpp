@@ -26,7 +26,7 @@ THE SOFTWARE.
 //! \brief The input validator callback.
 static vx_status VX_CALLBACK validate(vx_node node, const vx_reference parameters[], vx_uint32 num, vx_meta_format metas[])
 {
-	if (num != 3)
+	if (num != 3 && num != 4)
 		return VX_ERROR_INVALID_PARAMETERS;
 	vx_uint32 width, height, width2, height2;
 	vx_df_image format, format2;
@@ -40,6 +40,15 @@ static vx_status VX_CALLBACK validate(vx_node node, const vx_reference parameter
 		return VX_ERROR_INVALID_FORMAT;
 	if (width != width2 || height != height2)
 		return VX_ERROR_INVALID_DIMENSION;
+	if (num > 3 && parameters[3]) {
+		// optional array of overlay regions
+		vx_enum itemtype = VX_TYPE_INVALID;
+		ERROR_CHECK_STATUS(vxQueryArray((vx_array)parameters[3], VX_ARRAY_ATTRIBUTE_ITEMTYPE, &itemtype, sizeof(itemtype)));
+		if (itemtype != VX_TYPE_RECTANGLE) {
+			vxAddLogEntry((vx_reference)node, VX_ERROR_INVALID_TYPE, "ERROR: alpha_blend regions array type should be VX_TYPE_RECTANGLE\n");
+			return VX_ERROR_INVALID_TYPE;
+		}
+	}
 	ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(metas[2], VX_IMAGE_WIDTH, &width, sizeof(width)));
 	ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(metas[2], VX_IMAGE_HEIGHT, &height, sizeof(height)));
 	ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(metas[2], VX_IMAGE_FORMAT, &format, sizeof(format)));
@@ -52,7 +61,15 @@ static vx_status VX_CALLBACK query_target_support(vx_graph graph, vx_node node,
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	char textBuffer[256];
+	int ALPHA_BLEND_TARGET = 0;
+	if (StitchGetEnvironmentVariable("ALPHA_BLEND_TARGET", textBuffer, sizeof(textBuffer))) { ALPHA_BLEND_TARGET = atoi(textBuffer); }
+
+	if (!ALPHA_BLEND_TARGET)
+		supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	else
+		supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
+
 	return VX_SUCCESS;
 }
 
@@ -89,67 +106,140 @@ static vx_status VX_CALLBACK opencl_codegen(
 	opencl_local_buffer_usage_mask = 0;
 	opencl_local_buffer_size_in_bytes = 0;
 
-	// kernel header and reading
+	// kernel header and reading: with the regions array, the pixels outside of the regions are copied from the input
+	// without blending. The blend uses the integer arithmetic of AlphaBlendRow, so that both targets give the same output.
+	bool regions = (num > 3 && parameters[3]);
 	char item[8192];
 	sprintf(item,
-		"#pragma OPENCL EXTENSION cl_amd_media_ops : enable\n"
-		"#pragma OPENCL EXTENSION cl_amd_media_ops2 : enable\n"
-		"float4 amd_unpack(uint src)\n"
-		"{\n"
-		"  return (float4)(amd_unpack0(src), amd_unpack1(src), amd_unpack2(src), amd_unpack3(src));\n"
-		"}\n"
-		"\n"
 		"__kernel __attribute__((reqd_work_group_size(%d, %d, 1)))\n" // opencl_local_work[0], opencl_local_work[1]
 		"void %s(uint i0_width, uint i0_height, __global uchar * i0_buf, uint i0_stride, uint i0_offset,\n"
 		"        uint i1_width, uint i1_height, __global uchar * i1_buf, uint i1_stride, uint i1_offset,\n"
-		"        uint o0_width, uint o0_height, __global uchar * o0_buf, uint o0_stride, uint o0_offset)\n"
+		"        uint o0_width, uint o0_height, __global uchar * o0_buf, uint o0_stride, uint o0_offset%s)\n"
 		"{\n"
 		"  int gx = get_global_id(0);\n"
 		"  int gy = get_global_id(1);\n"
 		"  if ((gx < %d) && (gy < %d)) {\n" // work_items[0], work_items[1]
 		"    uint3 i0 = *(__global uint3 *) (i0_buf + i0_offset + (gy * i0_stride) + (gx * 12));\n"
 		"    uint4 i1 = *(__global uint4 *) (i1_buf + i1_offset + (gy * i1_stride) + (gx * 16));\n"
-		"    uint3 o0;\n"
-		"    float4 f; float alpha0, alpha1, alpha_normalizer = 0.0039215686274509803921568627451f;\n"
-		"    alpha1 = amd_unpack3(i1.s0)*alpha_normalizer; alpha0 = 1.0f - alpha1;\n"
-		"    f.s0 = mad(amd_unpack0(i0.s0), alpha0, amd_unpack0(i1.s0)*alpha1);\n"
-		"    f.s1 = mad(amd_unpack1(i0.s0), alpha0, amd_unpack1(i1.s0)*alpha1);\n"
-		"    f.s2 = mad(amd_unpack2(i0.s0), alpha0, amd_unpack2(i1.s0)*alpha1);\n"
-		"    alpha1 = amd_unpack3(i1.s1)*alpha_normalizer; alpha0 = 1.0f - alpha1;\n"
-		"    f.s3 = mad(amd_unpack3(i0.s0), alpha0, amd_unpack0(i1.s1)*alpha1);\n"
-		"    o0.s0 = amd_pack(f);\n"
-		"    f.s0 = mad(amd_unpack0(i0.s1), alpha0, amd_unpack1(i1.s1)*alpha1);\n"
-		"    f.s1 = mad(amd_unpack1(i0.s1), alpha0, amd_unpack2(i1.s1)*alpha1);\n"
-		"    alpha1 = amd_unpack3(i1.s2)*alpha_normalizer; alpha0 = 1.0f - alpha1;\n"
-		"    f.s2 = mad(amd_unpack2(i0.s1), alpha0, amd_unpack0(i1.s2)*alpha1);\n"
-		"    f.s3 = mad(amd_unpack3(i0.s1), alpha0, amd_unpack1(i1.s2)*alpha1);\n"
-		"    o0.s1 = amd_pack(f);\n"
-		"    f.s0 = mad(amd_unpack0(i0.s2), alpha0, amd_unpack2(i1.s2)*alpha1);\n"
-		"    alpha1 = amd_unpack3(i1.s3)*alpha_normalizer; alpha0 = 1.0f - alpha1;\n"
-		"    f.s1 = mad(amd_unpack1(i0.s2), alpha0, amd_unpack0(i1.s3)*alpha1);\n"
-		"    f.s2 = mad(amd_unpack2(i0.s2), alpha0, amd_unpack1(i1.s3)*alpha1);\n"
-		"    f.s3 = mad(amd_unpack3(i0.s2), alpha0, amd_unpack2(i1.s3)*alpha1);\n"
-		"    o0.s2 = amd_pack(f);\n"
+		"    uint3 o0 = i0;\n"
+		"    uint4 a = i1 >> (uint4)24;\n"
+		, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name,
+		regions ? ",\n        __global uchar * r_buf, uint r_offset, uint r_num" : "", work_items[0], work_items[1]);
+	opencl_kernel_code = item;
+	if (regions) {
+		// the alpha of the pixels outside of the regions is cleared
+		opencl_kernel_code +=
+			"    __global uint4 * r = (__global uint4 *) (r_buf + r_offset);\n"
+			"    uint4 px = (uint4)((uint)gx << 2) + (uint4)(0, 1, 2, 3);\n"
+			"    uint py = (uint)gy;\n"
+			"    int4 inside = (int4)0;\n"
+			"    for (uint i = 0; i < r_num; i++) {\n"
+			"      uint4 rect = r[i];\n"
+			"      if ((py >= rect.s1) && (py < rect.s3))\n"
+			"        inside |= (px >= (uint4)rect.s0) & (px < (uint4)rect.s2);\n"
+			"    }\n"
+			"    a = select((uint4)0, a, inside);\n";
+	}
+	opencl_kernel_code +=
+		"    if (a.s0 | a.s1 | a.s2 | a.s3) {\n"
+		"      uchar16 s1 = as_uchar16(i1);\n"
+		"      uint16 c0 = convert_uint16((uchar16)(as_uchar4(i0.s0), as_uchar4(i0.s1), as_uchar4(i0.s2), (uchar4)0));\n"
+		"      uint16 c1 = convert_uint16((uchar16)(s1.s012, s1.s456, s1.s89a, s1.scde, (uchar4)0));\n"
+		"      uint16 alpha = (uint16)(a.s000, a.s111, a.s222, a.s333, (uint4)0);\n"
+		"      uint4 f = as_uint4(convert_uchar16((c0 * ((uint16)255 - alpha) + c1 * alpha + (uint16)127) / (uint16)255));\n"
+		"      o0 = f.s012;\n"
+		"    }\n"
 		"    *(__global uint3 *) (o0_buf + o0_offset + (gy * o0_stride) + (gx * 12)) = o0;\n"
 		"  }\n"
-		"}\n"
-		, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name, work_items[0], work_items[1]);
-	opencl_kernel_code = item;
+		"}\n";
 
 	return VX_SUCCESS;
 }
 
+//! \brief Blend RGBX pixels with alpha over RGB pixels: transparent pixels are skipped and opaque pixels are copied.
+//  The OpenCL kernel uses the same rounding: (rgb * (255 - a) + rgbx * a + 127) / 255.
+static inline void AlphaBlendRow(const vx_uint8 * rgb, const vx_uint8 * rgbx, vx_uint8 * dst, vx_uint32 count)
+{
+	for (vx_uint32 i = 0; i < count; i++, rgb += 3, rgbx += 4, dst += 3) {
+		vx_uint32 a = rgbx[3];
+		if (a == 255) {
+			dst[0] = rgbx[0]; dst[1] = rgbx[1]; dst[2] = rgbx[2];
+		}
+		else if (a > 0) {
+			vx_uint32 b = 255 - a;
+			dst[0] = (vx_uint8)((rgb[0] * b + rgbx[0] * a + 127) / 255);
+			dst[1] = (vx_uint8)((rgb[1] * b + rgbx[1] * a + 127) / 255);
+			dst[2] = (vx_uint8)((rgb[2] * b + rgbx[2] * a + 127) / 255);
+		}
+	}
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK host_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_IMPLEMENTED;
+	vx_image input_rgb = (vx_image)parameters[0];
+	vx_image input_rgba = (vx_image)parameters[1];
+	vx_image output_rgb = (vx_image)parameters[2];
+	vx_array regions = (num > 3) ? (vx_array)parameters[3] : nullptr;
+	vx_uint32 width = 0, height = 0;
+	ERROR_CHECK_STATUS(vxQueryImage(output_rgb, VX_IMAGE_WIDTH, &width, sizeof(width)));
+	ERROR_CHECK_STATUS(vxQueryImage(output_rgb, VX_IMAGE_HEIGHT, &height, sizeof(height)));
+
+	// regions to blend: the complete image without the regions array
+	std::vector<vx_rectangle_t> rectList;
+	if (regions) {
+		vx_size numItems = 0;
+		ERROR_CHECK_STATUS(vxQueryArray(regions, VX_ARRAY_ATTRIBUTE_NUMITEMS, &numItems, sizeof(numItems)));
+		if (numItems > 0) {
+			vx_size stride = 0; void * base = nullptr;
+			ERROR_CHECK_STATUS(vxAccessArrayRange(regions, 0, numItems, &stride, &base, VX_READ_ONLY));
+			for (vx_size i = 0; i < numItems; i++) {
+				vx_rectangle_t rect = vxArrayItem(vx_rectangle_t, base, i, stride);
+				rect.end_x = std::min(rect.end_x, width); rect.end_y = std::min(rect.end_y, height);
+				if (rect.start_x < rect.end_x && rect.start_y < rect.end_y)
+					rectList.push_back(rect);
+			}
+			ERROR_CHECK_STATUS(vxCommitArrayRange(regions, 0, numItems, base));
+		}
+	}
+	else {
+		vx_rectangle_t rect = { 0, 0, width, height };
+		rectList.push_back(rect);
+	}
+
+	vx_rectangle_t rect = { 0, 0, width, height };
+	vx_imagepatch_addressing_t input_rgb_addr, input_rgba_addr, output_addr;
+	void * input_rgb_ptr = nullptr, * input_rgba_ptr = nullptr, * output_ptr = nullptr;
+	ERROR_CHECK_STATUS(vxAccessImagePatch(input_rgb, &rect, 0, &input_rgb_addr, &input_rgb_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(input_rgba, &rect, 0, &input_rgba_addr, &input_rgba_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(output_rgb, &rect, 0, &output_addr, &output_ptr, VX_WRITE_ONLY));
+
+	// copy each row and blend the parts of the row in the regions
+	StitchParallelFor(height, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 y = start; y < end; y++) {
+			const vx_uint8 * rgb = (const vx_uint8 *)input_rgb_ptr + y * input_rgb_addr.stride_y;
+			const vx_uint8 * rgbx = (const vx_uint8 *)input_rgba_ptr + y * input_rgba_addr.stride_y;
+			vx_uint8 * dst = (vx_uint8 *)output_ptr + y * output_addr.stride_y;
+			memcpy(dst, rgb, width * 3);
+			for (const vx_rectangle_t& r : rectList) {
+				if (y >= r.start_y && y < r.end_y) {
+					AlphaBlendRow(rgb + r.start_x * 3, rgbx + r.start_x * 4, dst + r.start_x * 3, r.end_x - r.start_x);
+				}
+			}
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitImagePatch(input_rgb, &rect, 0, &input_rgb_addr, input_rgb_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(input_rgba, &rect, 0, &input_rgba_addr, input_rgba_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(output_rgb, &rect, 0, &output_addr, output_ptr));
+	return VX_SUCCESS;
 }
 
 //! \brief The kernel publisher.
 vx_status alpha_blend_publish(vx_context context)
 {
 	// add kernel to the context with callbacks
-	vx_kernel kernel = vxAddUserKernel(context, "com.amd.loomsl.alpha_blend", AMDOVX_KERNEL_STITCHING_ALPHA_BLEND, host_kernel, 2, validate, nullptr, nullptr);
+	vx_kernel kernel = vxAddUserKernel(context, "com.amd.loomsl.alpha_blend", AMDOVX_KERNEL_STITCHING_ALPHA_BLEND, host_kernel, 4, validate, nullptr, nullptr);
 	ERROR_CHECK_OBJECT(kernel);
 	amd_kernel_query_target_support_f query_target_support_f = query_target_support;
 	amd_kernel_opencl_codegen_callback_f opencl_codegen_callback_f = opencl_codegen;
@@ -160,6 +250,7 @@ vx_status alpha_blend_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 0, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 1, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_OUTPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_OPTIONAL));
 
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
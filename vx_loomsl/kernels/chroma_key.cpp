@@ -23,6 +23,133 @@ THE SOFTWARE.
 #define _CRT_SECURE_NO_WARNINGS
 #include "chroma_key.h"
 
+/***********************************************************************************************************************************
+Chroma Key -- CPU helpers shared by the mask generation, merge, and fused kernels
+************************************************************************************************************************************/
+//! \brief The chroma key in CbCr space: a pixel is keyed when its CbCr distance from the key is below the tolerance.
+typedef struct {
+	vx_int32 cb_key, cr_key;
+	vx_int32 tol2;           // squared tolerance
+} ChromaKeyParams;
+
+//! \brief Initialize the chroma key parameters from the RGB key (R in bits 0..7) and the tolerance.
+static void ChromaKeyInit(ChromaKeyParams& k, vx_uint32 ChromaKey, vx_uint32 Tolerance)
+{
+	vx_uint8 Red_g = (vx_uint8)(ChromaKey & 0x000000FF);
+	vx_uint8 Green_g = (vx_uint8)((ChromaKey & 0x0000FF00) >> 8);
+	vx_uint8 Blue_g = (vx_uint8)((ChromaKey & 0x00FF0000) >> 16);
+	k.cb_key = (int)round(128 + -0.168736*Red_g - 0.331264*Green_g + 0.5*Blue_g);
+	k.cr_key = (int)round(128 + 0.5*Red_g - 0.418688*Green_g - 0.081312*Blue_g);
+	// the largest CbCr distance is below 512, so larger tolerances key every pixel
+	vx_int32 tol = (vx_int32)std::min(Tolerance, 512u);
+	k.tol2 = tol * tol;
+}
+
+//! \brief Get round(M/1000000 - 0.5) for 0 <= M < 2^31, i.e., floor(M/1000000).
+static inline __m128i ChromaKeyDivMillion(__m128i M)
+{
+	const __m128i million = _mm_set1_epi32(1000000);
+	__m128i q = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(M), _mm_set1_ps(1e-6f)));
+	// the float estimate is off by at most one: correct it using the remainder
+	__m128i r = _mm_sub_epi32(M, _mm_mullo_epi32(q, million));
+	q = _mm_add_epi32(q, _mm_cmplt_epi32(r, _mm_setzero_si128()));
+	q = _mm_sub_epi32(q, _mm_cmpgt_epi32(r, _mm_set1_epi32(999999)));
+	return q;
+}
+
+//! \brief Generate a row of the chroma key mask: 255 for keyed pixels, 0 otherwise.
+//  Cb and Cr are computed in fixed point with the BT601 coefficients scaled by 10^6, which is exact.
+static void ChromaKeyMaskRow(const ChromaKeyParams& k, const vx_uint8 * rgb, vx_uint8 * mask, vx_uint32 width)
+{
+	const __m128i shuffleR = _mm_setr_epi8(0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1);
+	const __m128i shuffleG = _mm_setr_epi8(1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1);
+	const __m128i shuffleB = _mm_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+	const __m128i cbR = _mm_set1_epi32(-168736), cbG = _mm_set1_epi32(-331264), cbB = _mm_set1_epi32(500000);
+	const __m128i crR = _mm_set1_epi32(500000), crG = _mm_set1_epi32(-418688), crB = _mm_set1_epi32(-81312);
+	const __m128i bias = _mm_set1_epi32(128000000 + 500000);
+	const __m128i cbKey = _mm_set1_epi32(k.cb_key), crKey = _mm_set1_epi32(k.cr_key), tol2 = _mm_set1_epi32(k.tol2);
+	for (vx_uint32 x = 0; x < width; x += 4) {
+		vx_uint32 n = std::min(4u, width - x);
+		__m128i L;
+		if (x + 6 <= width) L = _mm_loadu_si128((const __m128i *)(rgb + x * 3));
+		else { vx_uint8 buf[16] = { 0 }; memcpy(buf, rgb + x * 3, n * 3); L = _mm_loadu_si128((const __m128i *)buf); }
+		__m128i R = _mm_shuffle_epi8(L, shuffleR), G = _mm_shuffle_epi8(L, shuffleG), B = _mm_shuffle_epi8(L, shuffleB);
+		__m128i cb = _mm_add_epi32(_mm_add_epi32(bias, _mm_mullo_epi32(R, cbR)), _mm_add_epi32(_mm_mullo_epi32(G, cbG), _mm_mullo_epi32(B, cbB)));
+		__m128i cr = _mm_add_epi32(_mm_add_epi32(bias, _mm_mullo_epi32(R, crR)), _mm_add_epi32(_mm_mullo_epi32(G, crG), _mm_mullo_epi32(B, crB)));
+		__m128i dcb = _mm_sub_epi32(ChromaKeyDivMillion(cb), cbKey);
+		__m128i dcr = _mm_sub_epi32(ChromaKeyDivMillion(cr), crKey);
+		__m128i d2 = _mm_add_epi32(_mm_mullo_epi32(dcb, dcb), _mm_mullo_epi32(dcr, dcr));
+		__m128i m = _mm_cmplt_epi32(d2, tol2);
+		m = _mm_packs_epi16(_mm_packs_epi32(m, m), m);
+		vx_uint32 m4 = (vx_uint32)_mm_cvtsi128_si32(m);
+		memcpy(mask + x, &m4, n);
+	}
+}
+
+//! \brief A 3x3 erode (minimum) or dilate (maximum) of a row from its three neighboring rows with replicated borders.
+//  tmp must have room for width + 2 bytes.
+static void ChromaKeyMorphRow(const vx_uint8 * r0, const vx_uint8 * r1, const vx_uint8 * r2, vx_uint8 * dst, vx_uint8 * tmp, vx_uint32 width, bool dilate)
+{
+	vx_uint32 x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(r0 + x));
+		__m128i b = _mm_loadu_si128((const __m128i *)(r1 + x));
+		__m128i c = _mm_loadu_si128((const __m128i *)(r2 + x));
+		__m128i v = dilate ? _mm_max_epu8(_mm_max_epu8(a, b), c) : _mm_min_epu8(_mm_min_epu8(a, b), c);
+		_mm_storeu_si128((__m128i *)(tmp + 1 + x), v);
+	}
+	for (; x < width; x++) {
+		tmp[1 + x] = dilate ? std::max(std::max(r0[x], r1[x]), r2[x]) : std::min(std::min(r0[x], r1[x]), r2[x]);
+	}
+	tmp[0] = tmp[1];
+	tmp[width + 1] = tmp[width];
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(tmp + x));
+		__m128i b = _mm_loadu_si128((const __m128i *)(tmp + x + 1));
+		__m128i c = _mm_loadu_si128((const __m128i *)(tmp + x + 2));
+		__m128i v = dilate ? _mm_max_epu8(_mm_max_epu8(a, b), c) : _mm_min_epu8(_mm_min_epu8(a, b), c);
+		_mm_storeu_si128((__m128i *)(dst + x), v);
+	}
+	for (; x < width; x++) {
+		dst[x] = dilate ? std::max(std::max(tmp[x], tmp[x + 1]), tmp[x + 2]) : std::min(std::min(tmp[x], tmp[x + 1]), tmp[x + 2]);
+	}
+}
+
+//! \brief Merge a row: the chroma image pixel where the mask is 255 and the stitched pixel elsewhere.
+static void ChromaKeyMergeRow(const vx_uint8 * rgb, const vx_uint8 * chroma, const vx_uint8 * mask, vx_uint8 * dst, vx_uint32 width)
+{
+	const __m128i expand[3] = {
+		_mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5),
+		_mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10),
+		_mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15) };
+	const __m128i keyed = _mm_set1_epi8((char)0xFF);
+	vx_uint32 x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i m = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(mask + x)), keyed);
+		for (int i = 0; i < 3; i++) {
+			__m128i a = _mm_loadu_si128((const __m128i *)(rgb + x * 3 + i * 16));
+			__m128i b = _mm_loadu_si128((const __m128i *)(chroma + x * 3 + i * 16));
+			_mm_storeu_si128((__m128i *)(dst + x * 3 + i * 16), _mm_blendv_epi8(a, b, _mm_shuffle_epi8(m, expand[i])));
+		}
+	}
+	for (; x < width; x++) {
+		const vx_uint8 * src = (mask[x] == 255) ? chroma : rgb;
+		dst[x * 3 + 0] = src[x * 3 + 0];
+		dst[x * 3 + 1] = src[x * 3 + 1];
+		dst[x * 3 + 2] = src[x * 3 + 2];
+	}
+}
+
+//! \brief Get target affinity of the chroma key kernels.
+vx_uint32 GetChromaKeyTargetAffinity()
+{
+	char textBuffer[256];
+	int CHROMAKEY_MASK = 0, CHROMAKEY_MERGE = 0;
+	if (StitchGetEnvironmentVariable("CHROMAKEY_MASK", textBuffer, sizeof(textBuffer))) { CHROMAKEY_MASK = atoi(textBuffer); }
+	if (StitchGetEnvironmentVariable("CHROMAKEY_MERGE", textBuffer, sizeof(textBuffer))) { CHROMAKEY_MERGE = atoi(textBuffer); }
+	return (CHROMAKEY_MASK && CHROMAKEY_MERGE) ? AGO_TARGET_AFFINITY_CPU : AGO_TARGET_AFFINITY_GPU;
+}
+
 
 /***********************************************************************************************************************************
 Chroma Key Mask Generation -- CPU/GPU - Mask
@@ -266,41 +393,13 @@ static vx_status VX_CALLBACK chroma_key_mask_generation_kernel(vx_node node, con
 	ERROR_CHECK_STATUS(vxAccessImagePatch(output_mask_image, &output_mask_rect, plane, &output_mask_addr, &output_mask_image_ptr, VX_WRITE_ONLY));
 	vx_uint8 *output_mask_ptr = (vx_uint8*)output_mask_image_ptr;
 
-	int tola = 0, tolb = Tolerance;
-	vx_uint8 Red_g = 0, Green_g = 0, Blue_g = 0;
-
-	Red_g = (vx_uint8)(ChromaKey & 0x000000FF);
-	Green_g = (vx_uint8)((ChromaKey & 0x0000FF00) >> 8);
-	Blue_g = (vx_uint8)((ChromaKey & 0x00FF0000) >> 16);
-
-	int cb_key = (int)round(128 + -0.168736*Red_g - 0.331264*Green_g + 0.5*Blue_g);
-	int cr_key = (int)round(128 + 0.5*Red_g - 0.418688*Green_g - 0.081312*Blue_g);
-
-	for (vx_uint32 y = 0, pixelPosition = 0; y < input_height; y++){
-		for (vx_uint32 x = 0; x < input_width; x++, pixelPosition++){
-
-			double mask = 0;
-			vx_uint8 Red = 0, Green = 0, Blue = 0;
-			// get rgb values from the pixel
-			Red = input_ptr[(pixelPosition * 3) + 0];
-			Green = input_ptr[(pixelPosition * 3) + 1];
-			Blue = input_ptr[(pixelPosition * 3) + 2];
-
-			// convert rgb to yuv space
-			int cb_p = (int)round(128 + -0.168736*Red - 0.331264*Green + 0.5*Blue);
-			int cr_p = (int)round(128 + 0.5*Red - 0.418688*Green - 0.081312*Blue);
-				
-			// check for chroma key and set mask
-			double temp = sqrt((cb_key - cb_p)*(cb_key - cb_p) + (cr_key - cr_p)*(cr_key - cr_p));
-			if (temp < tola) { mask = 0.0; }
-			if (temp < tolb) { mask = ((temp - tola) / (tolb - tola)); }
-			else{ mask = 1.0; }
-			mask = 1 - mask;
-
-			if (mask){output_mask_ptr[pixelPosition] = 255;}
-			else{output_mask_ptr[pixelPosition] = 0;}
+	ChromaKeyParams k;
+	ChromaKeyInit(k, ChromaKey, Tolerance);
+	StitchParallelFor(input_height, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 y = start; y < end; y++) {
+			ChromaKeyMaskRow(k, input_ptr + y * input_addr.stride_y, output_mask_ptr + y * output_mask_addr.stride_y, input_width);
 		}
-	}
+	});
 
 	ERROR_CHECK_STATUS(vxCommitImagePatch(input_image, &input_rect, 0, &input_addr, input_image_ptr));
 	ERROR_CHECK_STATUS(vxCommitImagePatch(output_mask_image, &output_mask_rect, 0, &output_mask_addr, output_mask_image_ptr));
@@ -596,20 +695,12 @@ static vx_status VX_CALLBACK chroma_key_merge_kernel(vx_node node, const vx_refe
 	vx_uint8 * output_ptr = (vx_uint8*)output_image_ptr;
 
 
-	for (vx_uint32 y = 0, pixelPosition = 0; y < input_RGB_height; y++){
-		for (vx_uint32 x = 0; x < input_RGB_width; x++, pixelPosition++){
-			if (input_mask_ptr[pixelPosition] == 255){
-				output_ptr[pixelPosition * 3 + 0] = input_chroma_image_ptr[pixelPosition * 3 + 0];
-				output_ptr[pixelPosition * 3 + 1] = input_chroma_image_ptr[pixelPosition * 3 + 1];
-				output_ptr[pixelPosition * 3 + 2] = input_chroma_image_ptr[pixelPosition * 3 + 2];
-			}
-			else{
-				output_ptr[pixelPosition * 3 + 0] = input_RGB_image_ptr[pixelPosition * 3 + 0];
-				output_ptr[pixelPosition * 3 + 1] = input_RGB_image_ptr[pixelPosition * 3 + 1];
-				output_ptr[pixelPosition * 3 + 2] = input_RGB_image_ptr[pixelPosition * 3 + 2];
-			}
+	StitchParallelFor(input_RGB_height, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 y = start; y < end; y++) {
+			ChromaKeyMergeRow(input_RGB_image_ptr + y * input_RGB_addr.stride_y, input_chroma_image_ptr + y * input_chroma_addr.stride_y,
+				input_mask_ptr + y * input_mask_addr.stride_y, output_ptr + y * output_addr.stride_y, input_RGB_width);
 		}
-	}
+	});
 
 	ERROR_CHECK_STATUS(vxCommitImagePatch(input_RGB_image, &input_RGB_rect, 0, &input_RGB_addr, input_RGB_ptr));
 	ERROR_CHECK_STATUS(vxCommitImagePatch(input_chroma_image, &input_chroma_rect, 0, &input_chroma_addr, input_chroma_ptr));
@@ -647,6 +738,194 @@ vx_status chroma_key_merge_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_OUTPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 
 
+	// finalize and release kernel object
+	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
+	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
+
+	return VX_SUCCESS;
+}
+
+/***********************************************************************************************************************************
+
+Chroma Key Fused -- CPU - Mask + Erode/Dilate + Merge
+
+************************************************************************************************************************************/
+//! \brief The input validator callback.
+static vx_status VX_CALLBACK chroma_key_fused_input_validator(vx_node node, vx_uint32 index)
+{
+	vx_status status = VX_ERROR_INVALID_PARAMETERS;
+	// get reference for parameter at specified index
+	vx_reference ref = avxGetNodeParamRef(node, index);
+	ERROR_CHECK_OBJECT(ref);
+	// validate each parameter
+	if (index == 0 || index == 1 || index == 2)
+	{ // Chroma Key, Tolerance, and Erode/Dilate flag
+		vx_enum type = 0;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &type, sizeof(type)));
+		if (type == VX_TYPE_UINT32)
+			status = VX_SUCCESS;
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar*)&ref));
+	}
+	else if (index == 3 || index == 4)
+	{ // Image object
+		vx_int32 width_img = 0, height_img = 0;
+		vx_df_image format = VX_DF_IMAGE_VIRT;
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_WIDTH, &width_img, sizeof(width_img)));
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_HEIGHT, &height_img, sizeof(height_img)));
+		if (format != VX_DF_IMAGE_RGB)
+			status = VX_ERROR_INVALID_FORMAT;
+		else if (width_img < 0)
+			status = VX_ERROR_INVALID_DIMENSION;
+		else if (height_img != (width_img >> 1))
+			status = VX_ERROR_INVALID_DIMENSION;
+		else
+			status = VX_SUCCESS;
+		ERROR_CHECK_STATUS(vxReleaseImage((vx_image*)&ref));
+	}
+	return status;
+}
+
+//! \brief The output validator callback.
+static vx_status VX_CALLBACK chroma_key_fused_output_validator(vx_node node, vx_uint32 index, vx_meta_format meta)
+{
+	vx_status status = VX_ERROR_INVALID_PARAMETERS;
+	if (index == 5)
+	{ // Image object
+		vx_int32 width_img = 0, height_img = 0;
+		vx_df_image format = VX_DF_IMAGE_VIRT;
+		vx_image image = (vx_image)avxGetNodeParamRef(node, index);
+		ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+		ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_WIDTH, &width_img, sizeof(width_img)));
+		ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_HEIGHT, &height_img, sizeof(height_img)));
+		if (format != VX_DF_IMAGE_RGB)
+			status = VX_ERROR_INVALID_FORMAT;
+		else if (width_img < 0)
+			status = VX_ERROR_INVALID_DIMENSION;
+		else if (height_img != (width_img >> 1))
+			status = VX_ERROR_INVALID_DIMENSION;
+		else
+		{
+			// set output image data
+			ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(meta, VX_IMAGE_ATTRIBUTE_WIDTH, &width_img, sizeof(width_img)));
+			ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(meta, VX_IMAGE_ATTRIBUTE_HEIGHT, &height_img, sizeof(height_img)));
+			ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(meta, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+			status = VX_SUCCESS;
+		}
+		ERROR_CHECK_STATUS(vxReleaseImage(&image));
+	}
+	return status;
+}
+
+//! \brief The kernel target support callback.
+static vx_status VX_CALLBACK chroma_key_fused_query_target_support(vx_graph graph, vx_node node,
+	vx_bool use_opencl_1_2,              // [input]  false: OpenCL driver is 2.0+; true: OpenCL driver is 1.2
+	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
+	)
+{
+	supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
+	return VX_SUCCESS;
+}
+
+//! \brief The kernel execution on the CPU.
+//  Each thread works on a band of rows in a single pass: the mask rows y-2..y+2 and the eroded rows y-1..y+1
+//  needed for output row y are kept in rings of four rows, so each mask and eroded row is computed once.
+static vx_status VX_CALLBACK chroma_key_fused_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
+{
+	vx_uint32 ChromaKey = 0, Tolerance = 0, ErodeDilate = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &ChromaKey));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &Tolerance));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[2], &ErodeDilate));
+	vx_image input_RGB_image = (vx_image)parameters[3];
+	vx_image input_chroma_image = (vx_image)parameters[4];
+	vx_image output_image = (vx_image)parameters[5];
+	vx_uint32 width = 0, height = 0;
+	ERROR_CHECK_STATUS(vxQueryImage(input_RGB_image, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_RGB_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+	vx_rectangle_t rect = { 0, 0, width, height };
+	vx_imagepatch_addressing_t input_RGB_addr, input_chroma_addr, output_addr;
+	void * input_RGB_ptr = nullptr, * input_chroma_ptr = nullptr, * output_ptr = nullptr;
+	ERROR_CHECK_STATUS(vxAccessImagePatch(input_RGB_image, &rect, 0, &input_RGB_addr, &input_RGB_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(input_chroma_image, &rect, 0, &input_chroma_addr, &input_chroma_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(output_image, &rect, 0, &output_addr, &output_ptr, VX_WRITE_ONLY));
+
+	ChromaKeyParams k;
+	ChromaKeyInit(k, ChromaKey, Tolerance);
+	StitchParallelFor(height, [&](vx_uint32 start, vx_uint32 end) {
+		auto rgbRow = [&](vx_int32 y) { return (const vx_uint8 *)input_RGB_ptr + y * input_RGB_addr.stride_y; };
+		auto mergeRow = [&](vx_int32 y, const vx_uint8 * mask) {
+			ChromaKeyMergeRow(rgbRow(y), (const vx_uint8 *)input_chroma_ptr + y * input_chroma_addr.stride_y, mask,
+				(vx_uint8 *)output_ptr + y * output_addr.stride_y, width);
+		};
+		if (!ErodeDilate) {
+			std::vector<vx_uint8> mask(width);
+			for (vx_uint32 y = start; y < end; y++) {
+				ChromaKeyMaskRow(k, rgbRow(y), mask.data(), width);
+				mergeRow(y, mask.data());
+			}
+			return;
+		}
+		// buffers: 4 mask rows, 4 eroded rows, 1 opened row, and the morphology scratch row
+		std::vector<vx_uint8> buffer(width * 9 + 2);
+		vx_uint8 * maskRing = buffer.data(), * erodeRing = maskRing + width * 4;
+		vx_uint8 * opened = erodeRing + width * 4, * tmp = opened + width;
+		vx_int32 maskTag[4] = { -1, -1, -1, -1 }, erodeTag[4] = { -1, -1, -1, -1 };
+		auto clampRow = [&](vx_int32 y) { return std::min(std::max(y, 0), (vx_int32)height - 1); };
+		auto getMask = [&](vx_int32 y) {
+			vx_uint8 * row = maskRing + (y & 3) * width;
+			if (maskTag[y & 3] != y) {
+				ChromaKeyMaskRow(k, rgbRow(y), row, width);
+				maskTag[y & 3] = y;
+			}
+			return (const vx_uint8 *)row;
+		};
+		auto getErode = [&](vx_int32 y) {
+			vx_uint8 * row = erodeRing + (y & 3) * width;
+			if (erodeTag[y & 3] != y) {
+				const vx_uint8 * r0 = getMask(clampRow(y - 1)), * r1 = getMask(y), * r2 = getMask(clampRow(y + 1));
+				ChromaKeyMorphRow(r0, r1, r2, row, tmp, width, false);
+				erodeTag[y & 3] = y;
+			}
+			return (const vx_uint8 *)row;
+		};
+		for (vx_int32 y = (vx_int32)start; y < (vx_int32)end; y++) {
+			const vx_uint8 * r0 = getErode(clampRow(y - 1)), * r1 = getErode(y), * r2 = getErode(clampRow(y + 1));
+			ChromaKeyMorphRow(r0, r1, r2, opened, tmp, width, true);
+			mergeRow(y, opened);
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitImagePatch(input_RGB_image, &rect, 0, &input_RGB_addr, input_RGB_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(input_chroma_image, &rect, 0, &input_chroma_addr, input_chroma_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(output_image, &rect, 0, &output_addr, output_ptr));
+
+	return VX_SUCCESS;
+}
+
+//! \brief The kernel publisher.
+vx_status chroma_key_fused_publish(vx_context context)
+{
+	// add kernel to the context with callbacks
+	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.chroma_key_fused",
+		AMDOVX_KERNEL_STITCHING_CHROMA_KEY_FUSED,
+		chroma_key_fused_kernel,
+		6,
+		chroma_key_fused_input_validator,
+		chroma_key_fused_output_validator,
+		nullptr,
+		nullptr);
+	ERROR_CHECK_OBJECT(kernel);
+	amd_kernel_query_target_support_f query_target_support_f = chroma_key_fused_query_target_support;
+	ERROR_CHECK_STATUS(vxSetKernelAttribute(kernel, VX_KERNEL_ATTRIBUTE_AMD_QUERY_TARGET_SUPPORT, &query_target_support_f, sizeof(query_target_support_f)));
+
+	// set kernel parameters
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 0, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 1, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 4, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 5, VX_OUTPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
 	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
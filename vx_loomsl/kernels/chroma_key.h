@@ -30,5 +30,11 @@ THE SOFTWARE.
 //! \brief The Chroma Key kernel registration functions.
 vx_status chroma_key_merge_publish(vx_context context);
 vx_status chroma_key_mask_generation_publish(vx_context context);
+vx_status chroma_key_fused_publish(vx_context context);
+
+//////////////////////////////////////////////////////////////////////
+//! \brief Get target affinity of chroma key: CPU if CHROMAKEY_MASK and CHROMAKEY_MERGE environment variables are non-zero, GPU otherwise.
+//  The stitch graph uses the CPU-only fused chroma key kernel in place of separate mask/erode/dilate/merge nodes when this is CPU.
+vx_uint32 GetChromaKeyTargetAffinity();
 
 #endif //__CHROMA_KEY_H__
\ No newline at end of file
@@ -32,10 +32,11 @@ static vx_status VX_CALLBACK color_convert_input_validator(vx_node node, vx_uint
 	ERROR_CHECK_OBJECT(ref);
 	// validate each parameter
 	if (index == 0)
-	{ // image of format UYVY or Y210 or Y216
+	{ // image of format UYVY or YUYV or Y210 or Y216 or NV12 or IYUV or RGB
 		vx_df_image format = VX_DF_IMAGE_VIRT;
 		ERROR_CHECK_STATUS(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
-		if (format == VX_DF_IMAGE_UYVY || format == VX_DF_IMAGE_YUYV || format == VX_DF_IMAGE_Y210_AMD || format == VX_DF_IMAGE_Y216_AMD || format == VX_DF_IMAGE_RGB) {
+		if (format == VX_DF_IMAGE_UYVY || format == VX_DF_IMAGE_YUYV || format == VX_DF_IMAGE_Y210_AMD || format == VX_DF_IMAGE_Y216_AMD ||
+			format == VX_DF_IMAGE_NV12 || format == VX_DF_IMAGE_IYUV || format == VX_DF_IMAGE_RGB) {
 			status = VX_SUCCESS;
 		}
 		else {
@@ -76,7 +77,8 @@ static vx_status VX_CALLBACK color_convert_output_validator(vx_node node, vx_uin
 			vxAddLogEntry((vx_reference)node, status, "ERROR: color_convert doesn't support input & output image with different dimensions\n");
 			return status;
 		}
-		if ((input_format == VX_DF_IMAGE_UYVY || input_format == VX_DF_IMAGE_YUYV || input_format == VX_DF_IMAGE_Y210_AMD || input_format == VX_DF_IMAGE_Y216_AMD) && output_format != VX_DF_IMAGE_RGB && output_format != VX_DF_IMAGE_RGBX) {
+		if ((input_format == VX_DF_IMAGE_UYVY || input_format == VX_DF_IMAGE_YUYV || input_format == VX_DF_IMAGE_Y210_AMD || input_format == VX_DF_IMAGE_Y216_AMD ||
+			 input_format == VX_DF_IMAGE_NV12 || input_format == VX_DF_IMAGE_IYUV) && output_format != VX_DF_IMAGE_RGB && output_format != VX_DF_IMAGE_RGBX) {
 			// pick RGBX as default
 			output_format = VX_DF_IMAGE_RGBX;
 		}
@@ -99,7 +101,15 @@ static vx_status VX_CALLBACK color_convert_query_target_support(vx_graph graph,
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	supported_target_affinity = GetColorConvertTargetAffinity();
+	// NV12 and IYUV inputs are converted on CPU only
+	vx_image image = (vx_image)avxGetNodeParamRef(node, 0);
+	ERROR_CHECK_OBJECT(image);
+	vx_df_image input_format = VX_DF_IMAGE_VIRT;
+	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
+	ERROR_CHECK_STATUS(vxReleaseImage(&image));
+	if (input_format == VX_DF_IMAGE_NV12 || input_format == VX_DF_IMAGE_IYUV)
+		supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
 	return VX_SUCCESS;
 }
 
@@ -514,10 +524,241 @@ static vx_status VX_CALLBACK color_convert_opencl_codegen(
 	return VX_SUCCESS;
 }
 
+//////////////////////////////////////////////////////////////////////
+// CPU color conversion: uses the same coefficients and arithmetic as the OpenCL code and
+// processes 4 pixels per SSE iteration, with rows split across all cores
+
+//! \brief The YUV to RGB coefficients: R = y + cRv*v, G = y + cGu*u + cGv*v, B = y + cBu*u,
+//  where y = Y*yScale + yOffset and u/v = U/V*cScale + cOffset. RGBX output stores y in X.
+struct ColorConvertYuvCoeff {
+	float cRv, cGu, cGv, cBu;
+	float yScale, yOffset, cScale, cOffset;
+};
+
+//! \brief Get target affinity: CPU if COLOR_CONVERT_TARGET environment variable is non-zero, GPU otherwise.
+vx_uint32 GetColorConvertTargetAffinity()
+{
+	char textBuffer[256];
+	int COLOR_CONVERT_TARGET = 0;
+	if (StitchGetEnvironmentVariable("COLOR_CONVERT_TARGET", textBuffer, sizeof(textBuffer))) { COLOR_CONVERT_TARGET = atoi(textBuffer); }
+	return COLOR_CONVERT_TARGET ? AGO_TARGET_AFFINITY_CPU : AGO_TARGET_AFFINITY_GPU;
+}
+
+//! \brief Load upto 16 bytes into a vector (zero filled).
+static inline __m128i ColorConvertLoad(const vx_uint8 * src, vx_uint32 size)
+{
+	vx_uint8 buf[16] = { 0 };
+	memcpy(buf, src, size);
+	return _mm_loadu_si128((const __m128i *)buf);
+}
+
+//! \brief Get the Y, U, and V values of pixels x..x+3 of a row (pixels beyond width are zero).
+//  srcY is the packed row for UYVY/YUYV/Y210/Y216, srcU is the UV row for NV12.
+static inline void ColorConvertLoadYUV(vx_df_image format, const vx_uint8 * srcY, const vx_uint8 * srcU, const vx_uint8 * srcV,
+	vx_uint32 x, vx_uint32 n, __m128& Y, __m128& U, __m128& V)
+{
+	static const __m128i maskUYVY[3] = {
+		_mm_setr_epi8(1, -1, -1, -1, 3, -1, -1, -1, 5, -1, -1, -1, 7, -1, -1, -1),
+		_mm_setr_epi8(0, -1, -1, -1, 0, -1, -1, -1, 4, -1, -1, -1, 4, -1, -1, -1),
+		_mm_setr_epi8(2, -1, -1, -1, 2, -1, -1, -1, 6, -1, -1, -1, 6, -1, -1, -1) };
+	static const __m128i maskYUYV[3] = {
+		_mm_setr_epi8(0, -1, -1, -1, 2, -1, -1, -1, 4, -1, -1, -1, 6, -1, -1, -1),
+		_mm_setr_epi8(1, -1, -1, -1, 1, -1, -1, -1, 5, -1, -1, -1, 5, -1, -1, -1),
+		_mm_setr_epi8(3, -1, -1, -1, 3, -1, -1, -1, 7, -1, -1, -1, 7, -1, -1, -1) };
+	static const __m128i maskNV12[3] = { // Y0..Y3 U0 V0 U1 V1
+		_mm_setr_epi8(0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1),
+		_mm_setr_epi8(4, -1, -1, -1, 4, -1, -1, -1, 6, -1, -1, -1, 6, -1, -1, -1),
+		_mm_setr_epi8(5, -1, -1, -1, 5, -1, -1, -1, 7, -1, -1, -1, 7, -1, -1, -1) };
+	static const __m128i maskIYUV[3] = { // Y0..Y3 U0 U1 V0 V1
+		_mm_setr_epi8(0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1),
+		_mm_setr_epi8(4, -1, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1, 5, -1, -1, -1),
+		_mm_setr_epi8(6, -1, -1, -1, 6, -1, -1, -1, 7, -1, -1, -1, 7, -1, -1, -1) };
+	// Y210/Y216 words: U0 Y0 V0 Y1 U1 Y2 V1 Y3, used as lowByte + highByte/256 like the OpenCL code
+	static const __m128i maskY2xxLo[3] = {
+		_mm_setr_epi8(2, -1, -1, -1, 6, -1, -1, -1, 10, -1, -1, -1, 14, -1, -1, -1),
+		_mm_setr_epi8(0, -1, -1, -1, 0, -1, -1, -1, 8, -1, -1, -1, 8, -1, -1, -1),
+		_mm_setr_epi8(4, -1, -1, -1, 4, -1, -1, -1, 12, -1, -1, -1, 12, -1, -1, -1) };
+	static const __m128i maskY2xxHi[3] = {
+		_mm_setr_epi8(3, -1, -1, -1, 7, -1, -1, -1, 11, -1, -1, -1, 15, -1, -1, -1),
+		_mm_setr_epi8(1, -1, -1, -1, 1, -1, -1, -1, 9, -1, -1, -1, 9, -1, -1, -1),
+		_mm_setr_epi8(5, -1, -1, -1, 5, -1, -1, -1, 13, -1, -1, -1, 13, -1, -1, -1) };
+	const __m128i * mask = maskUYVY;
+	vx_uint32 nc = (n + 1) & ~1; // pixels covered by the chroma samples
+	__m128i L;
+	if (format == VX_DF_IMAGE_Y210_AMD || format == VX_DF_IMAGE_Y216_AMD) {
+		L = ColorConvertLoad(srcY + x * 4, nc * 4);
+		const __m128 scale = _mm_set1_ps(0.00390625f);
+		Y = _mm_add_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(L, maskY2xxLo[0])), _mm_mul_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(L, maskY2xxHi[0])), scale));
+		U = _mm_add_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(L, maskY2xxLo[1])), _mm_mul_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(L, maskY2xxHi[1])), scale));
+		V = _mm_add_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(L, maskY2xxLo[2])), _mm_mul_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(L, maskY2xxHi[2])), scale));
+		return;
+	}
+	else if (format == VX_DF_IMAGE_UYVY || format == VX_DF_IMAGE_YUYV) {
+		L = ColorConvertLoad(srcY + x * 2, nc * 2);
+		if (format == VX_DF_IMAGE_YUYV) mask = maskYUYV;
+	}
+	else if (format == VX_DF_IMAGE_NV12) {
+		vx_uint32 y4 = 0, uv4 = 0;
+		memcpy(&y4, srcY + x, n);
+		memcpy(&uv4, srcU + x, nc);
+		L = _mm_insert_epi32(_mm_cvtsi32_si128(y4), uv4, 1);
+		mask = maskNV12;
+	}
+	else { // VX_DF_IMAGE_IYUV
+		vx_uint32 y4 = 0; vx_uint16 u2 = 0, v2 = 0;
+		memcpy(&y4, srcY + x, n);
+		memcpy(&u2, srcU + (x >> 1), nc >> 1);
+		memcpy(&v2, srcV + (x >> 1), nc >> 1);
+		L = _mm_insert_epi32(_mm_cvtsi32_si128(y4), u2 | ((vx_uint32)v2 << 16), 1);
+		mask = maskIYUV;
+	}
+	Y = _mm_cvtepi32_ps(_mm_shuffle_epi8(L, mask[0]));
+	U = _mm_cvtepi32_ps(_mm_shuffle_epi8(L, mask[1]));
+	V = _mm_cvtepi32_ps(_mm_shuffle_epi8(L, mask[2]));
+}
+
+//! \brief Convert a row of YUV pixels into RGB or RGBX.
+static void ColorConvertYUVToRGBRow(vx_df_image input_format, vx_df_image output_format, const ColorConvertYuvCoeff& k,
+	const vx_uint8 * srcY, const vx_uint8 * srcU, const vx_uint8 * srcV, vx_uint8 * dst, vx_uint32 width)
+{
+	const __m128 cRv = _mm_set1_ps(k.cRv), cGu = _mm_set1_ps(k.cGu), cGv = _mm_set1_ps(k.cGv), cBu = _mm_set1_ps(k.cBu);
+	const __m128 yScale = _mm_set1_ps(k.yScale), yOffset = _mm_set1_ps(k.yOffset);
+	const __m128 cScale = _mm_set1_ps(k.cScale), cOffset = _mm_set1_ps(k.cOffset);
+	const __m128i shuffleRGBX = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	const __m128i shuffleRGB = _mm_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+	vx_uint32 pixelSize = (output_format == VX_DF_IMAGE_RGBX) ? 4 : 3;
+	for (vx_uint32 x = 0; x < width; x += 4) {
+		vx_uint32 n = std::min(4u, width - x);
+		__m128 Y, U, V;
+		ColorConvertLoadYUV(input_format, srcY, srcU, srcV, x, n, Y, U, V);
+		__m128 y = _mm_add_ps(_mm_mul_ps(Y, yScale), yOffset);
+		__m128 u = _mm_add_ps(_mm_mul_ps(U, cScale), cOffset);
+		__m128 v = _mm_add_ps(_mm_mul_ps(V, cScale), cOffset);
+		__m128 r = _mm_add_ps(_mm_mul_ps(cRv, v), y);
+		__m128 g = _mm_add_ps(_mm_mul_ps(cGv, v), _mm_add_ps(_mm_mul_ps(cGu, u), y));
+		__m128 b = _mm_add_ps(_mm_mul_ps(cBu, u), y);
+		// round to nearest even with saturation like amd_pack, then interleave
+		__m128i rg = _mm_packs_epi32(_mm_cvtps_epi32(r), _mm_cvtps_epi32(g));
+		__m128i bx = _mm_packs_epi32(_mm_cvtps_epi32(b), _mm_cvtps_epi32(y));
+		__m128i rgbx = _mm_packus_epi16(rg, bx);
+		vx_uint8 * out = dst + x * pixelSize;
+		if (pixelSize == 4) {
+			rgbx = _mm_shuffle_epi8(rgbx, shuffleRGBX);
+			if (n == 4) _mm_storeu_si128((__m128i *)out, rgbx);
+			else { vx_uint8 buf[16]; _mm_storeu_si128((__m128i *)buf, rgbx); memcpy(out, buf, n * 4); }
+		}
+		else {
+			vx_uint8 buf[16];
+			_mm_storeu_si128((__m128i *)buf, _mm_shuffle_epi8(rgbx, shuffleRGB));
+			memcpy(out, buf, n * 3);
+		}
+	}
+}
+
+//! \brief Convert a row of RGB pixels into UYVY or YUYV using the BT709 coefficients of the OpenCL code.
+//  The chroma of each pixel pair is taken from the even pixel.
+static void ColorConvertRGBToYUVRow(vx_df_image output_format, const vx_uint8 * src, vx_uint8 * dst, vx_uint32 width)
+{
+	const float cY[3] = { 0.2126f, 0.7152f, 0.0722f }, cU[3] = { -0.1146f, -0.3854f, 0.5f }, cV[3] = { 0.5f, -0.4542f, -0.0458f };
+	__m128 c[3], offset;
+	__m128i mask[3];
+	if (output_format == VX_DF_IMAGE_UYVY) { // U Y0 V Y1 from pixels: even even even odd
+		for (int i = 0; i < 3; i++) c[i] = _mm_setr_ps(cU[i], cY[i], cV[i], cY[i]);
+		for (int i = 0; i < 3; i++) mask[i] = _mm_setr_epi8(i, -1, -1, -1, i, -1, -1, -1, i, -1, -1, -1, i + 3, -1, -1, -1);
+		offset = _mm_setr_ps(128.0f, 0.0f, 128.0f, 0.0f);
+	}
+	else { // Y0 U Y1 V from pixels: even even odd even
+		for (int i = 0; i < 3; i++) c[i] = _mm_setr_ps(cY[i], cU[i], cY[i], cV[i]);
+		for (int i = 0; i < 3; i++) mask[i] = _mm_setr_epi8(i, -1, -1, -1, i, -1, -1, -1, i + 3, -1, -1, -1, i, -1, -1, -1);
+		offset = _mm_setr_ps(0.0f, 128.0f, 0.0f, 128.0f);
+	}
+	for (vx_uint32 x = 0; x + 1 < width; x += 2) {
+		__m128i L = ColorConvertLoad(src + x * 3, 6);
+		__m128 f = _mm_mul_ps(c[0], _mm_cvtepi32_ps(_mm_shuffle_epi8(L, mask[0])));
+		f = _mm_add_ps(f, _mm_mul_ps(c[1], _mm_cvtepi32_ps(_mm_shuffle_epi8(L, mask[1]))));
+		f = _mm_add_ps(f, _mm_mul_ps(c[2], _mm_cvtepi32_ps(_mm_shuffle_epi8(L, mask[2]))));
+		f = _mm_add_ps(f, offset);
+		__m128i i32 = _mm_cvtps_epi32(f);
+		__m128i u8 = _mm_packus_epi16(_mm_packs_epi32(i32, i32), i32);
+		vx_uint32 pair = (vx_uint32)_mm_cvtsi128_si32(u8);
+		memcpy(dst + x * 2, &pair, 4);
+	}
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK color_convert_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_SUPPORTED;
+	vx_image input_image = (vx_image)parameters[0];
+	vx_image output_image = (vx_image)parameters[1];
+	vx_uint32 width = 0, height = 0;
+	vx_df_image input_format = VX_DF_IMAGE_VIRT, output_format = VX_DF_IMAGE_VIRT;
+	vx_channel_range_e input_channel_range = VX_CHANNEL_RANGE_FULL;
+	vx_color_space_e input_color_space = VX_COLOR_SPACE_BT709;
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_RANGE, &input_channel_range, sizeof(input_channel_range)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_SPACE, &input_color_space, sizeof(input_color_space)));
+	ERROR_CHECK_STATUS(vxQueryImage(output_image, VX_IMAGE_ATTRIBUTE_FORMAT, &output_format, sizeof(output_format)));
+
+	// access input planes and output image
+	vx_uint32 num_planes = (input_format == VX_DF_IMAGE_IYUV) ? 3 : ((input_format == VX_DF_IMAGE_NV12) ? 2 : 1);
+	vx_rectangle_t rect = { 0, 0, width, height };
+	vx_imagepatch_addressing_t input_addr[3], output_addr;
+	void * input_ptr[3] = { nullptr, nullptr, nullptr }, * output_ptr = nullptr;
+	for (vx_uint32 plane = 0; plane < num_planes; plane++) {
+		ERROR_CHECK_STATUS(vxAccessImagePatch(input_image, &rect, plane, &input_addr[plane], &input_ptr[plane], VX_READ_ONLY));
+	}
+	ERROR_CHECK_STATUS(vxAccessImagePatch(output_image, &rect, 0, &output_addr, &output_ptr, VX_WRITE_ONLY));
+
+	if (input_format == VX_DF_IMAGE_RGB) {
+		StitchParallelFor(height, [&](vx_uint32 start, vx_uint32 end) {
+			for (vx_uint32 y = start; y < end; y++) {
+				ColorConvertRGBToYUVRow(output_format, (const vx_uint8 *)input_ptr[0] + y * input_addr[0].stride_y,
+					(vx_uint8 *)output_ptr + y * output_addr.stride_y, width);
+			}
+		});
+	}
+	else {
+		ColorConvertYuvCoeff k;
+		if (input_format == VX_DF_IMAGE_Y210_AMD || input_format == VX_DF_IMAGE_Y216_AMD) {
+			if (input_format == VX_DF_IMAGE_Y210_AMD) {
+				k.cRv = 1.57943176f; k.cGu = -0.18785088f; k.cGv = -0.46947676f; k.cBu = 1.86105765f;
+			}
+			else {
+				k.cRv = 1.5809516f; k.cGu = -0.18803164f; k.cGv = -0.46992852f; k.cBu = 1.86284844f;
+			}
+			k.yScale = 1.0f; k.yOffset = 0.0f; k.cScale = 1.0f; k.cOffset = -128.0f;
+		}
+		else {
+			if (input_color_space == VX_COLOR_SPACE_BT601_525 || input_color_space == VX_COLOR_SPACE_BT601_625) {
+				k.cRv = 1.4030f; k.cGu = -0.3440f; k.cGv = -0.7140f; k.cBu = 1.7730f;
+			}
+			else { // VX_COLOR_SPACE_BT709
+				k.cRv = 1.5748f; k.cGu = -0.1873f; k.cGv = -0.4681f; k.cBu = 1.8556f;
+			}
+			if (input_channel_range == VX_CHANNEL_RANGE_RESTRICTED) {
+				k.yScale = 256.0f / 219.0f; k.yOffset = -16.0f * 256.0f / 219.0f; k.cScale = 256.0f / 224.0f; k.cOffset = -128.0f * 256.0f / 224.0f;
+			}
+			else { // VX_CHANNEL_RANGE_FULL
+				k.yScale = 1.0f; k.yOffset = 0.0f; k.cScale = 1.0f; k.cOffset = -128.0f;
+			}
+		}
+		StitchParallelFor(height, [&](vx_uint32 start, vx_uint32 end) {
+			for (vx_uint32 y = start; y < end; y++) {
+				const vx_uint8 * srcY = (const vx_uint8 *)input_ptr[0] + y * input_addr[0].stride_y;
+				const vx_uint8 * srcU = (num_planes > 1) ? (const vx_uint8 *)input_ptr[1] + (y >> 1) * input_addr[1].stride_y : nullptr;
+				const vx_uint8 * srcV = (num_planes > 2) ? (const vx_uint8 *)input_ptr[2] + (y >> 1) * input_addr[2].stride_y : nullptr;
+				ColorConvertYUVToRGBRow(input_format, output_format, k, srcY, srcU, srcV, (vx_uint8 *)output_ptr + y * output_addr.stride_y, width);
+			}
+		});
+	}
+
+	for (vx_uint32 plane = 0; plane < num_planes; plane++) {
+		ERROR_CHECK_STATUS(vxCommitImagePatch(input_image, &rect, plane, &input_addr[plane], input_ptr[plane]));
+	}
+	ERROR_CHECK_STATUS(vxCommitImagePatch(output_image, &rect, 0, &output_addr, output_ptr));
+	return VX_SUCCESS;
 }
 
 //! \brief The kernel publisher.
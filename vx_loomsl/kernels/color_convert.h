@@ -30,4 +30,9 @@ THE SOFTWARE.
 //! \brief The kernel registration functions.
 vx_status color_convert_publish(vx_context context);
 
+//////////////////////////////////////////////////////////////////////
+//! \brief Get target affinity of color_convert: CPU if COLOR_CONVERT_TARGET environment variable is non-zero, GPU otherwise.
+//  NV12 and IYUV inputs are always converted on CPU.
+vx_uint32 GetColorConvertTargetAffinity();
+
 #endif //__COLOR_CONVERT_H__
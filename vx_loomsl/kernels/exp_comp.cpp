@@ -23,7 +23,7 @@ THE SOFTWARE.
 #define _CRT_SECURE_NO_WARNINGS
 #include "exp_comp.h"
 #include "exposure_compensation.h"
-#include <thread>
+#include "profiler.h"
 #define USE_GAMMA_CORRECTION		1
 static const float Gamma = 2.2f;
 static int g_Gamma2Linear[256];
@@ -606,20 +606,46 @@ CExpCompensator::CExpCompensator(int rows, int columns)
 {
 	m_NMat = nullptr;
 	m_IMat = nullptr;
-	m_AMat = nullptr;
 	m_Gains = nullptr;
 	m_block_gain_buf = nullptr;
 	m_pblockgainInfo = nullptr;
+	m_threadPool = nullptr;
+	m_pIMat = nullptr;
+	m_pNMat = nullptr;
+	m_solveSize = m_solveMatSize = 0;
+	m_solveWork = m_solveFactor = m_solveRhs = m_solveTmp = nullptr;
+	m_solveGains = m_solveOut = nullptr;
+	m_solveHasGains = false;
 	if (rows && columns){
 		m_pIMat = new vx_uint32[rows*columns];
 		m_pNMat = new vx_uint32[rows*columns];
+		m_solveMatSize = rows*columns;
+		// gain solver buffers: columns is the number of images
+		allocate_solve_buffers(columns);
 	}
 }
 
+void CExpCompensator::allocate_solve_buffers(vx_uint32 num)
+{
+	m_solveSize = num;
+	m_solveWork = new vx_float64[num*num];
+	m_solveFactor = new vx_float64[num*num];
+	m_solveRhs = new vx_float64[num];
+	m_solveTmp = new vx_float64[num];
+	m_solveGains = new vx_float32[3 * num];
+	m_solveOut = new vx_float32[3 * num];
+}
+
 CExpCompensator::~CExpCompensator()
 {
 	if (m_pIMat) delete[] m_pIMat;
 	if (m_pNMat) delete[] m_pNMat;
+	if (m_solveWork) delete[] m_solveWork;
+	if (m_solveFactor) delete[] m_solveFactor;
+	if (m_solveRhs) delete[] m_solveRhs;
+	if (m_solveTmp) delete[] m_solveTmp;
+	if (m_solveGains) delete[] m_solveGains;
+	if (m_solveOut) delete[] m_solveOut;
 }
 
 vx_status CExpCompensator::Initialize(vx_node node, vx_float32 alpha, vx_float32 beta, vx_array valid_roi, vx_image input, vx_image output, vx_array block_gains, vx_int32 channel)
@@ -671,6 +697,16 @@ vx_status CExpCompensator::Initialize(vx_node node, vx_float32 alpha, vx_float32
 	}
 	ERROR_CHECK_STATUS(vxCommitArrayRange(m_valid_roi, 0, capacity, base_array));
 
+	// split the valid rectangles into row tiles for the worker pool
+	m_applyTiles.clear();
+	for (i = 0; i < m_numImages; i++){
+		for (vx_uint32 y = mValidRect[i].start_y; y < mValidRect[i].end_y; y = (y + EXPCOMP_APPLY_TILE_HEIGHT) & ~(EXPCOMP_APPLY_TILE_HEIGHT - 1)){
+			expcomp_apply_tile tile = { i, y, std::min((y + EXPCOMP_APPLY_TILE_HEIGHT) & ~(EXPCOMP_APPLY_TILE_HEIGHT - 1), mValidRect[i].end_y) };
+			m_applyTiles.push_back(tile);
+		}
+	}
+	m_threadPool = new StitchThreadPool();
+
 	if (block_gains){
 		m_blockgainsStride = (m_width + 31) >> 5;
 		blockgains_bufsize = m_blockgainsStride*((m_height + 31) >> 5);
@@ -686,7 +722,6 @@ vx_status CExpCompensator::Initialize(vx_node node, vx_float32 alpha, vx_float32
 	m_IMat = new vx_float32*[m_numImages];
 	m_IMatG = new vx_float32*[m_numImages];
 	m_IMatB = new vx_float32*[m_numImages];
-	m_AMat = new vx_float64*[m_numImages];
 	m_Gains = new vx_float32[m_numImages];
 	m_GainsG = new vx_float32[m_numImages];
 	m_GainsB = new vx_float32[m_numImages];
@@ -695,9 +730,9 @@ vx_status CExpCompensator::Initialize(vx_node node, vx_float32 alpha, vx_float32
 		m_IMat[i] = new vx_float32[m_numImages];
 		m_IMatG[i] = new vx_float32[m_numImages];
 		m_IMatB[i] = new vx_float32[m_numImages];
-		m_AMat[i] = new vx_float64[m_numImages + 1];	// enough for the augmented matrix [a|b]
-		memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));
 	}
+	if (!m_solveWork)
+		allocate_solve_buffers(m_numImages);
 	memset(&m_Gains[0], 0x00000001, m_numImages*sizeof(vx_float32));
 	m_node = node;
 	ERROR_CHECK_STATUS(vxReleaseArray((vx_array *)&valid_roi));
@@ -723,15 +758,15 @@ vx_status CExpCompensator::DeInitialize()
 	{
 		if (m_NMat[i]) delete[] m_NMat[i];
 		if (m_IMat[i]) delete[] m_IMat[i];
-		if (m_AMat[i]) delete[] m_AMat[i];
 		if (m_IMatG[i]) delete[] m_IMatG[i];
 		if (m_IMatB[i]) delete[] m_IMatB[i];
 	}
 	if (m_block_gain_buf) delete[] m_block_gain_buf;
 	if (m_pblockgainInfo) delete[] m_pblockgainInfo;
+	if (m_threadPool) delete m_threadPool;
+	m_threadPool = nullptr;
 	delete[] m_NMat;
 	delete[] m_IMat;
-	delete[] m_AMat;
 	delete[] m_IMatG;
 	delete[] m_IMatB;
 	delete[] m_Gains;
@@ -740,6 +775,25 @@ vx_status CExpCompensator::DeInitialize()
 	return VX_SUCCESS;
 }
 
+vx_uint64 CExpCompensator::GetHostMemorySize() const
+{
+	// gain solver buffers
+	vx_uint64 n = m_solveSize, size = 0;
+	if (m_pIMat) size += 2 * (vx_uint64)m_solveMatSize * sizeof(vx_uint32);
+	if (m_solveWork) size += (2 * n * n + 2 * n) * sizeof(vx_float64) + 6 * n * sizeof(vx_float32);
+	// gain matrices, gains, apply tiles, and block gain buffers of Initialize
+	if (m_NMat) {
+		vx_uint64 m = m_numImages;
+		size += m * m * (sizeof(vx_uint32) + 3 * sizeof(vx_float32)) + 3 * m * sizeof(vx_float32);
+		size += m_applyTiles.capacity() * sizeof(expcomp_apply_tile);
+		if (m_block_gain_buf) {
+			vx_uint64 blockgains_bufsize = (vx_uint64)m_blockgainsStride*((m_height + 31) >> 5);
+			size += blockgains_bufsize * (m * sizeof(vx_float32) + sizeof(block_gain_info));
+		}
+	}
+	return size;
+}
+
 vx_status CExpCompensator::Process()
 {
 	if (m_channel >> 8)
@@ -809,19 +863,10 @@ vx_status CExpCompensator::CompensateGains()
 		}
 	}
 
-	// generate augmented matrix[A/b] for solving gains
-	for (int i = 0; i < (int)m_numImages; i++){
-		for (int j = 0; j < (int)m_numImages; ++j) {
-			m_AMat[i][m_numImages] += m_beta * m_NMat[i][j];		// b matrix
-			m_AMat[i][i] += m_beta * m_NMat[i][j];
-			if (j == i)			continue;
-			m_AMat[i][i] += 2 * m_alpha * m_IMat[i][j] * m_IMat[i][j] * m_NMat[i][j];
-			m_AMat[i][j] -= 2 * m_alpha * m_IMat[i][j] * m_IMat[j][i] * m_NMat[i][j];
-		}
-	}
-
-	//solve the linear equation A*gains_ = B
-	solve_gauss(m_AMat, m_Gains, m_numImages);
+	//solve the linear equation A*gains_ = B: without overlaps the gains are 1
+	build_model_gain_matrix(m_IMat);
+	if (!solve_cholesky(m_Gains, m_numImages))
+		for (i = 0; i < (int)m_numImages; i++) m_Gains[i] = 1.0f;
 	// Apply gains to all images
 	status = ApplyGains(base_ptr);
 	// commit image patch
@@ -921,52 +966,14 @@ vx_status CExpCompensator::CompensateGainsRGB(vx_int32 ref_img)
 		sd_r /= num; sd_g /= num; sd_b /= num;
 	}
 #endif
-	// generate augmented matrix[A/b] for solving gains
-	for (int i = 0; i < (int)m_numImages; i++){
-		for (int j = 0; j < (int)m_numImages; ++j) {
-			m_AMat[i][m_numImages] += m_beta * m_NMat[i][j];		// b matrix
-			m_AMat[i][i] += m_beta * m_NMat[i][j];
-			if (j == i)			continue;
-			m_AMat[i][i] += 2 * m_alpha * m_IMat[i][j] * m_IMat[i][j] * m_NMat[i][j];
-			m_AMat[i][j] -= 2 * m_alpha * m_IMat[i][j] * m_IMat[j][i] * m_NMat[i][j];
-		}
-	}
-	//solve the linear equation A*gains_ = B
-	solve_gauss(m_AMat, m_Gains, m_numImages);
-
-	// generate augmented matrix[A/b] for solving gains for G channel
-	for (i = 0; i < (int)m_numImages; i++){
-		memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));
-	}
-
-	for (int i = 0; i < (int)m_numImages; i++){
-		for (int j = 0; j < (int)m_numImages; ++j) {
-			m_AMat[i][m_numImages] += m_beta * m_NMat[i][j];		// b matrix
-			m_AMat[i][i] += m_beta * m_NMat[i][j];
-			if (j == i)			continue;
-			m_AMat[i][i] += 2 * m_alpha * m_IMatG[i][j] * m_IMatG[i][j] * m_NMat[i][j];
-			m_AMat[i][j] -= 2 * m_alpha * m_IMatG[i][j] * m_IMatG[j][i] * m_NMat[i][j];
-		}
-	}
-	//solve the linear equation A*gains_ = B
-	solve_gauss(m_AMat, m_GainsG, m_numImages);
-
-	for (i = 0; i < (int)m_numImages; i++){
-		memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));
+	//solve the linear equation A*gains_ = B for the R, G, and B channels: without overlaps the gains are 1
+	vx_float32 **IMat[3] = { m_IMat, m_IMatG, m_IMatB };
+	vx_float32 *Gains[3] = { m_Gains, m_GainsG, m_GainsB };
+	for (int c = 0; c < 3; c++){
+		build_model_gain_matrix(IMat[c]);
+		if (!solve_cholesky(Gains[c], m_numImages))
+			for (i = 0; i < (int)m_numImages; i++) Gains[c][i] = 1.0f;
 	}
-	// generate augmented matrix[A/b] for solving gains for B channel
-	for (int i = 0; i < (int)m_numImages; i++){
-		for (int j = 0; j < (int)m_numImages; ++j) {
-			m_AMat[i][m_numImages] += m_beta * m_NMat[i][j];		// b matrix
-			m_AMat[i][i] += m_beta * m_NMat[i][j];
-			if (j == i)			continue;
-			m_AMat[i][i] += 2 * m_alpha * m_IMatB[i][j] * m_IMatB[i][j] * m_NMat[i][j];
-			m_AMat[i][j] -= 2 * m_alpha * m_IMatB[i][j] * m_IMatB[j][i] * m_NMat[i][j];
-		}
-	}
-
-	//solve the linear equation A*gains_ = B
-	solve_gauss(m_AMat, m_GainsB, m_numImages);
 	// Apply gains to all images
 	status = ApplyGains(base_ptr);
 	// commit image patch
@@ -1040,20 +1047,23 @@ vx_status CExpCompensator::CompensateBlockGains()
 	// compute gain for each 32x32 block for all images and store in m_block_gain_buf
 	for (int blk = 0; pBg && blk < (int)(num_blocks_h*num_blocks_w); pBg++, blk++)
 	{
-		// generate augmented matrix[A/b] for solving gains
+		// generate the gain matrix A and b for solving gains: without overlaps in the block the gains are 1
 		vx_uint32 N;
 		for (i = 0; i < (int)m_numImages; i++){
-			memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));		//initialize
+			vx_float64 *Ai = m_solveWork + i*m_solveSize;
+			memset(Ai, 0, m_numImages*sizeof(vx_float64));		//initialize
+			m_solveRhs[i] = 0.0;
 			for (int j = 0; j < (int)m_numImages; ++j) {
 				N = pBg->Count[i][j];
-				m_AMat[i][m_numImages] += m_beta * N;		// b matrix
-				m_AMat[i][i] += m_beta * N;
+				m_solveRhs[i] += m_beta * N;		// b matrix
+				Ai[i] += m_beta * N;
 				if (j == i)			continue;
-				m_AMat[i][i] += 2 * m_alpha * pBg->Sum[i][j] * pBg->Sum[i][j] * N;
-				m_AMat[i][j] -= 2 * m_alpha * pBg->Sum[i][j] * pBg->Sum[j][i] * N;
+				Ai[i] += 2 * m_alpha * pBg->Sum[i][j] * pBg->Sum[i][j] * N;
+				Ai[j] -= 2 * m_alpha * pBg->Sum[i][j] * pBg->Sum[j][i] * N;
 			}
 		}
-		solve_gauss(m_AMat, m_Gains, m_numImages);
+		if (!solve_cholesky(m_Gains, m_numImages))
+			for (i = 0; i < (int)m_numImages; i++) m_Gains[i] = 1.0f;
 		for (i = 0; i < (int)m_numImages; i++){
 			vx_float32 *pblk = m_block_gain_buf + i*block_gain_buf_size;
 			*(pblk + pBg->b_dstY*m_blockgainsStride + pBg->b_dstX) = m_Gains[i];
@@ -1116,12 +1126,14 @@ vx_status CExpCompensator::CompensateBlockGains()
 	return VX_SUCCESS;
 }
 
-vx_status CExpCompensator::SolveForGains(vx_float32 alpha, vx_float32 beta, vx_uint32 *pIMat, vx_uint32 *pNMat, vx_uint32 num_images, vx_array Gains_arr, vx_uint32 rows, vx_uint32 cols)
+vx_status CExpCompensator::SolveForGains(vx_float32 alpha, vx_float32 beta, vx_uint32 *pIMat, vx_uint32 *pNMat, vx_uint32 num_images, vx_array Gains_arr, vx_uint32 rows, vx_uint32 cols, vx_float32 smoothing, const vx_float32 *applied)
 {
 	int i, N = cols*cols;
 	m_numImages = num_images;
 	int bRGBGain = (rows >= 3 * cols) ? 1 : 0;
-	float *gains = new float[num_images];
+	int numChannels = bRGBGain ? 3 : 1;
+	if (num_images > m_solveSize || num_images > cols)
+		return VX_ERROR_INVALID_DIMENSION;
 
 	// normalize intensity 
 	vx_uint32 *pGMat = nullptr; 
@@ -1140,169 +1152,212 @@ vx_status CExpCompensator::SolveForGains(vx_float32 alpha, vx_float32 beta, vx_u
 			}
 		}
 	}
-	// generate augmented matrix[A/b] for solving gains
-	m_AMat = new vx_float64*[m_numImages];
-	for (i = 0; i < (int)m_numImages; i++){
-		m_AMat[i] = new vx_float64[m_numImages + 1];	// enough for the augmented matrix [a|b]
-		memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));
-	}
-	for (i = 0; i < (int)num_images; i++){
-		vx_uint32 *pI = pIMat + i*cols;
-		vx_uint32 *pN = pNMat + i*cols;
-		for (int j = 0; j < (int)num_images; ++j) {
-			vx_uint32 N = pN[j] ? pN[j] : 1;
-			m_AMat[i][m_numImages] += beta * N;		// b matrix
-			m_AMat[i][i] += beta * N;
-			if (j == i)			continue;
-			m_AMat[i][i] += 2 * alpha * pI[j] * pI[j] * N;
-			m_AMat[i][j] -= 2 * alpha * pI[j] * pIMat[j*num_images + i] * N;
+	// the intensities were measured on pixels that already have the applied gains: divide them out,
+	// so that the solved gains stay relative to the unmodified camera images
+	if (applied){
+		vx_uint32 *pChannel[3] = { pIMat, pGMat, pBMat };
+		for (int c = 0; c < numChannels; c++){
+			for (i = 0; i < (int)num_images; i++){
+				vx_float32 g = bRGBGain ? applied[i * 3 + c] : applied[i];
+				if (g > 0.0f){
+					vx_uint32 *pI = pChannel[c] + i*cols;
+					for (int j = 0; j < (int)num_images; j++)
+						pI[j] = (vx_uint32)(pI[j] / g + 0.5f);
+				}
+			}
 		}
 	}
-	solve_gauss(m_AMat, gains, m_numImages);
-	if (bRGBGain){
-		float *gain_g = new float[num_images];
-		float *gain_b = new float[num_images];
-		for (i = 0; i < (int)m_numImages; i++){
-			memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));
-		}
-		for (i = 0; i < (int)m_numImages; i++){
-			vx_uint32 *pI = pGMat + i*cols;
-			vx_uint32 *pN = pNMat + i*cols;
-			for (int j = 0; j < (int)num_images; ++j) {
-				vx_uint32 N = pN[j] ? pN[j] : 1;
-				m_AMat[i][m_numImages] += beta * N;		// b matrix
-				m_AMat[i][i] += beta * N;
-				if (j == i)			continue;
-				m_AMat[i][i] += 2 * alpha * pI[j] * pI[j] * N;
-				m_AMat[i][j] -= 2 * alpha * pI[j] * pGMat[j*num_images + i] * N;
-			}
+	// the right-hand side b (and the beta term of the diagonal) only depends on the overlap counts: same for all channels
+	for (i = 0; i < (int)num_images; i++){
+		const vx_uint32 *pN = pNMat + i*cols;
+		vx_float64 sum = 0.0;
+		for (int j = 0; j < (int)num_images; j++)
+			sum += pN[j] ? pN[j] : 1;
+		m_solveRhs[i] = beta * sum;
+	}
+	// solve A*gains = b of each channel: A is symmetric positive definite, so the solver uses its Cholesky factor
+	vx_uint32 *pChannelMat[3] = { pIMat, pGMat, pBMat };
+	for (int c = 0; c < numChannels; c++){
+		vx_float32 *gains = m_solveOut + c*num_images;
+		if (smoothing >= 1.0f && m_solveHasGains) {
+			// hold: keep the gains of the previous frame without solving
+			memcpy(gains, m_solveGains + c*num_images, num_images * sizeof(vx_float32));
+			continue;
 		}
-		//solve the linear equation A*gains_ = B
-		solve_gauss(m_AMat, gain_g, m_numImages);
-
-		for (i = 0; i < (int)m_numImages; i++){
-			memset(&m_AMat[i][0], 0, (m_numImages + 1)*sizeof(vx_float64));
+		build_gain_matrix(pChannelMat[c], pNMat, cols, num_images, alpha);
+		if (!solve_cholesky(gains, num_images)) {
+			// keep the gains of the previous frame
+			for (i = 0; i < (int)num_images; i++)
+				gains[i] = m_solveHasGains ? m_solveGains[c*num_images + i] : 1.0f;
 		}
-		// generate augmented matrix[A/b] for solving gains for B channel
-		for (i = 0; i < (int)m_numImages; i++){
-			vx_uint32 *pI = pBMat + i*cols;
-			vx_uint32 *pN = pNMat + i*cols;
-			for (int j = 0; j < (int)num_images; ++j) {
-				vx_uint32 N = pN[j] ? pN[j] : 1;
-				m_AMat[i][m_numImages] += beta * N;		// b matrix
-				m_AMat[i][i] += beta * N;
-				if (j == i)			continue;
-				m_AMat[i][i] += 2 * alpha * pI[j] * pI[j] * N;
-				m_AMat[i][j] -= 2 * alpha * pI[j] * pBMat[j*num_images + i] * N;
-			}
+		// temporal smoothing with the gains of the previous frame
+		vx_float32 *prev = m_solveGains + c*num_images;
+		for (i = 0; i < (int)num_images; i++){
+			if (m_solveHasGains && smoothing > 0.0f)
+				gains[i] = smoothing * prev[i] + (1.0f - smoothing) * gains[i];
+			prev[i] = gains[i];
 		}
-		//solve the linear equation A*gains_ = B
-		solve_gauss(m_AMat, gain_b, m_numImages);
-		float *pRGB_gains = new float[m_numImages * 3];
+	}
+	m_solveHasGains = true;
+	if (bRGBGain){
 		for (i = 0; i < (int)m_numImages; i++){
 			// gamma correction for the gains
-			pRGB_gains[i * 3]     = powf(gains[i], 0.454546f);
-			pRGB_gains[i * 3 + 1] = powf(gain_g[i], 0.454546f);
-			pRGB_gains[i * 3 + 2] = powf(gain_b[i], 0.454546f);
+			m_solveOut[i * 3]     = powf(m_solveGains[i], 0.454546f);
+			m_solveOut[i * 3 + 1] = powf(m_solveGains[i + num_images], 0.454546f);
+			m_solveOut[i * 3 + 2] = powf(m_solveGains[i + 2 * num_images], 0.454546f);
 		}
 		ERROR_CHECK_STATUS(vxTruncateArray(Gains_arr, 0));
-		ERROR_CHECK_STATUS(vxAddArrayItems(Gains_arr, m_numImages*3, pRGB_gains, sizeof(float)));
-		delete[] pRGB_gains;
-		delete[] gain_g;
-		delete[] gain_b;
+		ERROR_CHECK_STATUS(vxAddArrayItems(Gains_arr, m_numImages*3, m_solveOut, sizeof(float)));
 	}
 	else
 	{
 		ERROR_CHECK_STATUS(vxTruncateArray(Gains_arr, 0));
-		ERROR_CHECK_STATUS(vxAddArrayItems(Gains_arr, m_numImages, gains, sizeof(float)));
-	}
-	delete[] gains;
-	for (i = 0; i < (int)num_images; i++){
-		delete[] m_AMat[i];
+		ERROR_CHECK_STATUS(vxAddArrayItems(Gains_arr, m_numImages, m_solveGains, sizeof(float)));
 	}
-	delete[] m_AMat;
 	return VX_SUCCESS;
 }
 
-// solving linear equation of Augmented matrix[A|b] using gaussian elemination method
-void CExpCompensator::solve_gauss(vx_float64 **A, vx_float32 *g, int num)
+//! \brief Build the gain matrix A of a channel into m_solveWork: the diagonal starts from the beta term in m_solveRhs.
+void CExpCompensator::build_gain_matrix(const vx_uint32 *pIMat, const vx_uint32 *pNMat, vx_uint32 cols, int num, vx_float32 alpha)
 {
-	int n = num;
-
-	for (int i = 0; i < n; i++) {
-		// Search for maximum in this column
-		double maxEl = fabs(A[i][i]);
-		int maxRow = i;
-		for (int k = i + 1; k<n; k++) {
-			if (fabs(A[k][i]) > maxEl) {
-				maxEl = fabs(A[k][i]);
-				maxRow = k;
-			}
-		}
-		// Swap maximum row with current row (column by column)
-		for (int k = i; k < n + 1; k++) {
-			double tmp = A[maxRow][k];
-			A[maxRow][k] = A[i][k];
-			A[i][k] = tmp;
-		}
-		// Make all rows below this one 0 in current column: scale
-		for (int k = i + 1; k < n; k++) {
-			double c = -A[k][i] / A[i][i];
-			for (int j = i; j < n + 1; j++) {
-				if (i == j) {
-					A[k][j] = 0;
-				}
-				else {
-					A[k][j] += c * A[i][j];
-				}
-			}
+	vx_float64 *A = m_solveWork;
+	for (int i = 0; i < num; i++){
+		const vx_uint32 *pI = pIMat + i*cols;
+		const vx_uint32 *pN = pNMat + i*cols;
+		vx_float64 *Ai = A + i*m_solveSize;
+		Ai[i] = m_solveRhs[i];
+		for (int j = 0; j < num; ++j) {
+			if (j == i)			continue;
+			vx_float64 N = pN[j] ? pN[j] : 1;
+			Ai[i] += 2.0 * alpha * pI[j] * pI[j] * N;
+			Ai[j] = -2.0 * alpha * pI[j] * pIMat[j*cols + i] * N;
 		}
 	}
+}
 
-	// Solve equation Ax=b for an upper triangular matrix A
-	for (int i = n - 1; i >= 0; i--) {
-		double gain = (A[i][n] / A[i][i]);
-		for (int k = i - 1; k >= 0; k--) {
-			A[k][n] -= A[k][i] * gain;
+//! \brief Build the gain matrix A into m_solveWork and b into m_solveRhs from the mean intensities IMat and the overlap counts m_NMat.
+void CExpCompensator::build_model_gain_matrix(vx_float32 **IMat)
+{
+	for (int i = 0; i < (int)m_numImages; i++){
+		vx_float64 *Ai = m_solveWork + i*m_solveSize;
+		memset(Ai, 0, m_numImages*sizeof(vx_float64));
+		m_solveRhs[i] = 0.0;
+		for (int j = 0; j < (int)m_numImages; ++j) {
+			m_solveRhs[i] += m_beta * m_NMat[i][j];		// b matrix
+			Ai[i] += m_beta * m_NMat[i][j];
+			if (j == i)			continue;
+			Ai[i] += 2 * m_alpha * IMat[i][j] * IMat[i][j] * m_NMat[i][j];
+			Ai[j] -= 2 * m_alpha * IMat[i][j] * IMat[j][i] * m_NMat[i][j];
 		}
-		g[i] = (vx_float32)gain;
 	}
-	return;
 }
 
-vx_status CExpCompensator::ApplyGains(void *in_base_addr)
+//! \brief Solve A*g = b with A in m_solveWork and b in m_solveRhs using the Cholesky factor of A.
+// Returns false if A is not positive definite.
+bool CExpCompensator::solve_cholesky(vx_float32 *g, int num)
 {
-	uint32_t num_threads = m_numImages - 1;
-	std::thread *thread_apply_gains = new std::thread[num_threads];
-	for (int i = 0; i < (int)m_numImages - 1; i++)
-	{
-		thread_apply_gains[i] = std::thread(&CExpCompensator::applygains_thread_func, this, i, (char *)in_base_addr);
+	int n = (int)m_solveSize;
+	const vx_float64 *A = m_solveWork;
+	vx_float64 *L = m_solveFactor;
+	for (int i = 0; i < num; i++) {
+		for (int j = 0; j <= i; j++) {
+			vx_float64 sum = A[i*n + j];
+			for (int k = 0; k < j; k++)
+				sum -= L[i*n + k] * L[j*n + k];
+			if (i == j) {
+				if (sum <= 0.0)
+					return false;
+				L[i*n + i] = sqrt(sum);
+			}
+			else
+				L[i*n + j] = sum / L[j*n + j];
+		}
 	}
-	applygains_thread_func(num_threads, (char *)in_base_addr);
-	//Join the threads with the main thread
-	for (int i = 0; i < (int)m_numImages - 1; i++) {
-		thread_apply_gains[i].join();
+	// forward substitution L*y = b
+	vx_float64 *y = m_solveTmp;
+	for (int i = 0; i < num; i++) {
+		vx_float64 sum = m_solveRhs[i];
+		for (int k = 0; k < i; k++)
+			sum -= L[i*n + k] * y[k];
+		y[i] = sum / L[i*n + i];
+	}
+	// back substitution L'*g = y
+	for (int i = num - 1; i >= 0; i--) {
+		vx_float64 sum = y[i];
+		for (int k = i + 1; k < num; k++)
+			sum -= L[k*n + i] * y[k];
+		y[i] = sum / L[i*n + i];
+		g[i] = (vx_float32)y[i];
+	}
+	return true;
+}
+
+//! \brief Apply gains to four RGBX pixels: truncated product with saturation, invalid pixels (0x80000000) are copied.
+static inline __m128i expcomp_apply_gain_4(__m128i src, __m128 gain)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_unpacklo_epi8(src, zero), hi = _mm_unpackhi_epi8(src, zero);
+	__m128i p0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), gain));
+	__m128i p1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), gain));
+	__m128i p2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), gain));
+	__m128i p3 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), gain));
+	__m128i dst = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+	return _mm_blendv_epi8(dst, src, _mm_cmpeq_epi32(src, _mm_set1_epi32((int)0x80000000)));
+}
+
+//! \brief Apply gains (r, g, b, y) to a row of RGBX pixels.
+static inline void expcomp_apply_gain_row(const vx_uint32 *pSrc, vx_uint32 *pDst, vx_int32 width, __m128 gain)
+{
+	vx_int32 x = 0;
+	for (; x <= width - 4; x += 4)
+		_mm_storeu_si128((__m128i *)&pDst[x], expcomp_apply_gain_4(_mm_loadu_si128((const __m128i *)&pSrc[x]), gain));
+	float g[4]; _mm_storeu_ps(g, gain);
+	for (; x < width; x++){
+		if (pSrc[x] != 0x80000000){
+			const uint8_t *p = (const uint8_t *)&pSrc[x];
+			uint8_t *d = (uint8_t *)&pDst[x];
+			d[0] = saturate_char((int)(p[0] * g[0]));
+			d[1] = saturate_char((int)(p[1] * g[1]));
+			d[2] = saturate_char((int)(p[2] * g[2]));
+			d[3] = saturate_char((int)(p[3] * g[3]));
+		}
+		else
+			pDst[x] = pSrc[x];
 	}
-	return VX_SUCCESS;
 }
 
-vx_status CExpCompensator::applygains_thread_func(vx_int32 img_num, char *in_base_addr)
+vx_status CExpCompensator::ApplyGains(void *in_base_addr)
 {
+	PROFILER_START(ExpComp, ApplyGains);
+	// access output image for writing: the row tiles are processed by the worker pool
 	vx_status status;
-	// access image patch output for writing
 	vx_imagepatch_addressing_t addr = { 0 };
-	vx_rectangle_t rect;
-	rect.start_x = 0;
-	rect.start_y = m_height*img_num;
-	rect.end_x = m_width;
-	rect.end_y = rect.start_y + m_height;
+	vx_rectangle_t rect = { 0, 0, m_width, m_height*m_numImages };
 	vx_uint8 * base_ptr = nullptr;
-	ERROR_CHECK_STATUS(vxAccessImagePatch(m_OutputImage, &rect, 0, &addr, (void **)&base_ptr, VX_WRITE_ONLY));
+	if ((status = vxAccessImagePatch(m_OutputImage, &rect, 0, &addr, (void **)&base_ptr, VX_WRITE_ONLY)) != VX_SUCCESS) {
+		vxAddLogEntry((vx_reference)m_node, status, "ERROR: ApplyGains: vxAccessImagePatch(WRITE) failed, status = %d\n", status);
+		PROFILER_STOP(ExpComp, ApplyGains);
+		return status;
+	}
+	m_threadPool->Run((vx_uint32)m_applyTiles.size(), [&](vx_uint32 item) {
+		applygains_tile(m_applyTiles[item], (const vx_uint8 *)in_base_addr, base_ptr, addr.stride_y);
+	});
+	// commit image patch
+	if ((status = vxCommitImagePatch(m_OutputImage, &rect, 0, &addr, (void *)base_ptr)) != VX_SUCCESS) {
+		vxAddLogEntry((vx_reference)m_node, VX_FAILURE, "ERROR Decoder Node: vxCommitImagePatch(WRITE) failed, status = %d\n", status);
+		PROFILER_STOP(ExpComp, ApplyGains);
+		return VX_FAILURE;
+	}
+	PROFILER_STOP(ExpComp, ApplyGains);
+	return VX_SUCCESS;
+}
 
+void CExpCompensator::applygains_tile(const expcomp_apply_tile& tile, const vx_uint8 *in_base_addr, vx_uint8 *out_base_addr, vx_uint32 out_stride)
+{
+	vx_uint32 img_num = tile.img_num;
 	vx_int32 width = mValidRect[img_num].end_x - mValidRect[img_num].start_x;
-	vx_int32 height = mValidRect[img_num].end_y - mValidRect[img_num].start_y;
-	vx_uint32 *pRGB = (vx_uint32 *)(in_base_addr + (img_num*m_height + mValidRect[img_num].start_y)*m_stride + (mValidRect[img_num].start_x*m_stride_x));
-	vx_uint32 *pDst = (vx_uint32 *)(base_ptr + mValidRect[img_num].start_y*addr.stride_y + mValidRect[img_num].start_x*addr.stride_x);
+	const vx_uint32 *pRGB = (const vx_uint32 *)(in_base_addr + (img_num*m_height + tile.start_y)*m_stride + (mValidRect[img_num].start_x*m_stride_x));
+	vx_uint32 *pDst = (vx_uint32 *)(out_base_addr + (img_num*m_height + tile.start_y)*out_stride + (mValidRect[img_num].start_x*m_stride_x));
 	float g_y = m_Gains[img_num];
 	float g_r, g_g, g_b;
 	//	g_y = (float)pow(g_y, 1.2);
@@ -1319,98 +1374,56 @@ vx_status CExpCompensator::applygains_thread_func(vx_int32 img_num, char *in_bas
 	else{
 		g_r = g_g = g_b = g_y;	// todo: check if we need to apply gain factor for RGB
 	}
-	// todo:: if we do the following code in CPU, need to optimize using SSE
-	for (int i = 0; i < height; i++){
-		for (int j = 0; j < width; j++){
-			// apply gain only to valid pixels : todo: multiply with approapriate gain factors for R, G and B
-			if (pRGB[j] != 0x80000000){
-				uint8_t *p = (uint8_t *)&pRGB[j];
-				uint8_t *d = (uint8_t *)&pDst[j];
-				d[0] = saturate_char((int)(p[0] * g_r));
-				d[1] = saturate_char((int)(p[1] * g_g));
-				d[2] = saturate_char((int)(p[2] * g_b));
-				d[3] = saturate_char((int)(p[3] * g_y));
-			}
-			else
-				pDst[j] = pRGB[j];
-		}
+	// apply gain only to valid pixels
+	__m128 gain = _mm_setr_ps(g_r, g_g, g_b, g_y);
+	for (vx_uint32 i = tile.start_y; i < tile.end_y; i++){
+		expcomp_apply_gain_row(pRGB, pDst, width, gain);
 		pRGB += (m_stride >> 2);
-		pDst += (addr.stride_y >> 2);
-	}
-	// commit image patch
-	if ((status = vxCommitImagePatch(m_OutputImage, &rect, 0, &addr, (void *)base_ptr) != VX_SUCCESS)) {
-		vxAddLogEntry((vx_reference)m_node, VX_FAILURE, "ERROR Decoder Node: vxCommitImagePatch(WRITE) failed, status = %d\n", status);
-		return VX_FAILURE;
+		pDst += (out_stride >> 2);
 	}
-	return status;
 }
 
 vx_status CExpCompensator::ApplyBlockGains(void *in_base_addr)
 {
-	uint32_t num_threads = m_numImages - 1;
-	applygains_thread_func(0, (char *)in_base_addr);
-	applygains_thread_func(1, (char *)in_base_addr);
-	applygains_thread_func(2, (char *)in_base_addr);
-	applygains_thread_func(3, (char *)in_base_addr);
-	return VX_SUCCESS;
-}
-
-vx_status CExpCompensator::applyblockgains_thread_func(vx_int32 img_num, char *in_base_addr)
-{
+	PROFILER_START(ExpComp, ApplyBlockGains);
+	// access output image for writing: the row tiles are processed by the worker pool
 	vx_status status;
-	// access image patch output for writing
-	float *gain_buf = m_block_gain_buf + (img_num*m_blockgainsStride*((m_height + 31) >> 5));
 	vx_imagepatch_addressing_t addr = { 0 };
-	vx_rectangle_t rect;
-	rect.start_x = 0;
-	rect.start_y = m_height*img_num;
-	rect.end_x = m_width;
-	rect.end_y = rect.start_y + m_height;
+	vx_rectangle_t rect = { 0, 0, m_width, m_height*m_numImages };
 	vx_uint8 * base_ptr = nullptr;
-	ERROR_CHECK_STATUS(vxAccessImagePatch(m_OutputImage, &rect, 0, &addr, (void **)&base_ptr, VX_WRITE_ONLY));
-
-	vx_int32 width = mValidRect[img_num].end_x - mValidRect[img_num].start_x;
-	vx_int32 height = mValidRect[img_num].end_y - mValidRect[img_num].start_y;
-	vx_uint32 *pRGB = (vx_uint32 *)(in_base_addr + (img_num*m_height + mValidRect[img_num].start_y)*m_stride + (mValidRect[img_num].start_x*m_stride_x));
-	vx_uint32 *pDst = (vx_uint32 *)(base_ptr + mValidRect[img_num].start_y*addr.stride_y + mValidRect[img_num].start_x*addr.stride_x);
-	int b_startx = mValidRect[img_num].start_x >> 5;
-	int b_endx = std::min((m_width>>5),((mValidRect[img_num].end_x + 31) >> 5));
-	int b_starty = mValidRect[img_num].start_y >> 5;
-	int b_endy = std::min((m_height >> 5), ((mValidRect[img_num].end_y + 31) >> 5));
-
-	// todo:: if we do the following code in CPU, need to optimize using SSE
-	for (int i = b_starty; i < b_endy; i++){
-		for (int j = b_startx; j < b_endx; j++){
-			int pos = i * 32 * (m_stride >> 2) + j * 32;
-			int dpos = i * 32 * ((addr.stride_y >> 2) >> 2) + j * 32;
-			int end_y = (((i + 1) << 5) >= (int)m_height) ? m_height - (i * 32) : 32;
-			int end_x = (((j + 1) << 5) >= (int)m_width) ? m_width - (i * 32) : 32;
-			float g_y = *(gain_buf + b_starty*m_blockgainsStride + b_startx);
-			vx_uint32 *pSrc = pRGB + pos;
-			vx_uint32 *pRGBDst = pDst + dpos;
-			for (int y = 0; y < end_y; y++) {
-				for (int x = 0; x < end_x; x++){
-					// apply gain only to valid pixels : todo: multiply with approapriate gain factors for R, G and B
-					if (pSrc[x] != 0x80000000){
-						uint8_t *p = (uint8_t *)&pRGB[x];
-						uint8_t *d = (uint8_t *)&pRGBDst[x];
-						d[0] = saturate_char((int)(p[0] * g_y));
-						d[1] = saturate_char((int)(p[1] * g_y));
-						d[2] = saturate_char((int)(p[2] * g_y));
-						d[3] = saturate_char((int)(p[3] * g_y));
-					}
-					else
-						pRGBDst[dpos + x] = pSrc[pos + x];
-				}
-				pSrc += (m_stride >> 2);
-				pRGBDst += (addr.stride_y >> 2);
-			}
-		}
-	}
+	if ((status = vxAccessImagePatch(m_OutputImage, &rect, 0, &addr, (void **)&base_ptr, VX_WRITE_ONLY)) != VX_SUCCESS) {
+		vxAddLogEntry((vx_reference)m_node, status, "ERROR: ApplyBlockGains: vxAccessImagePatch(WRITE) failed, status = %d\n", status);
+		PROFILER_STOP(ExpComp, ApplyBlockGains);
+		return status;
+	}
+	m_threadPool->Run((vx_uint32)m_applyTiles.size(), [&](vx_uint32 item) {
+		applyblockgains_tile(m_applyTiles[item], (const vx_uint8 *)in_base_addr, base_ptr, addr.stride_y);
+	});
 	// commit image patch
-	if ((status = vxCommitImagePatch(m_OutputImage, &rect, 0, &addr, (void *)base_ptr) != VX_SUCCESS)) {
+	if ((status = vxCommitImagePatch(m_OutputImage, &rect, 0, &addr, (void *)base_ptr)) != VX_SUCCESS) {
 		vxAddLogEntry((vx_reference)m_node, VX_FAILURE, "ERROR Decoder Node: vxCommitImagePatch(WRITE) failed, status = %d\n", status);
+		PROFILER_STOP(ExpComp, ApplyBlockGains);
 		return VX_FAILURE;
 	}
-	return status;
+	PROFILER_STOP(ExpComp, ApplyBlockGains);
+	return VX_SUCCESS;
+}
+
+void CExpCompensator::applyblockgains_tile(const expcomp_apply_tile& tile, const vx_uint8 *in_base_addr, vx_uint8 *out_base_addr, vx_uint32 out_stride)
+{
+	// the tile rows are within one row of 32x32 gain blocks
+	vx_uint32 img_num = tile.img_num;
+	const float *gain_buf = m_block_gain_buf + (img_num*m_blockgainsStride*((m_height + 31) >> 5)) + (tile.start_y >> 5)*m_blockgainsStride;
+	vx_int32 start_x = mValidRect[img_num].start_x, end_x = mValidRect[img_num].end_x;
+	const vx_uint32 *pRGB = (const vx_uint32 *)(in_base_addr + (img_num*m_height + tile.start_y)*m_stride);
+	vx_uint32 *pDst = (vx_uint32 *)(out_base_addr + (img_num*m_height + tile.start_y)*out_stride);
+	for (vx_uint32 i = tile.start_y; i < tile.end_y; i++){
+		for (vx_int32 x = start_x; x < end_x; x = (x + 32) & ~31){
+			float g_y = gain_buf[x >> 5];
+			vx_int32 width = std::min((x + 32) & ~31, end_x) - x;
+			expcomp_apply_gain_row(pRGB + x, pDst + x, width, _mm_set1_ps(g_y));
+		}
+		pRGB += (m_stride >> 2);
+		pDst += (out_stride >> 2);
+	}
 }
@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #define MAX_NUM_IMAGES_IN_STITCHED_OUTPUT	16
 #define USE_LUMA_VALUES_FOR_GAIN			1
+#define EXPCOMP_APPLY_TILE_HEIGHT			32		// rows per work item when applying gains (same as gain block size)
 
 typedef struct _block_gain_info
 {
@@ -36,6 +37,12 @@ typedef struct _block_gain_info
 	vx_uint8    Sum[MAX_NUM_IMAGES_IN_STITCHED_OUTPUT][MAX_NUM_IMAGES_IN_STITCHED_OUTPUT];
 }block_gain_info;
 
+typedef struct _expcomp_apply_tile
+{
+	vx_uint32   img_num;
+	vx_uint32   start_y, end_y;     // rows of the valid rectangle of the image
+}expcomp_apply_tile;
+
 class CExpCompensator
 {
 public:
@@ -45,7 +52,8 @@ public:
 	virtual vx_status ProcessBlockGains(vx_array ArrBlkGains);
 	virtual vx_status Initialize(vx_node node, vx_float32 alpha, vx_float32 beta, vx_array valid_roi, vx_image input, vx_image output, vx_array blockgain_arr = nullptr, vx_int32 channel=-1);
 	virtual vx_status DeInitialize();
-	virtual vx_status SolveForGains(vx_float32 alpha, vx_float32 beta, vx_uint32 *IMat, vx_uint32 *NMat, vx_uint32 num_images, vx_array pGains, vx_uint32 rows, vx_uint32 cols);
+	virtual vx_status SolveForGains(vx_float32 alpha, vx_float32 beta, vx_uint32 *IMat, vx_uint32 *NMat, vx_uint32 num_images, vx_array pGains, vx_uint32 rows, vx_uint32 cols, vx_float32 smoothing = 0.0f, const vx_float32 *applied = nullptr);
+	vx_uint64 GetHostMemorySize() const;	// size of the host buffers allocated by the constructor and Initialize
 	vx_uint32 *m_pIMat, *m_pNMat;
 
 protected:
@@ -62,10 +70,20 @@ protected:
 	block_gain_info *m_pblockgainInfo;
 	vx_uint32 **m_NMat;
 	vx_float32  **m_IMat, **m_IMatG, **m_IMatB;
-	vx_float64 **m_AMat;
 	vx_float32 *m_Gains, *m_GainsG, *m_GainsB;
 	vx_rectangle_t mValidRect[MAX_NUM_IMAGES_IN_STITCHED_OUTPUT];
 	vx_float32 *m_block_gain_buf;       // for block based exposure control
+	StitchThreadPool *m_threadPool;     // persistent workers for applying gains
+	std::vector<expcomp_apply_tile> m_applyTiles;	// row tiles of the valid rectangles of all images
+	// gain solver buffers, allocated once for [m_solveSize] images
+	vx_uint32   m_solveSize;
+	vx_uint32   m_solveMatSize;         // items of m_pIMat and m_pNMat [rows][columns]
+	vx_float64 *m_solveWork;            // gain matrix A of the current frame [n][n]
+	vx_float64 *m_solveFactor;          // Cholesky factor L (A = L*L') [n][n]
+	vx_float64 *m_solveRhs, *m_solveTmp;	// right-hand side b and substitution temporary [n]
+	vx_float32 *m_solveGains;           // smoothed gains of the previous frame per channel [3][n]
+	vx_float32 *m_solveOut;             // solved gains per channel [3][n], then the gains written to the output array
+	bool        m_solveHasGains;        // m_solveGains is valid
 
 
 // functions
@@ -76,9 +94,12 @@ protected:
 	virtual vx_status ApplyBlockGains(void *in_base_addr);
 
 private:
-	void solve_gauss(vx_float64 **A, vx_float32* g, int num);
-	vx_status applygains_thread_func(vx_int32 img_num, char *in_base_addr);
-	vx_status applyblockgains_thread_func(vx_int32 img_num, char *in_base_addr);
+	void allocate_solve_buffers(vx_uint32 num);
+	void build_gain_matrix(const vx_uint32 *pIMat, const vx_uint32 *pNMat, vx_uint32 cols, int num, vx_float32 alpha);
+	void build_model_gain_matrix(vx_float32 **IMat);
+	bool solve_cholesky(vx_float32 *g, int num);
+	void applygains_tile(const expcomp_apply_tile& tile, const vx_uint8 *in_base_addr, vx_uint8 *out_base_addr, vx_uint32 out_stride);
+	void applyblockgains_tile(const expcomp_apply_tile& tile, const vx_uint8 *in_base_addr, vx_uint8 *out_base_addr, vx_uint32 out_stride);
 };
 
 vx_status Compute_StitchExpCompCalcEntry(vx_rectangle_t *pValid_roi, vx_array ExpCompOut, int numCameras);
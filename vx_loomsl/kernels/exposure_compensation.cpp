@@ -95,6 +95,27 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_input_validator(vx_node n
 		}
 		status = VX_SUCCESS;
 	}
+	else if (index == 5)
+	{ // optional object of SCALAR type: subsample step
+		vx_enum itemtype = VX_TYPE_INVALID;
+		vx_uint32 subsample = 0;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
+		if (itemtype == VX_TYPE_UINT32) {
+			ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)ref, &subsample));
+		}
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+		if (itemtype != VX_TYPE_UINT32) {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp subsample scalar type should be a UINT32\n");
+		}
+		else if (subsample != 1 && subsample != 2 && subsample != 4) {
+			status = VX_ERROR_INVALID_VALUE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp subsample should be 1, 2, or 4\n");
+		}
+		else {
+			status = VX_SUCCESS;
+		}
+	}
 	return status;
 }
 
@@ -165,6 +186,33 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_global_work_update
 	return VX_SUCCESS;
 }
 
+//! \brief The OpenCL macros of the error function kernels to read the 8 samples of a work item row.
+// With subsample > 1 the samples are every subsample-th pixel of every subsample-th row and the sums are scaled up
+// to full resolution: the samples past the end of the entry (nx) read as invalid pixels.
+static std::string exposure_comp_errorfn_sample_code(vx_uint32 subsample)
+{
+	char item[256];
+	sprintf(item,
+		"#define EXPCOMP_SUBSAMPLE %d\n"
+		"#define EXPCOMP_SUM_SCALE %.4ff\n"
+		, subsample, 0.0625f * subsample * subsample);
+	std::string code = item;
+	if (subsample > 1) {
+		code +=
+			"#define EXPCOMP_PIXEL(p, k) (((k) < nx) ? (p)[(k)*EXPCOMP_SUBSAMPLE] : 0x80000000u)\n"
+			"#define EXPCOMP_LOAD4(n, p) (uint4)(EXPCOMP_PIXEL(p, 4*(n)), EXPCOMP_PIXEL(p, 4*(n)+1), EXPCOMP_PIXEL(p, 4*(n)+2), EXPCOMP_PIXEL(p, 4*(n)+3))\n"
+			"#define EXPCOMP_MASK(p, k) (((k) < nx) ? (uint)(p)[(k)*EXPCOMP_SUBSAMPLE] : 0u)\n"
+			"#define EXPCOMP_MASK4(p, k) (EXPCOMP_MASK(p, k) | (EXPCOMP_MASK(p, k+1) << 8) | (EXPCOMP_MASK(p, k+2) << 16) | (EXPCOMP_MASK(p, k+3) << 24))\n"
+			"#define EXPCOMP_LOAD_MASK8(p) (uint2)(EXPCOMP_MASK4((global uchar *)(p), 0), EXPCOMP_MASK4((global uchar *)(p), 4))\n";
+	}
+	else {
+		code +=
+			"#define EXPCOMP_LOAD4(n, p) vload4(n, p)\n"
+			"#define EXPCOMP_LOAD_MASK8(p) *(global uint2 *)(p)\n";
+	}
+	return code;
+}
+
 //! \brief The OpenCL code generator callback.
 static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 	vx_node node,                                  // [input] node
@@ -204,6 +252,12 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 		ERROR_CHECK_STATUS(vxQueryImage(mask_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &input_height, sizeof(input_height)));
 		ERROR_CHECK_STATUS(vxQueryImage(mask_image, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
 	}
+	vx_uint32 subsample = 1;
+	scalar = (vx_scalar)avxGetNodeParamRef(node, 5);
+	if (scalar) {
+		ERROR_CHECK_STATUS(vxReadScalarValue(scalar, &subsample));
+		ERROR_CHECK_STATUS(vxReleaseScalar(&scalar));
+	}
 
 	// set kernel configuration
 	vx_uint32 height_one = (vx_uint32)(input_height / num_cameras);
@@ -233,7 +287,7 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 			"	uint size = (uint)(pIn_stride*%d);\n"
 			"	uint wt_size = (uint)(pWt_stride*%d);\n"
 			, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name, height_one, height_one);
-		opencl_kernel_code = item;
+		opencl_kernel_code = exposure_comp_errorfn_sample_code(subsample) + item;
 		opencl_kernel_code +=
 			"	int lx = get_local_id(0);\n"
 			"	int ly = get_local_id(1);\n"
@@ -244,44 +298,45 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 			"		global uint *pI, *pJ;\n"
 			"		uint4 maskSrc, I, J, mask; \n"
 			"		uint4 Isum4, Jsum4;\n"
-			"		int   gx = (lx<<3) + ((offs.s0 >> 5) & 0x3FFF);\n"
-			"		int   gy = (ly<<1) + (offs.s0 >> 19);\n"
+			"		int   gx = (lx<<3)*EXPCOMP_SUBSAMPLE + ((offs.s0 >> 5) & 0x3FFF);\n"
+			"		int   nx = (int)(offs.s1&0x7f) + 1 - (lx<<3);\n"
+			"		int   gy = (ly<<1)*EXPCOMP_SUBSAMPLE + (offs.s0 >> 19);\n"
 			"		uint2 cam_id = (uint2)((offs.s0 & 0x1f), ((offs.s1>>12) & 0x1f));\n"
 			"		pIn_buf += pIn_offs + mad24(gy, (int)pIn_stride, (gx<<2));\n"
 			"		pWt_buf += pWt_offs + mad24(gy, (int)pWt_stride, gx);\n"
 			"		pI	   =  (global uint *)(pIn_buf + size*cam_id.x);\n"
 			"		pJ	   =  (global uint *)(pIn_buf + size*cam_id.y);\n"
-			"		maskSrc.s01	   =  *(global uint2 *)(pWt_buf + wt_size*cam_id.x);\n"
-			"		maskSrc.s01	   &=  *(global uint2 *)(pWt_buf + wt_size*cam_id.y); pWt_buf += pWt_stride;\n"
-			"		maskSrc.s23	   =  *(global uint2 *)(pWt_buf + wt_size*cam_id.x);\n"
-			"		maskSrc.s23	   &=  *(global uint2 *)(pWt_buf + wt_size*cam_id.y);\n"
+			"		maskSrc.s01	   =  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.x);\n"
+			"		maskSrc.s01	   &=  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.y); pWt_buf += pWt_stride*EXPCOMP_SUBSAMPLE;\n"
+			"		maskSrc.s23	   =  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.x);\n"
+			"		maskSrc.s23	   &=  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.y);\n"
 			"		char4 maskIJ = as_char4(maskSrc.s0);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000))) & (int)maskIJ.s2;\n"
 			"		mask.s3	= select(0xff000000, 0u, ((I.s3==0x80000000) | (J.s3==0x80000000))) & (int)maskIJ.s3;\n"
 			"		Isum4	= (I&mask)>>24; Jsum4 = (J & mask)>>24;\n"
-			"		I = vload4(1, pI);\n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI);\n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s1);\n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000))) & (int)maskIJ.s2;\n"
 			"		mask.s3	= select(0xff000000, 0u, ((I.s3==0x80000000) | (J.s3==0x80000000))) & (int)maskIJ.s3;\n"
 			"		Isum4	+= (I&mask)>>24; Jsum4 += (J & mask)>>24;\n"
-			"		pI += (pIn_stride>>2); pJ += (pIn_stride>>2);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		pI += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE; pJ += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE;\n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s2);\n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000))) & (int)maskIJ.s2;\n"
 			"		mask.s3	= select(0xff000000, 0u, ((I.s3==0x80000000) | (J.s3==0x80000000))) & (int)maskIJ.s3;\n"
 			"		Isum4	+= (I&mask)>>24; Jsum4 += (J & mask)>>24;\n"
-			"		I = vload4(1, pI); \n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI); \n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s3);\n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
@@ -309,7 +364,7 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 			"	uint2 offs = ((__global uint2 *)(exp_data+exp_data_offs))[grp_id];\n"
 			"	uint size = (uint)(pIn_stride*%d);\n"
 			, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name, height_one);
-		opencl_kernel_code = item;
+		opencl_kernel_code = exposure_comp_errorfn_sample_code(subsample) + item;
 		opencl_kernel_code +=
 			"	int lx = get_local_id(0);\n"
 			"	int ly = get_local_id(1);\n"
@@ -320,36 +375,37 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 			"		global uint *pI, *pJ;\n"
 			"		uint4  I, J, mask; \n"
 			"		uint4 Isum4, Jsum4;\n"
-			"		int   gx = (lx<<3) + ((offs.s0 >> 5) & 0x3FFF);\n"
-			"		int   gy = (ly<<1) + (offs.s0 >> 19);\n"
+			"		int   gx = (lx<<3)*EXPCOMP_SUBSAMPLE + ((offs.s0 >> 5) & 0x3FFF);\n"
+			"		int   nx = (int)(offs.s1&0x7f) + 1 - (lx<<3);\n"
+			"		int   gy = (ly<<1)*EXPCOMP_SUBSAMPLE + (offs.s0 >> 19);\n"
 			"		uint2 cam_id = (uint2)((offs.s0 & 0x1f), ((offs.s1>>12) & 0x1f));\n"
 			"		pIn_buf += pIn_offs + mad24(gy, (int)pIn_stride, (gx<<2));\n"
 			"		pI	   =  (global uint *)(pIn_buf + size*cam_id.x);\n"
 			"		pJ	   =  (global uint *)(pIn_buf + size*cam_id.y);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000)));\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000)));\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000)));\n"
 			"		mask.s3	= select(0xff000000, 0u, ((I.s3==0x80000000) | (J.s3==0x80000000)));\n"
 			"		Isum4	= (I&mask)>>24; Jsum4 = (J & mask)>>24;\n"
-			"		I = vload4(1, pI);\n"
-			"		J = vload4(1, pJ);\n"
+			"		I = EXPCOMP_LOAD4(1, pI);\n"
+			"		J = EXPCOMP_LOAD4(1, pJ);\n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000)));\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000)));\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000)));\n"
 			"		mask.s3	= select(0xff000000, 0u, ((I.s3==0x80000000) | (J.s3==0x80000000)));\n"
 			"		Isum4	+= (I&mask)>>24; Jsum4 += (J & mask)>>24;\n"
-			"		pI += (pIn_stride>>2); pJ += (pIn_stride>>2);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		pI += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE; pJ += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE;\n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000)));\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000)));\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000)));\n"
 			"		mask.s3	= select(0xff000000, 0u, ((I.s3==0x80000000) | (J.s3==0x80000000)));\n"
 			"		Isum4	+= (I&mask)>>24; Jsum4 += (J & mask)>>24;\n"
-			"		I = vload4(1, pI); \n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI); \n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		mask.s0	= select(0xff000000, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000)));\n"
 			"		mask.s1	= select(0xff000000, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000)));\n"
 			"		mask.s2	= select(0xff000000, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000)));\n"
@@ -399,13 +455,13 @@ static vx_status VX_CALLBACK exposure_comp_calcErrorFn_opencl_codegen(
 		"			idx1 = mad24(cam_id.x, cols, cam_id.y);\n"
 		"			t1 = ((local uint4*)sumI)[0] + ((local uint4*)sumI)[1];\n"
 		"			s1 = t1.s0 + t1.s1 + t1.s2 + t1.s3;\n"
-		"			atomic_add(&pAMat[idx1], (int)(s1*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(s1*EXPCOMP_SUM_SCALE));\n"
 		"		}\n"
 		"		else if (lid == 1){\n"
 		"			idx1 = mad24(cam_id.y, cols, cam_id.x);\n"
 		"			t1 = ((local uint4*)sumJ)[0] + ((local uint4*)sumJ)[1];\n"
 		"			s1 = t1.s0 + t1.s1 + t1.s2 + t1.s3;\n"
-		"			atomic_add(&pAMat[idx1], (int)(s1*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(s1*EXPCOMP_SUM_SCALE));\n"
 		"		}\n"
 		"	}\n"
 		"	}\n"
@@ -421,7 +477,7 @@ vx_status exposure_comp_calcErrorFn_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.expcomp_compute_gainmatrix",
 		AMDOVX_KERNEL_STITCHING_EXPCOMP_COMPUTE_GAINMAT,
 		exposure_comp_calcErrorFn_kernel,
-		5,
+		6,
 		exposure_comp_calcErrorFn_input_validator,
 		exposure_comp_calcErrorFn_output_validator,
 		nullptr,
@@ -440,6 +496,7 @@ vx_status exposure_comp_calcErrorFn_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_OPTIONAL));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 4, VX_OUTPUT, VX_TYPE_MATRIX, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 5, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
 	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
@@ -1061,6 +1118,40 @@ static vx_status VX_CALLBACK exposure_comp_solvegains_input_validator(vx_node no
 			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp_solve matrix data types are not valid\n");
 		}
 	}
+	else if (index == 5)
+	{ // optional scalar of type VX_TYPE_FLOAT32: temporal smoothing of the gains
+		vx_enum type = VX_TYPE_INVALID;
+		vx_float32 smoothing = 0.0f;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &type, sizeof(type)));
+		if (type == VX_TYPE_FLOAT32) {
+			ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)ref, &smoothing));
+			if (smoothing >= 0.0f && smoothing <= 1.0f) {
+				status = VX_SUCCESS;
+			}
+			else {
+				status = VX_ERROR_INVALID_VALUE;
+				vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp_solve smoothing value should be in range [0,1]\n");
+			}
+		}
+		else {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp_solve smoothing scalar type should be a float32\n");
+		}
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+	}
+	else if (index == 6)
+	{ // optional array of type VX_TYPE_FLOAT32: gains already applied to the pixels of the error function
+		vx_enum itemtype = VX_TYPE_INVALID;
+		ERROR_CHECK_STATUS(vxQueryArray((vx_array)ref, VX_ARRAY_ATTRIBUTE_ITEMTYPE, &itemtype, sizeof(itemtype)));
+		if (itemtype == VX_TYPE_FLOAT32) {
+			status = VX_SUCCESS;
+		}
+		else {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp_solve applied gains array type should be float32\n");
+		}
+		ERROR_CHECK_STATUS(vxReleaseArray((vx_array *)&ref));
+	}
 	return status;
 }
 
@@ -1137,9 +1228,24 @@ static vx_status VX_CALLBACK exposure_comp_solvegains_kernel(vx_node node, const
 		vxAddLogEntry((vx_reference)node, status, "ERROR: exposure_compensation_gain array capacity not enough\n");
 	}
 	numCameras = (vx_uint32)columns;
-	vx_size stride = 0;
-	void *base = NULL;
-	status = exp_comp->SolveForGains(alpha, beta, pIMat, pNMat, numCameras, arr, (vx_uint32)rows, (vx_uint32)columns);
+	vx_float32 smoothing = 0.0f;
+	if (num > 5 && parameters[5]) {
+		ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[5], &smoothing));
+	}
+	if (num > 6 && parameters[6]) {
+		// gains applied to the pixels the intensities were measured on (one per camera, or RGB per camera)
+		vx_array applied_arr = (vx_array)parameters[6];
+		vx_size count = 0, stride = 0;
+		ERROR_CHECK_STATUS(vxQueryArray(applied_arr, VX_ARRAY_ATTRIBUTE_NUMITEMS, &count, sizeof(count)));
+		if (count >= ((rows >= 3 * columns) ? 3 : 1) * numCameras) {
+			void *base = nullptr;
+			ERROR_CHECK_STATUS(vxAccessArrayRange(applied_arr, 0, count, &stride, &base, VX_READ_ONLY));
+			status = exp_comp->SolveForGains(alpha, beta, pIMat, pNMat, numCameras, arr, (vx_uint32)rows, (vx_uint32)columns, smoothing, (const vx_float32 *)base);
+			ERROR_CHECK_STATUS(vxCommitArrayRange(applied_arr, 0, count, base));
+			return status;
+		}
+	}
+	status = exp_comp->SolveForGains(alpha, beta, pIMat, pNMat, numCameras, arr, (vx_uint32)rows, (vx_uint32)columns, smoothing);
 	return status;
 }
 
@@ -1175,7 +1281,7 @@ vx_status exposure_comp_solvegains_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.expcomp_solvegains",
 		AMDOVX_KERNEL_STITCHING_EXPCOMP_SOLVE,
 		exposure_comp_solvegains_kernel,
-		5,
+		7,
 		exposure_comp_solvegains_input_validator,
 		exposure_comp_solvegains_output_validator,
 		exposure_comp_solvegains_initialize,
@@ -1187,6 +1293,8 @@ vx_status exposure_comp_solvegains_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_INPUT, VX_TYPE_MATRIX, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_INPUT, VX_TYPE_MATRIX, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 4, VX_OUTPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 5, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 6, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_OPTIONAL));
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
 	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
@@ -1265,6 +1373,27 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_input_validator(vx_nod
 		}
 		status = VX_SUCCESS;
 	}
+	else if (index == 5)
+	{ // optional object of SCALAR type: subsample step
+		vx_enum itemtype = VX_TYPE_INVALID;
+		vx_uint32 subsample = 0;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
+		if (itemtype == VX_TYPE_UINT32) {
+			ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)ref, &subsample));
+		}
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+		if (itemtype != VX_TYPE_UINT32) {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp subsample scalar type should be a UINT32\n");
+		}
+		else if (subsample != 1 && subsample != 2 && subsample != 4) {
+			status = VX_ERROR_INVALID_VALUE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: exp_comp subsample should be 1, 2, or 4\n");
+		}
+		else {
+			status = VX_SUCCESS;
+		}
+	}
 	return status;
 }
 
@@ -1338,6 +1467,12 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 		ERROR_CHECK_STATUS(vxQueryImage(mask_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &input_height, sizeof(input_height)));
 		ERROR_CHECK_STATUS(vxQueryImage(mask_image, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
 	}
+	vx_uint32 subsample = 1;
+	scalar = (vx_scalar)avxGetNodeParamRef(node, 5);
+	if (scalar) {
+		ERROR_CHECK_STATUS(vxReadScalarValue(scalar, &subsample));
+		ERROR_CHECK_STATUS(vxReleaseScalar(&scalar));
+	}
 
 	// set kernel configuration
 	vx_uint32 height_one = (vx_uint32)(input_height / num_cameras);
@@ -1360,6 +1495,7 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 		"	92, 93, 95, 96, 97, 99, 100, 101, 103, 104, 105, 107, 108, 109, 111, 112, 114, 115, 117, 118, 119, 121, 122, 124, 125, 127, 128, 130, 131, 133, 135, 136,\n"
 		"	138, 139, 141, 142, 144, 146, 147, 149, 151, 152, 154, 156, 157, 159, 161, 162, 164, 166, 168, 169, 171, 173, 175, 176, 178, 180, 182, 184, 186, 187, 189, 191,\n"
 		"	193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221, 223, 225, 227, 229, 231, 233, 235, 237, 239, 241, 244, 246, 248, 250, 252, 255};\n";
+	opencl_kernel_code += exposure_comp_errorfn_sample_code(subsample);
 	if (mask_image){
 		sprintf(item,
 			"#pragma OPENCL EXTENSION cl_amd_media_ops : enable\n"
@@ -1393,20 +1529,21 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		global uint *pI, *pJ;\n"
 			"		uint4 maskSrc, I, J, mask; \n"
 			"		uint4 Isum4, Jsum4;\n"
-			"		int   gx = (lx<<3) + ((offs.s0 >> 5) & 0x3FFF);\n"
-			"		int   gy = (ly<<1) + (offs.s0 >> 19);\n"
+			"		int   gx = (lx<<3)*EXPCOMP_SUBSAMPLE + ((offs.s0 >> 5) & 0x3FFF);\n"
+			"		int   nx = (int)(offs.s1&0x7f) + 1 - (lx<<3);\n"
+			"		int   gy = (ly<<1)*EXPCOMP_SUBSAMPLE + (offs.s0 >> 19);\n"
 			"		uint2 cam_id = (uint2)((offs.s0 & 0x1f), ((offs.s1>>12) & 0x1f));\n"
 			"		pIn_buf += pIn_offs + mad24(gy, (int)pIn_stride, (gx<<2));\n"
 			"		pWt_buf += pWt_offs + mad24(gy, (int)pWt_stride, gx);\n"
 			"		pI	   =  (global uint *)(pIn_buf + size*cam_id.x);\n"
 			"		pJ	   =  (global uint *)(pIn_buf + size*cam_id.y);\n"
-			"		maskSrc.s01	   =  *(global uint2 *)(pWt_buf + wt_size*cam_id.x);\n"
-			"		maskSrc.s01	   &=  *(global uint2 *)(pWt_buf + wt_size*cam_id.y); pWt_buf += pWt_stride;\n"
-			"		maskSrc.s23	   =  *(global uint2 *)(pWt_buf + wt_size*cam_id.x);\n"
-			"		maskSrc.s23	   &=  *(global uint2 *)(pWt_buf + wt_size*cam_id.y);\n"
+			"		maskSrc.s01	   =  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.x);\n"
+			"		maskSrc.s01	   &=  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.y); pWt_buf += pWt_stride*EXPCOMP_SUBSAMPLE;\n"
+			"		maskSrc.s23	   =  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.x);\n"
+			"		maskSrc.s23	   &=  EXPCOMP_LOAD_MASK8(pWt_buf + wt_size*cam_id.y);\n"
 			"		char4 maskIJ = as_char4(maskSrc.s0);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
 			"		mask.s2	= select(0xffffffff, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000))) & (int)maskIJ.s2;\n"
@@ -1423,8 +1560,8 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		Isum4 += convert_uint4(as_uchar4(I.s1 & mask.s1));		Jsum4 += convert_uint4(as_uchar4(J.s1 & mask.s1));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s2 & mask.s2));		Jsum4 += convert_uint4(as_uchar4(J.s2 & mask.s2));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s3 & mask.s3));		Jsum4 += convert_uint4(as_uchar4(J.s3 & mask.s3));\n"
-			"		I = vload4(1, pI);\n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI);\n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s1);\n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
@@ -1442,9 +1579,9 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		Isum4 += convert_uint4(as_uchar4(I.s1 & mask.s1));		Jsum4 += convert_uint4(as_uchar4(J.s1 & mask.s1));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s2 & mask.s2));		Jsum4 += convert_uint4(as_uchar4(J.s2 & mask.s2));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s3 & mask.s3));		Jsum4 += convert_uint4(as_uchar4(J.s3 & mask.s3));\n"
-			"		pI += (pIn_stride>>2); pJ += (pIn_stride>>2);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		pI += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE; pJ += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE;\n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s2);\n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
@@ -1462,8 +1599,8 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		Isum4 += convert_uint4(as_uchar4(I.s1 & mask.s1));		Jsum4 += convert_uint4(as_uchar4(J.s1 & mask.s1));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s2 & mask.s2));		Jsum4 += convert_uint4(as_uchar4(J.s2 & mask.s2));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s3 & mask.s3));		Jsum4 += convert_uint4(as_uchar4(J.s3 & mask.s3));\n"
-			"		I = vload4(1, pI); \n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI); \n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s3);\n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
@@ -1516,14 +1653,15 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		global uint *pI, *pJ;\n"
 			"		uint4  I, J, mask; \n"
 			"		uint4 Isum4, Jsum4;\n"
-			"		int   gx = (lx<<3) + ((offs.s0 >> 5) & 0x3FFF);\n"
-			"		int   gy = (ly<<1) + (offs.s0 >> 19);\n"
+			"		int   gx = (lx<<3)*EXPCOMP_SUBSAMPLE + ((offs.s0 >> 5) & 0x3FFF);\n"
+			"		int   nx = (int)(offs.s1&0x7f) + 1 - (lx<<3);\n"
+			"		int   gy = (ly<<1)*EXPCOMP_SUBSAMPLE + (offs.s0 >> 19);\n"
 			"		uint2 cam_id = (uint2)((offs.s0 & 0x1f), ((offs.s1>>12) & 0x1f));\n"
 			"		pIn_buf += pIn_offs + mad24(gy, (int)pIn_stride, (gx<<2));\n"
 			"		pI	   =  (global uint *)(pIn_buf + size*cam_id.x);\n"
 			"		pJ	   =  (global uint *)(pIn_buf + size*cam_id.y);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000)));\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000)));\n"
 			"		mask.s2	= select(0xffffffff, 0u, ((I.s2==0x80000000) | (J.s2==0x80000000)));\n"
@@ -1540,8 +1678,8 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		Isum4 += convert_uint4(as_uchar4(I.s1 & mask.s1));		Jsum4 += convert_uint4(as_uchar4(J.s1 & mask.s1));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s2 & mask.s2));		Jsum4 += convert_uint4(as_uchar4(J.s2 & mask.s2));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s3 & mask.s3));		Jsum4 += convert_uint4(as_uchar4(J.s3 & mask.s3));\n"
-			"		I = vload4(1, pI);\n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI);\n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s1);\n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000)));\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000)));\n"
@@ -1559,9 +1697,9 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		Isum4 += convert_uint4(as_uchar4(I.s1 & mask.s1));		Jsum4 += convert_uint4(as_uchar4(J.s1 & mask.s1));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s2 & mask.s2));		Jsum4 += convert_uint4(as_uchar4(J.s2 & mask.s2));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s3 & mask.s3));		Jsum4 += convert_uint4(as_uchar4(J.s3 & mask.s3));\n"
-			"		pI += (pIn_stride>>2); pJ += (pIn_stride>>2);\n"
-			"		I = vload4(0, pI);\n"
-			"		J = vload4(0, pJ); \n"
+			"		pI += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE; pJ += (pIn_stride>>2)*EXPCOMP_SUBSAMPLE;\n"
+			"		I = EXPCOMP_LOAD4(0, pI);\n"
+			"		J = EXPCOMP_LOAD4(0, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s2);\n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
@@ -1579,8 +1717,8 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 			"		Isum4 += convert_uint4(as_uchar4(I.s1 & mask.s1));		Jsum4 += convert_uint4(as_uchar4(J.s1 & mask.s1));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s2 & mask.s2));		Jsum4 += convert_uint4(as_uchar4(J.s2 & mask.s2));\n"
 			"		Isum4 += convert_uint4(as_uchar4(I.s3 & mask.s3));		Jsum4 += convert_uint4(as_uchar4(J.s3 & mask.s3));\n"
-			"		I = vload4(1, pI); \n"
-			"		J = vload4(1, pJ); \n"
+			"		I = EXPCOMP_LOAD4(1, pI); \n"
+			"		J = EXPCOMP_LOAD4(1, pJ); \n"
 			"		maskIJ = as_char4(maskSrc.s3);\n"
 			"		mask.s0	= select(0xffffffff, 0u, ((I.s0==0x80000000) | (J.s0==0x80000000))) & (int)maskIJ.s0;\n"
 			"		mask.s1	= select(0xffffffff, 0u, ((I.s1==0x80000000) | (J.s1==0x80000000))) & (int)maskIJ.s1;\n"
@@ -1644,20 +1782,20 @@ static vx_status VX_CALLBACK exposure_comp_calcRGBErrorFn_opencl_codegen(
 		"		{\n"
 		"			idx1 = mad24(cam_id.x, cols, cam_id.y);\n"
 		"			uint4 sum	= sumI[0] + sumI[1] + sumI[2] + sumI[3];\n"
-		"			atomic_add(&pAMat[idx1], (int)(sum.s0*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(sum.s0*EXPCOMP_SUM_SCALE));\n"
 		"			idx1 += mul24(cols, row1);\n"
-		"			atomic_add(&pAMat[idx1], (int)(sum.s1*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(sum.s1*EXPCOMP_SUM_SCALE));\n"
 		"			idx1 += mul24(cols, row1);\n"
-		"			atomic_add(&pAMat[idx1], (int)(sum.s2*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(sum.s2*EXPCOMP_SUM_SCALE));\n"
 		"		}\n"
 		"		else if (lid == 1){\n"
 		"			idx1 = mad24(cam_id.y, cols, cam_id.x);\n"
 		"			uint4 sum = sumJ[0] + sumJ[1] + sumJ[2] + sumJ[3];\n"
-		"			atomic_add(&pAMat[idx1], (int)(sum.s0*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(sum.s0*EXPCOMP_SUM_SCALE));\n"
 		"			idx1 += mul24(cols, row1);\n"
-		"			atomic_add(&pAMat[idx1], (int)(sum.s1*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(sum.s1*EXPCOMP_SUM_SCALE));\n"
 		"			idx1 += mul24(cols, row1);\n"
-		"			atomic_add(&pAMat[idx1], (int)(sum.s2*0.0625f));\n"
+		"			atomic_add(&pAMat[idx1], (int)(sum.s2*EXPCOMP_SUM_SCALE));\n"
 		"		}\n"
 		"	}\n"
 		"	}\n"
@@ -1680,7 +1818,7 @@ vx_status exposure_comp_calcRGBErrorFn_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.expcomp_compute_gainmatrix_rgb",
 		AMDOVX_KERNEL_STITCHING_EXPCOMP_COMPUTE_GAINMAT_RGB,
 		exposure_comp_calcRGBErrorFn_kernel,
-		5,
+		6,
 		exposure_comp_calcRGBErrorFn_input_validator,
 		exposure_comp_calcRGBErrorFn_output_validator,
 		nullptr,
@@ -1699,6 +1837,7 @@ vx_status exposure_comp_calcRGBErrorFn_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_OPTIONAL));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 4, VX_OUTPUT, VX_TYPE_MATRIX, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 5, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
 	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
@@ -1736,6 +1875,7 @@ vx_status CalculateSmallestExpCompBufferSizes(
 	const vx_uint32 * paddedPixelCamMap,           // [in] padded pixel camera index map: size: [eqrWidth * eqrHeight](optional)
 	const vx_rectangle_t * const * overlapPadded,  // [in] overlap regions: overlapPadded[cam_i][cam_j] for overlap of cam_i and cam_j, cam_j <= cam_i(optional)
 	const vx_uint32 * paddedCamOverlapInfo,        // [in] camera overlap info - use "paddedCamOverlapInfo[cam_i] & (1 << cam_j)": size: [32](optional)
+	vx_uint32 overlapSubsample,                    // [in] subsample step of the overlap table entries: 1, 2, or 4
 	vx_size * validTableEntryCount,                // [out] number of entries needed by expComp valid table
 	vx_size * overlapTableEntryCount               // [out] number of entries needed by expComp overlap table
 	)
@@ -1773,18 +1913,19 @@ vx_status CalculateSmallestExpCompBufferSizes(
 		}
 	}
 
-	// count overlapTable entries
+	// count overlapTable entries: blocks of 128x32 samples
 	vx_uint32 overlapEntryCount = 0;
+	vx_uint32 blockWidth = 128 * overlapSubsample, blockHeight = 32 * overlapSubsample;
 	for (vx_uint32 i = 1; i < numCamera; i++) {
 		for (vx_uint32 j = 0; j < i; j++) {
 			vx_uint32 overlapMaskBits = (1 << i) | (1 << j);
 			vx_uint32 start_x = overlapRegion[i][j].start_x, end_x = overlapRegion[i][j].end_x;
 			vx_uint32 start_y = overlapRegion[i][j].start_y, end_y = overlapRegion[i][j].end_y;
 			if ((start_x < end_x) && (start_y < end_y))	{
-				for (vx_uint32 ys = start_y; ys < end_y; ys += 32) {
-					for (vx_uint32 xs = start_x; xs < end_x; xs += 128) {
-						vx_uint32 xe = (xs + 128) < end_x ? (xs + 128) : end_x;
-						vx_uint32 ye = (ys + 32) < end_y ? (ys + 32) : end_y;
+				for (vx_uint32 ys = start_y; ys < end_y; ys += blockHeight) {
+					for (vx_uint32 xs = start_x; xs < end_x; xs += blockWidth) {
+						vx_uint32 xe = (xs + blockWidth) < end_x ? (xs + blockWidth) : end_x;
+						vx_uint32 ye = (ys + blockHeight) < end_y ? (ys + blockHeight) : end_y;
 						// count valid pixels
 						vx_int32 count = 0;
 						for (vx_uint32 y = ys; y < ye; y++) {
@@ -1823,6 +1964,7 @@ vx_status GenerateExpCompBuffers(
 	const vx_uint32 * paddedPixelCamMap,           // [in] padded pixel camera index map: size: [eqrWidth * eqrHeight](optional)
 	const vx_rectangle_t * const * overlapPadded,  // [in] overlap regions: overlapPadded[cam_i][cam_j] for overlap of cam_i and cam_j, cam_j <= cam_i(optional)
 	const vx_uint32 * paddedCamOverlapInfo,        // [in] camera overlap info - use "paddedCamOverlapInfo[cam_i] & (1 << cam_j)": size: [32](optional)
+	vx_uint32 overlapSubsample,                    // [in] subsample step of the overlap table entries: 1, 2, or 4
 	vx_size validTableSize,                        // [in] size of valid table, in terms of number of entries
 	vx_size overlapTableSize,                      // [in] size of overlap table, in terms of number of entries
 	StitchExpCompCalcEntry * validTable,           // [out] expComp valid table
@@ -1877,19 +2019,20 @@ vx_status GenerateExpCompBuffers(
 		}
 	}
 
-	// generate overlapTable and overlapPixelCountMatrix
+	// generate overlapTable (blocks of 128x32 samples) and overlapPixelCountMatrix (full resolution pixel counts)
 	memset(overlapPixelCountMatrix, 0, numCamera * numCamera * sizeof(vx_int32));
 	vx_uint32 overlapEntryCount = 0;
+	vx_uint32 blockWidth = 128 * overlapSubsample, blockHeight = 32 * overlapSubsample;
 	for (vx_uint32 i = 1; i < numCamera; i++) {
 		for (vx_uint32 j = 0; j < i; j++) {
 			vx_uint32 overlapMaskBits = (1 << i) | (1 << j);
 			vx_uint32 start_x = overlapRegion[i][j].start_x, end_x = overlapRegion[i][j].end_x;
 			vx_uint32 start_y = overlapRegion[i][j].start_y, end_y = overlapRegion[i][j].end_y;
 			if ((start_x < end_x) && (start_y < end_y))	{
-				for (vx_uint32 ys = start_y; ys < end_y; ys += 32) {
-					for (vx_uint32 xs = start_x; xs < end_x; xs += 128) {
-						vx_uint32 xe = (xs + 128) < end_x ? (xs + 128) : end_x;
-						vx_uint32 ye = (ys +  32) < end_y ? (ys +  32) : end_y;
+				for (vx_uint32 ys = start_y; ys < end_y; ys += blockHeight) {
+					for (vx_uint32 xs = start_x; xs < end_x; xs += blockWidth) {
+						vx_uint32 xe = (xs + blockWidth) < end_x ? (xs + blockWidth) : end_x;
+						vx_uint32 ye = (ys + blockHeight) < end_y ? (ys + blockHeight) : end_y;
 						// count valid pixels
 						vx_int32 count = 0;
 						for (vx_uint32 y = ys; y < ye; y++) {
@@ -1909,8 +2052,8 @@ vx_status GenerateExpCompBuffers(
 									overlapEntry.camId0 = i;
 									overlapEntry.start_x = xs;
 									overlapEntry.start_y = ys;
-									overlapEntry.end_x = xe - xs - 1;
-									overlapEntry.end_y = ye - ys - 1;
+									overlapEntry.end_x = (xe - xs + overlapSubsample - 1) / overlapSubsample - 1;
+									overlapEntry.end_y = (ye - ys + overlapSubsample - 1) / overlapSubsample - 1;
 									overlapEntry.camId1 = j;
 									overlapEntry.camId2 = 0x1F;
 									overlapEntry.camId3 = 0x1F;
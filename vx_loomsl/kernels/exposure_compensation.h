@@ -63,6 +63,8 @@ vx_status exposure_comp_calcRGBErrorFn_publish(vx_context context);
 //   CalculateLargestExpCompBufferSizes  - useful when reinitialize is enabled
 //   CalculateSmallestExpCompBufferSizes - useful when reinitialize is disabled
 //   GenerateExpCompBuffers              - generate tables
+// Each overlap table entry covers a block of 128x32 samples: with overlapSubsample > 1 the samples are every
+// overlapSubsample-th pixel of every overlapSubsample-th row, and end_x/end_y are in samples.
 
 vx_status CalculateLargestExpCompBufferSizes(
 	vx_uint32 numCamera,                    // [in] number of cameras
@@ -82,6 +84,7 @@ vx_status CalculateSmallestExpCompBufferSizes(
 	const vx_uint32 * paddedPixelCamMap,           // [in] padded pixel camera index map: size: [eqrWidth * eqrHeight](optional)
 	const vx_rectangle_t * const * overlapPadded,  // [in] overlap regions: overlapPadded[cam_i][cam_j] for overlap of cam_i and cam_j, cam_j <= cam_i(optional)
 	const vx_uint32 * paddedCamOverlapInfo,        // [in] camera overlap info - use "paddedCamOverlapInfo[cam_i] & (1 << cam_j)": size: [32](optional)
+	vx_uint32 overlapSubsample,                    // [in] subsample step of the overlap table entries: 1, 2, or 4
 	vx_size * validTableEntryCount,                // [out] number of entries needed by expComp valid table
 	vx_size * overlapTableEntryCount               // [out] number of entries needed by expComp overlap table
 	);
@@ -96,6 +99,7 @@ vx_status GenerateExpCompBuffers(
 	const vx_uint32 * paddedPixelCamMap,           // [in] padded pixel camera index map: size: [eqrWidth * eqrHeight](optional)
 	const vx_rectangle_t * const * overlapPadded,  // [in] overlap regions: overlapPadded[cam_i][cam_j] for overlap of cam_i and cam_j, cam_j <= cam_i(optional)
 	const vx_uint32 * paddedCamOverlapInfo,        // [in] camera overlap info - use "paddedCamOverlapInfo[cam_i] & (1 << cam_j)": size: [32](optional)
+	vx_uint32 overlapSubsample,                    // [in] subsample step of the overlap table entries: 1, 2, or 4
 	vx_size validTableSize,                        // [in] size of valid table, in terms of number of entries
 	vx_size overlapTableSize,                      // [in] size of overlap table, in terms of number of entries
 	StitchExpCompCalcEntry * validTable,           // [out] expComp valid table
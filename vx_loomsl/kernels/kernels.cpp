@@ -63,6 +63,7 @@ SHARED_PUBLIC vx_status VX_API_CALL vxPublishKernels(vx_context context)
 	ERROR_CHECK_STATUS(upscale_gaussian_subtract_publish(context));
 	ERROR_CHECK_STATUS(upscale_gaussian_add_publish(context));
 	ERROR_CHECK_STATUS(laplacian_reconstruct_publish(context));
+	ERROR_CHECK_STATUS(area_downscale_publish(context));
 	ERROR_CHECK_STATUS(seamfind_model_publish(context));
 	ERROR_CHECK_STATUS(seamfind_scene_detect_publish(context));
 	ERROR_CHECK_STATUS(seamfind_cost_generate_publish(context));
@@ -73,6 +74,7 @@ SHARED_PUBLIC vx_status VX_API_CALL vxPublishKernels(vx_context context)
 	ERROR_CHECK_STATUS(exposure_comp_calcRGBErrorFn_publish(context));
 	ERROR_CHECK_STATUS(chroma_key_mask_generation_publish(context));
 	ERROR_CHECK_STATUS(chroma_key_merge_publish(context));
+	ERROR_CHECK_STATUS(chroma_key_fused_publish(context));
 	ERROR_CHECK_STATUS(noise_filter_publish(context));
 	ERROR_CHECK_STATUS(warp_eqr_to_aze_publish(context));
 	ERROR_CHECK_STATUS(calc_lens_distortionwarp_map_publish(context));
@@ -195,6 +197,92 @@ bool StitchGetEnvironmentVariable(const char * name, char * value, size_t valueS
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////
+// persistent worker thread pool
+
+StitchThreadPool::StitchThreadPool(vx_uint32 numThreads)
+	: m_func(nullptr), m_numItems(0), m_busy(0), m_generation(0), m_nextItem(0), m_exit(false)
+{
+	if (numThreads == 0)
+		numThreads = (vx_uint32)std::thread::hardware_concurrency();
+	for (vx_uint32 i = 1; i < numThreads; i++)
+		m_workers.push_back(std::thread(&StitchThreadPool::WorkerLoop, this));
+}
+
+StitchThreadPool::~StitchThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exit = true;
+	}
+	m_cvWork.notify_all();
+	for (auto& t : m_workers) t.join();
+}
+
+void StitchThreadPool::Run(vx_uint32 numItems, const std::function<void(vx_uint32)>& func)
+{
+	if (m_workers.empty() || numItems <= 1) {
+		for (vx_uint32 item = 0; item < numItems; item++)
+			func(item);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = &func;
+		m_numItems = numItems;
+		m_nextItem = 0;
+		m_busy = (vx_uint32)m_workers.size();
+		m_generation++;
+	}
+	m_cvWork.notify_all();
+	RunItems();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cvDone.wait(lock, [this] { return m_busy == 0; });
+	m_func = nullptr;
+}
+
+void StitchThreadPool::RunItems()
+{
+	for (vx_uint32 item = m_nextItem++; item < m_numItems; item = m_nextItem++)
+		(*m_func)(item);
+}
+
+void StitchThreadPool::WorkerLoop()
+{
+	vx_uint32 generation = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cvWork.wait(lock, [&] { return m_exit || m_generation != generation; });
+			if (m_exit)
+				return;
+			generation = m_generation;
+		}
+		RunItems();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busy == 0)
+			m_cvDone.notify_one();
+	}
+}
+
+// the shared pool lives until the process exits: its workers wait idle between calls
+static std::mutex g_sharedThreadPoolMutex;
+static StitchThreadPool * g_sharedThreadPool = nullptr;
+
+StitchThreadPool * StitchAcquireSharedThreadPool()
+{
+	if (!g_sharedThreadPoolMutex.try_lock())
+		return nullptr;
+	if (!g_sharedThreadPool)
+		g_sharedThreadPool = new StitchThreadPool();
+	return g_sharedThreadPool;
+}
+
+void StitchReleaseSharedThreadPool()
+{
+	g_sharedThreadPoolMutex.unlock();
+}
+
 /***********************************************************************************************************************************
 OVX Stich Nodes
 ************************************************************************************************************************************/
@@ -219,11 +307,17 @@ VX_API_ENTRY vx_node VX_API_CALL stitchColorConvertNode(vx_graph graph, vx_image
 /**
 * \brief Function to create Stitch Warp node
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchWarpNode(vx_graph graph, vx_enum method, vx_uint32 num_cam, vx_array ValidPixelEntry, vx_array WarpRemapEntry, vx_image input, vx_image output, vx_image outputLuma, vx_uint32 num_camera_columns)
+VX_API_ENTRY vx_node VX_API_CALL stitchWarpNode(vx_graph graph, vx_enum method, vx_uint32 num_cam, vx_array ValidPixelEntry, vx_array WarpRemapEntry, vx_image input, vx_image output, vx_image outputLuma, vx_uint32 num_camera_columns,
+	vx_array gains, vx_uint32 gain_width, vx_uint32 gain_height)
 {
 	vx_scalar METHOD = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_ENUM, &method);
 	vx_scalar NUM_CAM = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &num_cam);
 	vx_scalar s_num_camera_columns = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &num_camera_columns);
+	vx_scalar s_gain_width = nullptr, s_gain_height = nullptr;
+	if (gains && ((gain_width > 1) || (gain_height > 1))) {
+		s_gain_width = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &gain_width);
+		s_gain_height = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &gain_height);
+	}
 
 	vx_reference params[] = {
 		(vx_reference)METHOD,
@@ -234,6 +328,11 @@ VX_API_ENTRY vx_node VX_API_CALL stitchWarpNode(vx_graph graph, vx_enum method,
 		(vx_reference)output,
 		(vx_reference)outputLuma,
 		(vx_reference)s_num_camera_columns,
+		nullptr,
+		nullptr,
+		(vx_reference)gains,
+		(vx_reference)s_gain_width,
+		(vx_reference)s_gain_height,
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_WARP,
@@ -242,26 +341,38 @@ VX_API_ENTRY vx_node VX_API_CALL stitchWarpNode(vx_graph graph, vx_enum method,
 	vxReleaseScalar(&METHOD);
 	vxReleaseScalar(&NUM_CAM);
 	vxReleaseScalar(&s_num_camera_columns);
+	if (s_gain_width) vxReleaseScalar(&s_gain_width);
+	if (s_gain_height) vxReleaseScalar(&s_gain_height);
 	return node;
 }
 
 /**
 * \brief Function to create Stitch Merge node
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchMergeNode(vx_graph graph, vx_image camera_id_image, vx_image group1_image, vx_image group2_image, vx_image input, vx_image weight_image, vx_image output)
+VX_API_ENTRY vx_node VX_API_CALL stitchMergeNode(vx_graph graph, vx_image camera_id_image, vx_image group1_image, vx_image group2_image, vx_image input, vx_image weight_image, vx_image output,
+	vx_image camera_input, vx_array MergeRemapEntry, vx_uint32 num_camera_columns, vx_array gains)
 {
+	vx_scalar s_num_camera_columns = nullptr;
+	if (camera_input) {
+		s_num_camera_columns = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &num_camera_columns);
+	}
 	vx_reference params[] = {
 		(vx_reference)camera_id_image,
 		(vx_reference)group1_image,
 		(vx_reference)group2_image,
 		(vx_reference)input,
 		(vx_reference)weight_image,
-		(vx_reference)output
+		(vx_reference)output,
+		(vx_reference)camera_input,
+		(vx_reference)MergeRemapEntry,
+		(vx_reference)s_num_camera_columns,
+		(vx_reference)gains,
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_MERGE,
 		params,
 		dimof(params));
+	if (s_num_camera_columns) vxReleaseScalar(&s_num_camera_columns);
 
 	return node;
 }
@@ -269,12 +380,13 @@ VX_API_ENTRY vx_node VX_API_CALL stitchMergeNode(vx_graph graph, vx_image camera
 /**
 * \brief Function to create Stitch AlphaBlendnode
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchAlphaBlendNode(vx_graph graph, vx_image input_rgb, vx_image input_rgba, vx_image output_rgb)
+VX_API_ENTRY vx_node VX_API_CALL stitchAlphaBlendNode(vx_graph graph, vx_image input_rgb, vx_image input_rgba, vx_image output_rgb, vx_array regions)
 {
 	vx_reference params[] = {
 		(vx_reference)input_rgb,
 		(vx_reference)input_rgba,
-		(vx_reference)output_rgb
+		(vx_reference)output_rgb,
+		(vx_reference)regions
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_ALPHA_BLEND,
@@ -287,9 +399,12 @@ VX_API_ENTRY vx_node VX_API_CALL stitchAlphaBlendNode(vx_graph graph, vx_image i
 /**
 * \brief Function to create Calculate Error Function node
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnNode(vx_graph graph, vx_uint32 numCameras, vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity)
+VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnNode(vx_graph graph, vx_uint32 numCameras, vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity, vx_uint32 subsample)
 {
 	vx_scalar Num_Camera = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &numCameras);
+	vx_scalar Subsample = nullptr;
+	if (subsample > 1)
+		Subsample = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &subsample);
 
 	vx_reference params[] = {
 		(vx_reference)Num_Camera,
@@ -297,6 +412,7 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnNode(vx_graph grap
 		(vx_reference)exp_data,
 		(vx_reference)mask,
 		(vx_reference)out_intensity,
+		(vx_reference)Subsample,
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_EXPCOMP_COMPUTE_GAINMAT,
@@ -304,15 +420,19 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnNode(vx_graph grap
 		dimof(params));
 
 	vxReleaseScalar(&Num_Camera);
+	if (Subsample) vxReleaseScalar(&Subsample);
 	return node;
 }
 
 /**
 * \brief Function to create Calculate RGB Error Function node
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnRGBNode(vx_graph graph, vx_uint32 numCameras, vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity)
+VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnRGBNode(vx_graph graph, vx_uint32 numCameras, vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity, vx_uint32 subsample)
 {
 	vx_scalar Num_Camera = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &numCameras);
+	vx_scalar Subsample = nullptr;
+	if (subsample > 1)
+		Subsample = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &subsample);
 
 	vx_reference params[] = {
 		(vx_reference)Num_Camera,
@@ -320,6 +440,7 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnRGBNode(vx_graph g
 		(vx_reference)exp_data,
 		(vx_reference)mask,
 		(vx_reference)out_intensity,
+		(vx_reference)Subsample,
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_EXPCOMP_COMPUTE_GAINMAT_RGB,
@@ -327,16 +448,18 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnRGBNode(vx_graph g
 		dimof(params));
 
 	vxReleaseScalar(&Num_Camera);
+	if (Subsample) vxReleaseScalar(&Subsample);
 	return node;
 }
 
 /**
 * \brief Function to create Calculate Gains node
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompSolveForGainNode(vx_graph graph, vx_float32 alpha, vx_float32 beta, vx_matrix in_intensity, vx_matrix in_count, vx_array out_gains)
+VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompSolveForGainNode(vx_graph graph, vx_float32 alpha, vx_float32 beta, vx_matrix in_intensity, vx_matrix in_count, vx_array out_gains, vx_float32 smoothing, vx_array applied_gains)
 {
 	vx_scalar Alpha = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_FLOAT32, &alpha);
 	vx_scalar Beta = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_FLOAT32, &beta);
+	vx_scalar Smoothing = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_FLOAT32, &smoothing);
 
 	vx_reference params[] = {
 		(vx_reference)Alpha,
@@ -344,6 +467,8 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompSolveForGainNode(vx_graph gra
 		(vx_reference)in_intensity,
 		(vx_reference)in_count,
 		(vx_reference)out_gains,
+		(vx_reference)Smoothing,
+		(vx_reference)applied_gains,
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_EXPCOMP_SOLVE,
@@ -352,6 +477,7 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompSolveForGainNode(vx_graph gra
 
 	vxReleaseScalar(&Alpha);
 	vxReleaseScalar(&Beta);
+	vxReleaseScalar(&Smoothing);
 	return node;
 }
 
@@ -426,10 +552,14 @@ VX_API_ENTRY vx_node VX_API_CALL stitchSeamFindCostGenerateNode(vx_graph graph,
 
 //*\brief Function to create SeamFind Cost Accumulate Node - GPU 
 VX_API_ENTRY vx_node VX_API_CALL stitchSeamFindCostAccumulateNode(vx_graph graph, vx_scalar current_frame, vx_uint32 output_width, vx_uint32 output_height,
-	vx_image magnitude_img, vx_image phase_img, vx_image mask_img, vx_array valid_seam, vx_array pref_seam, vx_array info_seam, vx_array accum_seam)
+	vx_image magnitude_img, vx_image phase_img, vx_image mask_img, vx_array valid_seam, vx_array pref_seam, vx_array info_seam, vx_array accum_seam,
+	vx_uint32 coarse_scale)
 {
 	vx_scalar OUTPUT_WIDTH = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &output_width);
 	vx_scalar OUTPUT_HEIGHT = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &output_height);
+	vx_scalar COARSE_SCALE = nullptr;
+	if (coarse_scale > 1)
+		COARSE_SCALE = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &coarse_scale);
 
 	vx_reference params[] = {
 		(vx_reference)current_frame,
@@ -441,7 +571,8 @@ VX_API_ENTRY vx_node VX_API_CALL stitchSeamFindCostAccumulateNode(vx_graph graph
 		(vx_reference)valid_seam,
 		(vx_reference)pref_seam,
 		(vx_reference)info_seam,
-		(vx_reference)accum_seam
+		(vx_reference)accum_seam,
+		(vx_reference)COARSE_SCALE
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_SEAMFIND_COST_ACCUMULATE,
@@ -450,6 +581,7 @@ VX_API_ENTRY vx_node VX_API_CALL stitchSeamFindCostAccumulateNode(vx_graph graph
 
 	vxReleaseScalar(&OUTPUT_WIDTH);
 	vxReleaseScalar(&OUTPUT_HEIGHT);
+	if (COARSE_SCALE) vxReleaseScalar(&COARSE_SCALE);
 	return node;
 }
 
@@ -574,6 +706,24 @@ VX_API_ENTRY vx_node VX_API_CALL stitchMultiBandHalfScaleGaussianNode(vx_graph g
 	return node;
 }
 
+VX_API_ENTRY vx_node VX_API_CALL stitchAreaDownscaleNode(vx_graph graph, vx_uint32 scale, vx_image input, vx_image output)
+{
+	vx_scalar s_scale = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &scale);
+
+	vx_reference params[] = {
+		(vx_reference)s_scale,
+		(vx_reference)input,
+		(vx_reference)output
+	};
+	vx_node node = stitchCreateNode(graph,
+		AMDOVX_KERNEL_STITCHING_AREA_DOWNSCALE,
+		params,
+		dimof(params));
+
+	vxReleaseScalar(&s_scale);
+	return node;
+}
+
 VX_API_ENTRY vx_node VX_API_CALL stitchMultiBandUpscaleGaussianSubtractNode(vx_graph graph, vx_uint32 num_cameras, vx_uint32 blend_array_offs,
 	vx_image input1, vx_image input2, vx_array valid_arr, vx_image weight_img, vx_image output)
 {
@@ -688,16 +838,42 @@ VX_API_ENTRY vx_node VX_API_CALL stitchChromaKeyMergeNode(vx_graph graph, vx_ima
 	return node;
 }
 
+VX_API_ENTRY vx_node VX_API_CALL stitchChromaKeyFusedNode(vx_graph graph, vx_uint32 ChromaKey, vx_uint32 Tolerance, vx_uint32 ErodeDilate, vx_image input_rgb_img, vx_image input_chroma_img, vx_image output_merged_img)
+{
+	vx_scalar CHROMA_KEY = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &ChromaKey);
+	vx_scalar TOLERANCE = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &Tolerance);
+	vx_scalar ERODE_DILATE = vxCreateScalar(vxGetContext((vx_reference)graph), VX_TYPE_UINT32, &ErodeDilate);
+
+	vx_reference params[] = {
+		(vx_reference)CHROMA_KEY,
+		(vx_reference)TOLERANCE,
+		(vx_reference)ERODE_DILATE,
+		(vx_reference)input_rgb_img,
+		(vx_reference)input_chroma_img,
+		(vx_reference)output_merged_img
+	};
+	vx_node node = stitchCreateNode(graph,
+		AMDOVX_KERNEL_STITCHING_CHROMA_KEY_FUSED,
+		params,
+		dimof(params));
+
+	vxReleaseScalar(&CHROMA_KEY);
+	vxReleaseScalar(&TOLERANCE);
+	vxReleaseScalar(&ERODE_DILATE);
+	return node;
+}
+
 /***********************************************************************************************************************************
 Stitch Noise Filter
 ************************************************************************************************************************************/
-VX_API_ENTRY vx_node VX_API_CALL stitchNoiseFilterNode(vx_graph graph, vx_scalar lambda, vx_image input_rgb_img_1, vx_image input_rgb_img_2, vx_image denoised_image)
+VX_API_ENTRY vx_node VX_API_CALL stitchNoiseFilterNode(vx_graph graph, vx_scalar lambda, vx_image input_rgb_img_1, vx_image input_rgb_img_2, vx_image denoised_image, vx_scalar motion_threshold)
 {
 	vx_reference params[] = {
 		(vx_reference)lambda,
 		(vx_reference)input_rgb_img_1,
 		(vx_reference)input_rgb_img_2,
-		(vx_reference)denoised_image
+		(vx_reference)denoised_image,
+		(vx_reference)motion_threshold
 	};
 	vx_node node = stitchCreateNode(graph,
 		AMDOVX_KERNEL_STITCHING_NOISE_FILTER,
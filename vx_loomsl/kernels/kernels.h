@@ -47,7 +47,14 @@ THE SOFTWARE.
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <algorithm>
-
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// CPU kernels use 128-bit SSE intrinsics up to SSE4.2: the library is built with -msse4.2 (see CMakeLists.txt)
+// and the README lists SSE4.1 as the minimum CPU, so there are no AVX/AVX2 code paths
 #if _WIN32
 #include <intrin.h>
 #else
@@ -180,6 +187,12 @@ enum vx_kernel_stitching_amd_e {
 	//! \brief The warp to sphere kernel. Kernel name is "com.amd.loomsl.extend_padding_vert".
 	AMDOVX_KERNEL_STITCHING_INIT_EXTEND_PAD_VERT = VX_KERNEL_BASE(VX_ID_AMD, AMDOVX_LIBRARY_STITCHING) + 0x01c,
 
+	//! \brief The fused chroma key mask, erode/dilate, and merge kernel. Kernel name is "com.amd.loomsl.chroma_key_fused".
+	AMDOVX_KERNEL_STITCHING_CHROMA_KEY_FUSED = VX_KERNEL_BASE(VX_ID_AMD, AMDOVX_LIBRARY_STITCHING) + 0x01d,
+
+	//! \brief The RGB area downscale kernel. Kernel name is "com.amd.loomsl.area_downscale".
+	AMDOVX_KERNEL_STITCHING_AREA_DOWNSCALE = VX_KERNEL_BASE(VX_ID_AMD, AMDOVX_LIBRARY_STITCHING) + 0x01e,
+
 	// TBD: remove
 
 	//! \brief The Exposure Compensation kernel. Kernel name is "com.amd.loomsl.exposure_compensation_model".
@@ -214,11 +227,15 @@ VX_API_ENTRY vx_node VX_API_CALL stitchColorConvertNode(vx_graph graph, vx_image
 * \param [in] input The input image.
 * \param [out] output The output image.
 * \param [in] num_camera_columns The number of camera columns (optional)
+* \param [in] gains The exposure comp gains applied to the output pixels, same layout as for ExposureCompApplyGain (optional)
+* \param [in] gain_width The gain image width per camera: gains are sampled per output pixel when width or height is above 1
+* \param [in] gain_height The gain image height per camera
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
 VX_API_ENTRY vx_node VX_API_CALL stitchWarpNode(vx_graph graph, vx_enum method, vx_uint32 num_cam,
-	vx_array ValidPixelEntry, vx_array WarpRemapEntry, vx_image input, vx_image output, vx_image outputLuma, vx_uint32 num_camera_columns);
+	vx_array ValidPixelEntry, vx_array WarpRemapEntry, vx_image input, vx_image output, vx_image outputLuma, vx_uint32 num_camera_columns,
+	vx_array gains, vx_uint32 gain_width, vx_uint32 gain_height);
 
 /*! \brief [Graph] Creates a Stitch Merge node.
 * \param [in] graph The reference to the graph.
@@ -228,23 +245,37 @@ VX_API_ENTRY vx_node VX_API_CALL stitchWarpNode(vx_graph graph, vx_enum method,
 * \param [in] input The input image.
 * \param [in] input The weight image.
 * \param [out] output The output image.
-* \param [out/optional] output The output U8 image containing the X plane of output RGBX
-* \param [in/optional] input The number of camera columns (uint32 scalar)
-* \param [in/optional] input The external alpha value (uint32 scalar)
+* \param [in/optional] camera_input The RGB camera input image to sample the single camera pixels from (nullptr: read from input image).
+* \param [in/optional] MergeRemapEntry The remap entries of single camera pixels (StitchWarpRemapEntry), indexed by group1/group2 images.
+* \param [in] num_camera_columns The number of camera columns in camera_input.
+* \param [in/optional] gains The exposure comp gains applied to the single camera pixels: one (mono) or three (RGB) gains per camera.
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchMergeNode(vx_graph graph, vx_image camera_id_image, vx_image group1_image, vx_image group2_image, vx_image input, vx_image weight_image, vx_image output);
+VX_API_ENTRY vx_node VX_API_CALL stitchMergeNode(vx_graph graph, vx_image camera_id_image, vx_image group1_image, vx_image group2_image, vx_image input, vx_image weight_image, vx_image output,
+	vx_image camera_input, vx_array MergeRemapEntry, vx_uint32 num_camera_columns, vx_array gains);
 
 /*! \brief [Graph] Creates a AlphaBlend node.
 * \param [in] graph The reference to the graph.
 * \param [in] input_rgb Input RGB image.
 * \param [in] input_rgba Input RGBX image with alpha channel.
 * \param [out] output_rgb Output RGB image.
+* \param [in/optional] regions Array of VX_TYPE_RECTANGLE: only these regions are blended, the rest of input_rgba isn't read.
+*        The array can be updated before each frame up to its capacity of items.
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchAlphaBlendNode(vx_graph graph, vx_image input_rgb, vx_image input_rgba, vx_image output_rgb);
+VX_API_ENTRY vx_node VX_API_CALL stitchAlphaBlendNode(vx_graph graph, vx_image input_rgb, vx_image input_rgba, vx_image output_rgb, vx_array regions);
+
+/*! \brief [Graph] Creates a AreaDownscale node.
+* \param [in] graph The reference to the graph.
+* \param [in] scale The downscale factor N.
+* \param [in] input Input RGB image.
+* \param [out] output Output RGB image of the input dimensions divided by N: each pixel is the average of a NxN input block.
+* \return <tt>\ref vx_node</tt>.
+* \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
+*/
+VX_API_ENTRY vx_node VX_API_CALL stitchAreaDownscaleNode(vx_graph graph, vx_uint32 scale, vx_image input, vx_image output);
 
 /*! \brief [Graph] Creates a ExposureCompCalcErrorFn node.
 * \param [in] graph      The reference to the graph.
@@ -253,11 +284,12 @@ VX_API_ENTRY vx_node VX_API_CALL stitchAlphaBlendNode(vx_graph graph, vx_image i
 * \param [in] exp_data   Input Array of expdata.
 * \param [in] mask       Mask image.
 * \param [out] out_intensity     Output matrix for sum of overlapping pixels.
+* \param [in] subsample  Subsample step of the overlap pixels: 1, 2, or 4 (exp_data entries generated with the same step)
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
 VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnNode(vx_graph graph, vx_uint32 numCameras,
-	vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity);
+	vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity, vx_uint32 subsample);
 
 
 /*! \brief [Graph] Creates a ExposureCompSolveForGain node.
@@ -267,11 +299,13 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnNode(vx_graph grap
 * \param [in] in_intensity  Input matrix for sum of overlapping pixels.
 * \param [in] in_count      Input matrix for count of overlapping pixels.
 * \param [out] out_gains    Output array for gains.
+* \param [in] smoothing     Temporal smoothing: weight of the gains of the previous frame in range [0,1] (0: no smoothing, 1: keep the gains of the previous frame)
+* \param [in] applied_gains Optional input array of the gains already applied to the pixels of the error function (can be nullptr)
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
 VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompSolveForGainNode(vx_graph graph, vx_float32 alpha,
-	vx_float32 beta, vx_matrix in_intensity, vx_matrix in_count, vx_array out_gains);
+	vx_float32 beta, vx_matrix in_intensity, vx_matrix in_count, vx_array out_gains, vx_float32 smoothing, vx_array applied_gains);
 
 /*! \brief [Graph] Creates a ExposureCompApplyGain node.
 * \param [in] graph      The reference to the graph.
@@ -295,11 +329,12 @@ VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompApplyGainNode(vx_graph graph,
 * \param [in] exp_data   Input Array of expdata.
 * \param [in] mask       Mask image.
 * \param [out] out_intensity     Output matrix for sum of overlapping pixels.
+* \param [in] subsample  Subsample step of the overlap pixels: 1, 2, or 4 (exp_data entries generated with the same step)
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
 VX_API_ENTRY vx_node VX_API_CALL stitchExposureCompCalcErrorFnRGBNode(vx_graph graph, vx_uint32 numCameras,
-	vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity);
+	vx_image input, vx_array exp_data, vx_image mask, vx_matrix out_intensity, vx_uint32 subsample);
 
 
 /*! \brief [Graph] Creates a stitchBlendMultiBandMerge node.
@@ -410,12 +445,14 @@ VX_API_ENTRY vx_node VX_API_CALL stitchSeamFindCostGenerateNode(vx_graph graph,
 * \param [in] pref_seam     The input array of seam preference.
 * \param [in] info_seam     The input seam info array.
 * \param [out] output       The output seam_accum array.
+* \param [in] coarse_scale  The cost downsampling factor for coarse-to-fine seam search (0 or 1: OFF, CPU only).
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
 VX_API_ENTRY vx_node VX_API_CALL stitchSeamFindCostAccumulateNode(vx_graph graph, vx_scalar current_frame,
 	vx_uint32 output_width, vx_uint32 output_height, vx_image magnitude_img, vx_image phase_img,
-	vx_image mask_img, vx_array valid_seam, vx_array pref_seam, vx_array info_seam, vx_array accum_seam);
+	vx_image mask_img, vx_array valid_seam, vx_array pref_seam, vx_array info_seam, vx_array accum_seam,
+	vx_uint32 coarse_scale);
 
 /*! \brief [Graph] Creates a SeamFind Accumulate node K4 - GPU/CPU.
 * \param [in] graph The reference to the graph.
@@ -484,17 +521,31 @@ VX_API_ENTRY vx_node VX_API_CALL stitchChromaKeyMaskGeneratorNode(vx_graph graph
 */
 VX_API_ENTRY vx_node VX_API_CALL stitchChromaKeyMergeNode(vx_graph graph, vx_image input_rgb_img, vx_image input_chroma_img, vx_image input_mask_img, vx_image output_merged_img);
 
+/*! \brief [Graph] Creates a stitch Chroma Key Node that generates the mask, optionally erodes and dilates it, and merges in one pass - CPU.
+* \param [in] graph				The reference to the graph.
+* \param [in] ChromaKey			The input Chroma Key.
+* \param [in] ChromaKeyTol		The input Chroma Key tolerance.
+* \param [in] ErodeDilate		The input flag to erode and dilate the mask with 3x3 kernels.
+* \param [in] input_rgb_img		The input stitched output image.
+* \param [in] input_chroma_img	The input Chroma image.
+* \param [out] output			The output chorma merged image.
+* \return <tt>\ref vx_node</tt>.
+* \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
+*/
+VX_API_ENTRY vx_node VX_API_CALL stitchChromaKeyFusedNode(vx_graph graph, vx_uint32 ChromaKey, vx_uint32 ChromaKeyTol, vx_uint32 ErodeDilate, vx_image input_rgb_img, vx_image input_chroma_img, vx_image output_merged_img);
+
 
-/*! \brief [Graph] Creates a stitch Noise Filter Node- GPU.
+/*! \brief [Graph] Creates a stitch Noise Filter Node- GPU/CPU.
 * \param [in] graph				The reference to the graph.
 * \param [in] lambda			The input scalar lambda.
 * \param [in] input_rgb_img		The input camera image.
 * \param [in] input_rgb_img		The input delayed camera image.
 * \param [out] output			The output denoised image.
+* \param [in] motion_threshold	The optional input scalar motion threshold for per-block motion adaptive lambda (selects the CPU target, 0 or nullptr to disable).
 * \return <tt>\ref vx_node</tt>.
 * \retval vx_node A node reference. Any possible errors preventing a successful creation should be checked using <tt>\ref vxGetStatus</tt>
 */
-VX_API_ENTRY vx_node VX_API_CALL stitchNoiseFilterNode(vx_graph graph, vx_scalar lambda, vx_image input_rgb_img_1, vx_image input_rgb_img_2, vx_image denoised_image);
+VX_API_ENTRY vx_node VX_API_CALL stitchNoiseFilterNode(vx_graph graph, vx_scalar lambda, vx_image input_rgb_img_1, vx_image input_rgb_img_2, vx_image denoised_image, vx_scalar motion_threshold = nullptr);
 
 /*! \brief [Graph] Creates a stitch Equirectangular to Azimuthal Equidistant projection Node- GPU.
 * \param [in] graph					The reference to the graph.
@@ -522,6 +573,58 @@ vx_node stitchCreateNode(vx_graph graph, vx_enum kernelEnum, vx_reference params
 vx_node stitchCreateNode(vx_graph graph, const char * kernelName, vx_reference params[], vx_uint32 num);
 bool StitchGetEnvironmentVariable(const char * name, char * value, size_t valueSize);
 
+//////////////////////////////////////////////////////////////////////
+//! \brief A persistent pool of worker threads for kernels that run every frame on CPU.
+//  Run(numItems, func) calls func(item) for each item in [0, numItems) on the workers and the calling
+//  thread, and returns after all items are done. Items are handed out dynamically, so they can be of
+//  different sizes. Only one Run can be active at a time.
+class StitchThreadPool
+{
+public:
+	StitchThreadPool(vx_uint32 numThreads = 0); // 0: one thread per core (including the calling thread)
+	~StitchThreadPool();
+	void Run(vx_uint32 numItems, const std::function<void(vx_uint32)>& func);
+	vx_uint32 GetNumThreads() const { return (vx_uint32)m_workers.size() + 1; }
+
+private:
+	void WorkerLoop();
+	void RunItems();
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_cvWork, m_cvDone;
+	const std::function<void(vx_uint32)> * m_func;
+	vx_uint32 m_numItems, m_busy, m_generation;
+	std::atomic<vx_uint32> m_nextItem;
+	bool m_exit;
+};
+
+//////////////////////////////////////////////////////////////////////
+//! \brief The thread pool shared by StitchParallelFor, created on first use with one thread per core.
+//  Acquire returns nullptr when the pool is running another call; release the acquired pool after Run.
+StitchThreadPool * StitchAcquireSharedThreadPool();
+void StitchReleaseSharedThreadPool();
+
+//////////////////////////////////////////////////////////////////////
+//! \brief Run func(start, end) over contiguous ranges of [0, count) on the shared thread pool.
+//  Returns after all ranges are done. When the pool is busy with another call (from a concurrent graph),
+//  the ranges run on the calling thread, as the cores are already in use.
+template<typename F> static void StitchParallelFor(vx_uint32 count, F func)
+{
+	StitchThreadPool * pool = StitchAcquireSharedThreadPool();
+	vx_uint32 numRanges = pool ? std::min(pool->GetNumThreads(), count) : 1;
+	if (numRanges <= 1) {
+		if (pool) StitchReleaseSharedThreadPool();
+		func(0u, count);
+		return;
+	}
+	vx_uint32 rangeSize = (count + numRanges - 1) / numRanges;
+	pool->Run(numRanges, [&](vx_uint32 i) {
+		vx_uint32 start = std::min(count, i * rangeSize), end = std::min(count, start + rangeSize);
+		if (start < end) func(start, end);
+	});
+	StitchReleaseSharedThreadPool();
+}
+
 //////////////////////////////////////////////////////////////////////
 //! \brief The macro for error checking from OpenVX status.
 #define ERROR_CHECK_STATUS(call) { vx_status status = (call); if(status != VX_SUCCESS){ printf("ERROR: failed with status = (%d) at " __FILE__ "#%d\n", status, __LINE__); return status; }}
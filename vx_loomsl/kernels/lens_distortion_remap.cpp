@@ -126,34 +126,40 @@ vx_status CalculateCameraWarpParameters(
 }
 
 //////////////////////////////////////////////////////////////////////
-// lens models
-static inline float ptgui_lens_rectilinear_model(float th, float fr, float a, float b, float c, float d)
+// lens models: radius polynomials with scalar and SSE versions that evaluate
+// in the same order so that both produce bit-identical results
+static inline float ptgui_lens_poly(float r, float a, float b, float c, float d)
 {
-	float r = tanf(th) * fr;
 	return r * (d + r * (c + r * (b + r * a)));
 }
-static inline float ptgui_lens_fisheye_model(float th, float fr, float a, float b, float c, float d)
+static inline float adobe_lens_poly(float r, float k1, float k2, float k3)
 {
-	float r = th * fr;
-	return r * (d + r * (c + r * (b + r * a)));
+	float r2 = r * r;
+	return r * (1 + r2 * (k1 + r2 * (k2 + r2 * k3)));
 }
-static inline float adobe_lens_rectilinear_model(float th, float fr, float k1, float k2, float k3, float k0)
+static inline __m128 ptgui_lens_poly_sse(__m128 r, __m128 a, __m128 b, __m128 c, __m128 d)
 {
-	float r = tanf(th) * fr, r2 = r * r;
-	return r * (1 + r2 * (k1 + r2 * (k2 + r2 * k3)));
+	__m128 p = _mm_add_ps(b, _mm_mul_ps(r, a));
+	p = _mm_add_ps(c, _mm_mul_ps(r, p));
+	p = _mm_add_ps(d, _mm_mul_ps(r, p));
+	return _mm_mul_ps(r, p);
 }
-static inline float adobe_lens_fisheye_model(float th, float fr, float k1, float k2, float k3, float k0)
+static inline __m128 adobe_lens_poly_sse(__m128 r, __m128 k1, __m128 k2, __m128 k3)
 {
-	float r = th * fr, r2 = r * r;
-	return r * (1 + r2 * (k1 + r2 * k2));
+	__m128 r2 = _mm_mul_ps(r, r);
+	__m128 p = _mm_add_ps(k2, _mm_mul_ps(r2, k3));
+	p = _mm_add_ps(k1, _mm_mul_ps(r2, p));
+	p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, p));
+	return _mm_mul_ps(r, p);
 }
 
 //////////////////////////////////////////////////////////////////////
 // calculate padded region for the circular fisheye unwarpped image
 static void CalculatePaddedRegion(
 	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output equirectangular dimensions
+	vx_uint32 yStart, vx_uint32 yEnd,        // [in] range of equirectangular rows to process
 	vx_uint32 camId,                         // [in] camera index
-	vx_uint32 * validPixelCamMap,            // [in] valid pixel camera index map: size: [eqrWidth * eqrHeight]
+	const vx_uint32 * validPixelCamMap,      // [in] valid pixel camera index map: size: [eqrWidth * eqrHeight]
 	vx_uint32 paddingPixelCount,             // [in] padding pixels around valid region
 	vx_uint32 * paddedPixelCamMap            // [out] padded pixel camera index map: size: [eqrWidth * eqrHeight]
 	)
@@ -161,7 +167,8 @@ static void CalculatePaddedRegion(
 	vx_uint32 camMapBit = 1 << camId;
 	vx_uint32 loopPixels = (2 * paddingPixelCount) + 1;
 	// dilate using separable filter for (N x 1) & (1 x N)
-	for (vx_uint32 y_eqr = 0, pixelPosition = 0; y_eqr < (int)eqrHeight; y_eqr++) {
+	// note: both passes only read validPixelCamMap and write pixels of their own rows
+	for (vx_uint32 y_eqr = yStart, pixelPosition = yStart * eqrWidth; y_eqr < yEnd; y_eqr++) {
 		for (vx_uint32 x_eqr = 0; x_eqr < (int)eqrWidth; x_eqr++, pixelPosition++) {
 			vx_uint32 val = 0;
 			vx_int32 X = (vx_int32)x_eqr - paddingPixelCount;
@@ -181,7 +188,7 @@ static void CalculatePaddedRegion(
 			}
 		}
 	}
-	for (vx_uint32 y_eqr = 0, pixelPosition = 0; y_eqr < (int)eqrHeight; y_eqr++) {
+	for (vx_uint32 y_eqr = yStart, pixelPosition = yStart * eqrWidth; y_eqr < yEnd; y_eqr++) {
 		for (vx_uint32 x_eqr = 0; x_eqr < (int)eqrWidth; x_eqr++, pixelPosition++) {
 			vx_uint32 val = 0;
 			vx_int32 Y = (vx_int32)y_eqr - paddingPixelCount;
@@ -205,102 +212,312 @@ static void CalculatePaddedRegion(
 }
 
 //////////////////////////////////////////////////////////////////////
-// calculate lens distorion and warp maps using lens model
+// per camera parameters for lens distortion and warp map calculation
+struct LensWarpCameraParams {
+	vx_uint32 camId;
+	camera_lens_type lens_type;
+	const float * M, * T, * f;
+	float k1, k2, k3, k0;
+	float center_x, center_y, r_crop;
+	float left, top, right, bottom;
+};
+
+//////////////////////////////////////////////////////////////////////
+// default camera of a pixel: the valid camera with the largest z, ties go to the lowest camera index
+// (the full compute visits the cameras in ascending order, the update compares against any existing default)
+static inline bool IsPreferredDefaultCamera(vx_float32 z, vx_uint32 camId, vx_float32 zDefault, vx_uint32 camIdDefault)
+{
+	return z > zDefault || (z == zDefault && z > 0.0f && camId < camIdDefault);
+}
+
+//////////////////////////////////////////////////////////////////////
+// calculate lens distorion and warp maps using lens model for one equirectangular row of a camera
 static void CalculateLensDistortionAndWarpMapsUsingLensModel(
-	vx_uint32 camWidth, vx_uint32 camHeight, // [in] individual camera dimensions
-	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output equirectangular dimensions
+	vx_uint32 eqrWidth,                      // [in] output equirectangular width
+	vx_uint32 y_eqr,                         // [in] output equirectangular row
+	const float * X0, const float * X1, const float * X2, // [in] output direction vectors of the row: size: [eqrWidth]
+	vx_uint32 validWidth,                    // [in] number of columns covered by the output projection
+	const LensWarpCameraParams * cam,        // [in] camera parameters
 	vx_uint32 * validPixelCamMap,            // [out] valid pixel camera index map: size: [eqrWidth * eqrHeight] (optional)
 	vx_uint32 paddingPixelCount,             // [in] padding pixels around valid region
 	vx_uint32 * paddedPixelCamMap,           // [out] padded pixel camera index map: size: [eqrWidth * eqrHeight] (optional)
-	StitchCoord2dFloat * camSrcMap,          // [out] camera coordinate mapping: size: [numCamera * eqrWidth * eqrHeight] (optional)
+	StitchCoord2dFloat * camSrcMap,          // [out] camera coordinate mapping of this camera: size: [eqrWidth * eqrHeight] (optional)
 	vx_float32 * internalBufferForCamIndex,  // [tmp] buffer for internal use: size: [eqrWidth * eqrHeight] (optional)
 	vx_uint8 * defaultCamIndex,              // [out] default camera index (255 refers to no camera): size: [eqrWidth * eqrHeight] (optional)
-	vx_uint32 camId,                         // [in] camera index
-	const float * M, const float * T, const float * f,
-	float k1, float k2, float k3, float k0, float du0, float dv0, float r_crop,
-	float left, float top, float right, float bottom,
-	float(&lens_model_f)(float th, float fr, float k1, float k2, float k3, float k0),
-	camera_lens_type lens_type
+	float * rowBuf                           // [tmp] row buffer for internal use: size: [5 * eqrWidth]
 	)
 {
-	vx_uint32 camMapBit = 1 << camId;
-	float pi_by_h = (float)M_PI / (float)eqrHeight;
-	float center_x = du0 + (float)camWidth * 0.5f, center_y = dv0 + (float)camHeight * 0.5f;
+	const float * M = cam->M, * T = cam->T, * f = cam->f;
+	camera_lens_type lens_type = cam->lens_type;
+	vx_uint32 camMapBit = 1 << cam->camId;
+	float left = cam->left, top = cam->top, right = cam->right, bottom = cam->bottom;
 	float rightMinus1 = right - 1, right2Minus2 = rightMinus1 * 2;
 	float bottomMinus1 = bottom - 1, bottom2Minus2 = bottomMinus1 * 2;
-	for (vx_uint32 y_eqr = 0, pixelPosition=0; y_eqr < (int)eqrHeight; y_eqr++) {
-		float pe = (float)y_eqr * pi_by_h - (float)M_PI_2;
-		float sin_pe = sinf(pe);
-		float cos_pe = cosf(pe);
-		for (vx_uint32 x_eqr = 0; x_eqr < (int)eqrWidth; x_eqr++, pixelPosition++) {
-			float x_src = -1, y_src = -1;
-			float te = (float)x_eqr * pi_by_h - (float)M_PI;
-			float sin_te = sinf(te);
-			float cos_te = cosf(te);
-			float X[3] = { sin_te*cos_pe, sin_pe, cos_te*cos_pe };
-			float Xt[3] = { X[0] - T[0], X[1] - T[1], X[2] - T[2] };
-			float nfactor = sqrtf(Xt[0] * Xt[0] + Xt[1] * Xt[1] + Xt[2] * Xt[2]);
-			Xt[0] /= nfactor;
-			Xt[1] /= nfactor;
-			Xt[2] /= nfactor;
-			float Y[3];
-			MatMul3x1(Y, M, Xt);
-				// only consider pixels within 180 degrees field of view for non-circular fisheye lens
-			if (Y[2] > 0.0f || lens_type == ptgui_lens_fisheye_circ) {
-				float ph = atan2f(Y[1], Y[0]);
-				float th = asinf(sqrtf(fmin(fmax(Y[0] * Y[0] + Y[1] * Y[1], 0.0f), 1.0f)));
-				float rd = lens_model_f(th, f[0], k1, k2, k3, k0);
-				float rr;
-				x_src = f[1] * rd * cosf(ph);
-				y_src = f[1] * rd * sinf(ph);
-				rr = sqrtf(x_src*x_src + y_src*y_src);
-				x_src += center_x;
-				y_src += center_y;
-				bool validCamIndex = false;
-				if ((Y[2] > 0.0f) && validPixelCamMap &&
-					(x_src >= left && x_src <= rightMinus1) && (y_src >= top && y_src <= bottomMinus1) &&
-					(r_crop <= 0.0f || rr <= r_crop))
-				{
-					validCamIndex = true;
-					// update camera map
-					validPixelCamMap[pixelPosition] |= camMapBit;
-				}
-				else if (paddedPixelCamMap &&
-					(x_src >= left - (float)paddingPixelCount) && (x_src <= rightMinus1 + paddingPixelCount) &&
-					(y_src >= top - (float)paddingPixelCount) && (y_src <= bottomMinus1 + paddingPixelCount) &&
-					((r_crop <= 0.0f) || (rr <= (r_crop + paddingPixelCount))))
-				{
-					// reflect the source coordinates
-					if (x_src < left) x_src = left - x_src; else if (x_src >= rightMinus1) x_src = right2Minus2 - x_src;
-					if (y_src < top) y_src = top - y_src; else if (y_src >= bottomMinus1) y_src = bottom2Minus2 - y_src;
-					// update camera map
-					if (lens_type != ptgui_lens_fisheye_circ){
-						paddedPixelCamMap[pixelPosition] |= camMapBit;
-					}
-				}
-				else{ x_src = y_src = -1.0f; }
-				// pick default camera index
-				if (validCamIndex) {
-					vx_float32 zindicator = fabs(Y[2]);
-					if (zindicator > internalBufferForCamIndex[pixelPosition]) {
-						defaultCamIndex[pixelPosition] = camId;
-						internalBufferForCamIndex[pixelPosition] = zindicator;
-					}
-				}
+	float * Y0 = rowBuf, * Y1 = Y0 + eqrWidth, * Y2 = Y1 + eqrWidth, * PH = Y2 + eqrWidth, * RD = PH + eqrWidth;
+	bool rectilinear = (lens_type == ptgui_lens_rectilinear || lens_type == adobe_lens_rectilinear);
+
+	// step 1: rotate the direction vectors into camera coordinates (4 pixels at a time)
+	vx_uint32 x_eqr = 0;
+	__m128 m0 = _mm_set1_ps(M[0]), m1 = _mm_set1_ps(M[1]), m2 = _mm_set1_ps(M[2]);
+	__m128 m3 = _mm_set1_ps(M[3]), m4 = _mm_set1_ps(M[4]), m5 = _mm_set1_ps(M[5]);
+	__m128 m6 = _mm_set1_ps(M[6]), m7 = _mm_set1_ps(M[7]), m8 = _mm_set1_ps(M[8]);
+	__m128 t0 = _mm_set1_ps(T[0]), t1 = _mm_set1_ps(T[1]), t2 = _mm_set1_ps(T[2]);
+	for (; x_eqr + 4 <= eqrWidth; x_eqr += 4) {
+		__m128 xt0 = _mm_sub_ps(_mm_loadu_ps(&X0[x_eqr]), t0);
+		__m128 xt1 = _mm_sub_ps(_mm_loadu_ps(&X1[x_eqr]), t1);
+		__m128 xt2 = _mm_sub_ps(_mm_loadu_ps(&X2[x_eqr]), t2);
+		__m128 nfactor = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(xt0, xt0), _mm_mul_ps(xt1, xt1)), _mm_mul_ps(xt2, xt2)));
+		__m128 x0 = _mm_div_ps(xt0, nfactor), x1 = _mm_div_ps(xt1, nfactor), x2 = _mm_div_ps(xt2, nfactor);
+		_mm_storeu_ps(&Y0[x_eqr], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x0), _mm_mul_ps(m1, x1)), _mm_mul_ps(m2, x2)));
+		_mm_storeu_ps(&Y1[x_eqr], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x0), _mm_mul_ps(m4, x1)), _mm_mul_ps(m5, x2)));
+		_mm_storeu_ps(&Y2[x_eqr], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m6, x0), _mm_mul_ps(m7, x1)), _mm_mul_ps(m8, x2)));
+	}
+	for (; x_eqr < eqrWidth; x_eqr++) {
+		float Xt[3] = { X0[x_eqr] - T[0], X1[x_eqr] - T[1], X2[x_eqr] - T[2] };
+		float nfactor = sqrtf(Xt[0] * Xt[0] + Xt[1] * Xt[1] + Xt[2] * Xt[2]);
+		Xt[0] /= nfactor;
+		Xt[1] /= nfactor;
+		Xt[2] /= nfactor;
+		float Y[3];
+		MatMul3x1(Y, M, Xt);
+		Y0[x_eqr] = Y[0]; Y1[x_eqr] = Y[1]; Y2[x_eqr] = Y[2];
+	}
+
+	// step 2: polar angles and undistorted radius
+	// only consider pixels within 180 degrees field of view for non-circular fisheye lens
+	for (x_eqr = 0; x_eqr < eqrWidth; x_eqr++) {
+		float r = 0.0f;
+		if (x_eqr < validWidth && (Y2[x_eqr] > 0.0f || lens_type == ptgui_lens_fisheye_circ)) {
+			float Yx = Y0[x_eqr], Yy = Y1[x_eqr];
+			PH[x_eqr] = atan2f(Yy, Yx);
+			float th = asinf(sqrtf(fmin(fmax(Yx * Yx + Yy * Yy, 0.0f), 1.0f)));
+			r = (rectilinear ? tanf(th) : th) * f[0];
+		}
+		RD[x_eqr] = r;
+	}
+
+	// step 3: lens distortion polynomial (4 pixels at a time)
+	x_eqr = 0;
+	if (lens_type == adobe_lens_rectilinear) {
+		__m128 k1 = _mm_set1_ps(cam->k1), k2 = _mm_set1_ps(cam->k2), k3 = _mm_set1_ps(cam->k3);
+		for (; x_eqr + 4 <= eqrWidth; x_eqr += 4)
+			_mm_storeu_ps(&RD[x_eqr], adobe_lens_poly_sse(_mm_loadu_ps(&RD[x_eqr]), k1, k2, k3));
+		for (; x_eqr < eqrWidth; x_eqr++)
+			RD[x_eqr] = adobe_lens_poly(RD[x_eqr], cam->k1, cam->k2, cam->k3);
+	}
+	else if (lens_type == adobe_lens_fisheye) {
+		// adobe fisheye model has no k3 term: a zero k3 gives the same result
+		__m128 k1 = _mm_set1_ps(cam->k1), k2 = _mm_set1_ps(cam->k2), k3 = _mm_setzero_ps();
+		for (; x_eqr + 4 <= eqrWidth; x_eqr += 4)
+			_mm_storeu_ps(&RD[x_eqr], adobe_lens_poly_sse(_mm_loadu_ps(&RD[x_eqr]), k1, k2, k3));
+		for (; x_eqr < eqrWidth; x_eqr++)
+			RD[x_eqr] = adobe_lens_poly(RD[x_eqr], cam->k1, cam->k2, 0.0f);
+	}
+	else {
+		__m128 a = _mm_set1_ps(cam->k1), b = _mm_set1_ps(cam->k2), c = _mm_set1_ps(cam->k3), d = _mm_set1_ps(cam->k0);
+		for (; x_eqr + 4 <= eqrWidth; x_eqr += 4)
+			_mm_storeu_ps(&RD[x_eqr], ptgui_lens_poly_sse(_mm_loadu_ps(&RD[x_eqr]), a, b, c, d));
+		for (; x_eqr < eqrWidth; x_eqr++)
+			RD[x_eqr] = ptgui_lens_poly(RD[x_eqr], cam->k1, cam->k2, cam->k3, cam->k0);
+	}
+
+	// step 4: source coordinates and camera maps
+	for (vx_uint32 x_eqr = 0, pixelPosition = y_eqr * eqrWidth; x_eqr < eqrWidth; x_eqr++, pixelPosition++) {
+		float x_src = -1, y_src = -1;
+		if (x_eqr < validWidth && (Y2[x_eqr] > 0.0f || lens_type == ptgui_lens_fisheye_circ)) {
+			float ph = PH[x_eqr];
+			float rd = RD[x_eqr];
+			float rr;
+			x_src = f[1] * rd * cosf(ph);
+			y_src = f[1] * rd * sinf(ph);
+			rr = sqrtf(x_src*x_src + y_src*y_src);
+			x_src += cam->center_x;
+			y_src += cam->center_y;
+			bool validCamIndex = false;
+			if ((Y2[x_eqr] > 0.0f) && validPixelCamMap &&
+				(x_src >= left && x_src <= rightMinus1) && (y_src >= top && y_src <= bottomMinus1) &&
+				(cam->r_crop <= 0.0f || rr <= cam->r_crop))
+			{
+				validCamIndex = true;
+				// update camera map
+				validPixelCamMap[pixelPosition] |= camMapBit;
 			}
-			// save source pixel coordinates, if requested
-			if (camSrcMap) {
+			else if (paddedPixelCamMap &&
+				(x_src >= left - (float)paddingPixelCount) && (x_src <= rightMinus1 + paddingPixelCount) &&
+				(y_src >= top - (float)paddingPixelCount) && (y_src <= bottomMinus1 + paddingPixelCount) &&
+				((cam->r_crop <= 0.0f) || (rr <= (cam->r_crop + paddingPixelCount))))
+			{
+				// reflect the source coordinates
 				if (x_src < left) x_src = left - x_src; else if (x_src >= rightMinus1) x_src = right2Minus2 - x_src;
 				if (y_src < top) y_src = top - y_src; else if (y_src >= bottomMinus1) y_src = bottom2Minus2 - y_src;
-				camSrcMap[pixelPosition].x = x_src;
-				camSrcMap[pixelPosition].y = y_src;
+				// update camera map
+				if (lens_type != ptgui_lens_fisheye_circ){
+					paddedPixelCamMap[pixelPosition] |= camMapBit;
+				}
+			}
+			else{ x_src = y_src = -1.0f; }
+			// pick default camera index
+			if (validCamIndex && defaultCamIndex) {
+				vx_float32 zindicator = fabsf(Y2[x_eqr]);
+				if (IsPreferredDefaultCamera(zindicator, cam->camId, internalBufferForCamIndex[pixelPosition], defaultCamIndex[pixelPosition])) {
+					defaultCamIndex[pixelPosition] = cam->camId;
+					internalBufferForCamIndex[pixelPosition] = zindicator;
+				}
 			}
 		}
+		// save source pixel coordinates, if requested
+		if (camSrcMap) {
+			if (x_src < left) x_src = left - x_src; else if (x_src >= rightMinus1) x_src = right2Minus2 - x_src;
+			if (y_src < top) y_src = top - y_src; else if (y_src >= bottomMinus1) y_src = bottom2Minus2 - y_src;
+			camSrcMap[pixelPosition].x = x_src;
+			camSrcMap[pixelPosition].y = y_src;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// collect per camera lens parameters: returns true if any camera has a circular fisheye lens
+static bool SetupLensWarpCameraParams(
+	vx_uint32 numCamera,                     // [in] number of cameras
+	vx_uint32 camWidth, vx_uint32 camHeight, // [in] individual camera dimensions
+	const camera_params * camParam,          // [in] individual camera configuration: size: [numCamera]
+	const float * Mcam, const float * Tcam, const float * fcam, // [in] camera warp parameters from CalculateCameraWarpParameters
+	LensWarpCameraParams * camList           // [out] per camera parameters: size: [numCamera]
+	)
+{
+	bool anyCircularFisheye = false;
+	for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+		const camera_lens_params * lens = &camParam[cam].lens;
+		float left = 0, top = 0, right = (float)camWidth, bottom = (float)camHeight;
+		if (lens->lens_type <= ptgui_lens_fisheye_circ && (lens->reserved[3] != 0 || lens->reserved[4] != 0 || lens->reserved[5] != 0 || lens->reserved[6] != 0)) {
+			left = std::max(left, lens->reserved[3]);
+			top = std::max(top, lens->reserved[4]);
+			right = std::min(right, lens->reserved[5]);
+			bottom = std::min(bottom, lens->reserved[6]);
+		}
+		LensWarpCameraParams * p = &camList[cam];
+		p->camId = cam;
+		p->lens_type = lens->lens_type;
+		p->M = &Mcam[cam * 9]; p->T = &Tcam[cam * 3]; p->f = &fcam[cam * 2];
+		p->k1 = lens->k1; p->k2 = lens->k2; p->k3 = lens->k3;
+		p->k0 = 1.0f - (lens->k1 + lens->k2 + lens->k3);
+		p->center_x = lens->du0 + (float)camWidth * 0.5f;
+		p->center_y = lens->dv0 + (float)camHeight * 0.5f;
+		p->r_crop = lens->r_crop;
+		p->left = left; p->top = top; p->right = right; p->bottom = bottom;
+		if (lens->lens_type == ptgui_lens_fisheye_circ) anyCircularFisheye = true;
+	}
+	return anyCircularFisheye;
+}
+
+//////////////////////////////////////////////////////////////////////
+// calculate sin/cos of the column azimuths
+static void CalculateAzimuthTerms(vx_uint32 eqrWidth, vx_uint32 eqrHeight, float * sin_te, float * cos_te)
+{
+	float pi_by_h = (float)M_PI / (float)eqrHeight;
+	for (vx_uint32 x_eqr = 0; x_eqr < eqrWidth; x_eqr++) {
+		float te = (float)x_eqr * pi_by_h - (float)M_PI;
+		sin_te[x_eqr] = sinf(te);
+		cos_te[x_eqr] = cosf(te);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// cube faces of the cubemap and EAC outputs in 3x2 grid order: center, right, and down vectors of each face
+static const float g_cubeFaces[6][9] = {
+	{ -1,  0,  0,    0,  0,  1,    0,  1,  0 }, // left
+	{  0,  0,  1,    1,  0,  0,    0,  1,  0 }, // front
+	{  1,  0,  0,    0,  0, -1,    0,  1,  0 }, // right
+	{  0,  1,  0,    0,  0, -1,   -1,  0,  0 }, // down
+	{  0,  0, -1,    0, -1,  0,   -1,  0,  0 }, // back
+	{  0, -1,  0,    0,  0,  1,   -1,  0,  0 }, // up
+};
+
+// unit direction vector of a cube face at linear face coordinates (a, b) in [-1,1]
+static inline void CalculateCubeFaceDirection(vx_uint32 projection, vx_uint32 face, float a, float b, float * dir)
+{
+	if (projection == output_projection_eac) {
+		a = tanf(a * (float)M_PI_4);
+		b = tanf(b * (float)M_PI_4);
+	}
+	const float * F = g_cubeFaces[face];
+	float d0 = F[0] + a * F[3] + b * F[6];
+	float d1 = F[1] + a * F[4] + b * F[7];
+	float d2 = F[2] + a * F[5] + b * F[8];
+	float rnorm = 1.0f / sqrtf(d0 * d0 + d1 * d1 + d2 * d2);
+	dir[0] = d0 * rnorm; dir[1] = d1 * rnorm; dir[2] = d2 * rnorm;
+}
+
+vx_uint32 GetOutputProjectionRegions(vx_uint32 projection, vx_uint32 eqrWidth, vx_uint32 eqrHeight, vx_rectangle_t * regions)
+{
+	if (projection == output_projection_equirectangular) {
+		regions[0] = { 0, 0, eqrWidth, eqrHeight };
+		return 1;
+	}
+	vx_uint32 faceSize = eqrHeight / 2;
+	for (vx_uint32 face = 0; face < 6; face++) {
+		vx_uint32 x = (face % 3) * faceSize, y = (face / 3) * faceSize;
+		regions[face] = { x, y, x + faceSize, y + faceSize };
+	}
+	return 6;
+}
+
+void CalculateOutputDirection(vx_uint32 projection, vx_uint32 eqrWidth, vx_uint32 eqrHeight, const vx_rectangle_t& region, float x, float y, float * dir)
+{
+	if (projection == output_projection_equirectangular) {
+		float te = x * (float)M_PI / (float)eqrHeight - (float)M_PI;
+		float pe = y * (float)M_PI / (float)eqrHeight - (float)M_PI_2;
+		dir[0] = sinf(te) * cosf(pe);
+		dir[1] = sinf(pe);
+		dir[2] = cosf(te) * cosf(pe);
+		return;
+	}
+	float faceSize = (float)(eqrHeight / 2);
+	vx_uint32 face = (region.start_y / (eqrHeight / 2)) * 3 + region.start_x / (eqrHeight / 2);
+	float a = 2.0f * (x - (float)region.start_x) / faceSize - 1.0f;
+	float b = 2.0f * (y - (float)region.start_y) / faceSize - 1.0f;
+	CalculateCubeFaceDirection(projection, face, a, b, dir);
+}
+
+//////////////////////////////////////////////////////////////////////
+// calculate the output direction vectors of the pixel centers of a row: returns the number of columns covered
+// by the projection, the remaining columns get zero vectors
+static vx_uint32 CalculateOutputRowDirections(
+	vx_uint32 projection,                    // [in] output projection
+	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output dimensions
+	vx_uint32 y_eqr,                         // [in] output row
+	const float * sin_te, const float * cos_te, // [in] sin/cos of the column azimuths (equirectangular only): size: [eqrWidth]
+	float * X0, float * X1, float * X2       // [out] direction vectors: size: [eqrWidth]
+	)
+{
+	if (projection == output_projection_equirectangular) {
+		float pi_by_h = (float)M_PI / (float)eqrHeight;
+		float pe = (float)y_eqr * pi_by_h - (float)M_PI_2;
+		float sin_pe = sinf(pe);
+		float cos_pe = cosf(pe);
+		for (vx_uint32 x_eqr = 0; x_eqr < eqrWidth; x_eqr++) {
+			X0[x_eqr] = sin_te[x_eqr] * cos_pe;
+			X1[x_eqr] = sin_pe;
+			X2[x_eqr] = cos_te[x_eqr] * cos_pe;
+		}
+		return eqrWidth;
 	}
-	// calculate paddedPixelCamMap for circular fisheye lens
-	if (paddedPixelCamMap && (lens_type == ptgui_lens_fisheye_circ)){
-		CalculatePaddedRegion(eqrWidth, eqrHeight, camId, validPixelCamMap, paddingPixelCount, paddedPixelCamMap);
+	// cube faces are sampled at the pixel centers
+	vx_uint32 faceSize = eqrHeight / 2, faceRow = y_eqr / faceSize;
+	vx_uint32 validWidth = std::min(eqrWidth, 3 * faceSize);
+	float scale = 2.0f / (float)faceSize;
+	float b = ((float)(y_eqr - faceRow * faceSize) + 0.5f) * scale - 1.0f;
+	for (vx_uint32 x_eqr = 0; x_eqr < validWidth; x_eqr++) {
+		vx_uint32 faceCol = x_eqr / faceSize;
+		float a = ((float)(x_eqr - faceCol * faceSize) + 0.5f) * scale - 1.0f;
+		float dir[3];
+		CalculateCubeFaceDirection(projection, faceRow * 3 + faceCol, a, b, dir);
+		X0[x_eqr] = dir[0]; X1[x_eqr] = dir[1]; X2[x_eqr] = dir[2];
 	}
+	for (vx_uint32 x_eqr = validWidth; x_eqr < eqrWidth; x_eqr++) {
+		X0[x_eqr] = X1[x_eqr] = X2[x_eqr] = 0.0f;
+	}
+	return validWidth;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -310,6 +527,7 @@ vx_status CalculateLensDistortionAndWarpMaps(
 	vx_uint32 numCamera,                     // [in] number of cameras
 	vx_uint32 camWidth, vx_uint32 camHeight, // [in] individual camera dimensions
 	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output equirectangular dimensions
+	vx_uint32 projection,                    // [in] output projection (see output_projection_type)
 	const rig_params * rigParam,             // [in] rig configuration
 	const camera_params * camParam,          // [in] individual camera configuration: size: [numCamera]
 	vx_uint32 * validPixelCamMap,            // [out] valid pixel camera index map: size: [eqrWidth * eqrHeight] (optional)
@@ -336,7 +554,7 @@ vx_status CalculateLensDistortionAndWarpMaps(
 	QueryPerformanceCounter(&v);
 	stime = v.QuadPart;
 #endif
-	if (pInitData && pInitData->graphInitialize)
+	if (pInitData && pInitData->graphInitialize && projection == output_projection_equirectangular)
 	{	
 		ERROR_CHECK_STATUS(vxProcessGraph(pInitData->graphInitialize));
 
@@ -431,47 +649,36 @@ vx_status CalculateLensDistortionAndWarpMaps(
 			memset(internalBufferForCamIndex, 0, totSize*sizeof(vx_uint32));
 			memset(defaultCamIndex, 0xFF, totSize);
 		}
-		// compute valid pixels based on warp parameters
-		const float * T = Tcam, *M = Mcam, *f = fcam;
-		for (vx_uint32 cam = 0; cam < numCamera; cam++, T += 3, M += 9, f += 2) {
-			// perform lens distortion and warp for each pixel in the equirectangular destination image
-			const camera_lens_params * lens = &camParam[cam].lens;
-			float k0 = 1.0f - (lens->k1 + lens->k2 + lens->k3);
-			float left = 0, top = 0, right = (float)camWidth, bottom = (float)camHeight;
-			if (lens->lens_type <= ptgui_lens_fisheye_circ && (lens->reserved[3] != 0 || lens->reserved[4] != 0 || lens->reserved[5] != 0 || lens->reserved[6] != 0)) {
-				left = std::max(left, lens->reserved[3]);
-				top = std::max(top, lens->reserved[4]);
-				right = std::min(right, lens->reserved[5]);
-				bottom = std::min(bottom, lens->reserved[6]);
-			}
-			if (lens->lens_type == ptgui_lens_rectilinear) {
-				CalculateLensDistortionAndWarpMapsUsingLensModel(camWidth, camHeight, eqrWidth, eqrHeight,
-					validPixelCamMap, paddingPixelCount, paddedPixelCamMap, &camSrcMap[cam * eqrWidth * eqrHeight],
-					internalBufferForCamIndex, defaultCamIndex,
-					cam, M, T, f, lens->k1, lens->k2, lens->k3, k0, lens->du0, lens->dv0, lens->r_crop,
-					left, top, right, bottom, ptgui_lens_rectilinear_model, lens->lens_type);
-			}
-			else if (lens->lens_type == ptgui_lens_fisheye_ff || lens->lens_type == ptgui_lens_fisheye_circ) {
-				CalculateLensDistortionAndWarpMapsUsingLensModel(camWidth, camHeight, eqrWidth, eqrHeight,
-					validPixelCamMap, paddingPixelCount, paddedPixelCamMap, &camSrcMap[cam * eqrWidth * eqrHeight],
-					internalBufferForCamIndex, defaultCamIndex,
-					cam, M, T, f, lens->k1, lens->k2, lens->k3, k0, lens->du0, lens->dv0, lens->r_crop,
-					left, top, right, bottom, ptgui_lens_fisheye_model, lens->lens_type);
-			}
-			else if (lens->lens_type == adobe_lens_rectilinear) {
-				CalculateLensDistortionAndWarpMapsUsingLensModel(camWidth, camHeight, eqrWidth, eqrHeight,
-					validPixelCamMap, paddingPixelCount, paddedPixelCamMap, &camSrcMap[cam * eqrWidth * eqrHeight],
-					internalBufferForCamIndex, defaultCamIndex,
-					cam, M, T, f, lens->k1, lens->k2, lens->k3, k0, lens->du0, lens->dv0, lens->r_crop,
-					left, top, right, bottom, adobe_lens_rectilinear_model, lens->lens_type);
-			}
-			else if (lens->lens_type == adobe_lens_fisheye) {
-				CalculateLensDistortionAndWarpMapsUsingLensModel(camWidth, camHeight, eqrWidth, eqrHeight,
-					validPixelCamMap, paddingPixelCount, paddedPixelCamMap, &camSrcMap[cam * eqrWidth * eqrHeight],
-					internalBufferForCamIndex, defaultCamIndex,
-					cam, M, T, f, lens->k1, lens->k2, lens->k3, k0, lens->du0, lens->dv0, lens->r_crop,
-					left, top, right, bottom, adobe_lens_fisheye_model, lens->lens_type);
+		// collect per camera lens parameters
+		LensWarpCameraParams camList[32];
+		bool anyCircularFisheye = SetupLensWarpCameraParams(numCamera, camWidth, camHeight, camParam, Mcam, Tcam, fcam, camList);
+		// per column azimuth terms are common to all rows and cameras
+		std::vector<float> sin_te(eqrWidth), cos_te(eqrWidth);
+		CalculateAzimuthTerms(eqrWidth, eqrHeight, sin_te.data(), cos_te.data());
+		// perform lens distortion and warp for each pixel in the equirectangular destination image:
+		// each thread owns a band of rows and processes all cameras in order, so that shared
+		// per pixel maps and default camera index selection match the sequential result
+		StitchParallelFor(eqrHeight, [&](vx_uint32 yStart, vx_uint32 yEnd) {
+			std::vector<float> rowBuf(8 * eqrWidth);
+			float * X0 = &rowBuf[5 * eqrWidth], * X1 = X0 + eqrWidth, * X2 = X1 + eqrWidth;
+			for (vx_uint32 y_eqr = yStart; y_eqr < yEnd; y_eqr++) {
+				vx_uint32 validWidth = CalculateOutputRowDirections(projection, eqrWidth, eqrHeight, y_eqr, sin_te.data(), cos_te.data(), X0, X1, X2);
+				for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+					CalculateLensDistortionAndWarpMapsUsingLensModel(eqrWidth, y_eqr, X0, X1, X2, validWidth, &camList[cam],
+						validPixelCamMap, paddingPixelCount, paddedPixelCamMap, camSrcMap ? &camSrcMap[cam * eqrWidth * eqrHeight] : nullptr,
+						internalBufferForCamIndex, defaultCamIndex, rowBuf.data());
+				}
 			}
+		});
+		// calculate paddedPixelCamMap for circular fisheye lens once the valid pixel map is complete
+		if (paddedPixelCamMap && validPixelCamMap && anyCircularFisheye) {
+			StitchParallelFor(eqrHeight, [&](vx_uint32 yStart, vx_uint32 yEnd) {
+				for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+					if (camList[cam].lens_type == ptgui_lens_fisheye_circ) {
+						CalculatePaddedRegion(eqrWidth, eqrHeight, yStart, yEnd, cam, validPixelCamMap, paddingPixelCount, paddedPixelCamMap);
+					}
+				}
+			});
 		}
 #if DUMP_BUFFERS_INITIALIZE
 		DumpBuffer((vx_uint8 *)paddedPixelCamMap, eqrWidth*eqrHeight * 4, "PaddedCamMap.bin");
@@ -490,6 +697,120 @@ vx_status CalculateLensDistortionAndWarpMaps(
 }
 
 
+//////////////////////////////////////////////////////////////////////
+// update lens distorion and warp maps of the cameras in camUpdateMask
+vx_status UpdateLensDistortionAndWarpMaps(
+	vx_uint32 numCamera,                     // [in] number of cameras
+	vx_uint32 camWidth, vx_uint32 camHeight, // [in] individual camera dimensions
+	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output equirectangular dimensions
+	vx_uint32 projection,                    // [in] output projection (see output_projection_type)
+	const rig_params * rigParam,             // [in] rig configuration
+	const camera_params * camParam,          // [in] individual camera configuration: size: [numCamera]
+	vx_uint32 camUpdateMask,                 // [in] cameras to update - use "camUpdateMask & (1 << cam)"
+	vx_uint32 * validPixelCamMap,            // [in/out] valid pixel camera index map: size: [eqrWidth * eqrHeight]
+	vx_uint32 paddingPixelCount,             // [in] padding pixels around valid region
+	vx_uint32 * paddedPixelCamMap,           // [in/out] padded pixel camera index map: size: [eqrWidth * eqrHeight] (optional)
+	StitchCoord2dFloat * camSrcMap,          // [in/out] camera coordinate mapping: size: [numCamera * eqrWidth * eqrHeight]
+	vx_float32 * internalBufferForCamIndex,  // [in/out] buffer for internal use: size: [eqrWidth * eqrHeight] (optional)
+	vx_uint8 * defaultCamIndex               // [in/out] default camera index (255 refers to no camera): size: [eqrWidth * eqrHeight] (optional)
+	)
+{
+	// disable defaultCamIndex if tmp buffer is not specified (and vice versa)
+	if (!internalBufferForCamIndex || !defaultCamIndex) {
+		internalBufferForCamIndex = nullptr;
+		defaultCamIndex = nullptr;
+	}
+	if (numCamera > 32) {
+		printf("ERROR: UpdateLensDistortionAndWarpMaps: can't support %d cameras -- 32 is the current limit\n", numCamera);
+		return VX_ERROR_NOT_SUPPORTED;
+	}
+	if (!validPixelCamMap || !camSrcMap) {
+		printf("ERROR: UpdateLensDistortionAndWarpMaps: valid pixel map and camera coordinate mapping are required\n");
+		return VX_ERROR_INVALID_PARAMETERS;
+	}
+	if (numCamera < 32) camUpdateMask &= (1u << numCamera) - 1;
+	if (!camUpdateMask) return VX_SUCCESS;
+
+	// compute camera warp parameters and check for supported lens types
+	float Mcam[32 * 9], Tcam[32 * 3], fcam[32 * 2], Mr[3 * 3];
+	vx_status status = CalculateCameraWarpParameters(numCamera, camWidth, camHeight, rigParam, camParam, Mcam, Tcam, fcam, Mr);
+	if (status != VX_SUCCESS) return status;
+	LensWarpCameraParams camList[32];
+	SetupLensWarpCameraParams(numCamera, camWidth, camHeight, camParam, Mcam, Tcam, fcam, camList);
+	bool anyCircularFisheye = false;
+	for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+		if ((camUpdateMask & (1 << cam)) && camList[cam].lens_type == ptgui_lens_fisheye_circ)
+			anyCircularFisheye = true;
+	}
+	std::vector<float> sin_te(eqrWidth), cos_te(eqrWidth);
+	CalculateAzimuthTerms(eqrWidth, eqrHeight, sin_te.data(), cos_te.data());
+
+	// only the cameras in camUpdateMask are recomputed: their map bits are cleared and rebuilt, pixels that had one of
+	// them as default camera pick the best of the remaining valid cameras, the updated cameras compete for all pixels;
+	// both steps use IsPreferredDefaultCamera so that the result matches CalculateLensDistortionAndWarpMaps
+	vx_uint32 keepMask = ~camUpdateMask;
+	StitchParallelFor(eqrHeight, [&](vx_uint32 yStart, vx_uint32 yEnd) {
+		std::vector<float> rowBuf(8 * eqrWidth);
+		float * X0 = &rowBuf[5 * eqrWidth], * X1 = X0 + eqrWidth, * X2 = X1 + eqrWidth;
+		for (vx_uint32 y_eqr = yStart; y_eqr < yEnd; y_eqr++) {
+			vx_uint32 validWidth = CalculateOutputRowDirections(projection, eqrWidth, eqrHeight, y_eqr, sin_te.data(), cos_te.data(), X0, X1, X2);
+			vx_uint32 * validRow = &validPixelCamMap[y_eqr * eqrWidth];
+			vx_uint32 * paddedRow = paddedPixelCamMap ? &paddedPixelCamMap[y_eqr * eqrWidth] : nullptr;
+			for (vx_uint32 x_eqr = 0; x_eqr < eqrWidth; x_eqr++) {
+				validRow[x_eqr] &= keepMask;
+				if (paddedRow) paddedRow[x_eqr] &= keepMask;
+			}
+			if (defaultCamIndex) {
+				vx_uint8 * camIndexRow = &defaultCamIndex[y_eqr * eqrWidth];
+				vx_float32 * zRow = &internalBufferForCamIndex[y_eqr * eqrWidth];
+				for (vx_uint32 x_eqr = 0; x_eqr < eqrWidth; x_eqr++) {
+					vx_uint32 camId = camIndexRow[x_eqr];
+					if (camId < numCamera && (camUpdateMask & (1 << camId))) {
+						// re-select default camera from the cameras that are not updated: valid pixels have z > 0
+						camIndexRow[x_eqr] = 0xFF;
+						zRow[x_eqr] = 0.0f;
+						for (vx_uint32 validMask = validRow[x_eqr], cam = 0; validMask; validMask >>= 1, cam++) {
+							if (validMask & 1) {
+								const float * M = camList[cam].M, * T = camList[cam].T;
+								float Xt[3] = { X0[x_eqr] - T[0], X1[x_eqr] - T[1], X2[x_eqr] - T[2] };
+								float nfactor = sqrtf(Xt[0] * Xt[0] + Xt[1] * Xt[1] + Xt[2] * Xt[2]);
+								Xt[0] /= nfactor;
+								Xt[1] /= nfactor;
+								Xt[2] /= nfactor;
+								float Y[3];
+								MatMul3x1(Y, M, Xt);
+								float zindicator = fabsf(Y[2]);
+								if (IsPreferredDefaultCamera(zindicator, cam, zRow[x_eqr], camIndexRow[x_eqr])) {
+									camIndexRow[x_eqr] = (vx_uint8)cam;
+									zRow[x_eqr] = zindicator;
+								}
+							}
+						}
+					}
+				}
+			}
+			for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+				if (camUpdateMask & (1 << cam)) {
+					CalculateLensDistortionAndWarpMapsUsingLensModel(eqrWidth, y_eqr, X0, X1, X2, validWidth, &camList[cam],
+						validPixelCamMap, paddingPixelCount, paddedPixelCamMap, &camSrcMap[cam * eqrWidth * eqrHeight],
+						internalBufferForCamIndex, defaultCamIndex, rowBuf.data());
+				}
+			}
+		}
+	});
+	// calculate paddedPixelCamMap for updated circular fisheye lens once the valid pixel map is complete
+	if (paddedPixelCamMap && anyCircularFisheye) {
+		StitchParallelFor(eqrHeight, [&](vx_uint32 yStart, vx_uint32 yEnd) {
+			for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+				if ((camUpdateMask & (1 << cam)) && camList[cam].lens_type == ptgui_lens_fisheye_circ) {
+					CalculatePaddedRegion(eqrWidth, eqrHeight, yStart, yEnd, cam, validPixelCamMap, paddingPixelCount, paddedPixelCamMap);
+				}
+			}
+		});
+	}
+	return VX_SUCCESS;
+}
+
 //////////////////////////////////////////////////////////////////////
 // calculate overlap regions and returns number of overlaps
 vx_uint32 CalculateValidOverlapRegions(
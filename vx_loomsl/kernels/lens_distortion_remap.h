@@ -32,6 +32,17 @@ typedef struct {
 	float x, y;
 } StitchCoord2dFloat;
 
+//////////////////////////////////////////////////////////////////////
+//! \brief The output projections (see LIVE_STITCH_ATTR_OUTPUT_PROJECTION).
+//  The cubemap and EAC outputs use a 3:2 output frame as a 3x2 grid of square faces of size height/2:
+//  the top row has left/front/right faces and the bottom row has down/back/up faces rotated to form a
+//  continuous strip, so the only seams inside the frame are between the two face rows.
+typedef enum {
+	output_projection_equirectangular = 0, // equirectangular
+	output_projection_cubemap         = 1, // cubemap: linear sampling of the cube faces
+	output_projection_eac             = 2, // equi-angular cubemap: face coordinates sampled at equal angles
+} output_projection_type;
+
 //////////////////////////////////////////////////////////////////////
 typedef struct {
 	vx_uint32 camId;
@@ -73,13 +84,22 @@ vx_status CalculateCameraWarpParameters(
 	float * Mr                         // M matrix: 3x3 for the rig
 	);
 
+//////////////////////////////////////////////////////////////////////
+// output projection geometry: directions use +X right, +Y down, and +Z at the center of the equirectangular output
+//   GetOutputProjectionRegions - get the continuous regions of the output: returns 1 for equirectangular, 6 faces otherwise
+//   CalculateOutputDirection   - unit direction vector at a continuous position (x, y) of the output inside the given region
+vx_uint32 GetOutputProjectionRegions(vx_uint32 projection, vx_uint32 eqrWidth, vx_uint32 eqrHeight, vx_rectangle_t * regions);
+void CalculateOutputDirection(vx_uint32 projection, vx_uint32 eqrWidth, vx_uint32 eqrHeight, const vx_rectangle_t& region, float x, float y, float * dir);
+
 //////////////////////////////////////////////////////////////////////
 // calculate lens distorion and warp maps from rig and camera configuration
+// note: the GPU graph in pInitData only supports equirectangular output
 vx_status CalculateLensDistortionAndWarpMaps(
 	StitchInitializeData *pInitData,		 // [in] data pointer for init
 	vx_uint32 numCamera,                     // [in] number of cameras
 	vx_uint32 camWidth, vx_uint32 camHeight, // [in] individual camera dimensions
 	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output equirectangular dimensions
+	vx_uint32 projection,                    // [in] output projection (see output_projection_type)
 	const rig_params * rigParam,             // [in] rig configuration
 	const camera_params * camParam,          // [in] individual camera configuration: size: [numCamera]
 	vx_uint32 * validPixelCamMap,            // [out] valid pixel camera index map: size: [eqrWidth * eqrHeight] (optional)
@@ -90,6 +110,25 @@ vx_status CalculateLensDistortionAndWarpMaps(
 	vx_uint8 * defaultCamIndex               // [out] default camera index (255 refers to no camera): size: [eqrWidth * eqrHeight] (optional)
 	);
 
+//////////////////////////////////////////////////////////////////////
+// update lens distorion and warp maps of the cameras in camUpdateMask only (CPU):
+// the maps must have been calculated by CalculateLensDistortionAndWarpMaps on CPU with the same rig configuration
+vx_status UpdateLensDistortionAndWarpMaps(
+	vx_uint32 numCamera,                     // [in] number of cameras
+	vx_uint32 camWidth, vx_uint32 camHeight, // [in] individual camera dimensions
+	vx_uint32 eqrWidth, vx_uint32 eqrHeight, // [in] output equirectangular dimensions
+	vx_uint32 projection,                    // [in] output projection (see output_projection_type)
+	const rig_params * rigParam,             // [in] rig configuration
+	const camera_params * camParam,          // [in] individual camera configuration: size: [numCamera]
+	vx_uint32 camUpdateMask,                 // [in] cameras to update - use "camUpdateMask & (1 << cam)"
+	vx_uint32 * validPixelCamMap,            // [in/out] valid pixel camera index map: size: [eqrWidth * eqrHeight]
+	vx_uint32 paddingPixelCount,             // [in] padding pixels around valid region
+	vx_uint32 * paddedPixelCamMap,           // [in/out] padded pixel camera index map: size: [eqrWidth * eqrHeight] (optional)
+	StitchCoord2dFloat * camSrcMap,          // [in/out] camera coordinate mapping: size: [numCamera * eqrWidth * eqrHeight]
+	vx_float32 * internalBufferForCamIndex,  // [in/out] buffer for internal use: size: [eqrWidth * eqrHeight] (optional)
+	vx_uint8 * defaultCamIndex               // [in/out] default camera index (255 refers to no camera): size: [eqrWidth * eqrHeight] (optional)
+	);
+
 //////////////////////////////////////////////////////////////////////
 // calculate overlap regions and returns number of overlaps
 vx_uint32 CalculateValidOverlapRegions(
@@ -126,6 +126,76 @@ static vx_status VX_CALLBACK merge_input_validator(vx_node node, vx_uint32 index
 			status = VX_SUCCESS;
 		}
 	}
+	else if (index == 6)
+	{ // optional camera input image of format RGB for the single camera pixels
+		vx_df_image input_format = VX_DF_IMAGE_VIRT;
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
+		ERROR_CHECK_STATUS(vxReleaseImage((vx_image *)&ref));
+		vx_array arr = (vx_array)avxGetNodeParamRef(node, 7);
+		if (input_format != VX_DF_IMAGE_RGB) {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge camera input image should be of RGB type\n");
+		}
+		else if (!arr) {
+			status = VX_ERROR_INVALID_PARAMETERS;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge camera input image requires the single camera remap table\n");
+		}
+		else {
+			status = VX_SUCCESS;
+		}
+		if (arr) ERROR_CHECK_STATUS(vxReleaseArray(&arr));
+	}
+	else if (index == 7)
+	{ // optional array object of StitchWarpRemapEntry type for the single camera pixels
+		vx_size itemsize = 0;
+		ERROR_CHECK_STATUS(vxQueryArray((vx_array)ref, VX_ARRAY_ATTRIBUTE_ITEMSIZE, &itemsize, sizeof(itemsize)));
+		ERROR_CHECK_STATUS(vxReleaseArray((vx_array *)&ref));
+		vx_image image = (vx_image)avxGetNodeParamRef(node, 6);
+		if (itemsize != sizeof(StitchWarpRemapEntry)) {
+			status = VX_ERROR_INVALID_DIMENSION;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge array element (StitchWarpRemapEntry) size should be 32 bytes\n");
+		}
+		else if (!image) {
+			status = VX_ERROR_INVALID_PARAMETERS;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge single camera remap table requires the camera input image\n");
+		}
+		else {
+			status = VX_SUCCESS;
+		}
+		if (image) ERROR_CHECK_STATUS(vxReleaseImage(&image));
+	}
+	else if (index == 8)
+	{ // optional object of SCALAR type (UINT32) for num_camera_columns
+		vx_enum itemtype = VX_TYPE_INVALID;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+		if (itemtype == VX_TYPE_UINT32) {
+			status = VX_SUCCESS;
+		}
+		else {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge num_camera_columns scalar type should be a UINT32\n");
+		}
+	}
+	else if (index == 9)
+	{ // optional array object of FLOAT32 type for the exposure comp gains of the single camera pixels
+		vx_enum itemtype = VX_TYPE_INVALID;
+		ERROR_CHECK_STATUS(vxQueryArray((vx_array)ref, VX_ARRAY_ATTRIBUTE_ITEMTYPE, &itemtype, sizeof(itemtype)));
+		ERROR_CHECK_STATUS(vxReleaseArray((vx_array *)&ref));
+		vx_array arr = (vx_array)avxGetNodeParamRef(node, 7);
+		if (itemtype != VX_TYPE_FLOAT32) {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge gain array type should be a FLOAT32\n");
+		}
+		else if (!arr) {
+			status = VX_ERROR_INVALID_PARAMETERS;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: merge gain array requires the single camera remap table\n");
+		}
+		else {
+			status = VX_SUCCESS;
+		}
+		if (arr) ERROR_CHECK_STATUS(vxReleaseArray(&arr));
+	}
 	return status;
 }
 
@@ -207,6 +277,32 @@ static vx_status VX_CALLBACK merge_opencl_codegen(
 	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
 	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &output_format, sizeof(output_format)));
 	ERROR_CHECK_STATUS(vxReleaseImage(&image));
+	// with the optional camera input and remap table, the single camera pixels are sampled from the camera input
+	// using the remap entry indexed by the group1 (low 16-bits) and group2 (high 16-bits) images
+	bool sampleSingleCamera = (parameters[6] && parameters[7]) ? true : false;
+	vx_uint32 num_camera_columns = 1, ip_image_height_offs = 0;
+	// with the optional gain array, the exposure comp gains of the camera (mono or RGB) are applied to these samples,
+	// since they don't go through the warp or expcomp_applygains
+	vx_uint32 num_gain_channels = 0;
+	if (sampleSingleCamera) {
+		vx_uint32 input_height = 0, camera_height = 0;
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[3], VX_IMAGE_ATTRIBUTE_HEIGHT, &input_height, sizeof(input_height)));
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[6], VX_IMAGE_ATTRIBUTE_HEIGHT, &camera_height, sizeof(camera_height)));
+		if (parameters[8]) {
+			ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[8], &num_camera_columns));
+		}
+		vx_uint32 num_cameras = input_height / height;
+		ip_image_height_offs = camera_height / (num_cameras / num_camera_columns);
+		if (num > 9 && parameters[9]) {
+			vx_size capacity = 0;
+			ERROR_CHECK_STATUS(vxQueryArray((vx_array)parameters[9], VX_ARRAY_ATTRIBUTE_CAPACITY, &capacity, sizeof(capacity)));
+			num_gain_channels = (capacity >= (vx_size)num_cameras * 3) ? 3 : 1;
+			if (capacity < num_cameras) {
+				vxAddLogEntry((vx_reference)node, VX_ERROR_INVALID_DIMENSION, "ERROR: merge gain array needs a gain per camera (%d < %d)\n", (int)capacity, num_cameras);
+				return VX_ERROR_INVALID_DIMENSION;
+			}
+		}
+	}
 	// set kernel configuration
 	strcpy(opencl_kernel_function_name, "merge");
 	vx_uint32 work_items[2] = { (width + 3) / 4, height };
@@ -230,35 +326,111 @@ static vx_status VX_CALLBACK merge_opencl_codegen(
 		"{\n"
 		"  return (float4)(amd_unpack0(src), amd_unpack1(src), amd_unpack2(src), amd_unpack3(src));\n"
 		"}\n"
-		"\n"
+		"\n");
+	opencl_kernel_code = item;
+	if (sampleSingleCamera) {
+		// bilinear sampling of RGB camera input with Q13.3 source coordinates, same as the warp kernel
+		opencl_kernel_code +=
+			"float4 merge_sample_rgb(__global uchar * ip_buf, uint ip_stride, uint map)\n"
+			"{\n"
+			"  uint sx = map & 0xffff, sy = (map >> 16) & 0xffff;\n"
+			"  if (sx == 0xffff && sy == 0xffff) return (float4)0;\n"
+			"  uint offset = (sy >> 3) * ip_stride + (sx >> 3) * 3;\n"
+			"  __global uchar * pt = ip_buf + (offset & ~3);\n"
+			"  uint3 px0 = vload3(0, (__global uint *)pt), px1 = vload3(0, (__global uint *)(pt + ip_stride));\n"
+			"  px0.s0 = amd_bytealign(px0.s1, px0.s0, offset); px0.s1 = amd_bytealign(px0.s2, px0.s1, offset);\n"
+			"  px1.s0 = amd_bytealign(px1.s1, px1.s0, offset); px1.s1 = amd_bytealign(px1.s2, px1.s1, offset);\n"
+			"  float4 f, mf;\n"
+			"  mf.s0 = (sx & 7) * 0.125f; mf.s1 = (sy & 7) * 0.125f; mf.s2 = 1.0f - mf.s0; mf.s3 = 1.0f - mf.s1;\n"
+			"  f.s0 = (amd_unpack0(px0.s0) * mf.s2 + amd_unpack3(px0.s0) * mf.s0) * mf.s3 + (amd_unpack0(px1.s0) * mf.s2 + amd_unpack3(px1.s0) * mf.s0) * mf.s1;\n"
+			"  f.s1 = (amd_unpack1(px0.s0) * mf.s2 + amd_unpack0(px0.s1) * mf.s0) * mf.s3 + (amd_unpack1(px1.s0) * mf.s2 + amd_unpack0(px1.s1) * mf.s0) * mf.s1;\n"
+			"  f.s2 = (amd_unpack2(px0.s0) * mf.s2 + amd_unpack1(px0.s1) * mf.s0) * mf.s3 + (amd_unpack2(px1.s0) * mf.s2 + amd_unpack1(px1.s1) * mf.s0) * mf.s1;\n"
+			"  f.s3 = 0.0f;\n"
+			"  return f;\n"
+			"}\n"
+			"\n";
+	}
+	sprintf(item,
 		"__kernel __attribute__((reqd_work_group_size(%d, %d, 1)))\n" // opencl_local_work[0], opencl_local_work[1]
 		"void %s(uint camID0_img_width, uint camID0_img_height, __global uchar * camID0_img_buf, uint camID0_img_stride, uint camID0_img_offset,\n" // opencl_kernel_function_name
 		"        uint camID1_img_width, uint camID1_img_height, __global uchar * camID1_img_buf, uint camID1_img_stride, uint camID1_img_offset,\n"
 		"        uint camID2_img_width, uint camID2_img_height, __global uchar * camID2_img_buf, uint camID2_img_stride, uint camID2_img_offset,\n"
 		"        uint ip_width, uint ip_height, __global uchar * ip_buf, uint ip_stride, uint ip_offset,\n"
 		"        uint wt_width, uint wt_height, __global uchar * wt_buf, uint wt_stride, uint wt_offset,\n"
-		"        uint op_width, uint op_height, __global uchar * op_buf, uint op_stride, uint op_offset)\n"
+		"        uint op_width, uint op_height, __global uchar * op_buf, uint op_stride, uint op_offset"
+		, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name);
+	opencl_kernel_code += item;
+	if (sampleSingleCamera) {
+		opencl_kernel_code +=
+			",\n"
+			"        uint cam_width, uint cam_height, __global uchar * cam_buf, uint cam_stride, uint cam_offset,\n"
+			"        __global uchar * remap_buf, uint remap_offset, uint remap_num";
+		if (parameters[8]) {
+			opencl_kernel_code +=
+				",\n"
+				"        uint num_camera_columns";
+		}
+		if (num_gain_channels) {
+			opencl_kernel_code +=
+				",\n"
+				"        __global uchar * gain_buf, uint gain_offset, uint gain_num";
+		}
+	}
+	sprintf(item,
+		")\n"
 		"{\n"
 		"  int gx = get_global_id(0);\n"
 		"  int gy = get_global_id(1);\n"
 		"  float weight_mul_factor = %f;\n" // wt_mul_factor
 		"  if ((gx < %d) && (gy < %d)) {\n" // work_items[0], work_items[1]
-		, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name, wt_mul_factor, work_items[0], work_items[1]);
-	opencl_kernel_code = item;
+		, wt_mul_factor, work_items[0], work_items[1]);
+	opencl_kernel_code += item;
 
 	opencl_kernel_code +=
 		"  uint4 pRGB_out;\n"
 		"  camID0_img_buf += camID0_img_offset + gy * camID0_img_stride + (gx >> 1);\n"
 		"  uchar camIdSelect = *(__global uchar *)camID0_img_buf;\n"
 		"  uint4 pRGBX_in; float4 weights;\n"
-		"  float16 fa = 0;\n"
-		"  if(camIdSelect < 31) {\n"
-		"    pRGBX_in = *(__global uint4 *) (ip_buf + ip_offset + ((gy + op_height * camIdSelect) * ip_stride) + (gx << 4));\n"
-		"    fa.s0123 += amd_unpack(pRGBX_in.s0);\n"
-		"    fa.s4567 += amd_unpack(pRGBX_in.s1);\n"
-		"    fa.s89AB += amd_unpack(pRGBX_in.s2);\n"
-		"    fa.sCDEF += amd_unpack(pRGBX_in.s3);\n"
-		"  }\n"
+		"  float16 fa = 0;\n";
+	if (sampleSingleCamera) {
+		sprintf(item,
+			"  if(camIdSelect < 31) {\n"
+			"    ushort idx_lo = *(__global ushort *)(camID1_img_buf + camID1_img_offset + gy * camID1_img_stride + ((gx >> 1) << 1));\n"
+			"    ushort idx_hi = *(__global ushort *)(camID2_img_buf + camID2_img_offset + gy * camID2_img_stride + ((gx >> 1) << 1));\n"
+			"    uint idx = ((uint)idx_hi << 16) | idx_lo;\n"
+			"    if (idx < remap_num) {\n"
+			"      uint4 map = *(__global uint4 *)(remap_buf + remap_offset + (idx << 5) + ((gx & 1) << 4));\n"
+			"      __global uchar * cam_ptr = cam_buf + cam_offset + (camIdSelect / %d) * %d * cam_stride;\n" // num_camera_columns, ip_image_height_offs
+			"      fa.s0123 = merge_sample_rgb(cam_ptr, cam_stride, map.s0);\n"
+			"      fa.s4567 = merge_sample_rgb(cam_ptr, cam_stride, map.s1);\n"
+			"      fa.s89AB = merge_sample_rgb(cam_ptr, cam_stride, map.s2);\n"
+			"      fa.sCDEF = merge_sample_rgb(cam_ptr, cam_stride, map.s3);\n"
+			, num_camera_columns, ip_image_height_offs);
+		opencl_kernel_code += item;
+		if (num_gain_channels) {
+			opencl_kernel_code += (num_gain_channels == 1) ?
+				"      __global float * pg = (__global float *)(gain_buf + gain_offset) + camIdSelect;\n"
+				"      float4 g4 = (float4)(pg[0], pg[0], pg[0], 1.0f);\n" :
+				"      __global float * pg = (__global float *)(gain_buf + gain_offset) + camIdSelect * 3;\n"
+				"      float4 g4 = (float4)(pg[0], pg[1], pg[2], 1.0f);\n";
+			opencl_kernel_code +=
+				"      fa.s0123 *= g4; fa.s4567 *= g4; fa.s89AB *= g4; fa.sCDEF *= g4;\n";
+		}
+		opencl_kernel_code +=
+			"    }\n"
+			"  }\n";
+	}
+	else {
+		opencl_kernel_code +=
+			"  if(camIdSelect < 31) {\n"
+			"    pRGBX_in = *(__global uint4 *) (ip_buf + ip_offset + ((gy + op_height * camIdSelect) * ip_stride) + (gx << 4));\n"
+			"    fa.s0123 += amd_unpack(pRGBX_in.s0);\n"
+			"    fa.s4567 += amd_unpack(pRGBX_in.s1);\n"
+			"    fa.s89AB += amd_unpack(pRGBX_in.s2);\n"
+			"    fa.sCDEF += amd_unpack(pRGBX_in.s3);\n"
+			"  }\n";
+	}
+	opencl_kernel_code +=
 		"  else if(camIdSelect > 31) {\n"
 		"    camID1_img_buf += camID1_img_offset + gy * camID1_img_stride + ((gx >> 1) << 1);\n"
 		"    ushort camID_struct = *(__global ushort *)camID1_img_buf;\n"
@@ -374,7 +546,7 @@ vx_status merge_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.merge",
 		AMDOVX_KERNEL_STITCHING_MERGE,
 		merge_kernel,
-		6,
+		10,
 		merge_input_validator,
 		merge_output_validator,
 		merge_initialize,
@@ -392,6 +564,10 @@ vx_status merge_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 4, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 5, VX_OUTPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 6, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 7, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 8, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 9, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_OPTIONAL));
 
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
@@ -504,3 +680,63 @@ vx_status GenerateDefaultMergeMaskImage(
 	}
 	return VX_SUCCESS;
 }
+
+//////////////////////////////////////////////////////////////////////
+// Move the warp entries of single camera pixels into merge remap table
+vx_status GenerateMergeSingleCameraBuffers(
+	vx_uint32 eqrWidth,                   // [in] output equirectangular image width
+	vx_uint32 eqrHeight,                  // [in] output equirectangular image height
+	vx_uint32  camIdStride,               // [in] stride (in bytes) of camId table (image)
+	vx_uint32  camGroup1Stride,           // [in] stride (in bytes) of camGroup1 table (image)
+	vx_uint32  camGroup2Stride,           // [in] stride (in bytes) of camGroup2 table (image)
+	const vx_uint8 * camIdBuf,            // [in] camId table (image) from GenerateMergeBuffers
+	vx_uint16 * camGroup1Buf,             // [out] camId Group1 table (image): low 16-bits of merge remap entry index
+	vx_uint16 * camGroup2Buf,             // [out] camId Group2 table (image): high 16-bits of merge remap entry index
+	StitchValidPixelEntry * validMap,     // [in/out] valid map table: the single camera entries are removed
+	StitchWarpRemapEntry * warpMap,       // [in/out] warp map table: the single camera entries are removed
+	vx_size * warpEntryCount,             // [in/out] number of entries in warp/valid map table
+	StitchWarpRemapEntry * mergeMap,      // [out] merge remap table: size: [*warpEntryCount]
+	vx_size * mergeEntryCount             // [out] number of entries added to merge remap table
+	)
+{
+	vx_uint32 groupWidth = eqrWidth >> 3;
+	// single camera pixels without a warp entry are marked with index 0xffffffff
+	for (vx_uint32 y = 0; y < eqrHeight; y++) {
+		const vx_uint8 * camId = camIdBuf + y * camIdStride;
+		vx_uint16 * group1 = camGroup1Buf + y * (camGroup1Stride >> 1);
+		vx_uint16 * group2 = camGroup2Buf + y * (camGroup2Stride >> 1);
+		for (vx_uint32 xi = 0; xi < groupWidth; xi++) {
+			if (camId[xi] < 31) {
+				group1[xi] = 0xffff;
+				group2[xi] = 0xffff;
+			}
+		}
+	}
+	vx_size count = 0, mergeCount = 0;
+	for (vx_size k = 0; k < *warpEntryCount; k++) {
+		vx_uint32 entry;
+		memcpy(&entry, &validMap[k], sizeof(entry));
+		if (entry != 0xFFFFFFFF) {
+			const StitchValidPixelEntry& valid = validMap[k];
+			if (valid.dstX < groupWidth && valid.dstY < eqrHeight && camIdBuf[valid.dstY * camIdStride + valid.dstX] == valid.camId) {
+				mergeMap[mergeCount] = warpMap[k];
+				camGroup1Buf[valid.dstY * (camGroup1Stride >> 1) + valid.dstX] = (vx_uint16)(mergeCount & 0xffff);
+				camGroup2Buf[valid.dstY * (camGroup2Stride >> 1) + valid.dstX] = (vx_uint16)(mergeCount >> 16);
+				mergeCount++;
+				continue;
+			}
+		}
+		validMap[count] = validMap[k];
+		warpMap[count] = warpMap[k];
+		count++;
+	}
+	if (count == 0) {
+		// keep one dummy entry for the warp kernel
+		memset(&validMap[0], 0xff, sizeof(StitchValidPixelEntry));
+		memset(&warpMap[0], 0xff, sizeof(StitchWarpRemapEntry));
+		count = 1;
+	}
+	*warpEntryCount = count;
+	*mergeEntryCount = mergeCount;
+	return VX_SUCCESS;
+}
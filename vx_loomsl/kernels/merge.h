@@ -26,6 +26,7 @@ THE SOFTWARE.
 
 #include "kernels.h"
 #include "lens_distortion_remap.h"
+#include "warp.h"
 
 //////////////////////////////////////////////////////////////////////
 //! \brief The merge cameraId packing within U016 pixel entry.
@@ -67,4 +68,24 @@ vx_status GenerateDefaultMergeMaskImage(
 	vx_uint8 * maskBuf                    // [out] mask image buffer: size: [eqrWidth * eqrHeight * numCamera]
 	);
 
+//////////////////////////////////////////////////////////////////////
+// Move the warp entries of single camera pixels into merge remap table:
+// the merge kernel samples these pixels from the camera input, so that only
+// the overlap pixels are warped into the intermediate RGBX image
+vx_status GenerateMergeSingleCameraBuffers(
+	vx_uint32 eqrWidth,                   // [in] output equirectangular image width
+	vx_uint32 eqrHeight,                  // [in] output equirectangular image height
+	vx_uint32  camIdStride,               // [in] stride (in bytes) of camId table (image)
+	vx_uint32  camGroup1Stride,           // [in] stride (in bytes) of camGroup1 table (image)
+	vx_uint32  camGroup2Stride,           // [in] stride (in bytes) of camGroup2 table (image)
+	const vx_uint8 * camIdBuf,            // [in] camId table (image) from GenerateMergeBuffers
+	vx_uint16 * camGroup1Buf,             // [out] camId Group1 table (image): low 16-bits of merge remap entry index
+	vx_uint16 * camGroup2Buf,             // [out] camId Group2 table (image): high 16-bits of merge remap entry index
+	StitchValidPixelEntry * validMap,     // [in/out] valid map table: the single camera entries are removed
+	StitchWarpRemapEntry * warpMap,       // [in/out] warp map table: the single camera entries are removed
+	vx_size * warpEntryCount,             // [in/out] number of entries in warp/valid map table
+	StitchWarpRemapEntry * mergeMap,      // [out] merge remap table: size: [*warpEntryCount]
+	vx_size * mergeEntryCount             // [out] number of entries added to merge remap table
+	);
+
 #endif //__MERGE_H__
@@ -144,7 +144,7 @@ static vx_status VX_CALLBACK multiband_blend_query_target_support(vx_graph graph
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	supported_target_affinity = GetBlendTargetAffinity();
 	return VX_SUCCESS;
 }
 
@@ -297,10 +297,103 @@ static vx_status VX_CALLBACK multiband_blend_opencl_codegen(
 	return VX_SUCCESS;
 }
 
+//! \brief CPU helpers shared by the multiband blend and pyramid kernels.
+vx_uint32 GetBlendTargetAffinity()
+{
+	char textBuffer[256];
+	int MULTIBAND_TARGET = 0;
+	if (StitchGetEnvironmentVariable("MULTIBAND_TARGET", textBuffer, sizeof(textBuffer))) { MULTIBAND_TARGET = atoi(textBuffer); }
+	vx_uint32 supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	if (MULTIBAND_TARGET) supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
+	return supported_target_affinity;
+}
+
+vx_status AccessBlendCpuImage(vx_image image, vx_uint32 numCamera, vx_enum usage, StitchBlendCpuImage& img)
+{
+	vx_uint32 width = 0, height = 0;
+	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &img.format, sizeof(img.format)));
+	img.image = image;
+	img.ptr = nullptr;
+	img.width = (vx_int32)width;
+	img.height = (vx_int32)(numCamera ? height / numCamera : height);
+	img.rect.start_x = img.rect.start_y = 0;
+	img.rect.end_x = width;
+	img.rect.end_y = height;
+	ERROR_CHECK_STATUS(vxAccessImagePatch(image, &img.rect, 0, &img.addr, &img.ptr, usage));
+	return VX_SUCCESS;
+}
+
+vx_status CommitBlendCpuImage(StitchBlendCpuImage& img)
+{
+	ERROR_CHECK_STATUS(vxCommitImagePatch(img.image, &img.rect, 0, &img.addr, img.ptr));
+	return VX_SUCCESS;
+}
+
+vx_status AccessBlendValidEntries(vx_array arr, vx_uint32 arrOffset, void *& base, const StitchBlendValidEntry *& entry, vx_uint32& numEntries)
+{
+	vx_size arr_numitems = 0, stride = sizeof(StitchBlendValidEntry);
+	ERROR_CHECK_STATUS(vxQueryArray(arr, VX_ARRAY_ATTRIBUTE_NUMITEMS, &arr_numitems, sizeof(arr_numitems)));
+	if (arrOffset < 1 || arrOffset > arr_numitems)
+		return VX_ERROR_INVALID_PARAMETERS;
+	base = nullptr;
+	ERROR_CHECK_STATUS(vxAccessArrayRange(arr, 0, arr_numitems, &stride, &base, VX_READ_ONLY));
+	if (stride != sizeof(StitchBlendValidEntry)) {
+		vxCommitArrayRange(arr, 0, 0, base);
+		return VX_ERROR_INVALID_FORMAT;
+	}
+	entry = (const StitchBlendValidEntry *)base + arrOffset;
+	numEntries = *(const vx_uint32 *)(entry - 1);
+	if (numEntries > arr_numitems - arrOffset) {
+		vxCommitArrayRange(arr, 0, 0, base);
+		return VX_ERROR_INVALID_VALUE;
+	}
+	return VX_SUCCESS;
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK multiband_blend_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_IMPLEMENTED;
+	vx_uint32 numCam = 0, arr_offs = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &numCam));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &arr_offs));
+	vx_array arr = (vx_array)parameters[4];
+	StitchBlendCpuImage ip, wt, op;
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[2], numCam, VX_READ_ONLY, ip));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[3], numCam, VX_READ_ONLY, wt));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[5], numCam, VX_WRITE_ONLY, op));
+	void * base = nullptr;
+	const StitchBlendValidEntry * entry = nullptr;
+	vx_uint32 numEntries = 0;
+	ERROR_CHECK_STATUS(AccessBlendValidEntries(arr, arr_offs, base, entry, numEntries));
+
+	// weight the RGB of each valid tile pixel: U8 weights are in 0..255 and S16 weights in 0..32767 (divfactor maps them to 1/16)
+	const __m128 divfactor = _mm_set1_ps(wt.format == VX_DF_IMAGE_U8 ? 0.0627451f : 0.000490196f);
+	StitchParallelFor(numEntries, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 i = start; i < end; i++) {
+			const StitchBlendValidEntry& e = entry[i];
+			vx_int32 x0 = e.dstX, y0 = e.dstY;
+			vx_int32 x1 = std::min(x0 + (vx_int32)((e.last_x >> 2) + 1) * 4, op.width);
+			vx_int32 y1 = std::min(y0 + (vx_int32)e.last_y + 1, op.height);
+			for (vx_int32 y = y0; y < y1; y++) {
+				const vx_uint8 * ipRow = StitchBlendCpuRow(ip, e.camId, y);
+				const vx_uint8 * wtRow = StitchBlendCpuRow(wt, e.camId, y);
+				vx_uint8 * opRow = StitchBlendCpuRow(op, e.camId, y);
+				for (vx_int32 x = x0; x < x1; x++) {
+					float w = (wt.format == VX_DF_IMAGE_U8) ? (float)wtRow[x] : (float)((const vx_int16 *)wtRow)[x];
+					__m128 v = _mm_mul_ps(StitchBlendCpuLoadPixel(ipRow, ip.format, x), _mm_set1_ps(w));
+					StitchBlendCpuStoreRGB4(opRow, x, _mm_mul_ps(v, divfactor));
+				}
+			}
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitArrayRange(arr, 0, 0, base));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(op));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(wt));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip));
+	return VX_SUCCESS;
 }
 
 //! \brief The OpenCL global work updater callback.
@@ -53,6 +53,57 @@ typedef struct {
 	vx_uint32 skip_y  :  8; // starting pixel y-coordinate within the 64x16 block
 } StitchBlendValidEntry;
 
+//////////////////////////////////////////////////////////////////////
+//! \brief CPU view of a pyramid level image with camera images stacked vertically.
+typedef struct {
+	vx_image image;
+	void * ptr;
+	vx_imagepatch_addressing_t addr;
+	vx_rectangle_t rect;
+	vx_df_image format;
+	vx_int32 width;          // width of one camera image
+	vx_int32 height;         // height of one camera image
+} StitchBlendCpuImage;
+
+//! \brief Get row y of camera camId of a pyramid level image.
+static inline vx_uint8 * StitchBlendCpuRow(const StitchBlendCpuImage& img, vx_uint32 camId, vx_int32 y)
+{
+	return (vx_uint8 *)img.ptr + ((vx_size)camId * img.height + y) * img.addr.stride_y;
+}
+
+//! \brief Load one RGBX or RGB4 pixel as four floats (A is zero for RGB4).
+static inline __m128 StitchBlendCpuLoadPixel(const vx_uint8 * row, vx_df_image format, vx_int32 x)
+{
+	if (format == VX_DF_IMAGE_RGBX) {
+		vx_int32 v; memcpy(&v, row + (x << 2), sizeof(v));
+		return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+	}
+	const vx_int16 * p = (const vx_int16 *)(row + x * 6);
+	return _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+}
+
+//! \brief Store RGB of v as one RGB4 pixel (round to nearest even with saturation).
+static inline void StitchBlendCpuStoreRGB4(vx_uint8 * row, vx_int32 x, __m128 v)
+{
+	__m128i s = _mm_cvtps_epi32(v);
+	s = _mm_packs_epi32(s, s);
+	vx_int16 * p = (vx_int16 *)(row + x * 6);
+	p[0] = (vx_int16)_mm_extract_epi16(s, 0);
+	p[1] = (vx_int16)_mm_extract_epi16(s, 1);
+	p[2] = (vx_int16)_mm_extract_epi16(s, 2);
+}
+
+//////////////////////////////////////////////////////////////////////
+// CPU helpers shared by the multiband blend and pyramid kernels
+//   GetBlendTargetAffinity  - CPU if MULTIBAND_TARGET environment variable is non-zero, GPU otherwise
+//   AccessBlendCpuImage     - access the whole image for CPU processing
+//   CommitBlendCpuImage     - commit an image accessed by AccessBlendCpuImage
+//   AccessBlendValidEntries - access the valid entries of a pyramid level: the count is stored in the entry before arrOffset
+vx_uint32 GetBlendTargetAffinity();
+vx_status AccessBlendCpuImage(vx_image image, vx_uint32 numCamera, vx_enum usage, StitchBlendCpuImage& img);
+vx_status CommitBlendCpuImage(StitchBlendCpuImage& img);
+vx_status AccessBlendValidEntries(vx_array arr, vx_uint32 arrOffset, void *& base, const StitchBlendValidEntry *& entry, vx_uint32& numEntries);
+
 //////////////////////////////////////////////////////////////////////
 //! \brief The kernel registration functions.
 vx_status multiband_blend_publish(vx_context context);
@@ -45,6 +45,19 @@ static vx_status VX_CALLBACK noise_filter_input_validator(vx_node node, vx_uint3
 			vxAddLogEntry((vx_reference)node, status, "ERROR: noise filter lambda scalar type should be a vx_float32\n");
 		}
 	}
+	if (index == 4)
+	{ // optional object of SCALAR type: motion threshold (0 when absent)
+		vx_enum itemtype = VX_TYPE_INVALID;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+		if (itemtype == VX_TYPE_FLOAT32) {
+			status = VX_SUCCESS;
+		}
+		else {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: noise filter motion threshold scalar type should be a vx_float32\n");
+		}
+	}
 	if (index == 1)
 	{ // image of format RGB
 		vx_df_image format = VX_DF_IMAGE_VIRT;
@@ -137,7 +150,22 @@ static vx_status VX_CALLBACK noise_filter_query_target_support(vx_graph graph, v
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	char textBuffer[256];
+	int NOISE_FILTER_TARGET = 0;
+	if (StitchGetEnvironmentVariable("NOISE_FILTER_TARGET", textBuffer, sizeof(textBuffer))) { NOISE_FILTER_TARGET = atoi(textBuffer); }
+
+	// motion adaptive lambda is only available on CPU
+	vx_scalar scalar = (vx_scalar)avxGetNodeParamRef(node, 4);
+	if (scalar) {
+		ERROR_CHECK_STATUS(vxReleaseScalar(&scalar));
+		NOISE_FILTER_TARGET = 1;
+	}
+
+	if (!NOISE_FILTER_TARGET)
+		supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	else
+		supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
+
 	return VX_SUCCESS;
 }
 
@@ -214,10 +242,108 @@ static vx_status VX_CALLBACK noise_filter_opencl_codegen(
 	return VX_SUCCESS;
 }
 
+//////////////////////////////////////////////////////////////////////
+// CPU implementation: the frame is processed in blocks of NOISE_FILTER_BLOCK_SIZE x NOISE_FILTER_BLOCK_SIZE pixels.
+// When the motion threshold is non-zero, the mean absolute difference between the current and the previous
+// frame is measured for each block and raises lambda towards 1 in moving blocks, so that they don't ghost.
+// The block is blended right after it is measured, while it is still in cache.
+#define NOISE_FILTER_BLOCK_SIZE 16
+
+//! \brief Get sum of absolute differences of n bytes.
+static vx_uint32 NoiseFilterSAD(const vx_uint8 * cur, const vx_uint8 * prev, vx_uint32 n)
+{
+	__m128i acc = _mm_setzero_si128();
+	vx_uint32 i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(cur + i)), _mm_loadu_si128((const __m128i *)(prev + i))));
+	}
+	vx_uint32 sum = (vx_uint32)(_mm_cvtsi128_si32(acc) + _mm_extract_epi32(acc, 2));
+	for (; i < n; i++) {
+		sum += (vx_uint32)std::abs((vx_int32)cur[i] - (vx_int32)prev[i]);
+	}
+	return sum;
+}
+
+//! \brief Blend four 32-bit values: cur * lambda + prev * (1 - lambda), rounded to nearest even.
+static inline __m128i NoiseFilterBlend4(__m128i cur, __m128i prev, __m128 lambda, __m128 oneMinusLambda)
+{
+	return _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(cur), lambda), _mm_mul_ps(_mm_cvtepi32_ps(prev), oneMinusLambda)));
+}
+
+//! \brief Blend n bytes: dst = cur * lambda + prev * (1 - lambda) with saturation like amd_pack.
+static void NoiseFilterBlend(const vx_uint8 * cur, const vx_uint8 * prev, vx_uint8 * dst, vx_uint32 n, vx_float32 lambda)
+{
+	const __m128 l = _mm_set1_ps(lambda), oneMinusL = _mm_set1_ps(1.0f - lambda);
+	const __m128i zero = _mm_setzero_si128();
+	vx_uint32 i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(cur + i)), b = _mm_loadu_si128((const __m128i *)(prev + i));
+		__m128i a0 = _mm_unpacklo_epi8(a, zero), a1 = _mm_unpackhi_epi8(a, zero);
+		__m128i b0 = _mm_unpacklo_epi8(b, zero), b1 = _mm_unpackhi_epi8(b, zero);
+		__m128i r0 = NoiseFilterBlend4(_mm_unpacklo_epi16(a0, zero), _mm_unpacklo_epi16(b0, zero), l, oneMinusL);
+		__m128i r1 = NoiseFilterBlend4(_mm_unpackhi_epi16(a0, zero), _mm_unpackhi_epi16(b0, zero), l, oneMinusL);
+		__m128i r2 = NoiseFilterBlend4(_mm_unpacklo_epi16(a1, zero), _mm_unpacklo_epi16(b1, zero), l, oneMinusL);
+		__m128i r3 = NoiseFilterBlend4(_mm_unpackhi_epi16(a1, zero), _mm_unpackhi_epi16(b1, zero), l, oneMinusL);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3)));
+	}
+	for (; i < n; i++) {
+		vx_int32 v = _mm_cvtss_si32(_mm_set_ss(cur[i] * lambda + prev[i] * (1.0f - lambda)));
+		dst[i] = (vx_uint8)std::min(std::max(v, 0), 255);
+	}
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK noise_filter_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_SUPPORTED;
+	vx_float32 lambda = 0.0f, motion_threshold = 0.0f;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &lambda));
+	if (num > 4 && parameters[4])
+		ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[4], &motion_threshold));
+	vx_image input_image = (vx_image)parameters[1];
+	vx_image delayed_image = (vx_image)parameters[2];
+	vx_image output_image = (vx_image)parameters[3];
+	vx_uint32 width = 0, height = 0;
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+	vx_rectangle_t rect = { 0, 0, width, height };
+	vx_imagepatch_addressing_t input_addr, delayed_addr, output_addr;
+	void * input_ptr = nullptr, * delayed_ptr = nullptr, * output_ptr = nullptr;
+	ERROR_CHECK_STATUS(vxAccessImagePatch(input_image, &rect, 0, &input_addr, &input_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(delayed_image, &rect, 0, &delayed_addr, &delayed_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(output_image, &rect, 0, &output_addr, &output_ptr, VX_WRITE_ONLY));
+
+	bool motionAdaptive = (motion_threshold > 0.0f) && (lambda < 1.0f);
+	vx_uint32 rowBytes = width * 3, blockBytes = NOISE_FILTER_BLOCK_SIZE * 3;
+	vx_uint32 blockRowCount = (height + NOISE_FILTER_BLOCK_SIZE - 1) / NOISE_FILTER_BLOCK_SIZE;
+	StitchParallelFor(blockRowCount, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 by = start; by < end; by++) {
+			vx_uint32 y0 = by * NOISE_FILTER_BLOCK_SIZE, y1 = std::min(height, y0 + NOISE_FILTER_BLOCK_SIZE);
+			const vx_uint8 * cur = (const vx_uint8 *)input_ptr + y0 * input_addr.stride_y;
+			const vx_uint8 * prev = (const vx_uint8 *)delayed_ptr + y0 * delayed_addr.stride_y;
+			vx_uint8 * dst = (vx_uint8 *)output_ptr + y0 * output_addr.stride_y;
+			for (vx_uint32 x = 0; x < rowBytes; x += blockBytes) {
+				vx_uint32 n = std::min(blockBytes, rowBytes - x);
+				vx_float32 blockLambda = lambda;
+				if (motionAdaptive) {
+					vx_uint32 sad = 0;
+					for (vx_uint32 y = 0; y < y1 - y0; y++) {
+						sad += NoiseFilterSAD(cur + y * input_addr.stride_y + x, prev + y * delayed_addr.stride_y + x, n);
+					}
+					vx_float32 motion = (vx_float32)sad / (vx_float32)(n * (y1 - y0)) / motion_threshold;
+					blockLambda = lambda + (1.0f - lambda) * std::min(motion, 1.0f);
+				}
+				for (vx_uint32 y = 0; y < y1 - y0; y++) {
+					NoiseFilterBlend(cur + y * input_addr.stride_y + x, prev + y * delayed_addr.stride_y + x,
+						dst + y * output_addr.stride_y + x, n, blockLambda);
+				}
+			}
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitImagePatch(input_image, &rect, 0, &input_addr, input_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(delayed_image, &rect, 0, &delayed_addr, delayed_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(output_image, &rect, 0, &output_addr, output_ptr));
+	return VX_SUCCESS;
 }
 
 //! \brief The kernel publisher.
@@ -227,7 +353,7 @@ vx_status noise_filter_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.noise_filter",
 		AMDOVX_KERNEL_STITCHING_NOISE_FILTER,
 		noise_filter_kernel,
-		4,
+		5,
 		noise_filter_input_validator,
 		noise_filter_output_validator,
 		nullptr,
@@ -243,6 +369,7 @@ vx_status noise_filter_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 1, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 3, VX_OUTPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 4, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
@@ -23,6 +23,150 @@ THE SOFTWARE.
 #define _CRT_SECURE_NO_WARNINGS
 #include "pyramid_scale.h"
 #include "multiband_blender.h"
+#include "color_convert.h"
+
+//////////////////////////////////////////////////////////////////////
+// CPU implementation of the pyramid kernels
+//   Only the tiles listed in the blend valid entries of a level are processed. The horizontal filter
+//   pass of a tile goes into a small per-thread buffer and the vertical pass writes the output directly,
+//   so that downsample+gaussian and upsample+subtract/add are single passes over the level images.
+//   Pixels outside a camera image wrap around horizontally and are clamped vertically.
+
+#define PYRAMID_CPU_TILE_WIDTH   64
+#define PYRAMID_CPU_TILE_HEIGHT  16
+
+//! \brief Per-thread scratch buffers for processing one tile.
+struct PyramidCpuScratch {
+	std::vector<float> src;   // one source row: 4 floats per pixel
+	std::vector<float> hbuf;  // horizontally filtered source rows
+	std::vector<float> up;    // upsampled tile
+	PyramidCpuScratch()
+		: src((2 * PYRAMID_CPU_TILE_WIDTH + 8) * 4), hbuf((2 * PYRAMID_CPU_TILE_HEIGHT + 3) * PYRAMID_CPU_TILE_WIDTH * 4),
+		  up(PYRAMID_CPU_TILE_HEIGHT * PYRAMID_CPU_TILE_WIDTH * 4) {}
+};
+
+//! \brief Load count pixels of a row starting at x0 as floats (4 per pixel for RGBX/RGB4) with horizontal wrap-around.
+static void pyramid_cpu_load_row(float * dst, const StitchBlendCpuImage& img, const vx_uint8 * row, vx_int32 x0, vx_int32 count)
+{
+	for (vx_int32 i = 0; i < count; i++) {
+		vx_int32 x = x0 + i;
+		while (x < 0) x += img.width;
+		while (x >= img.width) x -= img.width;
+		if (img.format == VX_DF_IMAGE_U8) dst[i] = row[x];
+		else if (img.format == VX_DF_IMAGE_S16) dst[i] = ((const vx_int16 *)row)[x];
+		else _mm_storeu_ps(dst + 4 * i, StitchBlendCpuLoadPixel(row, img.format, x));
+	}
+}
+
+//! \brief Get the tile of a valid entry clipped to the image: width and height are in multiples of gx and gy pixels.
+static bool pyramid_cpu_get_tile(const StitchBlendValidEntry& e, const StitchBlendCpuImage& op, vx_int32 gx, vx_int32 gy, vx_int32& w, vx_int32& h)
+{
+	w = std::min(std::min(((vx_int32)e.last_x / gx + 1) * gx, PYRAMID_CPU_TILE_WIDTH), op.width - (vx_int32)e.dstX);
+	h = std::min(std::min(((vx_int32)e.last_y / gy + 1) * gy, PYRAMID_CPU_TILE_HEIGHT), op.height - (vx_int32)e.dstY);
+	return w > 0 && h > 0;
+}
+
+//! \brief Downsample one tile by 2 with the 5x5 gaussian [1 4 6 4 1] and scale the result.
+static void half_scale_gaussian_cpu_tile(const StitchBlendValidEntry& e, const StitchBlendCpuImage& ip, const StitchBlendCpuImage& op, float scale, PyramidCpuScratch& scratch)
+{
+	vx_int32 x0 = e.dstX, y0 = e.dstY, w, h;
+	if (!pyramid_cpu_get_tile(e, op, 4, 1, w, h))
+		return;
+	const vx_int32 C = (ip.format == VX_DF_IMAGE_RGBX) ? 4 : 1;
+	const vx_int32 wv = (w + 3) & ~3, n = wv * C;
+	const __m128 c4 = _mm_set1_ps(4.0f), c6 = _mm_set1_ps(6.0f), vscale = _mm_set1_ps(scale);
+	float * src = scratch.src.data(), * hbuf = scratch.hbuf.data();
+	// horizontal pass at the decimated positions on input rows 2*y0-1 .. 2*(y0+h)+1
+	for (vx_int32 j = 0; j < 2 * h + 3; j++) {
+		vx_int32 y = std::max(0, std::min(2 * y0 - 1 + j, ip.height - 1));
+		pyramid_cpu_load_row(src, ip, StitchBlendCpuRow(ip, e.camId, y), 2 * x0 - 1, 2 * wv + 8);
+		float * H = hbuf + j * n;
+		if (C == 4) {
+			for (vx_int32 ox = 0; ox < wv; ox++) {
+				const float * s = src + 8 * ox;
+				__m128 v = _mm_add_ps(_mm_loadu_ps(s), _mm_loadu_ps(s + 16));
+				v = _mm_add_ps(v, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s + 4), _mm_loadu_ps(s + 12)), c4));
+				v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(s + 8), c6));
+				_mm_storeu_ps(H + 4 * ox, v);
+			}
+		}
+		else {
+			for (vx_int32 ox = 0; ox < wv; ox += 4) {
+				const float * s = src + 2 * ox;
+				__m128 a = _mm_loadu_ps(s), b = _mm_loadu_ps(s + 4), c = _mm_loadu_ps(s + 8);
+				__m128 a2 = _mm_loadu_ps(s + 2), b2 = _mm_loadu_ps(s + 6);
+				__m128 e0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));   // s[0] s[2] s[4] s[6]
+				__m128 o0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));   // s[1] s[3] s[5] s[7]
+				__m128 e1 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0)); // s[2] s[4] s[6] s[8]
+				__m128 o1 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(3, 1, 3, 1)); // s[3] s[5] s[7] s[9]
+				__m128 e2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 0, 2, 0));   // s[4] s[6] s[8] s[10]
+				__m128 v = _mm_add_ps(_mm_add_ps(e0, e2), _mm_mul_ps(_mm_add_ps(o0, o1), c4));
+				_mm_storeu_ps(H + ox, _mm_add_ps(v, _mm_mul_ps(e1, c6)));
+			}
+		}
+	}
+	// vertical pass into the output with round to nearest even and saturation
+	const vx_int32 count = w * C;
+	for (vx_int32 oy = 0; oy < h; oy++) {
+		const float * r = hbuf + 2 * oy * n;
+		vx_uint8 * dst = StitchBlendCpuRow(op, e.camId, y0 + oy);
+		for (vx_int32 i = 0; i < count; i += 4) {
+			__m128 v = _mm_add_ps(_mm_loadu_ps(r + i), _mm_loadu_ps(r + 4 * n + i));
+			v = _mm_add_ps(v, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(r + n + i), _mm_loadu_ps(r + 3 * n + i)), c4));
+			v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(r + 2 * n + i), c6));
+			__m128i s16 = _mm_cvtps_epi32(_mm_mul_ps(v, vscale));
+			s16 = _mm_packs_epi32(s16, s16);
+			vx_int32 m = std::min(count - i, 4);
+			if (op.format == VX_DF_IMAGE_S16) {
+				vx_int16 t[8]; _mm_storeu_si128((__m128i *)t, s16);
+				memcpy(dst + (x0 * C + i) * 2, t, m * 2);
+			}
+			else {
+				vx_int32 t = _mm_cvtsi128_si32(_mm_packus_epi16(s16, s16));
+				memcpy(dst + x0 * C + i, &t, m);
+			}
+		}
+	}
+}
+
+//! \brief Upsample by 2 with the 5x5 gaussian the 4-channel source region under the output tile (x0, y0, w, h) into up.
+//  Output pixel x uses source pixels k-1, k, k+1 (k = x/2) with weights [1 6 1] at even x and [0 4 4] at odd x.
+static void pyramid_cpu_upscale_tile(float * up, const StitchBlendCpuImage& ip1, vx_uint32 camId, vx_int32 x0, vx_int32 y0, vx_int32 w, vx_int32 h, PyramidCpuScratch& scratch)
+{
+	const __m128 c4 = _mm_set1_ps(4.0f), c6 = _mm_set1_ps(6.0f), norm = _mm_set1_ps(0.015625f);
+	float * src = scratch.src.data(), * hbuf = scratch.hbuf.data();
+	const vx_int32 kx0 = (x0 >> 1) - 1, kw = ((x0 + w - 1) >> 1) + 2 - kx0;
+	const vx_int32 ky0 = (y0 >> 1) - 1, kh = ((y0 + h - 1) >> 1) + 2 - ky0;
+	const vx_int32 n = w * 4;
+	for (vx_int32 j = 0; j < kh; j++) {
+		vx_int32 y = std::max(0, std::min(ky0 + j, ip1.height - 1));
+		pyramid_cpu_load_row(src, ip1, StitchBlendCpuRow(ip1, camId, y), kx0, kw);
+		float * H = hbuf + j * n;
+		for (vx_int32 x = 0; x < w; x++) {
+			const float * s = src + 4 * (((x0 + x) >> 1) - kx0);
+			__m128 v;
+			if ((x0 + x) & 1) v = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s), _mm_loadu_ps(s + 4)), c4);
+			else v = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(s - 4), _mm_loadu_ps(s + 4)), _mm_mul_ps(_mm_loadu_ps(s), c6));
+			_mm_storeu_ps(H + 4 * x, v);
+		}
+	}
+	for (vx_int32 y = 0; y < h; y++) {
+		const float * r = hbuf + (((y0 + y) >> 1) - ky0) * n;
+		float * dst = up + y * n;
+		if ((y0 + y) & 1) {
+			for (vx_int32 i = 0; i < n; i += 4) {
+				__m128 v = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(r + i), _mm_loadu_ps(r + n + i)), c4);
+				_mm_storeu_ps(dst + i, _mm_mul_ps(v, norm));
+			}
+		}
+		else {
+			for (vx_int32 i = 0; i < n; i += 4) {
+				__m128 v = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(r - n + i), _mm_loadu_ps(r + n + i)), _mm_mul_ps(_mm_loadu_ps(r + i), c6));
+				_mm_storeu_ps(dst + i, _mm_mul_ps(v, norm));
+			}
+		}
+	}
+}
 
 //! \brief The input validator callback.
 static vx_status VX_CALLBACK half_scale_gaussian_input_validator(vx_node node, vx_uint32 index)
@@ -149,7 +293,7 @@ static vx_status VX_CALLBACK half_scale_gaussian_query_target_support(vx_graph g
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	supported_target_affinity = GetBlendTargetAffinity();
 	return VX_SUCCESS;
 }
 
@@ -678,7 +822,39 @@ static vx_status VX_CALLBACK half_scale_gaussian_opencl_codegen(
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK half_scale_gaussian_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_SUPPORTED;
+	vx_uint32 numCam = 0, arr_offs = 0;
+	vx_df_image ip_format = VX_DF_IMAGE_VIRT, op_format = VX_DF_IMAGE_VIRT;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &numCam));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &arr_offs));
+	ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[3], VX_IMAGE_ATTRIBUTE_FORMAT, &ip_format, sizeof(ip_format)));
+	ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[4], VX_IMAGE_ATTRIBUTE_FORMAT, &op_format, sizeof(op_format)));
+	float scale;
+	if (ip_format == op_format && (ip_format == VX_DF_IMAGE_U8 || ip_format == VX_DF_IMAGE_S16 || ip_format == VX_DF_IMAGE_RGBX))
+		scale = 0.00390625f;
+	else if (ip_format == VX_DF_IMAGE_U8 && op_format == VX_DF_IMAGE_S16)
+		scale = 0.5f;
+	else
+		return VX_ERROR_NOT_SUPPORTED;
+	vx_array arr = (vx_array)parameters[2];
+	StitchBlendCpuImage ip, op;
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[3], numCam, VX_READ_ONLY, ip));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[4], numCam, VX_WRITE_ONLY, op));
+	void * base = nullptr;
+	const StitchBlendValidEntry * entry = nullptr;
+	vx_uint32 numEntries = 0;
+	ERROR_CHECK_STATUS(AccessBlendValidEntries(arr, arr_offs, base, entry, numEntries));
+
+	StitchParallelFor(numEntries, [&](vx_uint32 start, vx_uint32 end) {
+		PyramidCpuScratch scratch;
+		for (vx_uint32 i = start; i < end; i++) {
+			half_scale_gaussian_cpu_tile(entry[i], ip, op, scale, scratch);
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitArrayRange(arr, 0, 0, base));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(op));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip));
+	return VX_SUCCESS;
 }
 
 //! \brief The kernel publisher.
@@ -858,14 +1034,71 @@ static vx_status VX_CALLBACK upscale_gaussian_subtract_query_target_support(vx_g
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	supported_target_affinity = GetBlendTargetAffinity();
 	return VX_SUCCESS;
 }
 
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK upscale_gaussian_subtract_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_IMPLEMENTED;
+	vx_uint32 numCam = 0, arr_offs = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &numCam));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &arr_offs));
+	vx_array arr = (vx_array)parameters[4];
+	bool useWeight = parameters[5] ? true : false;
+	StitchBlendCpuImage ip, ip1, wt, op;
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[2], numCam, VX_READ_ONLY, ip));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[3], numCam, VX_READ_ONLY, ip1));
+	if (useWeight) {
+		ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[5], numCam, VX_READ_ONLY, wt));
+	}
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[6], numCam, VX_WRITE_ONLY, op));
+	void * base = nullptr;
+	const StitchBlendValidEntry * entry = nullptr;
+	vx_uint32 numEntries = 0;
+	ERROR_CHECK_STATUS(AccessBlendValidEntries(arr, arr_offs, base, entry, numEntries));
+
+	// laplacian = level - upscale(next level), optionally weighted: U8 weights are in 0..255 and S16 weights in 0..32767
+	const __m128 divfactor = _mm_set1_ps((useWeight && wt.format == VX_DF_IMAGE_S16) ? 0.000490196f : 0.0627451f);
+	StitchParallelFor(numEntries, [&](vx_uint32 start, vx_uint32 end) {
+		PyramidCpuScratch scratch;
+		float * up = scratch.up.data();
+		for (vx_uint32 i = start; i < end; i++) {
+			const StitchBlendValidEntry& e = entry[i];
+			vx_int32 x0 = e.dstX, y0 = e.dstY, w, h;
+			if (!pyramid_cpu_get_tile(e, op, 4, 2, w, h))
+				continue;
+			pyramid_cpu_upscale_tile(up, ip1, e.camId, x0, y0, w, h, scratch);
+			for (vx_int32 y = 0; y < h; y++) {
+				const vx_uint8 * ipRow = StitchBlendCpuRow(ip, e.camId, y0 + y);
+				vx_uint8 * opRow = StitchBlendCpuRow(op, e.camId, y0 + y);
+				const float * upRow = up + y * w * 4;
+				if (useWeight) {
+					const vx_uint8 * wtRow = StitchBlendCpuRow(wt, e.camId, y0 + y);
+					for (vx_int32 x = 0; x < w; x++) {
+						float wf = (wt.format == VX_DF_IMAGE_U8) ? (float)wtRow[x0 + x] : (float)((const vx_int16 *)wtRow)[x0 + x];
+						__m128 v = _mm_sub_ps(StitchBlendCpuLoadPixel(ipRow, ip.format, x0 + x), _mm_loadu_ps(upRow + 4 * x));
+						StitchBlendCpuStoreRGB4(opRow, x0 + x, _mm_mul_ps(_mm_mul_ps(v, _mm_set1_ps(wf)), divfactor));
+					}
+				}
+				else {
+					for (vx_int32 x = 0; x < w; x++) {
+						__m128 v = _mm_sub_ps(StitchBlendCpuLoadPixel(ipRow, ip.format, x0 + x), _mm_loadu_ps(upRow + 4 * x));
+						StitchBlendCpuStoreRGB4(opRow, x0 + x, v);
+					}
+				}
+			}
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitArrayRange(arr, 0, 0, base));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(op));
+	if (useWeight) {
+		ERROR_CHECK_STATUS(CommitBlendCpuImage(wt));
+	}
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip1));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip));
+	return VX_SUCCESS;
 }
 
 //! \brief The OpenCL code generator callback.
@@ -1385,14 +1618,53 @@ static vx_status VX_CALLBACK upscale_gaussian_add_query_target_support(vx_graph
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	supported_target_affinity = GetBlendTargetAffinity();
 	return VX_SUCCESS;
 }
 
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK upscale_gaussian_add_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_IMPLEMENTED;
+	vx_uint32 numCam = 0, arr_offs = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &numCam));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &arr_offs));
+	vx_array arr = (vx_array)parameters[4];
+	StitchBlendCpuImage ip, ip1, op;
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[2], numCam, VX_READ_ONLY, ip));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[3], numCam, VX_READ_ONLY, ip1));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[5], numCam, VX_WRITE_ONLY, op));
+	void * base = nullptr;
+	const StitchBlendValidEntry * entry = nullptr;
+	vx_uint32 numEntries = 0;
+	ERROR_CHECK_STATUS(AccessBlendValidEntries(arr, arr_offs, base, entry, numEntries));
+
+	// reconstructed level = laplacian + upscale(reconstructed next level)
+	StitchParallelFor(numEntries, [&](vx_uint32 start, vx_uint32 end) {
+		PyramidCpuScratch scratch;
+		float * up = scratch.up.data();
+		for (vx_uint32 i = start; i < end; i++) {
+			const StitchBlendValidEntry& e = entry[i];
+			vx_int32 x0 = e.dstX, y0 = e.dstY, w, h;
+			if (!pyramid_cpu_get_tile(e, op, 8, 2, w, h))
+				continue;
+			pyramid_cpu_upscale_tile(up, ip1, e.camId, x0, y0, w, h, scratch);
+			for (vx_int32 y = 0; y < h; y++) {
+				const vx_uint8 * ipRow = StitchBlendCpuRow(ip, e.camId, y0 + y);
+				vx_uint8 * opRow = StitchBlendCpuRow(op, e.camId, y0 + y);
+				const float * upRow = up + y * w * 4;
+				for (vx_int32 x = 0; x < w; x++) {
+					__m128 v = _mm_round_ps(_mm_loadu_ps(upRow + 4 * x), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+					StitchBlendCpuStoreRGB4(opRow, x0 + x, _mm_add_ps(StitchBlendCpuLoadPixel(ipRow, ip.format, x0 + x), v));
+				}
+			}
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitArrayRange(arr, 0, 0, base));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(op));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip1));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip));
+	return VX_SUCCESS;
 }
 
 //! \brief The OpenCL code generator callback.
@@ -1793,14 +2065,56 @@ static vx_status VX_CALLBACK laplacian_reconstruct_query_target_support(vx_graph
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	supported_target_affinity = GetBlendTargetAffinity();
 	return VX_SUCCESS;
 }
 
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK laplacian_reconstruct_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_IMPLEMENTED;
+	vx_uint32 numCam = 0, arr_offs = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &numCam));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &arr_offs));
+	vx_array arr = (vx_array)parameters[4];
+	StitchBlendCpuImage ip, ip1, op;
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[2], numCam, VX_READ_ONLY, ip));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[3], numCam, VX_READ_ONLY, ip1));
+	ERROR_CHECK_STATUS(AccessBlendCpuImage((vx_image)parameters[5], numCam, VX_WRITE_ONLY, op));
+	void * base = nullptr;
+	const StitchBlendValidEntry * entry = nullptr;
+	vx_uint32 numEntries = 0;
+	ERROR_CHECK_STATUS(AccessBlendValidEntries(arr, arr_offs, base, entry, numEntries));
+
+	// output = (laplacian + upscale(reconstructed next level)) / 16 with opaque alpha
+	const __m128 norm = _mm_set1_ps(0.0625f), alpha = _mm_set1_ps(255.0f);
+	StitchParallelFor(numEntries, [&](vx_uint32 start, vx_uint32 end) {
+		PyramidCpuScratch scratch;
+		float * up = scratch.up.data();
+		for (vx_uint32 i = start; i < end; i++) {
+			const StitchBlendValidEntry& e = entry[i];
+			vx_int32 x0 = e.dstX, y0 = e.dstY, w, h;
+			if (!pyramid_cpu_get_tile(e, op, 8, 2, w, h))
+				continue;
+			pyramid_cpu_upscale_tile(up, ip1, e.camId, x0, y0, w, h, scratch);
+			for (vx_int32 y = 0; y < h; y++) {
+				const vx_uint8 * ipRow = StitchBlendCpuRow(ip, e.camId, y0 + y);
+				vx_uint8 * opRow = StitchBlendCpuRow(op, e.camId, y0 + y);
+				const float * upRow = up + y * w * 4;
+				for (vx_int32 x = 0; x < w; x++) {
+					__m128 v = _mm_add_ps(_mm_loadu_ps(upRow + 4 * x), StitchBlendCpuLoadPixel(ipRow, ip.format, x0 + x));
+					__m128i i32 = _mm_cvtps_epi32(_mm_blend_ps(_mm_mul_ps(v, norm), alpha, 8));
+					i32 = _mm_packs_epi32(i32, i32);
+					((vx_int32 *)opRow)[x0 + x] = _mm_cvtsi128_si32(_mm_packus_epi16(i32, i32));
+				}
+			}
+		}
+	});
+
+	ERROR_CHECK_STATUS(vxCommitArrayRange(arr, 0, 0, base));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(op));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip1));
+	ERROR_CHECK_STATUS(CommitBlendCpuImage(ip));
+	return VX_SUCCESS;
 }
 
 //! \brief The OpenCL code generator callback.
@@ -2086,3 +2400,219 @@ vx_status laplacian_reconstruct_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
 	return VX_SUCCESS;
 }
+
+//////////////////////////////////////////////////////////////////////
+// Area downscale of a RGB image by 1/N: each output pixel is the average of a NxN block of input pixels
+
+//! \brief The input validator callback.
+static vx_status VX_CALLBACK area_downscale_input_validator(vx_node node, vx_uint32 index)
+{
+	vx_status status = VX_ERROR_INVALID_PARAMETERS;
+	// get reference for parameter at specified index
+	vx_reference ref = avxGetNodeParamRef(node, index);
+	ERROR_CHECK_OBJECT(ref);
+	// validate each parameter
+	if (index == 0)
+	{ // object of SCALAR type: the scale factor N
+		vx_enum itemtype = VX_TYPE_INVALID;
+		vx_uint32 scale = 0;
+		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
+		if (itemtype == VX_TYPE_UINT32) {
+			ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)ref, &scale));
+			status = (scale >= 1) ? VX_SUCCESS : VX_ERROR_INVALID_VALUE;
+		}
+		else {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: area_downscale scale scalar type should be a UINT32\n");
+		}
+		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+	}
+	else if (index == 1)
+	{ // image of format RGB2
+		vx_df_image format = VX_DF_IMAGE_VIRT;
+		ERROR_CHECK_STATUS(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+		if (format == VX_DF_IMAGE_RGB) {
+			status = VX_SUCCESS;
+		}
+		else {
+			status = VX_ERROR_INVALID_TYPE;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: area_downscale doesn't support input image format: %4.4s\n", &format);
+		}
+		ERROR_CHECK_STATUS(vxReleaseImage((vx_image *)&ref));
+	}
+	return status;
+}
+
+//! \brief The output validator callback.
+static vx_status VX_CALLBACK area_downscale_output_validator(vx_node node, vx_uint32 index, vx_meta_format meta)
+{
+	vx_status status = VX_ERROR_INVALID_PARAMETERS;
+	if (index == 2)
+	{ // image of format RGB2 with the input dimensions divided by N
+		vx_uint32 scale = 0;
+		vx_scalar scalar = (vx_scalar)avxGetNodeParamRef(node, 0);
+		ERROR_CHECK_OBJECT(scalar);
+		ERROR_CHECK_STATUS(vxReadScalarValue(scalar, &scale));
+		ERROR_CHECK_STATUS(vxReleaseScalar(&scalar));
+		vx_image image = (vx_image)avxGetNodeParamRef(node, 1);
+		ERROR_CHECK_OBJECT(image);
+		vx_uint32 input_width = 0, input_height = 0;
+		ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_WIDTH, &input_width, sizeof(input_width)));
+		ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_HEIGHT, &input_height, sizeof(input_height)));
+		ERROR_CHECK_STATUS(vxReleaseImage(&image));
+		vx_uint32 output_width = input_width / scale, output_height = input_height / scale;
+		vx_df_image output_format = VX_DF_IMAGE_RGB;
+		if (!output_width || !output_height) {
+			status = VX_ERROR_INVALID_DIMENSION;
+			vxAddLogEntry((vx_reference)node, status, "ERROR: area_downscale output of %dx%d input scaled by 1/%d is empty\n", input_width, input_height, scale);
+		}
+		else {
+			// set output image meta data
+			ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(meta, VX_IMAGE_ATTRIBUTE_WIDTH, &output_width, sizeof(output_width)));
+			ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(meta, VX_IMAGE_ATTRIBUTE_HEIGHT, &output_height, sizeof(output_height)));
+			ERROR_CHECK_STATUS(vxSetMetaFormatAttribute(meta, VX_IMAGE_ATTRIBUTE_FORMAT, &output_format, sizeof(output_format)));
+			status = VX_SUCCESS;
+		}
+	}
+	return status;
+}
+
+//! \brief The kernel target support callback.
+static vx_status VX_CALLBACK area_downscale_query_target_support(vx_graph graph, vx_node node,
+	vx_bool use_opencl_1_2,              // [input]  false: OpenCL driver is 2.0+; true: OpenCL driver is 1.2
+	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
+	)
+{
+	supported_target_affinity = GetColorConvertTargetAffinity();
+	return VX_SUCCESS;
+}
+
+//! \brief The OpenCL code generator callback.
+static vx_status VX_CALLBACK area_downscale_opencl_codegen(
+	vx_node node,                                  // [input] node
+	const vx_reference parameters[],               // [input] parameters
+	vx_uint32 num,                                 // [input] number of parameters
+	bool opencl_load_function,                     // [input]  false: normal OpenCL kernel; true: reserved
+	char opencl_kernel_function_name[64],          // [output] kernel_name for clCreateKernel()
+	std::string& opencl_kernel_code,               // [output] string for clCreateProgramWithSource()
+	std::string& opencl_build_options,             // [output] options for clBuildProgram()
+	vx_uint32& opencl_work_dim,                    // [output] work_dim for clEnqueueNDRangeKernel()
+	vx_size opencl_global_work[],                  // [output] global_work[] for clEnqueueNDRangeKernel()
+	vx_size opencl_local_work[],                   // [output] local_work[] for clEnqueueNDRangeKernel()
+	vx_uint32& opencl_local_buffer_usage_mask,     // [output] reserved: must be ZERO
+	vx_uint32& opencl_local_buffer_size_in_bytes   // [output] reserved: must be ZERO
+	)
+{
+	// get the scale and output dimensions
+	vx_uint32 scale = 0, output_width = 0, output_height = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &scale));
+	ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[2], VX_IMAGE_ATTRIBUTE_WIDTH, &output_width, sizeof(output_width)));
+	ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[2], VX_IMAGE_ATTRIBUTE_HEIGHT, &output_height, sizeof(output_height)));
+
+	// set kernel configuration: a work-item per output pixel
+	strcpy(opencl_kernel_function_name, "area_downscale");
+	opencl_work_dim = 2;
+	opencl_local_work[0] = 16;
+	opencl_local_work[1] = 4;
+	opencl_global_work[0] = (output_width + opencl_local_work[0] - 1) & ~(opencl_local_work[0] - 1);
+	opencl_global_work[1] = (output_height + opencl_local_work[1] - 1) & ~(opencl_local_work[1] - 1);
+
+	// Setting variables required by the interface
+	opencl_local_buffer_usage_mask = 0;
+	opencl_local_buffer_size_in_bytes = 0;
+
+	// kernel body: the sum of the NxN block is rounded to the nearest average
+	char item[8192];
+	sprintf(item,
+		"__kernel __attribute__((reqd_work_group_size(%d, %d, 1)))\n" // opencl_local_work[0], opencl_local_work[1]
+		"void %s(uint scale,\n"
+		"        uint ip_width, uint ip_height, __global uchar * ip_buf, uint ip_stride, uint ip_offset,\n"
+		"        uint op_width, uint op_height, __global uchar * op_buf, uint op_stride, uint op_offset)\n"
+		"{\n"
+		"  uint gx = get_global_id(0);\n"
+		"  uint gy = get_global_id(1);\n"
+		"  if ((gx < %d) && (gy < %d)) {\n" // output_width, output_height
+		"    __global const uchar * ip = ip_buf + ip_offset + (gy * %d) * ip_stride + (gx * %d);\n" // scale, scale * 3
+		"    uint3 sum = (uint3)(0, 0, 0);\n"
+		"    for (uint y = 0; y < %d; y++, ip += ip_stride) {\n" // scale
+		"      for (uint x = 0; x < %d; x++) {\n" // scale
+		"        sum += convert_uint3(vload3(x, ip));\n"
+		"      }\n"
+		"    }\n"
+		"    sum = (sum + (uint3)%d) / (uint3)%d;\n" // scale * scale / 2, scale * scale
+		"    vstore3(convert_uchar3(sum), gx, op_buf + op_offset + gy * op_stride);\n"
+		"  }\n"
+		"}\n"
+		, (int)opencl_local_work[0], (int)opencl_local_work[1], opencl_kernel_function_name,
+		output_width, output_height, scale, scale * 3, scale, scale, (scale * scale) >> 1, scale * scale);
+	opencl_kernel_code = item;
+
+	return VX_SUCCESS;
+}
+
+//! \brief The kernel execution.
+static vx_status VX_CALLBACK area_downscale_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
+{
+	vx_uint32 scale = 0, output_width = 0, output_height = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &scale));
+	ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[2], VX_IMAGE_ATTRIBUTE_WIDTH, &output_width, sizeof(output_width)));
+	ERROR_CHECK_STATUS(vxQueryImage((vx_image)parameters[2], VX_IMAGE_ATTRIBUTE_HEIGHT, &output_height, sizeof(output_height)));
+	vx_rectangle_t ip_rect = { 0, 0, output_width * scale, output_height * scale };
+	vx_rectangle_t op_rect = { 0, 0, output_width, output_height };
+	vx_imagepatch_addressing_t ip_addr, op_addr;
+	void * ip_ptr = nullptr, * op_ptr = nullptr;
+	ERROR_CHECK_STATUS(vxAccessImagePatch((vx_image)parameters[1], &ip_rect, 0, &ip_addr, &ip_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch((vx_image)parameters[2], &op_rect, 0, &op_addr, &op_ptr, VX_WRITE_ONLY));
+	const vx_uint32 count = scale * scale;
+	StitchParallelFor(output_height, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 y = start; y < end; y++) {
+			const vx_uint8 * ip = (const vx_uint8 *)ip_ptr + y * scale * ip_addr.stride_y;
+			vx_uint8 * op = (vx_uint8 *)op_ptr + y * op_addr.stride_y;
+			for (vx_uint32 x = 0; x < output_width; x++, ip += scale * 3, op += 3) {
+				vx_uint32 sum[3] = { 0, 0, 0 };
+				const vx_uint8 * row = ip;
+				for (vx_uint32 j = 0; j < scale; j++, row += ip_addr.stride_y) {
+					for (vx_uint32 i = 0; i < scale * 3; i += 3) {
+						sum[0] += row[i]; sum[1] += row[i + 1]; sum[2] += row[i + 2];
+					}
+				}
+				op[0] = (vx_uint8)((sum[0] + (count >> 1)) / count);
+				op[1] = (vx_uint8)((sum[1] + (count >> 1)) / count);
+				op[2] = (vx_uint8)((sum[2] + (count >> 1)) / count);
+			}
+		}
+	});
+	ERROR_CHECK_STATUS(vxCommitImagePatch((vx_image)parameters[1], &ip_rect, 0, &ip_addr, ip_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch((vx_image)parameters[2], &op_rect, 0, &op_addr, op_ptr));
+	return VX_SUCCESS;
+}
+
+//! \brief The kernel publisher.
+vx_status area_downscale_publish(vx_context context)
+{
+	// add kernel to the context with callbacks
+	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.area_downscale",
+		AMDOVX_KERNEL_STITCHING_AREA_DOWNSCALE,
+		area_downscale_kernel,
+		3,
+		area_downscale_input_validator,
+		area_downscale_output_validator,
+		nullptr,
+		nullptr);
+	ERROR_CHECK_OBJECT(kernel);
+	amd_kernel_query_target_support_f query_target_support_f = area_downscale_query_target_support;
+	amd_kernel_opencl_codegen_callback_f opencl_codegen_callback_f = area_downscale_opencl_codegen;
+	ERROR_CHECK_STATUS(vxSetKernelAttribute(kernel, VX_KERNEL_ATTRIBUTE_AMD_QUERY_TARGET_SUPPORT, &query_target_support_f, sizeof(query_target_support_f)));
+	ERROR_CHECK_STATUS(vxSetKernelAttribute(kernel, VX_KERNEL_ATTRIBUTE_AMD_OPENCL_CODEGEN_CALLBACK, &opencl_codegen_callback_f, sizeof(opencl_codegen_callback_f)));
+
+	// set kernel parameters
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 0, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 1, VX_INPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 2, VX_OUTPUT, VX_TYPE_IMAGE, VX_PARAMETER_STATE_REQUIRED));
+
+	// finalize and release kernel object
+	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
+	ERROR_CHECK_STATUS(vxReleaseKernel(&kernel));
+
+	return VX_SUCCESS;
+}
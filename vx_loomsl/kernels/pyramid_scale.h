@@ -32,5 +32,6 @@ vx_status half_scale_gaussian_publish(vx_context context);
 vx_status upscale_gaussian_subtract_publish(vx_context context);
 vx_status upscale_gaussian_add_publish(vx_context context);
 vx_status laplacian_reconstruct_publish(vx_context context);
+vx_status area_downscale_publish(vx_context context);
 
 #endif //__PYRAMID_SCALE_H__
@@ -24,13 +24,14 @@ THE SOFTWARE.
 #include "seam_find.h"
 
 //developer settings
-#define GET_TIMING     0
 #define SHOW_MESSAGES  0
 
 #if _WIN32
 #include <windows.h>
 #undef min
 #undef max
+#else
+#include <chrono>
 #endif
 
 #if SHOW_MESSAGES
@@ -39,29 +40,27 @@ THE SOFTWARE.
 #define PRINTF(...)
 #endif
 
-#if GET_TIMING
-int64_t stitchGetClockCounter()
+static int64_t stitchGetClockCounter()
 {
 #if _WIN32
 	LARGE_INTEGER v;
 	QueryPerformanceCounter(&v);
 	return v.QuadPart;
 #else
-	return chrono::high_resolution_clock::now().time_since_epoch().count();
+	return std::chrono::high_resolution_clock::now().time_since_epoch().count();
 #endif
 }
 
-int64_t stitchGetClockFrequency()
+static int64_t stitchGetClockFrequency()
 {
 #if _WIN32
 	LARGE_INTEGER v;
 	QueryPerformanceFrequency(&v);
 	return v.QuadPart;
 #else
-	return chrono::high_resolution_clock::period::den / chrono::high_resolution_clock::period::num;
+	return std::chrono::high_resolution_clock::period::den / std::chrono::high_resolution_clock::period::num;
 #endif
 }
-#endif //GET_TIMING
 
 /***********************************************************************************************************************************
 												Seam Find CPU Model
@@ -1581,7 +1580,7 @@ static vx_status VX_CALLBACK seamfind_cost_accumulate_input_validator(vx_node no
 	vx_reference ref = avxGetNodeParamRef(node, index);
 	ERROR_CHECK_OBJECT(ref);
 	// validate each parameter
-	if (index == 0 || index == 1 || index == 2)
+	if (index == 0 || index == 1 || index == 2 || index == 10)
 	{ // object of SCALAR type
 		vx_enum itemtype = VX_TYPE_INVALID;
 		ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
@@ -1591,7 +1590,7 @@ static vx_status VX_CALLBACK seamfind_cost_accumulate_input_validator(vx_node no
 		}
 		else {
 			status = VX_ERROR_INVALID_TYPE;
-			vxAddLogEntry((vx_reference)node, status, "ERROR: SeamFind Equi Width/Height scalar type should be a UINT32\n");
+			vxAddLogEntry((vx_reference)node, status, "ERROR: SeamFind Equi Width/Height/Coarse Scale scalar type should be a UINT32\n");
 		}
 		ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
 	}
@@ -1723,7 +1722,25 @@ static vx_status VX_CALLBACK seamfind_cost_accumulate_query_target_support(vx_gr
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	char textBuffer[256];
+	int SEAM_FIND_TARGET = 0;
+	if (StitchGetEnvironmentVariable("SEAM_FIND_TARGET", textBuffer, sizeof(textBuffer))) { SEAM_FIND_TARGET = atoi(textBuffer); }
+
+	// coarse-to-fine seam search is only available on CPU
+	vx_scalar scalar = (vx_scalar)avxGetNodeParamRef(node, 10);
+	if (scalar) {
+		vx_uint32 coarse_scale = 0;
+		ERROR_CHECK_STATUS(vxReadScalarValue(scalar, &coarse_scale));
+		ERROR_CHECK_STATUS(vxReleaseScalar(&scalar));
+		if (coarse_scale > 1)
+			SEAM_FIND_TARGET = 1;
+	}
+
+	if (!SEAM_FIND_TARGET)
+		supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	else
+		supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
+
 	return VX_SUCCESS;
 }
 
@@ -2239,10 +2256,328 @@ static vx_status VX_CALLBACK seamfind_cost_accumulate_opencl_codegen(
 	return VX_SUCCESS;
 }
 
+//////////////////////////////////////////////////////////////////////
+// CPU implementation of seam find cost accumulation
+//   The overlaps are independent and processed in parallel. Within an overlap the accumulation is a
+//   dynamic program along the seam direction: all valid entries (columns of a vertical seam or rows of
+//   a horizontal seam) of one step only depend on the previous step, so four entries are processed
+//   at a time with SSE. The rules are the same as in the OpenCL kernel except that neighbors outside
+//   the overlap rectangle are never used.
+//   In coarse-to-fine mode (optional coarse scale parameter >= 2) the seam is first found on the cost
+//   downsampled by the coarse scale and the full resolution accumulation is limited to a narrow band
+//   around the upsampled seam.
+
+#define SEAMFIND_COST_INVALID 0x7F00FFFF
+#define SEAMFIND_COST_MAX     0x7FFFFFFF
+
+//! \brief The CPU seam find cost accumulation configuration.
+typedef struct {
+	const vx_uint8 * cost;
+	const vx_uint8 * phase;
+	const vx_uint8 * mask;
+	vx_int32 cost_stride, phase_stride, mask_stride;
+	vx_int32 equi_width, equi_height;
+	vx_int32 cost_select, seam_quality;
+	vx_int32 coarse_scale;
+	StitchSeamFindAccumEntry * accum;
+	vx_size accum_count;
+} SeamFindCostAccumulateCpuConfig;
+
+//! \brief A run of valid entries belonging to one overlap.
+typedef struct {
+	vx_uint32 start;
+	vx_uint32 count;
+	vx_int32 id;
+} SeamFindOverlapRun;
+
+//! \brief Find the seam of one overlap on a cost grid downsampled by cfg.coarse_scale and return the full
+//  resolution search band around it: band[2*i] and band[2*i+1] are the first and last+1 entries of step i.
+static bool seamfind_cost_accumulate_cpu_coarse_band(const SeamFindCostAccumulateCpuConfig& cfg, const StitchSeamFindValidEntry * entry, vx_int32 count, std::vector<vx_int32>& band)
+{
+	const bool vertical = entry[0].height >= entry[0].width;
+	const vx_int32 steps = vertical ? entry[0].height : entry[0].width;
+	const vx_int32 sx = vertical ? 0 : 1, sy = vertical ? 1 : 0;
+	const vx_int32 scale = cfg.coarse_scale;
+	const vx_int32 coarseSteps = (steps + scale - 1) / scale, coarseCount = (count + scale - 1) / scale;
+	if (steps <= 0 || coarseCount < 2)
+		return false;
+
+	// least cost path on the coarse grid: a block costs the average of its valid pixels
+	std::vector<vx_int32> value((vx_size)coarseSteps * coarseCount), parent((vx_size)coarseSteps * coarseCount);
+	for (vx_int32 is = 0; is < coarseSteps; is++) {
+		for (vx_int32 ic = 0; ic < coarseCount; ic++) {
+			vx_int32 sum = 0, num = 0;
+			for (vx_int32 i = is * scale; i < std::min(steps, (is + 1) * scale); i++) {
+				for (vx_int32 c = ic * scale; c < std::min(count, (ic + 1) * scale); c++) {
+					const StitchSeamFindValidEntry& e = entry[c];
+					vx_int32 px = e.dstX + i * sx, py = e.dstY + i * sy;
+					vx_int32 y1 = py + e.CAMERA_ID_1 * cfg.equi_height, x2 = e.OverLapX + i * sx, y2 = e.OverLapY + i * sy;
+					if (cfg.mask[y1 * cfg.mask_stride + px] && cfg.mask[y2 * cfg.mask_stride + x2]) {
+						vx_int32 cost = cfg.cost[y1 * cfg.cost_stride + px];
+						if (vertical && cfg.cost_select) cost = (cost + cfg.cost[y2 * cfg.cost_stride + x2]) / 2;
+						sum += cost; num++;
+					}
+				}
+			}
+			vx_int32 best = SEAMFIND_COST_MAX, from = -1;
+			if (num > 0 && is == 0)
+				best = 0;
+			else if (num > 0) {
+				for (vx_int32 k = std::max(ic - 1, 0); k <= std::min(ic + 1, coarseCount - 1); k++) {
+					if (value[(is - 1) * coarseCount + k] < best) {
+						best = value[(is - 1) * coarseCount + k];
+						from = k;
+					}
+				}
+			}
+			value[is * coarseCount + ic] = (best < SEAMFIND_COST_MAX) ? best + sum / num : SEAMFIND_COST_MAX;
+			parent[is * coarseCount + ic] = from;
+		}
+	}
+	vx_int32 end = -1;
+	for (vx_int32 ic = 0, best = SEAMFIND_COST_MAX; ic < coarseCount; ic++) {
+		if (value[(coarseSteps - 1) * coarseCount + ic] < best) {
+			best = value[(coarseSteps - 1) * coarseCount + ic];
+			end = ic;
+		}
+	}
+	if (end < 0)
+		return false;
+	std::vector<vx_int32> path(coarseSteps);
+	for (vx_int32 is = coarseSteps - 1; is >= 0; is--) {
+		path[is] = end;
+		end = parent[is * coarseCount + end];
+	}
+
+	// upsample the path into a band covering the neighboring coarse steps and one block on each side
+	band.resize(2 * (vx_size)steps);
+	for (vx_int32 i = 0; i < steps; i++) {
+		vx_int32 is = i / scale, isA = std::max(is - 1, 0), isB = std::min(is + 1, coarseSteps - 1);
+		vx_int32 lo = std::min(std::min(path[isA], path[is]), path[isB]) - 1;
+		vx_int32 hi = std::max(std::max(path[isA], path[is]), path[isB]) + 2;
+		band[2 * i] = std::max(lo * scale, 0);
+		band[2 * i + 1] = std::min(hi * scale, count);
+	}
+	return true;
+}
+
+//! \brief Accumulate the cost of one overlap, optionally only within a band of entries per step (entries outside are reset).
+static void seamfind_cost_accumulate_cpu_overlap(const SeamFindCostAccumulateCpuConfig& cfg, const StitchSeamFindInformation& info, const StitchSeamFindValidEntry * entry, vx_int32 count,
+	const vx_int32 * band)
+{
+	const bool vertical = entry[0].height >= entry[0].width;
+	const vx_int32 steps = vertical ? entry[0].height : entry[0].width;
+	const vx_int32 prevStride = vertical ? entry[0].width : entry[0].height;
+	// step and cross directions, and the overlap range along the cross direction
+	const vx_int32 sx = vertical ? 0 : 1, sy = vertical ? 1 : 0, dx = vertical ? 1 : 0, dy = vertical ? 0 : 1;
+	const vx_int32 crossStart = vertical ? info.start_x : info.start_y, crossEnd = vertical ? info.end_x : info.end_y;
+	const vx_int32 crossLimit = vertical ? cfg.equi_width : cfg.equi_height;
+	// bonus for paths next to edges along the seam direction
+	vx_int32 winThreshold = 225, magThreshold = 256, phaseA = vertical ? 0 : 2, phaseB = vertical ? 4 : 6;
+	if (cfg.seam_quality == 1) magThreshold = vertical ? 75 : 64;
+	else if (cfg.seam_quality == 2) { magThreshold = 128; winThreshold = vertical ? 225 : 200; }
+	if (steps <= 0 || (vx_size)info.offset + (vx_size)steps * prevStride > cfg.accum_count)
+		return;
+
+	const __m128i zero = _mm_setzero_si128(), ones = _mm_set1_epi32(-1), one = _mm_set1_epi32(1), maxv = _mm_set1_epi32(SEAMFIND_COST_MAX);
+	for (vx_int32 i = 0; i < steps; i++) {
+		vx_int32 lo = 0, hi = count, prevStart = crossStart, prevEnd = crossEnd;
+		if (band) {
+			lo = band[2 * i]; hi = band[2 * i + 1];
+			if (i > 0) { prevStart = crossStart + band[2 * i - 2]; prevEnd = crossStart + band[2 * i - 1]; }
+			StitchSeamFindAccumEntry reset = { -1, -1, SEAMFIND_COST_MAX, 0 };
+			std::fill(cfg.accum + info.offset + i * prevStride, cfg.accum + info.offset + i * prevStride + lo, reset);
+			std::fill(cfg.accum + info.offset + i * prevStride + hi, cfg.accum + info.offset + i * prevStride + count, reset);
+		}
+		for (vx_int32 c0 = lo; c0 < hi; c0 += 4) {
+			vx_int32 lanes = std::min(hi - c0, 4);
+			// gather per-entry inputs
+			vx_int32 g_pix[4] = { 0 }, g_valid[4] = { 0 }, g_bonus[4] = { 0 }, g_oidx[4] = { 0 };
+			vx_int32 g_val[4][4] = { { 0 } }, g_prop[4][4] = { { 0 } }, g_par[4][4] = { { 0 } };
+			for (vx_int32 l = 0; l < lanes; l++) {
+				const StitchSeamFindValidEntry& e = entry[c0 + l];
+				// local coordinates of the pixel and its cross coordinate
+				vx_int32 px = e.dstX + i * sx, py = e.dstY + i * sy, cross = vertical ? px : py;
+				vx_int32 y1 = py + e.CAMERA_ID_1 * cfg.equi_height, x2 = e.OverLapX + i * sx, y2 = e.OverLapY + i * sy;
+				vx_int32 oidx = info.offset + (vertical ? (py - info.start_y) * e.width + (px - info.start_x) : (px - info.start_x) * e.height + (py - info.start_y));
+				bool valid = cfg.mask[y1 * cfg.mask_stride + px] && cfg.mask[y2 * cfg.mask_stride + x2];
+				vx_int32 cost = cfg.cost[y1 * cfg.cost_stride + px];
+				if (vertical && cfg.cost_select) cost = (cost + cfg.cost[y2 * cfg.cost_stride + x2]) / 2;
+				vx_int32 pix = valid ? cost : SEAMFIND_COST_INVALID;
+				if (i == 0) {
+					// start of the seam
+					StitchSeamFindAccumEntry& a = cfg.accum[oidx];
+					a.parent_x = -1; a.parent_y = -1; a.value = pix; a.propagate = 0;
+					if (pix != SEAMFIND_COST_INVALID && (!vertical || (px > info.start_x && px < info.end_x)))
+						a.propagate = 1;
+					continue;
+				}
+				// bonus from the edge magnitude and quantized phase of the cross neighbors
+				vx_int32 bonus = 0;
+				if (cross > 0 && cross < crossLimit - 1) {
+					for (vx_int32 k = -1; k <= 1; k += 2) {
+						vx_int32 mag = cfg.cost[(y1 + k * dy) * cfg.cost_stride + px + k * dx];
+						vx_int32 phase = cfg.phase[(y1 + k * dy) * cfg.phase_stride + px + k * dx] >> 5;
+						if (mag > magThreshold && (phase == phaseA || phase == phaseB))
+							bonus += mag + (mag > winThreshold ? 50 : 0);
+					}
+				}
+				g_pix[l] = pix; g_valid[l] = valid ? -1 : 0; g_bonus[l] = 2 * bonus; g_oidx[l] = oidx;
+				// own entry at the previous step is kept when no propagating parent qualifies
+				const StitchSeamFindAccumEntry& prev = cfg.accum[oidx - prevStride];
+				memcpy(&g_par[3][l], &prev, sizeof(vx_int32));
+				g_val[3][l] = prev.value;
+				g_prop[3][l] = prev.propagate;
+				// parents at the previous step: left, middle, right along the cross direction
+				for (vx_int32 k = -1; k <= 1; k++) {
+					g_val[k + 1][l] = SEAMFIND_COST_MAX;
+					g_par[k + 1][l] = ((py - sy + k * dy) << 16) | ((px - sx + k * dx) & 0xFFFF);
+					if (cross + k < prevStart || cross + k >= prevEnd || cross + k < 0 || cross + k >= crossLimit)
+						continue;
+					const StitchSeamFindAccumEntry& a = cfg.accum[oidx - prevStride + k];
+					if (cfg.mask[(y1 - sy + k * dy) * cfg.mask_stride + px - sx + k * dx] && cfg.mask[(y2 - sy + k * dy) * cfg.mask_stride + x2 - sx + k * dx]) {
+						g_val[k + 1][l] = a.value;
+						g_prop[k + 1][l] = a.propagate;
+					}
+				}
+			}
+			if (i == 0)
+				continue;
+			// select the parent of four entries
+			__m128i pix = _mm_loadu_si128((const __m128i *)g_pix), bonus = _mm_loadu_si128((const __m128i *)g_bonus);
+			__m128i lv = _mm_loadu_si128((const __m128i *)g_val[0]), mv = _mm_loadu_si128((const __m128i *)g_val[1]), rv = _mm_loadu_si128((const __m128i *)g_val[2]);
+			__m128i lp = _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)g_prop[0]), zero), ones);
+			__m128i mp = _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)g_prop[1]), zero), ones);
+			__m128i rp = _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)g_prop[2]), zero), ones);
+			__m128i lpar = _mm_loadu_si128((const __m128i *)g_par[0]), mpar = _mm_loadu_si128((const __m128i *)g_par[1]), rpar = _mm_loadu_si128((const __m128i *)g_par[2]);
+			__m128i lsum = _mm_add_epi32(_mm_add_epi32(lv, pix), bonus);
+			__m128i rsum = _mm_add_epi32(_mm_add_epi32(rv, pix), bonus);
+			__m128i msum = _mm_sub_epi32(_mm_add_epi32(mv, pix), bonus);
+			// propagating paths: the cheapest propagating parent checked in the order right, left, middle
+			__m128i selR = _mm_and_si128(rp, _mm_cmplt_epi32(rv, maxv));
+			__m128i vc = _mm_blendv_epi8(maxv, rv, selR);
+			__m128i selL = _mm_and_si128(lp, _mm_cmplt_epi32(lv, vc));
+			vc = _mm_blendv_epi8(vc, lv, selL);
+			__m128i selM = _mm_and_si128(mp, _mm_cmplt_epi32(mv, vc));
+			__m128i parA = _mm_loadu_si128((const __m128i *)g_par[3]);
+			__m128i valA = _mm_loadu_si128((const __m128i *)g_val[3]);
+			__m128i propA = _mm_blendv_epi8(_mm_loadu_si128((const __m128i *)g_prop[3]), one, _mm_or_si128(_mm_or_si128(selR, selL), selM));
+			parA = _mm_blendv_epi8(_mm_blendv_epi8(_mm_blendv_epi8(parA, rpar, selR), lpar, selL), mpar, selM);
+			valA = _mm_blendv_epi8(_mm_blendv_epi8(_mm_blendv_epi8(valA, rsum, selR), lsum, selL), msum, selM);
+			// other paths: the cheapest parent without propagation
+			__m128i useR = _mm_and_si128(_mm_cmplt_epi32(rv, mv), _mm_cmplt_epi32(rv, lv));
+			__m128i useL = _mm_andnot_si128(useR, _mm_and_si128(_mm_cmplt_epi32(lv, rv), _mm_cmplt_epi32(lv, mv)));
+			__m128i parB = _mm_blendv_epi8(_mm_blendv_epi8(mpar, lpar, useL), rpar, useR);
+			__m128i valB = _mm_blendv_epi8(_mm_blendv_epi8(msum, lsum, useL), rsum, useR);
+			__m128i propagate = _mm_and_si128(_mm_loadu_si128((const __m128i *)g_valid), _mm_or_si128(_mm_or_si128(lp, mp), rp));
+			vx_int32 r_par[4], r_val[4], r_prop[4];
+			_mm_storeu_si128((__m128i *)r_par, _mm_blendv_epi8(parB, parA, propagate));
+			_mm_storeu_si128((__m128i *)r_val, _mm_blendv_epi8(valB, valA, propagate));
+			_mm_storeu_si128((__m128i *)r_prop, _mm_and_si128(propA, propagate));
+			for (vx_int32 l = 0; l < lanes; l++) {
+				StitchSeamFindAccumEntry& a = cfg.accum[g_oidx[l]];
+				memcpy(&a, &r_par[l], sizeof(vx_int32));
+				a.value = r_val[l];
+				a.propagate = r_prop[l];
+			}
+		}
+	}
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK seamfind_cost_accumulate_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_SUPPORTED;
+	vx_uint32 current_frame = 0, equi_width = 0, equi_height = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &current_frame));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &equi_width));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[2], &equi_height));
+	vx_uint32 coarse_scale = 0;
+	if (parameters[10]) {
+		ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[10], &coarse_scale));
+	}
+
+	// get developer configurations
+	int COST_SELECT = 0, SEAM_QUALITY = 1, SEAM_FIND_TIMING = 0;
+	char textBuffer[256];
+	if (StitchGetEnvironmentVariable("COST_SELECT", textBuffer, sizeof(textBuffer))) { COST_SELECT = atoi(textBuffer); }
+	if (StitchGetEnvironmentVariable("SEAM_QUALITY", textBuffer, sizeof(textBuffer))) { SEAM_QUALITY = atoi(textBuffer); }
+	if (StitchGetEnvironmentVariable("SEAM_FIND_TIMING", textBuffer, sizeof(textBuffer))) { SEAM_FIND_TIMING = atoi(textBuffer); }
+
+	// access input images
+	vx_image image[3] = { (vx_image)parameters[3], (vx_image)parameters[4], (vx_image)parameters[5] };
+	vx_rectangle_t rect[3]; vx_imagepatch_addressing_t addr[3]; void * ptr[3] = { nullptr, nullptr, nullptr };
+	for (int k = 0; k < 3; k++) {
+		vx_uint32 width = 0, height = 0;
+		ERROR_CHECK_STATUS(vxQueryImage(image[k], VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+		ERROR_CHECK_STATUS(vxQueryImage(image[k], VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+		rect[k].start_x = rect[k].start_y = 0; rect[k].end_x = width; rect[k].end_y = height;
+		ERROR_CHECK_STATUS(vxAccessImagePatch(image[k], &rect[k], 0, &addr[k], &ptr[k], VX_READ_ONLY));
+	}
+
+	// access valid, preference, information, and accumulation arrays
+	vx_array array[4] = { (vx_array)parameters[6], (vx_array)parameters[7], (vx_array)parameters[8], (vx_array)parameters[9] };
+	vx_size numitems[4] = { 0, 0, 0, 0 }; void * base[4] = { nullptr, nullptr, nullptr, nullptr };
+	for (int k = 0; k < 4; k++) {
+		ERROR_CHECK_STATUS(vxQueryArray(array[k], VX_ARRAY_ATTRIBUTE_NUMITEMS, &numitems[k], sizeof(numitems[k])));
+		if (numitems[k] > 0) {
+			vx_size stride = 0;
+			ERROR_CHECK_STATUS(vxAccessArrayRange(array[k], 0, numitems[k], &stride, &base[k], k < 3 ? VX_READ_ONLY : VX_READ_AND_WRITE));
+		}
+	}
+	const StitchSeamFindValidEntry * valid = (const StitchSeamFindValidEntry *)base[0];
+	const StitchSeamFindPreference * pref = (const StitchSeamFindPreference *)base[1];
+	const StitchSeamFindInformation * info = (const StitchSeamFindInformation *)base[2];
+
+	// collect the overlaps scheduled for this frame
+	std::vector<SeamFindOverlapRun> runs;
+	for (vx_uint32 i = 0; i < (vx_uint32)numitems[0];) {
+		SeamFindOverlapRun run = { i, 0, valid[i].ID };
+		while (i < (vx_uint32)numitems[0] && valid[i].ID == run.id) {
+			run.count++; i++;
+		}
+		if (run.id >= 0 && (vx_size)run.id < numitems[1] && (vx_size)run.id < numitems[2] && pref[run.id].priority != -1 &&
+			(((vx_uint32)pref[run.id].start_frame == current_frame) || ((current_frame + 1) % (pref[run.id].frequency + pref[run.id].seam_type_num) == 0)))
+		{
+			runs.push_back(run);
+		}
+	}
+
+	// accumulate the cost of the overlaps in parallel
+	SeamFindCostAccumulateCpuConfig cfg;
+	cfg.cost = (const vx_uint8 *)ptr[0]; cfg.cost_stride = addr[0].stride_y;
+	cfg.phase = (const vx_uint8 *)ptr[1]; cfg.phase_stride = addr[1].stride_y;
+	cfg.mask = (const vx_uint8 *)ptr[2]; cfg.mask_stride = addr[2].stride_y;
+	cfg.equi_width = (vx_int32)equi_width; cfg.equi_height = (vx_int32)equi_height;
+	cfg.cost_select = COST_SELECT; cfg.seam_quality = SEAM_QUALITY;
+	cfg.coarse_scale = (vx_int32)std::min(coarse_scale, 64u);
+	cfg.accum = (StitchSeamFindAccumEntry *)base[3]; cfg.accum_count = numitems[3];
+	std::vector<float> overlap_time(runs.size(), 0.0f);
+	float factor = 1000.0f / (float)stitchGetClockFrequency(); // to convert clock counter to ms
+	StitchParallelFor((vx_uint32)runs.size(), [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 k = start; k < end; k++) {
+			int64_t start_t = stitchGetClockCounter();
+			std::vector<vx_int32> band;
+			if (cfg.coarse_scale > 1 && seamfind_cost_accumulate_cpu_coarse_band(cfg, valid + runs[k].start, (vx_int32)runs[k].count, band))
+				seamfind_cost_accumulate_cpu_overlap(cfg, info[runs[k].id], valid + runs[k].start, (vx_int32)runs[k].count, band.data());
+			else
+				seamfind_cost_accumulate_cpu_overlap(cfg, info[runs[k].id], valid + runs[k].start, (vx_int32)runs[k].count, nullptr);
+			overlap_time[k] = (float)(stitchGetClockCounter() - start_t) * factor;
+		}
+	});
+	if (SEAM_FIND_TIMING) {
+		for (size_t k = 0; k < runs.size(); k++)
+			printf("Overlap::%d:::Cost Accumulate Time--> %f (ms) \n", runs[k].id, overlap_time[k]);
+	}
+
+	for (int k = 3; k >= 0; k--) {
+		if (base[k]) {
+			ERROR_CHECK_STATUS(vxCommitArrayRange(array[k], 0, k < 3 ? 0 : numitems[k], base[k]));
+		}
+	}
+	for (int k = 2; k >= 0; k--) {
+		ERROR_CHECK_STATUS(vxCommitImagePatch(image[k], &rect[k], 0, &addr[k], ptr[k]));
+	}
+	return VX_SUCCESS;
 }
 
 //! \brief The kernel publisher.
@@ -2252,7 +2587,7 @@ vx_status seamfind_cost_accumulate_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.seamfind_cost_accumulate",
 		AMDOVX_KERNEL_STITCHING_SEAMFIND_COST_ACCUMULATE,
 		seamfind_cost_accumulate_kernel,
-		10,
+		11,
 		seamfind_cost_accumulate_input_validator,
 		seamfind_cost_accumulate_output_validator,
 		nullptr,
@@ -2276,6 +2611,7 @@ vx_status seamfind_cost_accumulate_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 7, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 8, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_REQUIRED));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 9, VX_OUTPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_REQUIRED));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 10, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
@@ -2633,6 +2969,73 @@ static vx_status VX_CALLBACK seamfind_path_trace_opencl_codegen(
 	return VX_SUCCESS;
 }
 
+//! \brief Trace the least cost seam of one overlap into its path entries (same rules as the OpenCL kernel, limited to the overlap rectangle).
+static void seamfind_path_trace_cpu_overlap(const StitchSeamFindInformation& info, const StitchSeamFindAccumEntry * accum, const vx_uint8 * weight_ptr,
+	vx_uint32 weight_stride, vx_uint32 height_eqr, StitchSeamFindPathEntry * path, float& find_time, float& traverse_time)
+{
+	vx_int32 offset_1 = info.cam_id_1 * height_eqr;
+	vx_int32 x_dir = info.end_x - info.start_x;
+	vx_int32 y_dir = info.end_y - info.start_y;
+	float factor = 1000.0f / (float)stitchGetClockFrequency(); // to convert clock counter to ms
+	int64_t start_path_t = stitchGetClockCounter();
+	vx_int32 min_cost = 0x7FFFFFFF, min_x = -1, min_y = -1;
+	vx_int16 p_x = -1, p_y = -1;
+	if (y_dir >= x_dir) {
+		// vertical seam: select the least cost propagating pixel in the last row
+		min_y = info.end_y - 1;
+		for (vx_int32 xe = info.end_x - 1; xe >= info.start_x; xe--) {
+			const StitchSeamFindAccumEntry& a = accum[info.offset + ((min_y - info.start_y) * x_dir) + (xe - info.start_x)];
+			if (min_cost > a.value && a.propagate) {
+				p_x = a.parent_x; p_y = a.parent_y;
+				min_cost = a.value;
+				min_x = xe;
+			}
+		}
+		int64_t end_path_t = stitchGetClockCounter();
+		find_time = (float)(end_path_t - start_path_t) * factor;
+		// traverse the parents up to the first row of the overlap
+		vx_int16 i_val = weight_ptr[((info.end_y - 1) / 2 + offset_1) * weight_stride + info.end_x - 1] ? 255 : 0;
+		while (min_x >= 0 && (p_x != -1 || p_y != -1) && (p_x != 0 && p_y != 0)) {
+			path[min_y].min_pixel = (vx_int16)min_x;
+			path[min_y].weight_value_i = i_val;
+			if (--min_y < info.start_y)
+				break;
+			min_x = std::max((vx_int32)info.start_x, std::min((vx_int32)p_x, info.end_x - 1));
+			const StitchSeamFindAccumEntry& a = accum[info.offset + ((min_y - info.start_y) * x_dir) + (min_x - info.start_x)];
+			p_x = a.parent_x; p_y = a.parent_y;
+			if ((p_x > min_x + 1) || (p_x < min_x - 1)) p_x = (vx_int16)(min_x - 1);
+		}
+		traverse_time = (float)(stitchGetClockCounter() - end_path_t) * factor;
+	}
+	else {
+		// horizontal seam: select the least cost propagating pixel in the last column
+		min_x = info.end_x - 1;
+		for (vx_int32 ye = info.end_y - 1; ye >= info.start_y; ye--) {
+			const StitchSeamFindAccumEntry& a = accum[info.offset + ((min_x - info.start_x) * y_dir) + (ye - info.start_y)];
+			if (min_cost > a.value && a.propagate) {
+				p_x = a.parent_x; p_y = a.parent_y;
+				min_cost = a.value;
+				min_y = ye;
+			}
+		}
+		int64_t end_path_t = stitchGetClockCounter();
+		find_time = (float)(end_path_t - start_path_t) * factor;
+		// traverse the parents up to the first column of the overlap
+		vx_int16 i_val = weight_ptr[(info.end_y + offset_1 - 1) * weight_stride + info.end_x - 1] ? 255 : 0;
+		while (min_y >= 0 && p_x != -1 && (p_x != 0 && p_y != 0)) {
+			path[min_x].min_pixel = (vx_int16)min_y;
+			path[min_x].weight_value_i = i_val;
+			if (--min_x < info.start_x)
+				break;
+			min_y = std::max((vx_int32)info.start_y, std::min((vx_int32)p_y, info.end_y - 1));
+			const StitchSeamFindAccumEntry& a = accum[info.offset + ((min_x - info.start_x) * y_dir) + (min_y - info.start_y)];
+			p_x = a.parent_x; p_y = a.parent_y;
+			if ((p_y > min_y + 1) || (p_y < min_y - 1)) p_y = (vx_int16)(min_y - 1);
+		}
+		traverse_time = (float)(stitchGetClockCounter() - end_path_t) * factor;
+	}
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK seamfind_path_trace_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
@@ -2640,6 +3043,11 @@ static vx_status VX_CALLBACK seamfind_path_trace_kernel(vx_node node, const vx_r
 	vx_uint32 current_frame = 0, width_eqr = 0, height_eqr = 0;
 	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &current_frame));
 
+	//Env Variable to report the time taken by each overlap
+	int SEAM_FIND_TIMING = 0;
+	char textBuffer[256];
+	if (StitchGetEnvironmentVariable("SEAM_FIND_TIMING", textBuffer, sizeof(textBuffer))) { SEAM_FIND_TIMING = atoi(textBuffer); }
+
 	//Input Weight image - Variable 1
 	vx_image weight_image = (vx_image)parameters[1];
 	vx_uint32 width = 0, height = 0, plane = 0;
@@ -2681,142 +3089,25 @@ static vx_status VX_CALLBACK seamfind_path_trace_kernel(vx_node node, const vx_r
 	vx_size  path_array_size = (vx_size)(width_eqr * arr_numitems);
 	SeamFind_Path.resize(path_array_size);
 
-	//Horizontal Overlap Counter
-	vx_uint32 horizontal_overlap = 1;
-
-	//Loop over all the overlaps
-	for (vx_uint32 i = 0; i < arr_numitems; i++)
-	{
-		vx_uint32 offset_1 = SeamFindInfo_ptr[i].cam_id_1 * height_eqr;
-		vx_uint32 offset_2 = SeamFindInfo_ptr[i].cam_id_2 * height_eqr;
-		int y_dir = SeamFindInfo_ptr[i].end_y - SeamFindInfo_ptr[i].start_y;
-		int x_dir = SeamFindInfo_ptr[i].end_x - SeamFindInfo_ptr[i].start_x;
-
-		vx_int32 min_cost = 0X7FFFFFFF;
-		vx_int32 min_x = -1, min_y = -1;
-
-		if (SeamFind_Pref[i].priority != -1 && ((SeamFind_Pref[i].start_frame == current_frame) || ((current_frame + 1) % (SeamFind_Pref[i].frequency + SeamFind_Pref[i].seam_type_num) == 0)))
-		{
-			/***********************************************************************************************************************************
-			Vertical SeamCut
-			************************************************************************************************************************************/
-			if (y_dir >= x_dir)
-			{
-#if ENABLE_VERTICAL_SEAM
-
-#if GET_TIMING
-				int64_t start_path_t = stitchGetClockCounter();
-#endif
-				//Select the least cost pixel for the start of the seam
-				vx_uint32 ye = SeamFindInfo_ptr[i].end_y;
-				min_y = ye;
-
-				for (vx_int32 xe = (vx_int32)SeamFindInfo_ptr[i].end_x; xe >= (vx_int32)SeamFindInfo_ptr[i].start_x; xe--)
-				{
-					vx_uint32 pixel_id = SeamFindInfo_ptr[i].offset + ((ye - SeamFindInfo_ptr[i].start_y) * x_dir) + (xe - SeamFindInfo_ptr[i].start_x);
-					if ((min_cost > SeamFind_Accum[pixel_id].value))
-					{
-						min_cost = SeamFind_Accum[pixel_id].value;
-						min_x = xe;
-					}
-				}
-#if GET_TIMING
-				int64_t end_path_t = stitchGetClockCounter();
-				int64_t freq = stitchGetClockFrequency();
-				float factor = 1000.0f / (float)freq; // to convert clock counter to ms
-				float Path_find_time = (float)((end_path_t - start_path_t) * factor);
-				int64_t start_path_traverse = stitchGetClockCounter();
-#endif
-				//Selected Min Path 
-				vx_uint32 min_path_start = SeamFindInfo_ptr[i].offset + ((min_y - SeamFindInfo_ptr[i].start_y) * x_dir) + (min_x - SeamFindInfo_ptr[i].start_x);
-				vx_uint32 path_offset = (i * width_eqr);
-
-				//Selected Weight at End-X for Image i 
-				int i_val = 0;
-				vx_uint32 weight_pixel_check = ((SeamFindInfo_ptr[i].end_y + offset_1) * width_eqr) + SeamFindInfo_ptr[i].end_x;
-				if (weight_ptr[weight_pixel_check] == 255) i_val = 255;
-
-				//Traverse the path to obtain the seam			
-				while ((SeamFind_Accum[min_path_start].parent_x != -1 || SeamFind_Accum[min_path_start].parent_y != -1) && (SeamFind_Accum[min_path_start].parent_x != 0 && SeamFind_Accum[min_path_start].parent_y != 0))
-				{
-					vx_uint32 path_id = min_y + path_offset;
-					SeamFind_Path[path_id].min_pixel = min_x;
-					SeamFind_Path[path_id].weight_value_i = i_val;
-
-					min_y--;
-					min_x = SeamFind_Accum[min_path_start].parent_x;
-					min_path_start = SeamFindInfo_ptr[i].offset + ((SeamFind_Accum[min_path_start].parent_y - SeamFindInfo_ptr[i].start_y) * x_dir) + (SeamFind_Accum[min_path_start].parent_x - SeamFindInfo_ptr[i].start_x);
-				}
-#if GET_TIMING
-				int64_t end_path_traverse = stitchGetClockCounter();
-				float Path_travese_time = (float)((end_path_traverse - start_path_traverse) * factor);
-				printf("Overlap::%d,%d:::Best Path Find Time-->%f (ms) Path Traverse Time--> %f (ms) \n", i, j, Path_find_time, Path_travese_time);
-#endif
-
-#endif
-			}
-			/***********************************************************************************************************************************
-			Horizontal SeamCut
-			************************************************************************************************************************************/
-			else if (x_dir > y_dir)
+	//Trace the overlaps scheduled for this frame in parallel: each overlap has its own path entries
+	std::vector<float> find_time(arr_numitems, 0.0f), traverse_time(arr_numitems, 0.0f);
+	StitchParallelFor((vx_uint32)arr_numitems, [&](vx_uint32 start, vx_uint32 end) {
+		for (vx_uint32 i = start; i < end; i++) {
+			if (i < SeamFind_Pref_max && SeamFind_Pref[i].priority != -1 &&
+				(((vx_uint32)SeamFind_Pref[i].start_frame == current_frame) || ((current_frame + 1) % (SeamFind_Pref[i].frequency + SeamFind_Pref[i].seam_type_num) == 0)))
 			{
-#if ENABLE_HORIZONTAL_SEAM
-
-#if GET_TIMING
-				int64_t start_path_t = stitchGetClockCounter();
-#endif
-				//Select the least cost pixel for the start of the seam
-				vx_uint32 xe = SeamFindInfo_ptr[i].end_x;
-				min_x = xe;
-
-				for (vx_int32 ye = (vx_int32)SeamFindInfo_ptr[i].end_y; ye >= (vx_int32)SeamFindInfo_ptr[i].start_y; ye--)
-				{
-					vx_uint32 pixel_id = SeamFindInfo_ptr[i].offset + ((xe - SeamFindInfo_ptr[i].start_x) * y_dir) + (ye - SeamFindInfo_ptr[i].start_y);
-					if ((min_cost > SeamFind_Accum[pixel_id].value))
-					{
-						min_cost = SeamFind_Accum[pixel_id].value;
-						min_y = ye;
-					}
-				}
-#if GET_TIMING
-				int64_t end_path_t = stitchGetClockCounter();
-				int64_t freq = stitchGetClockFrequency();
-				float factor = 1000.0f / (float)freq; // to convert clock counter to ms
-				float Path_find_time = (float)((end_path_t - start_path_t) * factor);
-				int64_t start_path_traverse = stitchGetClockCounter();
-#endif
-				//Selected Min Path 
-				vx_uint32 min_path_start = SeamFindInfo_ptr[i].offset + ((min_x - SeamFindInfo_ptr[i].start_x) * y_dir) + (min_y - SeamFindInfo_ptr[i].start_y);
-				vx_uint32 path_offset = (i * width_eqr);
-
-				//Selected Weight at End-X for Image i 
-				int i_val = 0;
-				vx_uint32 weight_pixel_check = ((min_y + offset_1) * width_eqr) + SeamFindInfo_ptr[i].end_x;
-				if (weight_ptr[weight_pixel_check] == 255) i_val = 255;
-
-				//Traverse the path to obtain the seam			
-				while ((SeamFind_Accum[min_path_start].parent_x != -1 || SeamFind_Accum[min_path_start].parent_y != -1) && (SeamFind_Accum[min_path_start].parent_x != 0 && SeamFind_Accum[min_path_start].parent_y != 0))
-				{
-					vx_uint32 path_id = min_x + path_offset;
-					SeamFind_Path[path_id].min_pixel = min_y;
-					SeamFind_Path[path_id].weight_value_i = i_val;
-
-					min_x--;
-					min_y = SeamFind_Accum[min_path_start].parent_y;
-
-					min_path_start = SeamFindInfo_ptr[i].offset + ((min_x - SeamFindInfo_ptr[i].start_x) * y_dir) + (min_y - SeamFindInfo_ptr[i].start_y);
-				}
-
-#if GET_TIMING
-				int64_t end_path_traverse = stitchGetClockCounter();
-				float Path_travese_time = (float)((end_path_traverse - start_path_traverse) * factor);
-				printf("Overlap::%d,%d:::Best Path Find Time-->%f (ms) Path Traverse Time--> %f (ms) \n", i, j, Path_find_time, Path_travese_time);
-#endif
-				horizontal_overlap++;
-#endif
+				seamfind_path_trace_cpu_overlap(SeamFindInfo_ptr[i], SeamFind_Accum, weight_ptr, weight_addr.stride_y, height_eqr,
+					&SeamFind_Path[i * width_eqr], find_time[i], traverse_time[i]);
 			}
 		}
+	});
+	if (SEAM_FIND_TIMING) {
+		for (vx_uint32 i = 0; i < arr_numitems; i++) {
+			if (find_time[i] > 0.0f || traverse_time[i] > 0.0f)
+				printf("Overlap::%d:::Best Path Find Time-->%f (ms) Path Traverse Time--> %f (ms) \n", i, find_time[i], traverse_time[i]);
+		}
 	}
+
 	vx_array accum_seamFindPathEntry = (vx_array)parameters[5];
 	vx_size seamcut_path_size = width_eqr * arr_numitems;
 	StitchSeamFindPathEntry *StitchSeamCutPath_ptr = &SeamFind_Path[0];
@@ -25,6 +25,143 @@ THE SOFTWARE.
 
 #define WRITE_LUMA_AS_A 1
 
+//////////////////////////////////////////////////////////////////////
+//! \brief The exposure comp gains applied to the warp output pixels (same gain layouts as expcomp_applygains)
+enum {
+	WARP_GAIN_NONE          = 0, // no gains
+	WARP_GAIN_CAMERA        = 1, // one gain per camera
+	WARP_GAIN_CAMERA_RGB    = 2, // R, G, and B gains per camera
+	WARP_GAIN_CAMERA_MATRIX = 3, // 3x4 RGB color transform with offsets per camera
+	WARP_GAIN_BLOCK         = 4, // gain image per camera, bilinear sampled at each output pixel
+	WARP_GAIN_BLOCK_RGB     = 5, // R, G, and B gain image per camera, bilinear sampled at each output pixel
+};
+
+//! \brief Get the gain mode and the gain image size per camera from the optional gain parameters.
+static vx_status warp_get_gain_config(const vx_reference parameters[], vx_uint32 num, vx_uint32 num_cameras,
+	vx_uint32& mode, vx_uint32& gain_width, vx_uint32& gain_height, vx_size& num_gains)
+{
+	mode = WARP_GAIN_NONE;
+	gain_width = 1;
+	gain_height = 1;
+	num_gains = 0;
+	vx_array gains = (num > 10) ? (vx_array)parameters[10] : nullptr;
+	if (!gains)
+		return VX_SUCCESS;
+	vx_size capacity = 0;
+	ERROR_CHECK_STATUS(vxQueryArray(gains, VX_ARRAY_ATTRIBUTE_CAPACITY, &capacity, sizeof(capacity)));
+	bool blockGains = (num > 12) && parameters[11] && parameters[12];
+	if (blockGains) {
+		ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[11], &gain_width));
+		ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[12], &gain_height));
+		gain_width = std::max(gain_width, 1u);
+		gain_height = std::max(gain_height, 1u);
+	}
+	vx_size num_gains_mono = (vx_size)gain_width * gain_height * num_cameras;
+	if (capacity < num_gains_mono)
+		return VX_ERROR_INVALID_DIMENSION;
+	bool rgbGains = (capacity >= num_gains_mono * 3);
+	if (blockGains)
+		mode = rgbGains ? WARP_GAIN_BLOCK_RGB : WARP_GAIN_BLOCK;
+	else if (capacity == num_gains_mono * 12)
+		mode = WARP_GAIN_CAMERA_MATRIX;
+	else
+		mode = rgbGains ? WARP_GAIN_CAMERA_RGB : WARP_GAIN_CAMERA;
+	num_gains = num_gains_mono * ((mode == WARP_GAIN_CAMERA_MATRIX) ? 12 : (rgbGains ? 3 : 1));
+	return VX_SUCCESS;
+}
+
+//! \brief Generate the OpenCL helpers, kernel arguments, and the code that applies the gains to outpix before it is stored.
+//  The gains multiply the packed output pixels, so the results match a separate expcomp_applygains pass.
+static void warp_gain_codegen(vx_uint32 mode, vx_uint32 num_cameras, vx_uint32 gain_width, vx_uint32 gain_height,
+	vx_uint32 output_width, vx_uint32 output_height, std::string& helper_code, std::string& args_code, std::string& apply_code)
+{
+	helper_code = "";
+	args_code = "";
+	apply_code = "";
+	if (mode == WARP_GAIN_NONE)
+		return;
+	char item[2048];
+	args_code =
+		",\n"
+		"        __global uchar * gain_buf, uint gain_offset, uint gain_num";
+	if (mode == WARP_GAIN_BLOCK || mode == WARP_GAIN_BLOCK_RGB) {
+		args_code +=
+			",\n"
+			"        uint gain_width, uint gain_height";
+	}
+	helper_code =
+		"uint warp_gain(uint pix, float4 g4)\n"
+		"{\n"
+		"  return amd_pack((float4)(amd_unpack0(pix), amd_unpack1(pix), amd_unpack2(pix), amd_unpack3(pix)) * g4);\n"
+		"}\n";
+	if (mode == WARP_GAIN_CAMERA || mode == WARP_GAIN_CAMERA_RGB) {
+		apply_code =
+			"    { // apply exposure comp gains of the camera\n";
+		apply_code += (mode == WARP_GAIN_CAMERA) ?
+			"      __global float * pg = (__global float *)(gain_buf + gain_offset) + camera_id;\n"
+			"      float4 g4 = (float4)(pg[0], pg[0], pg[0], 1.0f);\n" :
+			"      __global float * pg = (__global float *)(gain_buf + gain_offset) + camera_id * 3;\n"
+			"      float4 g4 = (float4)(pg[0], pg[1], pg[2], 1.0f);\n";
+		apply_code +=
+			"      outpix.s0 = warp_gain(outpix.s0, g4); outpix.s1 = warp_gain(outpix.s1, g4);\n"
+			"      outpix.s2 = warp_gain(outpix.s2, g4); outpix.s3 = warp_gain(outpix.s3, g4);\n"
+			"    }\n";
+	}
+	else if (mode == WARP_GAIN_CAMERA_MATRIX) {
+		helper_code +=
+			"uint warp_gain_matrix(uint pix, float4 r4, float4 g4, float4 b4)\n"
+			"{\n"
+			"  float4 f = (float4)(amd_unpack0(pix), amd_unpack1(pix), amd_unpack2(pix), amd_unpack3(pix));\n"
+			"  return amd_pack((float4)(mad(f.s0, r4.s0, mad(f.s1, r4.s1, mad(f.s2, r4.s2, r4.s3))),\n"
+			"                           mad(f.s0, g4.s0, mad(f.s1, g4.s1, mad(f.s2, g4.s2, g4.s3))),\n"
+			"                           mad(f.s0, b4.s0, mad(f.s1, b4.s1, mad(f.s2, b4.s2, b4.s3))), f.s3));\n"
+			"}\n";
+		apply_code =
+			"    { // apply exposure comp color transform of the camera\n"
+			"      __global float4 * pg = (__global float4 *)(gain_buf + gain_offset) + camera_id * 3;\n"
+			"      float4 r4 = pg[0], g4 = pg[1], b4 = pg[2];\n"
+			"      outpix.s0 = warp_gain_matrix(outpix.s0, r4, g4, b4); outpix.s1 = warp_gain_matrix(outpix.s1, r4, g4, b4);\n"
+			"      outpix.s2 = warp_gain_matrix(outpix.s2, r4, g4, b4); outpix.s3 = warp_gain_matrix(outpix.s3, r4, g4, b4);\n"
+			"    }\n";
+	}
+	else {
+		vx_uint32 channels = (mode == WARP_GAIN_BLOCK_RGB) ? 3 : 1;
+		helper_code += (mode == WARP_GAIN_BLOCK) ?
+			"float4 warp_gain_block(__global float * p, uint ystride, float fy0, float fy1, float fx)\n"
+			"{\n"
+			"  float fint = floor(fx), fx1 = fx - fint, fx0 = 1.0f - fx1;\n"
+			"  p += (int)fint;\n"
+			"  float g = (p[0] * fx0 + p[1] * fx1) * fy0 + (p[ystride] * fx0 + p[ystride + 1] * fx1) * fy1;\n"
+			"  return (float4)(g, g, g, 1.0f);\n"
+			"}\n" :
+			"float4 warp_gain_block(__global float * p, uint ystride, float fy0, float fy1, float fx)\n"
+			"{\n"
+			"  float fint = floor(fx), fx1 = fx - fint, fx0 = 1.0f - fx1;\n"
+			"  p += (int)fint * 3;\n"
+			"  float3 g = (vload3(0, p) * fx0 + vload3(1, p) * fx1) * fy0 + (vload3(0, p + ystride) * fx0 + vload3(1, p + ystride) * fx1) * fy1;\n"
+			"  return (float4)(g, 1.0f);\n"
+			"}\n";
+		// gain image sample positions of the output pixels: same as expcomp_applygains
+		vx_float32 xscale = (vx_float32)gain_width / output_width, xoffset = xscale * 0.5f - 0.5f;
+		vx_float32 yscale = (vx_float32)(gain_height * num_cameras) / output_height, yoffset = yscale * 0.5f - 0.5f;
+		sprintf(item,
+			"    { // apply exposure comp gains sampled from the gain image of the camera\n"
+			"      __global float * pg = (__global float *)(gain_buf + gain_offset) + camera_id * %d;\n" // gain_width * gain_height * channels
+			"      float xscale = %.9ef;\n"
+			"      float fx = mad((float)((op_x << 3) + ((gid & 1) << 2)), xscale, %.9ef), fy = mad((float)op_y, %.9ef, %.9ef);\n"
+			"      float fy1 = fy - floor(fy), fy0 = 1.0f - fy1;\n"
+			"      pg += mul24((uint)fy, %du);\n" // gain_width * channels
+			"      outpix.s0 = warp_gain(outpix.s0, warp_gain_block(pg, %du, fy0, fy1, fx)); fx += xscale;\n"
+			"      outpix.s1 = warp_gain(outpix.s1, warp_gain_block(pg, %du, fy0, fy1, fx)); fx += xscale;\n"
+			"      outpix.s2 = warp_gain(outpix.s2, warp_gain_block(pg, %du, fy0, fy1, fx)); fx += xscale;\n"
+			"      outpix.s3 = warp_gain(outpix.s3, warp_gain_block(pg, %du, fy0, fy1, fx));\n"
+			"    }\n"
+			, gain_width * gain_height * channels, xscale, xoffset, yscale, yoffset, gain_width * channels
+			, gain_width * channels, gain_width * channels, gain_width * channels, gain_width * channels);
+		apply_code = item;
+	}
+}
+
 //! \brief The input validator callback.
 static vx_status VX_CALLBACK warp_input_validator(vx_node node, vx_uint32 index)
 {
@@ -151,6 +288,49 @@ static vx_status VX_CALLBACK warp_input_validator(vx_node node, vx_uint32 index)
 			}
 		}
 	}
+	else if (index == 10)
+	{ // array object of FLOAT32 type for exposure comp gains
+		status = VX_SUCCESS;
+		if (ref) {
+			vx_enum itemtype = VX_TYPE_INVALID;
+			vx_size capacity = 0;
+			ERROR_CHECK_STATUS(vxQueryArray((vx_array)ref, VX_ARRAY_ATTRIBUTE_ITEMTYPE, &itemtype, sizeof(itemtype)));
+			ERROR_CHECK_STATUS(vxQueryArray((vx_array)ref, VX_ARRAY_ATTRIBUTE_CAPACITY, &capacity, sizeof(capacity)));
+			ERROR_CHECK_STATUS(vxReleaseArray((vx_array *)&ref));
+			vx_df_image output_format = VX_DF_IMAGE_VIRT;
+			vx_image image = (vx_image)avxGetNodeParamRef(node, 5);
+			ERROR_CHECK_OBJECT(image);
+			ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &output_format, sizeof(output_format)));
+			ERROR_CHECK_STATUS(vxReleaseImage(&image));
+			if (itemtype != VX_TYPE_FLOAT32 || capacity == 0) {
+				status = VX_ERROR_INVALID_TYPE;
+				vxAddLogEntry((vx_reference)node, status, "ERROR: warp gains array type should be a non-empty FLOAT32 array\n");
+			}
+			else if (output_format != VX_DF_IMAGE_RGBX) {
+				status = VX_ERROR_INVALID_PARAMETERS;
+				vxAddLogEntry((vx_reference)node, status, "ERROR: warp doesn't support gains for non RGBX output image format\n");
+			}
+		}
+	}
+	else if ((index == 11) || (index == 12))
+	{ // object of SCALAR type (UINT32) for gain image width/height
+		status = VX_SUCCESS;
+		if (ref) {
+			vx_enum itemtype = VX_TYPE_INVALID;
+			ERROR_CHECK_STATUS(vxQueryScalar((vx_scalar)ref, VX_SCALAR_ATTRIBUTE_TYPE, &itemtype, sizeof(itemtype)));
+			ERROR_CHECK_STATUS(vxReleaseScalar((vx_scalar *)&ref));
+			vx_array gains = (vx_array)avxGetNodeParamRef(node, 10);
+			if (itemtype != VX_TYPE_UINT32) {
+				status = VX_ERROR_INVALID_TYPE;
+				vxAddLogEntry((vx_reference)node, status, "ERROR: warp gain image width/height scalar type should be a UINT32\n");
+			}
+			else if (!gains) {
+				status = VX_ERROR_INVALID_PARAMETERS;
+				vxAddLogEntry((vx_reference)node, status, "ERROR: warp gain image width/height requires gains array\n");
+			}
+			if (gains) ERROR_CHECK_STATUS(vxReleaseArray(&gains));
+		}
+	}
 	return status;
 }
 
@@ -219,7 +399,15 @@ static vx_status VX_CALLBACK warp_query_target_support(vx_graph graph, vx_node n
 	vx_uint32& supported_target_affinity // [output] must be set to AGO_TARGET_AFFINITY_CPU or AGO_TARGET_AFFINITY_GPU or (AGO_TARGET_AFFINITY_CPU | AGO_TARGET_AFFINITY_GPU)
 	)
 {
-	supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	char textBuffer[256];
+	int WARP_TARGET = 0;
+	if (StitchGetEnvironmentVariable("WARP_TARGET", textBuffer, sizeof(textBuffer))) { WARP_TARGET = atoi(textBuffer); }
+
+	if (!WARP_TARGET)
+		supported_target_affinity = AGO_TARGET_AFFINITY_GPU;
+	else
+		supported_target_affinity = AGO_TARGET_AFFINITY_CPU;
+
 	return VX_SUCCESS;
 }
 
@@ -281,7 +469,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 	ERROR_CHECK_STATUS(vxQueryArray(arr, VX_ARRAY_ATTRIBUTE_CAPACITY, &arr_capacity, sizeof(arr_capacity)));
 	ERROR_CHECK_STATUS(vxReleaseArray(&arr));
 	vx_image image = (vx_image)avxGetNodeParamRef(node, 4);				// input image
-	vx_uint32 input_height = 0, output_height = 0;
+	vx_uint32 input_height = 0, output_width = 0, output_height = 0;
 	ERROR_CHECK_OBJECT(image);
 	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
 	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_HEIGHT, &input_height, sizeof(input_height)));
@@ -289,6 +477,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 	image = (vx_image)avxGetNodeParamRef(node, 5);						// output image
 	ERROR_CHECK_OBJECT(image);
 	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_FORMAT, &output_format, sizeof(output_format)));
+	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_WIDTH, &output_width, sizeof(output_width)));
 	ERROR_CHECK_STATUS(vxQueryImage(image, VX_IMAGE_ATTRIBUTE_HEIGHT, &output_height, sizeof(output_height)));
 	ERROR_CHECK_STATUS(vxReleaseImage(&image));
 
@@ -312,6 +501,13 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 	}
 	bool useBilinearInterpolation = (flags & 1) ? false : true;
 
+	// optional exposure comp gains applied to the output pixels
+	vx_uint32 gain_mode = WARP_GAIN_NONE, gain_width = 1, gain_height = 1;
+	vx_size num_gains = 0;
+	ERROR_CHECK_STATUS(warp_get_gain_config(parameters, num, num_cameras, gain_mode, gain_width, gain_height, num_gains));
+	std::string gain_helper_code, gain_args_code, gain_apply_code;
+	warp_gain_codegen(gain_mode, num_cameras, gain_width, gain_height, output_width, output_height, gain_helper_code, gain_args_code, gain_apply_code);
+
 	// set kernel configuration
 	vx_uint32 work_items = (vx_uint32)arr_capacity << 1;
 	strcpy(opencl_kernel_function_name, "warp");
@@ -818,6 +1014,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 		sprintf(item,
 			"#pragma OPENCL EXTENSION cl_amd_media_ops : enable\n"
 			"#pragma OPENCL EXTENSION cl_amd_media_ops2 : enable\n"
+			"%s"
 			"__kernel __attribute__((reqd_work_group_size(%d, 1, 1)))\n" // opencl_local_work[0]
 			"void %s(uint grayscale_compute_method,\n" // opencl_kernel_function_name
 			"        uint num_cameras,\n"
@@ -825,7 +1022,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 			"        __global char * warp_remap_buf, uint warp_remap_buf_offset, uint warp_remap_num_items,\n"
 			"        uint ip_width, uint ip_height, __global uchar * ip_buf, uint ip_stride, uint ip_offset,\n"
 			"        uint op_width, uint op_height, __global uchar * op_buf, uint op_stride, uint op_offset"
-			, (int)opencl_local_work[0], opencl_kernel_function_name);
+			, gain_helper_code.c_str(), (int)opencl_local_work[0], opencl_kernel_function_name);
 		opencl_kernel_code = item;
 		if (bWriteU8Image) {
 			opencl_kernel_code +=
@@ -847,6 +1044,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 				",\n"
 				"        uint flags";
 		}
+		opencl_kernel_code += gain_args_code;
 		sprintf(item,
 			")\n"
 			"{\n"
@@ -1287,6 +1485,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 		}
 		if (output_format == VX_DF_IMAGE_RGBX)
 		{
+			opencl_kernel_code += gain_apply_code;
 			opencl_kernel_code +=
 				"    op_buf += op_offset + ((camera_id * op_image_height_offset + op_y) * op_stride) + (op_x << 5) + ((gid & 1) << 4);\n"
 				"    *(__global uint4 *) op_buf = outpix;\n";
@@ -1339,6 +1538,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 			"  return(mad(amd_unpack(pix.s0), (float4)mf.s0, mad(amd_unpack(pix.s1), (float4)mf.s1, mad(amd_unpack(pix.s2), (float4)mf.s2, amd_unpack(pix.s3) * mf.s3))));\n"
 			"}\n"
 			"\n"
+			"%s"
 			"__kernel __attribute__((reqd_work_group_size(%d, 1, 1)))\n" // opencl_local_work[0]
 			"void %s(uint grayscale_compute_method,\n" // opencl_kernel_function_name
 			"        uint num_cameras,\n"
@@ -1346,7 +1546,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 			"        __global char * warp_remap_buf, uint warp_remap_buf_offset, uint warp_remap_num_items,\n"
 			"        uint ip_width, uint ip_height, __global uchar * ip_buf, uint ip_stride, uint ip_offset,\n"
 			"        uint op_width, uint op_height, __global uchar * op_buf, uint op_stride, uint op_offset"
-			, (int)opencl_local_work[0], opencl_kernel_function_name);
+			, gain_helper_code.c_str(), (int)opencl_local_work[0], opencl_kernel_function_name);
 		opencl_kernel_code = item;
 		if (bWriteU8Image) {
 			opencl_kernel_code +=
@@ -1368,6 +1568,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 				",\n"
 				"        uint flags";
 		}
+		opencl_kernel_code += gain_args_code;
 		sprintf(item,
 			")\n"
 			"{\n"
@@ -1868,6 +2069,7 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 		}
 		if (output_format == VX_DF_IMAGE_RGBX)
 		{
+			opencl_kernel_code += gain_apply_code;
 			opencl_kernel_code +=
 				"    op_buf += op_offset + ((camera_id * op_image_height_offset + op_y) * op_stride) + (op_x << 5) + ((gid & 1) << 4);\n"
 				"    *(__global uint4 *) op_buf = outpix;\n";
@@ -1896,10 +2098,316 @@ static vx_status VX_CALLBACK warp_opencl_codegen(
 	return VX_SUCCESS;
 }
 
+//////////////////////////////////////////////////////////////////////
+// CPU implementation of warp
+
+//! \brief The warp buffers and configuration shared by all CPU worker threads.
+typedef struct {
+	const StitchValidPixelEntry * validEntry;
+	const StitchWarpRemapEntry * remapEntry;
+	vx_uint32 numCameraColumns;
+	vx_uint32 ipWidth, ipCamHeight;       // input image width and height of one camera
+	const vx_uint8 * ipBuf;
+	vx_uint32 ipStride, ipBpp;
+	vx_uint8 * opBuf;
+	vx_uint32 opStride, opBpp, opCamHeight;
+	vx_uint8 * lumaBuf;                   // optional U8 output (nullptr if not used)
+	vx_uint32 lumaStride;
+	bool bicubic;
+	bool useAlphaValue;
+	vx_float32 alphaValue;
+	vx_enum grayscaleComputeMethod;
+	const vx_float32 * gainBuf;           // exposure comp gains (nullptr if not used)
+	vx_uint32 gainMode;                   // WARP_GAIN_* layout of the gains
+	vx_uint32 gainWidth, gainHeight;      // gain image size per camera
+	vx_float32 gainScaleX, gainOffsetX;   // gain image x-coordinate of the output pixel x-coordinates
+	vx_float32 gainScaleY, gainOffsetY;   // gain image y-coordinate of the output pixel y-coordinates
+} StitchWarpCpuConfig;
+
+//! \brief Load one RGB/RGBX pixel as floats (A lane is zero for RGB).
+static inline __m128 warp_cpu_load_pixel(const vx_uint8 * p, vx_uint32 bpp)
+{
+	vx_uint32 v = p[0] | (p[1] << 8) | (p[2] << 16);
+	if (bpp == 4) v |= (vx_uint32)p[3] << 24;
+	return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)v)));
+}
+
+//! \brief Bilinear sample at (sx,sy) in Q13.3 from the camera image starting at ipCam.
+static inline __m128 warp_cpu_sample_bilinear(const StitchWarpCpuConfig * cfg, const vx_uint8 * ipCam, vx_uint32 sx, vx_uint32 sy)
+{
+	vx_uint32 x0 = std::min(sx >> 3, cfg->ipWidth - 1), x1 = std::min(x0 + 1, cfg->ipWidth - 1);
+	vx_uint32 y0 = std::min(sy >> 3, cfg->ipCamHeight - 1), y1 = std::min(y0 + 1, cfg->ipCamHeight - 1);
+	const vx_uint8 * r0 = ipCam + y0 * cfg->ipStride, * r1 = ipCam + y1 * cfg->ipStride;
+	__m128 fx = _mm_set1_ps((vx_float32)(sx & 7) * 0.125f), gx = _mm_sub_ps(_mm_set1_ps(1.0f), fx);
+	__m128 fy = _mm_set1_ps((vx_float32)(sy & 7) * 0.125f), gy = _mm_sub_ps(_mm_set1_ps(1.0f), fy);
+	__m128 t = _mm_add_ps(_mm_mul_ps(warp_cpu_load_pixel(r0 + x0 * cfg->ipBpp, cfg->ipBpp), gx), _mm_mul_ps(warp_cpu_load_pixel(r0 + x1 * cfg->ipBpp, cfg->ipBpp), fx));
+	__m128 b = _mm_add_ps(_mm_mul_ps(warp_cpu_load_pixel(r1 + x0 * cfg->ipBpp, cfg->ipBpp), gx), _mm_mul_ps(warp_cpu_load_pixel(r1 + x1 * cfg->ipBpp, cfg->ipBpp), fx));
+	return _mm_add_ps(_mm_mul_ps(t, gy), _mm_mul_ps(b, fy));
+}
+
+//! \brief Bicubic filter coefficients for taps -1..+2 at fraction x (same as the OpenCL compute_bicubic_coeffs).
+static inline void warp_cpu_bicubic_coeffs(vx_float32 x, vx_float32 c[4])
+{
+	c[0] = (-0.5f * x + x * x - 0.5f * x * x * x);
+	c[1] = (1.0f - 2.5f * x * x + 1.5f * x * x * x);
+	c[2] = (0.5f * x + 2.0f * x * x - 1.5f * x * x * x);
+	c[3] = (0.5f * (-x * x + x * x * x));
+}
+
+//! \brief Bicubic sample at (sx,sy) in Q13.3 from the camera image starting at ipCam.
+static inline __m128 warp_cpu_sample_bicubic(const StitchWarpCpuConfig * cfg, const vx_uint8 * ipCam, vx_uint32 sx, vx_uint32 sy)
+{
+	vx_float32 cx[4], cy[4];
+	warp_cpu_bicubic_coeffs((vx_float32)(sx & 7) * 0.125f, cx);
+	warp_cpu_bicubic_coeffs((vx_float32)(sy & 7) * 0.125f, cy);
+	vx_int32 xi = (vx_int32)(sx >> 3), yi = (vx_int32)(sy >> 3);
+	vx_uint32 xoff[4];
+	for (vx_int32 i = 0; i < 4; i++) {
+		vx_int32 x = std::max(0, std::min(xi + i - 1, (vx_int32)cfg->ipWidth - 1));
+		xoff[i] = (vx_uint32)x * cfg->ipBpp;
+	}
+	__m128 f = _mm_setzero_ps();
+	for (vx_int32 j = 0; j < 4; j++) {
+		vx_int32 y = std::max(0, std::min(yi + j - 1, (vx_int32)cfg->ipCamHeight - 1));
+		const vx_uint8 * r = ipCam + (vx_uint32)y * cfg->ipStride;
+		__m128 row = _mm_mul_ps(warp_cpu_load_pixel(r + xoff[0], cfg->ipBpp), _mm_set1_ps(cx[0]));
+		row = _mm_add_ps(row, _mm_mul_ps(warp_cpu_load_pixel(r + xoff[1], cfg->ipBpp), _mm_set1_ps(cx[1])));
+		row = _mm_add_ps(row, _mm_mul_ps(warp_cpu_load_pixel(r + xoff[2], cfg->ipBpp), _mm_set1_ps(cx[2])));
+		row = _mm_add_ps(row, _mm_mul_ps(warp_cpu_load_pixel(r + xoff[3], cfg->ipBpp), _mm_set1_ps(cx[3])));
+		f = _mm_add_ps(f, _mm_mul_ps(row, _mm_set1_ps(cy[j])));
+	}
+	return f;
+}
+
+//! \brief Apply the exposure comp gains of the camera at output pixel (x,y) to the RGB lanes.
+static inline __m128 warp_cpu_apply_gain(const StitchWarpCpuConfig * cfg, vx_uint32 camId, vx_uint32 x, vx_uint32 y, __m128 f)
+{
+	const vx_float32 * g = cfg->gainBuf;
+	if (cfg->gainMode == WARP_GAIN_CAMERA_MATRIX) {
+		const vx_float32 * m = g + camId * 12;
+		__m128 rgb1 = _mm_blend_ps(f, _mm_set1_ps(1.0f), 8);
+		__m128 r = _mm_dp_ps(rgb1, _mm_loadu_ps(m + 0), 0xf1);
+		__m128 gg = _mm_dp_ps(rgb1, _mm_loadu_ps(m + 4), 0xf2);
+		__m128 b = _mm_dp_ps(rgb1, _mm_loadu_ps(m + 8), 0xf4);
+		return _mm_blend_ps(_mm_or_ps(_mm_or_ps(r, gg), b), f, 8);
+	}
+	__m128 gain;
+	if (cfg->gainMode == WARP_GAIN_CAMERA) {
+		gain = _mm_set1_ps(g[camId]);
+	}
+	else if (cfg->gainMode == WARP_GAIN_CAMERA_RGB) {
+		gain = _mm_setr_ps(g[camId * 3 + 0], g[camId * 3 + 1], g[camId * 3 + 2], 1.0f);
+	}
+	else {
+		// bilinear sample from the gain image of the camera (clamped at the borders)
+		vx_uint32 channels = (cfg->gainMode == WARP_GAIN_BLOCK_RGB) ? 3 : 1;
+		vx_float32 fx = x * cfg->gainScaleX + cfg->gainOffsetX, fy = y * cfg->gainScaleY + cfg->gainOffsetY;
+		vx_float32 fx0 = floorf(fx), fy0 = floorf(fy), ax = fx - fx0, ay = fy - fy0;
+		vx_int32 xmax = (vx_int32)cfg->gainWidth - 1, ymax = (vx_int32)cfg->gainHeight - 1;
+		vx_int32 x0 = std::max(0, std::min((vx_int32)fx0, xmax)), x1 = std::max(0, std::min((vx_int32)fx0 + 1, xmax));
+		vx_int32 y0 = std::max(0, std::min((vx_int32)fy0, ymax)), y1 = std::max(0, std::min((vx_int32)fy0 + 1, ymax));
+		const vx_float32 * p = g + camId * cfg->gainWidth * cfg->gainHeight * channels;
+		const vx_float32 * r0 = p + y0 * cfg->gainWidth * channels, * r1 = p + y1 * cfg->gainWidth * channels;
+		vx_float32 s[3];
+		for (vx_uint32 c = 0; c < channels; c++) {
+			s[c] = (r0[x0 * channels + c] * (1.0f - ax) + r0[x1 * channels + c] * ax) * (1.0f - ay)
+				 + (r1[x0 * channels + c] * (1.0f - ax) + r1[x1 * channels + c] * ax) * ay;
+		}
+		gain = (channels == 3) ? _mm_setr_ps(s[0], s[1], s[2], 1.0f) : _mm_set1_ps(s[0]);
+	}
+	return _mm_blend_ps(_mm_mul_ps(f, gain), f, 8);
+}
+
+//! \brief Warp the valid pixel entries in range [start, end).
+//  Each entry maps to 8 unique output pixels, so ranges can be processed concurrently.
+static void warp_cpu_process_entries(const StitchWarpCpuConfig * cfg, vx_uint32 start, vx_uint32 end)
+{
+	const __m128 lumaCoeffs = _mm_setr_ps(0.2126f, 0.7152f, 0.0722f, 0.0f);
+	const __m128 avgCoeffs = _mm_setr_ps(0.3333333333f, 0.3333333333f, 0.3333333333f, 0.0f);
+	const __m128 invalidRGBX = _mm_setr_ps(0.0f, 0.0f, 0.0f, 128.0f);
+	vx_uint32 camRows = cfg->numCameraColumns;
+	for (vx_uint32 k = start; k < end; k++) {
+		vx_uint32 entry;
+		memcpy(&entry, &cfg->validEntry[k], sizeof(entry));
+		if (entry == 0xFFFFFFFF)
+			continue;
+		const StitchValidPixelEntry& valid = cfg->validEntry[k];
+		const vx_uint16 * map = &cfg->remapEntry[k].srcX0;
+		const vx_uint8 * ipCam = cfg->ipBuf + (valid.camId / camRows) * cfg->ipCamHeight * cfg->ipStride;
+		vx_uint32 dstY = valid.camId * cfg->opCamHeight + valid.dstY;
+		vx_uint32 dstX = valid.dstX * 8;
+		// sample 8 consecutive pixels
+		__m128 f[8];
+		bool pixelValid[8];
+		for (vx_uint32 i = 0; i < 8; i++) {
+			vx_uint32 sx = map[2 * i], sy = map[2 * i + 1];
+			pixelValid[i] = !(sx == 0xffff && sy == 0xffff);
+			if (!pixelValid[i]) {
+				f[i] = (cfg->opBpp == 4) ? invalidRGBX : _mm_setzero_ps();
+				continue;
+			}
+			f[i] = cfg->bicubic ? warp_cpu_sample_bicubic(cfg, ipCam, sx, sy) : warp_cpu_sample_bilinear(cfg, ipCam, sx, sy);
+			if (cfg->opBpp == 4 && cfg->ipBpp == 3) {
+				__m128 a;
+				if (cfg->useAlphaValue)
+					a = _mm_set1_ps(cfg->alphaValue);
+				else if (cfg->grayscaleComputeMethod == STITCH_GRAY_SCALE_COMPUTE_METHOD_AVG)
+					a = _mm_dp_ps(f[i], avgCoeffs, 0x7f);
+				else
+					a = _mm_sqrt_ps(_mm_dp_ps(_mm_mul_ps(f[i], f[i]), avgCoeffs, 0x7f));
+				f[i] = _mm_blend_ps(f[i], a, 8);
+			}
+		}
+		// apply the exposure comp gains to the output pixels (the luma output stays without gains)
+		__m128 o[8];
+		for (vx_uint32 i = 0; i < 8; i++)
+			o[i] = cfg->gainBuf ? warp_cpu_apply_gain(cfg, valid.camId, dstX + i, valid.dstY, f[i]) : f[i];
+		// pack with rounding and saturation and write output
+		__m128i p0 = _mm_packus_epi16(_mm_packs_epi32(_mm_cvtps_epi32(o[0]), _mm_cvtps_epi32(o[1])), _mm_packs_epi32(_mm_cvtps_epi32(o[2]), _mm_cvtps_epi32(o[3])));
+		__m128i p1 = _mm_packus_epi16(_mm_packs_epi32(_mm_cvtps_epi32(o[4]), _mm_cvtps_epi32(o[5])), _mm_packs_epi32(_mm_cvtps_epi32(o[6]), _mm_cvtps_epi32(o[7])));
+		vx_uint8 * op = cfg->opBuf + dstY * cfg->opStride + dstX * cfg->opBpp;
+		if (cfg->opBpp == 4) {
+			_mm_storeu_si128((__m128i *)op, p0);
+			_mm_storeu_si128((__m128i *)(op + 16), p1);
+		}
+		else {
+			vx_uint8 rgbx[32];
+			_mm_storeu_si128((__m128i *)rgbx, p0);
+			_mm_storeu_si128((__m128i *)(rgbx + 16), p1);
+			for (vx_uint32 i = 0; i < 8; i++) {
+				op[3 * i + 0] = rgbx[4 * i + 0];
+				op[3 * i + 1] = rgbx[4 * i + 1];
+				op[3 * i + 2] = rgbx[4 * i + 2];
+			}
+		}
+		if (cfg->lumaBuf) {
+			vx_float32 y[8];
+			for (vx_uint32 i = 0; i < 8; i++)
+				y[i] = pixelValid[i] ? _mm_cvtss_f32(_mm_dp_ps(f[i], lumaCoeffs, 0x71)) : 0.0f;
+			__m128i w = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(y)), _mm_cvtps_epi32(_mm_loadu_ps(y + 4)));
+			_mm_storel_epi64((__m128i *)(cfg->lumaBuf + dstY * cfg->lumaStride + dstX), _mm_packus_epi16(w, w));
+		}
+	}
+}
+
 //! \brief The kernel execution.
 static vx_status VX_CALLBACK warp_kernel(vx_node node, const vx_reference * parameters, vx_uint32 num)
 {
-	return VX_ERROR_NOT_SUPPORTED;
+	vx_enum grayscale_compute_method = STITCH_GRAY_SCALE_COMPUTE_METHOD_AVG;
+	vx_uint32 num_cameras = 0, num_camera_columns = 1;
+	vx_uint8 alpha_value = 0, flags = 0;
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[0], &grayscale_compute_method));
+	ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[1], &num_cameras));
+	if (num > 7 && parameters[7]) ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[7], &num_camera_columns));
+	if (num > 8 && parameters[8]) ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[8], &alpha_value));
+	if (num > 9 && parameters[9]) ERROR_CHECK_STATUS(vxReadScalarValue((vx_scalar)parameters[9], &flags));
+	if (num_cameras < 1 || num_camera_columns < 1 || (num_cameras % num_camera_columns) != 0)
+		return VX_ERROR_INVALID_VALUE;
+	vx_uint32 gain_mode = WARP_GAIN_NONE, gain_width = 1, gain_height = 1;
+	vx_size num_gains = 0;
+	ERROR_CHECK_STATUS(warp_get_gain_config(parameters, num, num_cameras, gain_mode, gain_width, gain_height, num_gains));
+
+	// access input and output images
+	vx_image input_image = (vx_image)parameters[4];
+	vx_image output_image = (vx_image)parameters[5];
+	vx_image luma_image = (num > 6) ? (vx_image)parameters[6] : nullptr;
+	vx_uint32 input_width = 0, input_height = 0, output_width = 0, output_height = 0;
+	vx_df_image input_format = VX_DF_IMAGE_VIRT, output_format = VX_DF_IMAGE_VIRT;
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_WIDTH, &input_width, sizeof(input_width)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &input_height, sizeof(input_height)));
+	ERROR_CHECK_STATUS(vxQueryImage(input_image, VX_IMAGE_ATTRIBUTE_FORMAT, &input_format, sizeof(input_format)));
+	ERROR_CHECK_STATUS(vxQueryImage(output_image, VX_IMAGE_ATTRIBUTE_WIDTH, &output_width, sizeof(output_width)));
+	ERROR_CHECK_STATUS(vxQueryImage(output_image, VX_IMAGE_ATTRIBUTE_HEIGHT, &output_height, sizeof(output_height)));
+	ERROR_CHECK_STATUS(vxQueryImage(output_image, VX_IMAGE_ATTRIBUTE_FORMAT, &output_format, sizeof(output_format)));
+	vx_rectangle_t input_rect = { 0, 0, input_width, input_height };
+	vx_rectangle_t output_rect = { 0, 0, output_width, output_height };
+	vx_imagepatch_addressing_t input_addr, output_addr, luma_addr;
+	void * input_ptr = nullptr, * output_ptr = nullptr, * luma_ptr = nullptr;
+	ERROR_CHECK_STATUS(vxAccessImagePatch(input_image, &input_rect, 0, &input_addr, &input_ptr, VX_READ_ONLY));
+	ERROR_CHECK_STATUS(vxAccessImagePatch(output_image, &output_rect, 0, &output_addr, &output_ptr, VX_WRITE_ONLY));
+	if (luma_image) {
+		ERROR_CHECK_STATUS(vxAccessImagePatch(luma_image, &output_rect, 0, &luma_addr, &luma_ptr, VX_WRITE_ONLY));
+	}
+
+	// access warp tables
+	vx_array valid_array = (vx_array)parameters[2];
+	vx_array remap_array = (vx_array)parameters[3];
+	vx_size num_entries = 0;
+	ERROR_CHECK_STATUS(vxQueryArray(valid_array, VX_ARRAY_ATTRIBUTE_NUMITEMS, &num_entries, sizeof(num_entries)));
+	StitchValidPixelEntry * valid_entry = nullptr;
+	StitchWarpRemapEntry * remap_entry = nullptr;
+	vx_size valid_stride = sizeof(StitchValidPixelEntry), remap_stride = sizeof(StitchWarpRemapEntry);
+	if (num_entries > 0) {
+		ERROR_CHECK_STATUS(vxAccessArrayRange(valid_array, 0, num_entries, &valid_stride, (void **)&valid_entry, VX_READ_ONLY));
+		ERROR_CHECK_STATUS(vxAccessArrayRange(remap_array, 0, num_entries, &remap_stride, (void **)&remap_entry, VX_READ_ONLY));
+	}
+
+	// access the optional exposure comp gains
+	vx_size gain_items = 0, gain_stride = sizeof(vx_float32);
+	vx_array gain_array = (gain_mode != WARP_GAIN_NONE) ? (vx_array)parameters[10] : nullptr;
+	vx_float32 * gain_ptr = nullptr;
+	if (gain_array) {
+		ERROR_CHECK_STATUS(vxQueryArray(gain_array, VX_ARRAY_ATTRIBUTE_NUMITEMS, &gain_items, sizeof(gain_items)));
+		if (gain_items > 0) {
+			ERROR_CHECK_STATUS(vxAccessArrayRange(gain_array, 0, gain_items, &gain_stride, (void **)&gain_ptr, VX_READ_ONLY));
+		}
+	}
+
+	vx_status status = VX_SUCCESS;
+	if (gain_array && (gain_items < num_gains || gain_stride != sizeof(vx_float32))) {
+		vxAddLogEntry((vx_reference)node, VX_ERROR_INVALID_DIMENSION, "ERROR: warp: gains array should have %d packed items\n", (vx_uint32)num_gains);
+		status = VX_ERROR_INVALID_DIMENSION;
+	}
+	else if (valid_stride != sizeof(StitchValidPixelEntry) || remap_stride != sizeof(StitchWarpRemapEntry)) {
+		vxAddLogEntry((vx_reference)node, VX_ERROR_INVALID_FORMAT, "ERROR: warp: warp tables shall be packed arrays\n");
+		status = VX_ERROR_INVALID_FORMAT;
+	}
+	else if (num_entries > 0) {
+		StitchWarpCpuConfig cfg;
+		cfg.validEntry = valid_entry;
+		cfg.remapEntry = remap_entry;
+		cfg.numCameraColumns = num_camera_columns;
+		cfg.ipWidth = input_width;
+		cfg.ipCamHeight = input_height / (num_cameras / num_camera_columns);
+		cfg.ipBuf = (const vx_uint8 *)input_ptr;
+		cfg.ipStride = (vx_uint32)input_addr.stride_y;
+		cfg.ipBpp = (input_format == VX_DF_IMAGE_RGBX) ? 4 : 3;
+		cfg.opBuf = (vx_uint8 *)output_ptr;
+		cfg.opStride = (vx_uint32)output_addr.stride_y;
+		cfg.opBpp = (output_format == VX_DF_IMAGE_RGBX) ? 4 : 3;
+		cfg.opCamHeight = output_height / num_cameras;
+		cfg.lumaBuf = (vx_uint8 *)luma_ptr;
+		cfg.lumaStride = luma_image ? (vx_uint32)luma_addr.stride_y : 0;
+		cfg.bicubic = (flags & 1) ? true : false;
+		cfg.useAlphaValue = (num > 8 && parameters[8]) ? true : false;
+		cfg.alphaValue = (vx_float32)alpha_value;
+		cfg.grayscaleComputeMethod = grayscale_compute_method;
+		cfg.gainBuf = gain_ptr;
+		cfg.gainMode = gain_mode;
+		cfg.gainWidth = gain_width;
+		cfg.gainHeight = gain_height;
+		cfg.gainScaleX = (vx_float32)gain_width / output_width;
+		cfg.gainOffsetX = cfg.gainScaleX * 0.5f - 0.5f;
+		cfg.gainScaleY = (vx_float32)(gain_height * num_cameras) / output_height;
+		cfg.gainOffsetY = cfg.gainScaleY * 0.5f - 0.5f;
+		StitchParallelFor((vx_uint32)num_entries, [&cfg](vx_uint32 start, vx_uint32 end) {
+			warp_cpu_process_entries(&cfg, start, end);
+		});
+	}
+
+	if (num_entries > 0) {
+		ERROR_CHECK_STATUS(vxCommitArrayRange(valid_array, 0, 0, valid_entry));
+		ERROR_CHECK_STATUS(vxCommitArrayRange(remap_array, 0, 0, remap_entry));
+	}
+	if (gain_ptr) {
+		ERROR_CHECK_STATUS(vxCommitArrayRange(gain_array, 0, 0, gain_ptr));
+	}
+	ERROR_CHECK_STATUS(vxCommitImagePatch(input_image, nullptr, 0, &input_addr, input_ptr));
+	ERROR_CHECK_STATUS(vxCommitImagePatch(output_image, &output_rect, 0, &output_addr, output_ptr));
+	if (luma_image) {
+		ERROR_CHECK_STATUS(vxCommitImagePatch(luma_image, &output_rect, 0, &luma_addr, luma_ptr));
+	}
+	return status;
 }
 
 //! \brief The kernel publisher.
@@ -1909,7 +2417,7 @@ vx_status warp_publish(vx_context context)
 	vx_kernel kernel = vxAddKernel(context, "com.amd.loomsl.warp",
 		AMDOVX_KERNEL_STITCHING_WARP,
 		warp_kernel,
-		9,
+		13,
 		warp_input_validator,
 		warp_output_validator,
 		nullptr,
@@ -1933,6 +2441,9 @@ vx_status warp_publish(vx_context context)
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 7, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 8, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 9, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 10, VX_INPUT, VX_TYPE_ARRAY, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 11, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
+	ERROR_CHECK_STATUS(vxAddParameterToKernel(kernel, 12, VX_INPUT, VX_TYPE_SCALAR, VX_PARAMETER_STATE_OPTIONAL));
 
 	// finalize and release kernel object
 	ERROR_CHECK_STATUS(vxFinalizeKernel(kernel));
@@ -28,10 +28,21 @@ THE SOFTWARE.
 #include "seam_find.h"
 #include "exposure_compensation.h"
 #include "multiband_blender.h"
+#include "color_convert.h"
+#include "chroma_key.h"
 #include <sstream>
 #include <stdarg.h>
 #include <map>
 #include <string>
+#if _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // Version
 #define LS_VERSION             "0.9.8"
@@ -74,6 +85,104 @@ struct ls_internal_table_size_info {
 	vx_size seamFindPathTableSize;
 };
 
+//////////////////////////////////////////////////////////////////////
+//! \brief The quick setup table cache file mapping
+struct ls_table_cache_record_header;
+struct ls_table_cache {
+	vx_uint64 key;                                      // configuration hash of the context
+	const vx_uint8 * data;                              // mapped cache file
+	vx_size size;                                       // size of mapped cache file
+	const ls_table_cache_record_header * record;        // record of the context tables in mapped file
+};
+//! \brief The tables shared by contexts with the same configuration (see SharedTablesLookup)
+struct ls_shared_tables;
+
+//////////////////////////////////////////////////////////////////////
+//! \brief The overlay regions: with LIVE_STITCH_ATTR_OVERLAY_REGIONS, the overlays are warped with a remap table
+//  per output region covered by the overlays into an ROI of the warped overlay image, and only these regions are blended
+//  (or only their parts in the dirty rectangles of the frame, see lsSetOverlayDirtyRects)
+#define LS_MAX_OVERLAY_REGIONS            16
+#define LS_MAX_OVERLAY_DIRTY_RECTS        16
+#define LS_OVERLAY_REGION_TILE_WIDTH      64
+#define LS_OVERLAY_REGION_TILE_HEIGHT     16
+struct ls_overlay_region {
+	vx_rectangle_t rect;                            // region in the output
+	vx_remap    remap;                              // remap table from overlay images to the region
+	vx_image    output;                             // region ROI of the warped overlay image
+	vx_node     remapNode;
+};
+struct ls_overlay_dirty_rects {
+	vx_uint32   count;                              // number of dirty rectangles
+	vx_rectangle_t rect[LS_MAX_OVERLAY_DIRTY_RECTS];// output rectangles with overlay pixels to blend
+};
+
+//////////////////////////////////////////////////////////////////////
+//! \brief The frame pipeline: with pipeline depth > 1 or tile jobs, scheduled frames are processed in order
+//  by a worker thread and the buffers set between lsScheduleFrame calls are applied per frame
+#define LS_MAX_PIPELINE_DEPTH   4
+#define LS_MAX_FRAME_BUFFERS    32  // 2 * MAX_TILE_IMG
+struct ls_viewport_params {
+	vx_float32 yaw, pitch, hfov, vfov;              // viewing direction and field of view in degrees (hfov <= 0: complete output)
+};
+struct ls_frame_buffers {
+	bool   setCamera, setOutput, setOverlay, setChromaKey, setPreview; // buffers set for the frame
+	bool   nullCamera, nullOutput, nullOverlay, nullChromaKey, nullPreview; // buffers set using nullptr
+	cl_mem camera[2], output[LS_MAX_FRAME_BUFFERS], overlay[1], chromaKey[1], preview[1];
+	bool   setViewport;                             // viewport set for the frame
+	ls_viewport_params viewport;
+	bool   setOverlayDirty;                         // overlay dirty rectangles set for the frame
+	ls_overlay_dirty_rects overlayDirty;
+};
+struct ls_frame_pipeline {
+	vx_uint32 depth;                                // maximum number of frames in flight
+	std::thread worker;                             // worker thread processing the frames
+	std::mutex mutex;                               // mutex for fields below
+	std::condition_variable cv;                     // signaled on frame schedule, completion, and terminate
+	bool terminate;                                 // true to terminate the worker after pending frames
+	ls_frame_buffers pending;                       // buffers set after last lsScheduleFrame
+	ls_frame_buffers frame[LS_MAX_PIPELINE_DEPTH];  // buffers of frames in flight
+	vx_status status[LS_MAX_PIPELINE_DEPTH];        // status of completed frames
+	vx_uint64 numScheduled, numCompleted, numWaited;// frame counters
+};
+
+//////////////////////////////////////////////////////////////////////
+//! \brief The output tile jobs: with LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS, each output tile is stitched by
+//  its own graph with a remap table for the tile, and the tile graphs of a frame run concurrently
+#define LS_MAX_TILE_JOBS   64
+struct ls_tile_job {
+	vx_int32    start_x;                            // tile region in the output: start_x < 0 or start_x + width > output width wraps around
+	vx_uint32   start_y, width, height;
+	vx_graph    graph;                              // graph of the tile
+	vx_remap    remap;                              // remap table from camera images to the tile
+	vx_image    rgb, output;                        // tile RGB image (when color conversion is needed) and output ROI
+	vx_node     remapNode, colorConvertNode;
+	vx_status   status;                             // status of the last processed frame
+};
+
+//////////////////////////////////////////////////////////////////////
+//! \brief The viewport restriction: the warp, exposure comp apply, and blend tables are trimmed
+//  to the entries that touch the output tiles selected by the viewport (see lsSetViewport)
+#define LS_VIEWPORT_TILE_WIDTH   128
+#define LS_VIEWPORT_TILE_HEIGHT   64
+#define LS_VIEWPORT_SAMPLE_STEP   16  // spacing of the output pixels tested against the viewport
+struct ls_viewport {
+	ls_viewport_params requested;                   // viewport for the next frame
+	ls_viewport_params applied;                     // viewport of the current tables
+	bool restricted;                                // true if the current tables are trimmed
+	vx_uint32 tileCountX, tileCountY;               // output tile grid
+	vx_uint8 * tileMask, * tileMaskNext;            // selected tiles: size: [tileCountX * tileCountY]
+	// complete tables saved before the first trim
+	bool saved;
+	vx_size warpCount, expCompCount, blendCount;
+	StitchValidPixelEntry * warpValid;
+	StitchWarpRemapEntry * warpRemap;
+	StitchExpCompCalcEntry * expCompValid;
+	StitchBlendValidEntry * blendOffsets;
+	// seam find priorities saved while the seams are frozen (see ViewportFreezeGainsAndSeams)
+	vx_size seamCount;
+	vx_int16 * seamPriority;
+};
+
 //////////////////////////////////////////////////////////////////////
 //! \brief The stitch handle
 struct ls_context_t {
@@ -86,8 +195,13 @@ struct ls_context_t {
 	bool rig_params_updated;                    // true if rig parameters updated
 	bool camera_params_updated;                 // true if camera parameters updated
 	bool overlay_params_updated;                // true if overlay parameters updated
+	vx_uint32 camera_params_dirty_mask;         // cameras with updated parameters - use "camera_params_dirty_mask & (1 << cam)"
+	vx_uint32 overlay_params_dirty_mask;        // overlays with updated parameters - use "overlay_params_dirty_mask & (1 << overlay)"
+	ls_frame_pipeline * pipeline;               // frame pipeline (only when pipeline depth > 1 or tile jobs)
+	ls_viewport viewport;                       // viewport restriction
 	// configuration parameters
 	vx_int32    stitching_mode;                 // stitching mode
+	vx_uint32   output_projection;              // output projection (see output_projection_type)
 	vx_uint32   num_cameras;                    // number of cameras
 	vx_uint32   num_camera_rows;				// camera buffer number of rows
 	vx_uint32   num_camera_columns;				// camera buffer number of cols
@@ -120,6 +234,8 @@ struct ls_context_t {
 	vx_uint32   MULTIBAND_BLEND;                // multiband blend flag from environment variable
 	vx_uint32   EXPO_COMP_GAINW, EXPO_COMP_GAINH;// exposure comp module gain image width and height
 	vx_uint32   EXPO_COMP_GAINC;                // exposure comp gain array number of gain values per camera. For mode 4, this should be 12 which is default if not specified.
+	vx_uint32   WARP_GAINS;                     // exposure comp gains are applied by the warp kernel
+	vx_uint32   EXPO_COMP_SUBSAMPLE;            // exposure comp subsample step of the overlap statistics (modes 1 and 2)
 	// global OpenVX objects
 	bool        context_is_external;            // To avoid releaseing external OpenVX context
 	vx_context  context;                        // OpenVX context
@@ -133,12 +249,20 @@ struct ls_context_t {
 	vx_image    Img_input, Img_output, Img_overlay;
 	vx_image    Img_input_rgb, Img_output_rgb, Img_overlay_rgb, Img_overlay_rgba;
 	vx_node	    InputColorConvertNode, SimpleStitchRemapNode, OutputColorConvertNode;
-	vx_array    ValidPixelEntry, WarpRemapEntry, OverlapPixelEntry, valid_array, gain_array;
+	vx_array    ValidPixelEntry, WarpRemapEntry, MergeRemapEntry, OverlapPixelEntry, valid_array, gain_array;
 	vx_matrix   overlap_matrix, A_matrix;
+	vx_delay    gain_delay;                     // solved gains of the current (0) and previous (-1) frame when applied by the warp
 	vx_image    RGBY1, RGBY2, weight_image, cam_id_image, group1_image, group2_image;
 	vx_node     WarpNode, ExpcompComputeGainNode, ExpcompSolveGainNode, ExpcompApplyGainNode, MergeNode;
 	vx_node     nodeOverlayRemap, nodeOverlayBlend;
+	// low resolution preview output
+	vx_uint32   preview_scale;                  // downscale factor of the preview (0: no preview)
+	vx_uint32   preview_buffer_width;           // preview RGB image width
+	vx_uint32   preview_buffer_height;          // preview RGB image height
+	vx_image    Img_preview;
+	vx_node     nodePreviewDownscale;
 	vx_float32  alpha, beta;                    // needed for expcomp
+	vx_float32  gain_smoothing;                 // temporal smoothing of the solved expcomp gains
 	vx_int32    * A_matrix_initial_value;       // needed for expcomp
 	// seamfind data & node elements
 	vx_array    overlap_rect_array, seamfind_valid_array, seamfind_weight_array, seamfind_accum_array, 
@@ -190,6 +314,17 @@ struct ls_context_t {
 	vx_rectangle_t src_encode_tile_rect[MAX_TILE_IMG];  // src encode rectangles 
 	vx_rectangle_t dst_encode_tile_rect[MAX_TILE_IMG];  // dst encode rectangles 
 	vx_node     encode_color_convert_nodes[MAX_TILE_IMG];// nodes to color convert each of the sectional ROI images
+	// output tile jobs
+	ls_tile_job * tileJobs;                             // tile jobs (quick stitch mode only)
+	vx_uint32   numTileJobs;                            // number of tile jobs
+	StitchThreadPool * tileJobPool;                     // threads running the tile graphs
+	// overlay regions
+	ls_overlay_region * overlayRegions;                 // overlay regions (null when the complete output is warped)
+	vx_uint32   numOverlayRegions;                      // number of overlay regions
+	vx_array    overlay_region_array;                   // rectangles of the overlay regions for the alpha blend
+	bool        overlayDirtyRequested;                  // overlay dirty rectangles set for the next frame
+	bool        overlayDirtyApplied;                    // overlay_region_array has the dirty rectangles of the last frame
+	ls_overlay_dirty_rects overlayDirty;                // overlay dirty rectangles for the next frame
 	// chroma key
 	vx_uint32   CHROMA_KEY;                             // chroma key flag variable
 	vx_uint32   CHROMA_KEY_EED;                         // chroma key flag variable
@@ -206,12 +341,17 @@ struct ls_context_t {
 	vx_uint32   NOISE_FILTER;                           // temporal noise filter enable/disable environment variable
 	vx_float32  noiseFilterLambda;                      // temporal noise filter variable
 	vx_scalar   filterLambda;                           // temporal noise filter scalar lambda variable from user
+	vx_float32  noiseFilterMotion;                      // temporal noise filter motion threshold for motion adaptive lambda
+	vx_scalar   filterMotion;                           // temporal noise filter scalar motion threshold variable from user
 	vx_delay    noiseFilterImageDelay;                  // temporal noise filter delay element
 	vx_image    noiseFilterInput_image;                 // temporal noise filter delay input image
 	vx_node     noiseFilterNode;                        // temporal noise filter node
 	// quick setup load
 	vx_uint32   SETUP_LOAD;                             // quick setup load flag variable
 	vx_bool     SETUP_LOAD_FILES_FOUND;                 // quick setup load files found flag variable
+	ls_table_cache tableCache;                          // quick setup table cache file mapping
+	vx_uint32   SHARE_TABLES;                           // share tables between contexts flag variable
+	ls_shared_tables * sharedTables;                    // shared tables used by the context
 	// data for Initialize tables
 	vx_uint32   USE_CPU_INIT;
 	StitchInitializeData *stitchInitData;
@@ -453,9 +593,12 @@ static void ResetLiveStitchGlobalAttributes()
 		g_live_stitch_attr[LIVE_STITCH_ATTR_SEAM_COEQUSH_OVERLAP_VD] = 20;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_SEAM_COEQUSH_TOPBOT_TOL] = 5;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_SEAM_COEQUSH_TOPBOT_VGD] = 46;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_SEAM_COARSE_SCALE] = 0;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_MULTIBAND] = 1;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_MULTIBAND_NUMBANDS] = 4;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_STITCH_MODE] = (float)stitching_mode_normal;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_PIPELINE_DEPTH] = 1;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_VIEWPORT_MARGIN] = 10;
 		// frame encoding default attributes
 		g_live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_X] = 1;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_Y] = 1;
@@ -464,6 +607,9 @@ static void ResetLiveStitchGlobalAttributes()
 		g_live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_ENCODER_WIDTH] = 3840;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_ENCODER_HEIGHT] = 2160;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_ENCODER_STRIDE_Y] = 3840;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS] = 0;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_OVERLAY_REGIONS] = 1;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_FUSED_WARP_MERGE] = 0;
 		// chroma key default
 		g_live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY] = 0;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY_VALUE] = 8454016;
@@ -476,7 +622,9 @@ static void ResetLiveStitchGlobalAttributes()
 		// Temporal Filter
 		g_live_stitch_attr[LIVE_STITCH_ATTR_NOISE_FILTER] = 0;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_NOISE_FILTER_LAMBDA] = 1;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_NOISE_FILTER_MOTION] = 0;
 		g_live_stitch_attr[LIVE_STITCH_ATTR_SAVE_AND_LOAD_INIT] = 0;
+		g_live_stitch_attr[LIVE_STITCH_ATTR_SHARE_INIT_TABLES] = 0;
 	}
 }
 static std::vector<std::string> split(std::string str, char delimiter) {
@@ -516,6 +664,7 @@ static const char * GetFileNameSuffix(ls_context stitch, vx_reference ref, bool&
 		// intermediate tables and data that needs initialization
 		{ (vx_reference)stitch->ValidPixelEntry,       false, false, "warp-valid.bin" },
 		{ (vx_reference)stitch->WarpRemapEntry,        false, false, "warp-remap.bin" },
+		{ (vx_reference)stitch->MergeRemapEntry,       false, false, "merge-remap.bin" },
 		{ (vx_reference)stitch->RGBY1,                 false, false, "warp-rgby.raw" },
 		{ (vx_reference)stitch->cam_id_image,          false, false, "merge-camid.raw" },
 		{ (vx_reference)stitch->group1_image,          false, false, "merge-group1.raw" },
@@ -559,6 +708,7 @@ static vx_status DumpInternalTables(ls_context stitch, const char * fileNamePref
 		// intermediate tables and data that needs initialization
 		(vx_reference)stitch->ValidPixelEntry,
 		(vx_reference)stitch->WarpRemapEntry,
+		(vx_reference)stitch->MergeRemapEntry,
 		(vx_reference)stitch->RGBY1,
 		(vx_reference)stitch->cam_id_image,
 		(vx_reference)stitch->group1_image,
@@ -628,6 +778,7 @@ static vx_status SyncInternalTables(ls_context stitch)
 	vx_reference refList[] = {
 		(vx_reference)stitch->ValidPixelEntry,
 		(vx_reference)stitch->WarpRemapEntry,
+		(vx_reference)stitch->MergeRemapEntry,
 		(vx_reference)stitch->cam_id_image,
 		(vx_reference)stitch->group1_image,
 		(vx_reference)stitch->group2_image,
@@ -658,42 +809,195 @@ static vx_status SyncInternalTables(ls_context stitch)
 			}
 		}
 	}
+	for (vx_uint32 i = 0; i < stitch->numTileJobs; i++) {
+		vx_status status = vxDirective((vx_reference)stitch->tileJobs[i].remap, VX_DIRECTIVE_AMD_COPY_TO_OPENCL);
+		if (status != VX_SUCCESS) {
+			ls_printf("ERROR: SyncInternalTables: vxDirective(tile job %d remap, VX_DIRECTIVE_AMD_COPY_TO_OPENCL) failed (%d)\n", i, status);
+			return status;
+		}
+	}
+	for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++) {
+		vx_status status = vxDirective((vx_reference)stitch->overlayRegions[i].remap, VX_DIRECTIVE_AMD_COPY_TO_OPENCL);
+		if (status != VX_SUCCESS) {
+			ls_printf("ERROR: SyncInternalTables: vxDirective(overlay region %d remap, VX_DIRECTIVE_AMD_COPY_TO_OPENCL) failed (%d)\n", i, status);
+			return status;
+		}
+	}
 	return VX_SUCCESS;
 }
-static vx_status quickSetupFilesLookup(ls_context stitch)
+//////////////////////////////////////////////////////////////////////
+// Quick setup table cache
+//   All tables needed by a configuration are saved as one record of a single cache file (LoomStitchTables.cache
+//   in the current directory, or the file in LOOM_TABLE_CACHE environment variable). A record is identified by
+//   a hash of the rig, camera, overlay, and output configuration and the attributes, and its payload is protected
+//   by a checksum, so tables of another configuration or a damaged file are never used. Records of different
+//   configurations are kept side by side (most recent LS_TABLE_CACHE_MAX_RECORDS). The file is memory mapped for
+//   loading without an intermediate read buffer: images and arrays are copied from the mapping into the OpenVX
+//   objects, remap tables are set point by point (vxSetRemapPoint) since there is no remap patch access. A new
+//   file is written to a temporary file that replaces the cache file by rename.
+#define LS_TABLE_CACHE_MAGIC        "LOOMTBLC"
+#define LS_TABLE_CACHE_VERSION      1
+#define LS_TABLE_CACHE_MAX_RECORDS  8
+#define LS_TABLE_CACHE_ALIGN        64
+#define LS_TABLE_CACHE_FILE_NAME    "LoomStitchTables.cache"
+
+//! \brief The cache file header.
+struct ls_table_cache_file_header {
+	char      magic[8];                         // LS_TABLE_CACHE_MAGIC
+	vx_uint32 version;                          // LS_TABLE_CACHE_VERSION
+	vx_uint32 numRecords;                       // number of records following the header
+};
+//! \brief The cache record header: followed by numTables table descriptors and the table data (payload).
+struct ls_table_cache_record_header {
+	vx_uint64 key;                              // configuration hash
+	vx_uint64 payloadSize;                      // size of payload in bytes (multiple of LS_TABLE_CACHE_ALIGN)
+	vx_uint64 checksum;                         // checksum of payload
+	vx_uint32 numTables;                        // number of table descriptors
+	vx_uint32 reserved;
+	vx_uint64 tableSizes[9];                    // ls_internal_table_size_info
+};
+//! \brief The cache table descriptor.
+struct ls_table_cache_table_entry {
+	vx_uint32 index;                            // index into the quick setup table list
+	vx_enum   type;                             // VX_TYPE_IMAGE/ARRAY/MATRIX/REMAP
+	vx_uint64 count;                            // number of items (arrays only)
+	vx_uint64 offset;                           // offset of data from the start of payload
+	vx_uint64 size;                             // size of data in bytes
+};
+
+//! \brief Hash/checksum of a buffer (64-bit FNV-1a on 64-bit words).
+static vx_uint64 TableCacheHash(const void * buf, vx_size size, vx_uint64 hash = 0xcbf29ce484222325ull)
 {
-	FILE * fp = fopen("StitchTableSizes.txt", "r");	
-	if (!fp) { stitch->SETUP_LOAD_FILES_FOUND = vx_false_e; }
-	else{ stitch->SETUP_LOAD_FILES_FOUND = vx_true_e; }
-	if (fp != NULL) fclose(fp);
-	return VX_SUCCESS;
+	const vx_uint8 * p = (const vx_uint8 *)buf;
+	for (; size >= 8; size -= 8, p += 8) {
+		vx_uint64 v; memcpy(&v, p, sizeof(v));
+		hash = (hash ^ v) * 0x100000001b3ull;
+	}
+	for (; size > 0; size--, p++)
+		hash = (hash ^ *p) * 0x100000001b3ull;
+	return hash;
 }
-static vx_status quickSetupDumpTableSizes(ls_context stitch)
+//! \brief Memory map a file for reading.
+static bool TableCacheMapFile(const char * fileName, ls_table_cache& cache)
 {
-	FILE * fp = fopen("StitchTableSizes.txt", "w+"); 
-	if (!fp) { 
-		ls_printf("ERROR: quickSetupDumpTableSize: unable to create: StitchTableSizes.txt\n"); 
-		if (fp != NULL)	fclose(fp);
-		return VX_FAILURE;
-	}
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.blendOffsetTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.expCompOverlapTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.expCompValidTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.seamFindAccumTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.seamFindPathTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.seamFindPrefInfoTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.seamFindValidTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.seamFindWeightTableSize); fprintf(fp, "\n");
-	fprintf(fp, VX_FMT_SIZE, stitch->table_sizes.warpTableSize); fprintf(fp, "\n");
-	fclose(fp);
-
-	return VX_SUCCESS;
+#if _WIN32
+	HANDLE hFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	HANDLE hMap = NULL;
+	void * data = nullptr;
+	if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0) {
+		hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap) data = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (hMap) CloseHandle(hMap);
+	CloseHandle(hFile);
+	if (!data) return false;
+	cache.data = (const vx_uint8 *)data;
+	cache.size = (vx_size)fileSize.QuadPart;
+#else
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	void * data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return false;
+	cache.data = (const vx_uint8 *)data;
+	cache.size = (vx_size)st.st_size;
+#endif
+	return true;
 }
-static vx_status quickSetupDumpTables(ls_context stitch)
+//! \brief Unmap the cache file.
+static void TableCacheUnmapFile(ls_table_cache& cache)
 {
-	vx_reference refList[] = {
+	if (cache.data) {
+#if _WIN32
+		UnmapViewOfFile(cache.data);
+#else
+		munmap((void *)cache.data, cache.size);
+#endif
+	}
+	cache.data = nullptr;
+	cache.size = 0;
+	cache.record = nullptr;
+}
+//! \brief Get the cache file name.
+static void TableCacheGetFileName(char * fileName, size_t fileNameSize)
+{
+	if (!StitchGetEnvironmentVariable("LOOM_TABLE_CACHE", fileName, fileNameSize) || !fileName[0])
+		snprintf(fileName, fileNameSize, "%s", LS_TABLE_CACHE_FILE_NAME);
+}
+//! \brief Get the records of a mapped cache file: returns number of records with valid headers.
+static vx_uint32 TableCacheGetRecords(const ls_table_cache& cache, const ls_table_cache_record_header ** records, vx_uint32 maxRecords)
+{
+	const ls_table_cache_file_header * header = (const ls_table_cache_file_header *)cache.data;
+	if (!header || cache.size < sizeof(*header) || memcmp(header->magic, LS_TABLE_CACHE_MAGIC, sizeof(header->magic)) || header->version != LS_TABLE_CACHE_VERSION)
+		return 0;
+	vx_uint32 count = 0;
+	vx_size offset = sizeof(*header);
+	for (vx_uint32 i = 0; i < header->numRecords && count < maxRecords; i++) {
+		const ls_table_cache_record_header * record = (const ls_table_cache_record_header *)(cache.data + offset);
+		if (offset + sizeof(*record) > cache.size || record->payloadSize > cache.size - offset - sizeof(*record))
+			break;
+		records[count++] = record;
+		offset += sizeof(*record) + (vx_size)record->payloadSize;
+	}
+	return count;
+}
+//! \brief Calculate the configuration hash used to identify the tables in the cache.
+static vx_uint64 TableCacheCalculateKey(ls_context stitch)
+{
+	vx_uint32 config[] = {
+		LS_TABLE_CACHE_VERSION, (vx_uint32)sizeof(vx_size), (vx_uint32)stitch->stitching_mode,
+		stitch->num_cameras, stitch->num_camera_rows, stitch->num_camera_columns,
+		stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height,
+		stitch->num_overlays, stitch->num_overlay_rows, stitch->num_overlay_columns,
+		stitch->overlay_buffer_width, stitch->overlay_buffer_height,
+		stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
+		stitch->EXPO_COMP, stitch->SEAM_FIND, stitch->MULTIBAND_BLEND,
+	};
+	vx_uint64 key = TableCacheHash(LS_VERSION, strlen(LS_VERSION));
+	key = TableCacheHash(config, sizeof(config), key);
+	key = TableCacheHash(&stitch->rig_par, sizeof(stitch->rig_par), key);
+	if (stitch->camera_par) key = TableCacheHash(stitch->camera_par, stitch->num_cameras * sizeof(camera_params), key);
+	if (stitch->overlay_par) key = TableCacheHash(stitch->overlay_par, stitch->num_overlays * sizeof(camera_params), key);
+	// static attributes except the profiler
+	key = TableCacheHash(&stitch->live_stitch_attr[LIVE_STITCH_ATTR_PROFILER + 1], (LIVE_STITCH_ATTR_SEAM_THRESHOLD - LIVE_STITCH_ATTR_PROFILER - 1) * sizeof(vx_float32), key);
+	return key;
+}
+//! \brief Get the table objects that can be shared between contexts of the same OpenVX context: the tables
+//  that are only read after initialization (lsSetBlendWeights writes weight_image, seam find its other tables).
+static vx_size SharedTablesGetObjectList(ls_context stitch, vx_reference ** objList)
+{
+	vx_reference * list[] = {
+		(vx_reference *)&stitch->ValidPixelEntry,
+		(vx_reference *)&stitch->WarpRemapEntry,
+		(vx_reference *)&stitch->MergeRemapEntry,
+		(vx_reference *)&stitch->cam_id_image,
+		(vx_reference *)&stitch->group1_image,
+		(vx_reference *)&stitch->group2_image,
+		(vx_reference *)&stitch->valid_array,
+		(vx_reference *)&stitch->OverlapPixelEntry,
+		(vx_reference *)&stitch->overlap_matrix,
+		(vx_reference *)&stitch->valid_mask_image,
+		(vx_reference *)&stitch->seamfind_valid_array,
+		(vx_reference *)&stitch->blend_offsets,
+	};
+	for (vx_size i = 0; i < dimof(list); i++)
+		objList[i] = list[i];
+	return dimof(list);
+}
+//! \brief Get the list of tables saved in the cache: with skipConstantBuffers, the buffers initialized
+//  with a constant value (see InitializeConstantBuffersForCamera) are left out, with skipSharedObjects
+//  the table objects of SharedTablesGetObjectList.
+static vx_size TableCacheGetTableList(ls_context stitch, vx_reference * refList, bool skipConstantBuffers = false, bool skipSharedObjects = false)
+{
+	vx_reference list[] = {
 		(vx_reference)stitch->ValidPixelEntry,
 		(vx_reference)stitch->WarpRemapEntry,
+		(vx_reference)stitch->MergeRemapEntry,
 		(vx_reference)stitch->RGBY1,
 		(vx_reference)stitch->cam_id_image,
 		(vx_reference)stitch->group1_image,
@@ -717,198 +1021,412 @@ static vx_status quickSetupDumpTables(ls_context stitch)
 		(vx_reference)stitch->camera_remap,
 		(vx_reference)stitch->overlay_remap,
 	};
-	for (vx_size i = 0; i < dimof(refList); i++) {
-		if (refList[i]) {
-			bool isIntermediateTmpData = false, isForCpuUseOnly = false;
-			const char * fileNameSuffix = GetFileNameSuffix(stitch, refList[i], isIntermediateTmpData, isForCpuUseOnly);
-			if (fileNameSuffix && (!isIntermediateTmpData)) {
-				char fileName[1024]; sprintf(fileName, "%s",fileNameSuffix);
-				vx_status status = DumpReference(refList[i], fileName);
-				if (status != VX_SUCCESS)
-					return status;
+	for (vx_size i = 0; i < dimof(list); i++) {
+		bool isIntermediateTmpData = false, isForCpuUseOnly = false;
+		refList[i] = (list[i] && GetFileNameSuffix(stitch, list[i], isIntermediateTmpData, isForCpuUseOnly) && !isIntermediateTmpData) ? list[i] : nullptr;
+		if (skipConstantBuffers && (list[i] == (vx_reference)stitch->RGBY1 || list[i] == (vx_reference)stitch->RGBY2 || list[i] == (vx_reference)stitch->blend_mask_image))
+			refList[i] = nullptr;
+	}
+	if (skipSharedObjects) {
+		vx_reference * objList[16];
+		vx_size numObjs = SharedTablesGetObjectList(stitch, objList);
+		for (vx_size i = 0; i < dimof(list); i++) {
+			for (vx_size k = 0; k < numObjs; k++) {
+				if (list[i] && list[i] == *objList[k])
+					refList[i] = nullptr;
 			}
 		}
 	}
+	return dimof(list);
+}
+//! \brief Get the size of table data in the cache and the number of items for arrays.
+static vx_status TableCacheGetTableSize(vx_reference ref, vx_enum& type, vx_uint64& count, vx_uint64& size)
+{
+	ERROR_CHECK_STATUS_(vxQueryReference(ref, VX_REFERENCE_TYPE, &type, sizeof(type)));
+	count = 0; size = 0;
+	if (type == VX_TYPE_IMAGE) {
+		vx_df_image format = VX_DF_IMAGE_VIRT;
+		vx_size num_planes = 0;
+		vx_uint32 width = 0, height = 0;
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_PLANES, &num_planes, sizeof(num_planes)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+		vx_rectangle_t rectFull = { 0, 0, width, height };
+		for (vx_uint32 plane = 0; plane < (vx_uint32)num_planes; plane++) {
+			vx_imagepatch_addressing_t addr = { 0 };
+			vx_uint8 * src = NULL;
+			ERROR_CHECK_STATUS_(vxAccessImagePatch((vx_image)ref, &rectFull, plane, &addr, (void **)&src, VX_READ_ONLY));
+			vx_size width_in_bytes = (format == VX_DF_IMAGE_U1_AMD) ? ((addr.dim_x + 7) >> 3) : (addr.dim_x * addr.stride_x);
+			size += width_in_bytes * ((addr.dim_y + addr.step_y - 1) / addr.step_y);
+			ERROR_CHECK_STATUS_(vxCommitImagePatch((vx_image)ref, &rectFull, plane, &addr, src));
+		}
+	}
+	else if (type == VX_TYPE_ARRAY) {
+		vx_size numItems = 0, itemSize = 0;
+		ERROR_CHECK_STATUS_(vxQueryArray((vx_array)ref, VX_ARRAY_ITEMSIZE, &itemSize, sizeof(itemSize)));
+		ERROR_CHECK_STATUS_(vxQueryArray((vx_array)ref, VX_ARRAY_NUMITEMS, &numItems, sizeof(numItems)));
+		count = numItems;
+		size = numItems * itemSize;
+	}
+	else if (type == VX_TYPE_MATRIX) {
+		vx_size matSize = 0;
+		ERROR_CHECK_STATUS_(vxQueryMatrix((vx_matrix)ref, VX_MATRIX_SIZE, &matSize, sizeof(matSize)));
+		size = matSize;
+	}
+	else if (type == VX_TYPE_REMAP) {
+		vx_uint32 dstWidth = 0, dstHeight = 0;
+		ERROR_CHECK_STATUS_(vxQueryRemap((vx_remap)ref, VX_REMAP_DESTINATION_WIDTH, &dstWidth, sizeof(dstWidth)));
+		ERROR_CHECK_STATUS_(vxQueryRemap((vx_remap)ref, VX_REMAP_DESTINATION_HEIGHT, &dstHeight, sizeof(dstHeight)));
+		size = (vx_uint64)dstWidth * dstHeight * 2 * sizeof(vx_float32);
+	}
+	else return VX_ERROR_NOT_SUPPORTED;
 	return VX_SUCCESS;
 }
-vx_status loadImage(vx_image img, const char * fileName)
+//! \brief Copy table data between an OpenVX object and a buffer (read: object to buffer).
+static vx_status TableCacheCopyTable(vx_reference ref, vx_enum type, vx_uint64 count, vx_uint8 * buf, vx_enum usage)
 {
-	FILE * fp = fopen(fileName, "r"); 
-	if (!fp) {
-		ls_printf("ERROR: loadImage: unable to open: %s\n", fileName); 
-		if (fp != NULL)	fclose(fp); 
-		return VX_FAILURE;
+	if (type == VX_TYPE_IMAGE) {
+		vx_df_image format = VX_DF_IMAGE_VIRT;
+		vx_size num_planes = 0;
+		vx_uint32 width = 0, height = 0;
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_PLANES, &num_planes, sizeof(num_planes)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+		vx_rectangle_t rectFull = { 0, 0, width, height };
+		for (vx_uint32 plane = 0; plane < (vx_uint32)num_planes; plane++) {
+			vx_imagepatch_addressing_t addr = { 0 };
+			vx_uint8 * src = NULL;
+			ERROR_CHECK_STATUS_(vxAccessImagePatch((vx_image)ref, &rectFull, plane, &addr, (void **)&src, usage));
+			vx_size width_in_bytes = (format == VX_DF_IMAGE_U1_AMD) ? ((addr.dim_x + 7) >> 3) : (addr.dim_x * addr.stride_x);
+			for (vx_uint32 y = 0; y < addr.dim_y; y += addr.step_y, buf += width_in_bytes) {
+				vx_uint8 * srcp = (vx_uint8 *)vxFormatImagePatchAddress2d(src, 0, y, &addr);
+				if (usage == VX_READ_ONLY) memcpy(buf, srcp, width_in_bytes);
+				else memcpy(srcp, buf, width_in_bytes);
+			}
+			ERROR_CHECK_STATUS_(vxCommitImagePatch((vx_image)ref, &rectFull, plane, &addr, src));
+		}
+	}
+	else if (type == VX_TYPE_ARRAY) {
+		vx_size itemSize = 0, capacity = 0;
+		ERROR_CHECK_STATUS_(vxQueryArray((vx_array)ref, VX_ARRAY_ITEMSIZE, &itemSize, sizeof(itemSize)));
+		ERROR_CHECK_STATUS_(vxQueryArray((vx_array)ref, VX_ARRAY_CAPACITY, &capacity, sizeof(capacity)));
+		if (count > capacity) {
+			ls_printf("ERROR: TableCacheCopyTable: array capacity " VX_FMT_SIZE " is smaller than " VX_FMT_SIZE " items\n", capacity, (vx_size)count);
+			return VX_ERROR_INVALID_DIMENSION;
+		}
+		if (usage != VX_READ_ONLY) {
+			ERROR_CHECK_STATUS_(vxTruncateArray((vx_array)ref, 0));
+			if (count > 0) ERROR_CHECK_STATUS_(vxAddArrayItems((vx_array)ref, (vx_size)count, buf, itemSize));
+		}
+		else if (count > 0) {
+			vx_map_id map_id;
+			vx_uint8 * ptr;
+			vx_size stride;
+			ERROR_CHECK_STATUS_(vxMapArrayRange((vx_array)ref, 0, (vx_size)count, &map_id, &stride, (void **)&ptr, VX_READ_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+			memcpy(buf, ptr, (vx_size)count * itemSize);
+			ERROR_CHECK_STATUS_(vxUnmapArrayRange((vx_array)ref, map_id));
+		}
+	}
+	else if (type == VX_TYPE_MATRIX) {
+		ERROR_CHECK_STATUS_(vxCopyMatrix((vx_matrix)ref, buf, usage, VX_MEMORY_TYPE_HOST));
+	}
+	else if (type == VX_TYPE_REMAP) {
+		vx_uint32 dstWidth = 0, dstHeight = 0;
+		ERROR_CHECK_STATUS_(vxQueryRemap((vx_remap)ref, VX_REMAP_DESTINATION_WIDTH, &dstWidth, sizeof(dstWidth)));
+		ERROR_CHECK_STATUS_(vxQueryRemap((vx_remap)ref, VX_REMAP_DESTINATION_HEIGHT, &dstHeight, sizeof(dstHeight)));
+		vx_float32 * src_xy = (vx_float32 *)buf;
+		for (vx_uint32 y = 0; y < dstHeight; y++) {
+			for (vx_uint32 x = 0; x < dstWidth; x++, src_xy += 2) {
+				if (usage == VX_READ_ONLY) {
+					ERROR_CHECK_STATUS_(vxGetRemapPoint((vx_remap)ref, x, y, &src_xy[0], &src_xy[1]));
+				}
+				else {
+					ERROR_CHECK_STATUS_(vxSetRemapPoint((vx_remap)ref, x, y, src_xy[0], src_xy[1]));
+				}
+			}
+		}
 	}
-	vx_df_image format = VX_DF_IMAGE_VIRT;
-	vx_size num_planes = 0;
-	vx_rectangle_t rectFull = { 0, 0, 0, 0 };
-	ERROR_CHECK_STATUS(vxQueryImage(img, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
-	ERROR_CHECK_STATUS(vxQueryImage(img, VX_IMAGE_ATTRIBUTE_PLANES, &num_planes, sizeof(num_planes)));
-	ERROR_CHECK_STATUS(vxQueryImage(img, VX_IMAGE_ATTRIBUTE_WIDTH, &rectFull.end_x, sizeof(rectFull.end_x)));
-	ERROR_CHECK_STATUS(vxQueryImage(img, VX_IMAGE_ATTRIBUTE_HEIGHT, &rectFull.end_y, sizeof(rectFull.end_y)));
-	// write all image planes from vx_image
-	for (vx_uint32 plane = 0; plane < (vx_uint32)num_planes; plane++){
-		vx_imagepatch_addressing_t addr = { 0 };
-		vx_uint8 * src = NULL;
-		ERROR_CHECK_STATUS(vxAccessImagePatch(img, &rectFull, plane, &addr, (void **)&src, VX_WRITE_ONLY));
-		vx_size width = (addr.dim_x * addr.scale_x) / VX_SCALE_UNITY;
-		vx_size width_in_bytes = (format == VX_DF_IMAGE_U1_AMD) ? ((width + 7) >> 3) : (width * addr.stride_x);
-		for (vx_uint32 y = 0; y < addr.dim_y; y += addr.step_y){
-			vx_uint8 *srcp = (vx_uint8 *)vxFormatImagePatchAddress2d(src, 0, y, &addr);
-			ERROR_CHECK_FREAD_(fread(srcp, 1, width_in_bytes, fp), width_in_bytes);
+	else return VX_ERROR_NOT_SUPPORTED;
+	return VX_SUCCESS;
+}
+static vx_status quickSetupFilesLookup(ls_context stitch)
+{
+	// look for a record with a matching key and a valid checksum
+	char fileName[1024];
+	TableCacheGetFileName(fileName, sizeof(fileName));
+	stitch->SETUP_LOAD_FILES_FOUND = vx_false_e;
+	stitch->tableCache.key = TableCacheCalculateKey(stitch);
+	if (!TableCacheMapFile(fileName, stitch->tableCache))
+		return VX_SUCCESS;
+	const ls_table_cache_record_header * records[LS_TABLE_CACHE_MAX_RECORDS * 2];
+	vx_uint32 numRecords = TableCacheGetRecords(stitch->tableCache, records, (vx_uint32)dimof(records));
+	for (vx_uint32 i = 0; i < numRecords; i++) {
+		if (records[i]->key == stitch->tableCache.key) {
+			if (TableCacheHash(records[i] + 1, (vx_size)records[i]->payloadSize) == records[i]->checksum) {
+				stitch->tableCache.record = records[i];
+				stitch->SETUP_LOAD_FILES_FOUND = vx_true_e;
+			}
+			else {
+				ls_printf("WARNING: quickSetupFilesLookup: ignored tables with invalid checksum in %s\n", fileName);
+			}
 		}
-		ERROR_CHECK_STATUS(vxCommitImagePatch(img, &rectFull, plane, &addr, src));
 	}
-	fclose(fp);
+	if (!stitch->SETUP_LOAD_FILES_FOUND)
+		TableCacheUnmapFile(stitch->tableCache);
+	return VX_SUCCESS;
+}
+//! \brief Create a cache record of the context tables: the record header followed by the payload.
+static vx_status TableCacheCreateRecord(ls_context stitch, vx_uint64 key, bool skipConstantBuffers, bool skipSharedObjects, std::vector<vx_uint8>& record)
+{
+	// get table sizes and layout of the new record
+	vx_reference refList[32];
+	vx_size numRefs = TableCacheGetTableList(stitch, refList, skipConstantBuffers, skipSharedObjects);
+	std::vector<ls_table_cache_table_entry> tables;
+	vx_uint64 payloadSize = 0;
+	for (vx_size i = 0; i < numRefs; i++) {
+		if (refList[i]) {
+			ls_table_cache_table_entry table = { (vx_uint32)i, VX_TYPE_INVALID, 0, 0, 0 };
+			ERROR_CHECK_STATUS_(TableCacheGetTableSize(refList[i], table.type, table.count, table.size));
+			tables.push_back(table);
+		}
+	}
+	payloadSize = (tables.size() * sizeof(ls_table_cache_table_entry) + LS_TABLE_CACHE_ALIGN - 1) & ~(vx_uint64)(LS_TABLE_CACHE_ALIGN - 1);
+	for (auto& table : tables) {
+		table.offset = payloadSize;
+		payloadSize += (table.size + LS_TABLE_CACHE_ALIGN - 1) & ~(vx_uint64)(LS_TABLE_CACHE_ALIGN - 1);
+	}
+	// generate the payload
+	record.assign(sizeof(ls_table_cache_record_header) + (vx_size)payloadSize, 0);
+	vx_uint8 * payload = record.data() + sizeof(ls_table_cache_record_header);
+	if (!tables.empty()) memcpy(payload, tables.data(), tables.size() * sizeof(ls_table_cache_table_entry));
+	for (auto& table : tables) {
+		ERROR_CHECK_STATUS_(TableCacheCopyTable(refList[table.index], table.type, table.count, payload + table.offset, VX_READ_ONLY));
+	}
+	ls_table_cache_record_header * header = (ls_table_cache_record_header *)record.data();
+	header->key = key;
+	header->payloadSize = payloadSize;
+	header->checksum = TableCacheHash(payload, (vx_size)payloadSize);
+	header->numTables = (vx_uint32)tables.size();
+	const vx_size * sizes = &stitch->table_sizes.warpTableSize;
+	for (vx_size i = 0; i < dimof(header->tableSizes); i++) header->tableSizes[i] = sizes[i];
 	return VX_SUCCESS;
 }
-vx_status loadArray(vx_array arr, const char * fileName)
+static vx_status quickSetupDumpTables(ls_context stitch)
 {
-	FILE * fp = fopen(fileName, "r"); 
+	std::vector<vx_uint8> record;
+	ERROR_CHECK_STATUS_(TableCacheCreateRecord(stitch, stitch->tableCache.key, false, false, record));
+	vx_uint64 key = stitch->tableCache.key;
+
+	// write the new cache file with the most recent records of other configurations and the new record
+	char fileName[1024], tmpFileName[1040];
+	TableCacheGetFileName(fileName, sizeof(fileName));
+	snprintf(tmpFileName, sizeof(tmpFileName), "%s.tmp", fileName);
+	ls_table_cache cache = { 0 };
+	const ls_table_cache_record_header * records[LS_TABLE_CACHE_MAX_RECORDS * 2];
+	vx_uint32 numRecords = 0;
+	if (TableCacheMapFile(fileName, cache))
+		numRecords = TableCacheGetRecords(cache, records, (vx_uint32)dimof(records));
+	std::vector<const ls_table_cache_record_header *> keep;
+	for (vx_uint32 i = 0; i < numRecords; i++) {
+		if (records[i]->key != key)
+			keep.push_back(records[i]);
+	}
+	if (keep.size() > LS_TABLE_CACHE_MAX_RECORDS - 1)
+		keep.erase(keep.begin(), keep.end() - (LS_TABLE_CACHE_MAX_RECORDS - 1));
+	FILE * fp = fopen(tmpFileName, "wb");
 	if (!fp) {
-		ls_printf("ERROR: loadArray: unable to open: %s\n", fileName);
-		if (fp != NULL)	fclose(fp);
+		TableCacheUnmapFile(cache);
+		ls_printf("ERROR: quickSetupDumpTables: unable to create: %s\n", tmpFileName);
+		return VX_FAILURE;
+	}
+	ls_table_cache_file_header header = { { 0 }, LS_TABLE_CACHE_VERSION, (vx_uint32)keep.size() + 1 };
+	memcpy(header.magic, LS_TABLE_CACHE_MAGIC, sizeof(header.magic));
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	for (auto r : keep)
+		ok = ok && fwrite(r, sizeof(*r) + (vx_size)r->payloadSize, 1, fp) == 1;
+	ok = ok && fwrite(record.data(), record.size(), 1, fp) == 1;
+	ok = (fclose(fp) == 0) && ok;
+	TableCacheUnmapFile(cache);
+	if (ok) {
+#if _WIN32
+		ok = MoveFileExA(tmpFileName, fileName, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		ok = rename(tmpFileName, fileName) == 0;
+#endif
+	}
+	if (!ok) {
+		remove(tmpFileName);
+		ls_printf("ERROR: quickSetupDumpTables: unable to write: %s\n", fileName);
 		return VX_FAILURE;
 	}
-	vx_size numItems, itemSize;
-	ERROR_CHECK_STATUS_(vxQueryArray(arr, VX_ARRAY_ITEMSIZE, &itemSize, sizeof(itemSize)));
-	ERROR_CHECK_STATUS_(vxQueryArray(arr, VX_ARRAY_CAPACITY, &numItems, sizeof(numItems)));
-	StitchWarpRemapEntry validPixelEntry = { 0 };
-	ERROR_CHECK_STATUS_(vxTruncateArray(arr, 0));
-	ERROR_CHECK_STATUS_(vxAddArrayItems(arr, numItems, &validPixelEntry, 0));
-	vx_map_id map_id;
-	vx_uint8 * ptr;
-	vx_size stride;
-	ERROR_CHECK_STATUS_(vxMapArrayRange(arr, 0, numItems, &map_id, &stride, (void **)&ptr, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, 0));
-	ERROR_CHECK_FREAD_(fread(ptr, itemSize, numItems, fp),numItems);
-	ERROR_CHECK_STATUS_(vxUnmapArrayRange(arr, map_id));
-	fclose(fp);
 	return VX_SUCCESS;
 }
-static vx_status loadMatrix(vx_matrix mat, const char * fileName)
+static vx_status quickSetupLoadTableSizes(ls_context stitch)
 {
-	FILE * fp = fopen(fileName, "r"); 
-	if (!fp) { 
-		ls_printf("ERROR: loadMatrix: unable to read: %s\n", fileName);
-		if (fp != NULL)	fclose(fp);
+	const ls_table_cache_record_header * record = stitch->tableCache.record;
+	if (!record) {
+		ls_printf("ERROR: quickSetupLoadTableSizes: no tables found\n");
 		return VX_FAILURE;
 	}
-	vx_size size;
-	ERROR_CHECK_STATUS_(vxQueryMatrix(mat, VX_MATRIX_SIZE, &size, sizeof(size)));
-	vx_uint8 * buf = new vx_uint8[size];
-	ERROR_CHECK_STATUS_(vxCopyMatrix(mat, buf, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST));
-	ERROR_CHECK_FREAD_(fread(buf, 4, size, fp),size);
-	delete[] buf;
-	fclose(fp);
-	vx_size rows, columns;
-	ERROR_CHECK_STATUS_(vxQueryMatrix(mat, VX_MATRIX_ROWS, &rows, sizeof(rows)));
-	ERROR_CHECK_STATUS_(vxQueryMatrix(mat, VX_MATRIX_COLUMNS, &columns, sizeof(columns)));
+	vx_size * sizes = &stitch->table_sizes.warpTableSize;
+	for (vx_size i = 0; i < dimof(record->tableSizes); i++) sizes[i] = (vx_size)record->tableSizes[i];
 	return VX_SUCCESS;
 }
-static vx_status loadRemap(vx_remap remap, const char * fileName)
+static bool SharedTablesHaveObjects(ls_context stitch);
+static vx_status quickSetupLoadTables(ls_context stitch)
 {
-	FILE * fp = fopen(fileName, "r"); 
-	if (!fp) { 
-		ls_printf("ERROR: loadRemap: unable to read: %s\n", fileName); 
-		if (fp != NULL)	fclose(fp);
+	const ls_table_cache_record_header * record = stitch->tableCache.record;
+	if (!record) {
+		ls_printf("ERROR: quickSetupLoadTables: no tables found\n");
 		return VX_FAILURE;
 	}
-	vx_uint32 dstWidth, dstHeight;
-	ERROR_CHECK_STATUS_(vxQueryRemap(remap, VX_REMAP_DESTINATION_WIDTH, &dstWidth, sizeof(dstWidth)));
-	ERROR_CHECK_STATUS_(vxQueryRemap(remap, VX_REMAP_DESTINATION_HEIGHT, &dstHeight, sizeof(dstHeight)));
-	for (vx_uint32 y = 0; y < dstHeight; y++){
-		for (vx_uint32 x = 0; x < dstWidth; x++){
-			vx_float32 src_xy[2];
-			ERROR_CHECK_STATUS_(vxGetRemapPoint(remap, x, y, &src_xy[0], &src_xy[1]));
-			ERROR_CHECK_FREAD_(fread(src_xy, sizeof(src_xy), 1, fp),1);
-		}
+	// copy tables from the mapped file (or the shared tables) into the OpenVX objects: remap tables point by point
+	vx_reference refList[32];
+	vx_size numRefs = TableCacheGetTableList(stitch, refList, stitch->sharedTables != nullptr, SharedTablesHaveObjects(stitch));
+	const vx_uint8 * payload = (const vx_uint8 *)(record + 1);
+	const ls_table_cache_table_entry * tables = (const ls_table_cache_table_entry *)payload;
+	vx_status status = VX_SUCCESS;
+	vx_uint32 numLoaded = 0;
+	for (vx_uint32 i = 0; i < record->numTables && status == VX_SUCCESS; i++) {
+		const ls_table_cache_table_entry& table = tables[i];
+		vx_enum type = VX_TYPE_INVALID;
+		vx_uint64 count = 0, size = 0;
+		if (table.index >= numRefs || !refList[table.index] || table.offset + table.size > record->payloadSize) status = VX_ERROR_INVALID_PARAMETERS;
+		else if ((status = TableCacheGetTableSize(refList[table.index], type, count, size)) != VX_SUCCESS) break;
+		else if (type != table.type || (type != VX_TYPE_ARRAY && size != table.size)) status = VX_ERROR_INVALID_DIMENSION;
+		else if ((status = TableCacheCopyTable(refList[table.index], type, table.count, (vx_uint8 *)payload + table.offset, VX_WRITE_ONLY)) == VX_SUCCESS) numLoaded++;
+	}
+	vx_uint32 numUsed = 0;
+	for (vx_size i = 0; i < numRefs; i++) numUsed += refList[i] ? 1 : 0;
+	if (status == VX_SUCCESS && numLoaded != numUsed) status = VX_ERROR_INVALID_PARAMETERS;
+	TableCacheUnmapFile(stitch->tableCache);
+	if (status != VX_SUCCESS) {
+		ls_printf("ERROR: quickSetupLoadTables: cached tables don't match the configuration (%d)\n", status);
+		return status;
 	}
-	fclose(fp);
 	return VX_SUCCESS;
 }
-static vx_status loadReference(vx_reference ref, const char * fileName)
+//////////////////////////////////////////////////////////////////////
+// Shared tables
+//   Contexts of the process with LIVE_STITCH_ATTR_SHARE_INIT_TABLES and the same configuration (the table cache key)
+//   share the tables generated by the first of them, reference counted by the contexts that use them. The other contexts
+//   don't compute the lens models and don't allocate the lens model buffers.
+//   Contexts of the same external OpenVX context (see lsSetOpenVXContext) use the table objects of the first context
+//   that are only read after initialization (see SharedTablesGetObjectList). The remaining tables, without the buffers
+//   that start with a constant value, are kept in memory as a table cache record and loaded as from the table cache file.
+//   Contexts with their own OpenVX contexts share only the record.
+struct ls_shared_tables {
+	vx_uint64 key;                              // configuration hash
+	vx_context context;                         // external OpenVX context of the shared objects (nullptr: no shared objects)
+	vx_reference objects[16];                   // shared table objects (see SharedTablesGetObjectList)
+	std::vector<vx_uint8> record;               // table cache record of the other tables: header followed by the payload
+	std::vector<vx_size> blendOffsets;          // multiband blend offsets of levels into the blend offset table
+	vx_uint32 refCount;                         // number of contexts using the tables
+};
+static std::mutex g_shared_tables_mutex;
+static std::vector<ls_shared_tables *> g_shared_tables;
+
+//! \brief Check if the context uses the table objects of the shared tables.
+static bool SharedTablesHaveObjects(ls_context stitch)
 {
-	vx_enum type;
-	ERROR_CHECK_STATUS_(vxQueryReference(ref, VX_REFERENCE_TYPE, &type, sizeof(type)));
-	if (type == VX_TYPE_IMAGE) return loadImage((vx_image)ref, fileName);
-	else if (type == VX_TYPE_ARRAY) return loadArray((vx_array)ref, fileName);
-	else if (type == VX_TYPE_MATRIX) return loadMatrix((vx_matrix)ref, fileName);
-	else if (type == VX_TYPE_REMAP) return loadRemap((vx_remap)ref, fileName);
-	else return VX_ERROR_NOT_SUPPORTED;
+	return stitch->sharedTables && stitch->sharedTables->context;
 }
-static vx_status quickSetupLoadTableSizes(ls_context stitch)
+//! \brief Release the table objects and destroy the shared tables.
+static void SharedTablesDestroy(ls_shared_tables * entry)
 {
-	FILE * fp = fopen("StitchTableSizes.txt", "r"); 
-	if (!fp) { 
-		ls_printf("ERROR: quickSetupLoadTableSizes: unable to open: StitchTableSizes.txt\n"); 
-		if (fp != NULL)	fclose(fp);
-		return VX_FAILURE;
+	for (vx_size i = 0; i < dimof(entry->objects); i++) {
+		if (entry->objects[i]) vxReleaseReference(&entry->objects[i]);
+	}
+	delete entry;
+}
+//! \brief Look for the shared tables of the context configuration: the tables are loaded like the table cache.
+static void SharedTablesLookup(ls_context stitch)
+{
+	stitch->tableCache.key = TableCacheCalculateKey(stitch);
+	vx_context context = stitch->context_is_external ? stitch->context : nullptr;
+	std::lock_guard<std::mutex> lock(g_shared_tables_mutex);
+	for (auto entry : g_shared_tables) {
+		if (entry->key == stitch->tableCache.key && entry->context == context) {
+			entry->refCount++;
+			stitch->sharedTables = entry;
+			stitch->tableCache.record = (const ls_table_cache_record_header *)entry->record.data();
+			stitch->SETUP_LOAD_FILES_FOUND = vx_true_e;
+			break;
+		}
+	}
+}
+//! \brief Use the shared table objects instead of the objects created by the context.
+static vx_status SharedTablesUseObjects(ls_context stitch)
+{
+	vx_reference * objList[16];
+	vx_size numObjs = SharedTablesGetObjectList(stitch, objList);
+	for (vx_size i = 0; i < numObjs; i++) {
+		vx_reference ref = stitch->sharedTables->objects[i];
+		if ((*objList[i] != nullptr) != (ref != nullptr)) {
+			ls_printf("ERROR: SharedTablesUseObjects: shared tables don't match the configuration\n");
+			return VX_ERROR_INVALID_PARAMETERS;
+		}
+		if (ref) {
+			ERROR_CHECK_STATUS_(vxReleaseReference(objList[i]));
+			ERROR_CHECK_STATUS_(vxRetainReference(ref));
+			*objList[i] = ref;
+		}
 	}
-	int readValue = 0;
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.blendOffsetTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.expCompOverlapTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.expCompValidTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.seamFindAccumTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.seamFindPathTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.seamFindPrefInfoTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.seamFindValidTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.seamFindWeightTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-	readValue = fscanf(fp, VX_FMT_SIZE, &stitch->table_sizes.warpTableSize); 
-	if (!readValue) { ls_printf("ERROR: quickSetupLoadTableSizes: unable to read file\n"); return VX_FAILURE; }
-
 	return VX_SUCCESS;
 }
-static vx_status quickSetupLoadTables(ls_context stitch)
+//! \brief Share the tables of the context after they are initialized.
+static vx_status SharedTablesPublish(ls_context stitch)
 {
-	vx_reference refList[] = {
-		// intermediate tables and data that needs initialization
-		(vx_reference)stitch->ValidPixelEntry,
-		(vx_reference)stitch->WarpRemapEntry,
-		(vx_reference)stitch->RGBY1,
-		(vx_reference)stitch->cam_id_image,
-		(vx_reference)stitch->group1_image,
-		(vx_reference)stitch->group2_image,
-		(vx_reference)stitch->weight_image,
-		(vx_reference)stitch->valid_array,
-		(vx_reference)stitch->OverlapPixelEntry,
-		(vx_reference)stitch->overlap_matrix,
-		(vx_reference)stitch->RGBY2,
-		(vx_reference)stitch->valid_mask_image,
-		(vx_reference)stitch->seamfind_valid_array,
-		(vx_reference)stitch->seamfind_weight_array,
-		(vx_reference)stitch->seamfind_accum_array,
-		(vx_reference)stitch->seamfind_pref_array,
-		(vx_reference)stitch->seamfind_info_array,
-		(vx_reference)stitch->seamfind_path_array,
-		(vx_reference)stitch->seamfind_scene_array,
-		(vx_reference)stitch->seamfind_weight_image,
-		(vx_reference)stitch->blend_mask_image,
-		(vx_reference)stitch->blend_offsets,
-		(vx_reference)stitch->camera_remap,
-		(vx_reference)stitch->overlay_remap,
-	};
-	for (vx_size i = 0; i < dimof(refList); i++) {
-		if (refList[i]) {
-			bool isIntermediateTmpData = false, isForCpuUseOnly = false;
-			const char * fileNameSuffix = GetFileNameSuffix(stitch, refList[i], isIntermediateTmpData, isForCpuUseOnly);
-			if (fileNameSuffix && (!isIntermediateTmpData)) {
-				char fileName[1024]; sprintf(fileName, "%s", fileNameSuffix);
-				vx_status status = loadReference(refList[i], fileName);
-				if (status != VX_SUCCESS)
-					return status;
+	ls_shared_tables * entry = nullptr;
+	ERROR_CHECK_ALLOC_(entry = new ls_shared_tables());
+	entry->key = stitch->tableCache.key;
+	entry->context = stitch->context_is_external ? stitch->context : nullptr;
+	entry->refCount = 1;
+	if (entry->context) {
+		vx_reference * objList[16];
+		vx_size numObjs = SharedTablesGetObjectList(stitch, objList);
+		for (vx_size i = 0; i < numObjs; i++) {
+			if (*objList[i]) {
+				vxRetainReference(*objList[i]);
+				entry->objects[i] = *objList[i];
 			}
 		}
 	}
+	vx_status status = TableCacheCreateRecord(stitch, entry->key, true, entry->context != nullptr, entry->record);
+	if (status != VX_SUCCESS) {
+		SharedTablesDestroy(entry);
+		return status;
+	}
+	if (stitch->MULTIBAND_BLEND)
+		entry->blendOffsets.assign(stitch->multibandBlendOffsetIntoBuffer, stitch->multibandBlendOffsetIntoBuffer + stitch->num_bands);
+	std::lock_guard<std::mutex> lock(g_shared_tables_mutex);
+	for (auto other : g_shared_tables) {
+		if (other->key == entry->key && other->context == entry->context) {
+			// published by a context initialized at the same time: this context keeps its own objects
+			other->refCount++;
+			stitch->sharedTables = other;
+			SharedTablesDestroy(entry);
+			return VX_SUCCESS;
+		}
+	}
+	g_shared_tables.push_back(entry);
+	stitch->sharedTables = entry;
 	return VX_SUCCESS;
 }
+//! \brief Release the shared tables used by the context.
+static void SharedTablesRelease(ls_context stitch)
+{
+	if (stitch->sharedTables) {
+		std::lock_guard<std::mutex> lock(g_shared_tables_mutex);
+		if (--stitch->sharedTables->refCount == 0) {
+			g_shared_tables.erase(std::find(g_shared_tables.begin(), g_shared_tables.end(), stitch->sharedTables));
+			SharedTablesDestroy(stitch->sharedTables);
+		}
+		stitch->sharedTables = nullptr;
+	}
+}
 static vx_status setupQuickInitializeParams(ls_context stitch)
 {
 	vx_uint32 camWidth = stitch->camera_rgb_buffer_width / stitch->num_camera_columns;
@@ -1068,82 +1586,271 @@ static vx_status AllocateLensModelBuffersForOverlay(ls_context stitch)
 	stitch->overlayIndexBuf = new vx_uint8[stitch->output_rgb_buffer_width * stitch->output_rgb_buffer_height];
 	return VX_SUCCESS;
 }
+// Set the remap points of an output region from the lens models: the region starts at (start_x, start_y) of the
+// output and x wraps around the output width. With prevCamIndexBuf, only the points from or to cameras in
+// camUpdateMask are set.
+static void SetRemapPointsForRegion(vx_remap remap, vx_int32 start_x, vx_uint32 start_y, vx_uint32 width, vx_uint32 height,
+	vx_uint32 numCamera, const vx_uint32 * x_offset, const vx_uint32 * y_offset, vx_uint32 eqrWidth, vx_uint32 eqrHeight,
+	const StitchCoord2dFloat * srcMap, const vx_uint8 * camIndexBuf, const vx_uint8 * prevCamIndexBuf, vx_uint32 camUpdateMask)
+{
+	vx_uint32 pixelsPerEqrImage = eqrWidth * eqrHeight;
+	for (vx_uint32 y = 0; y < height; y++) {
+		vx_uint32 row = (start_y + y) * eqrWidth;
+		for (vx_uint32 x = 0; x < width; x++) {
+			vx_int32 xe = (start_x + (vx_int32)x) % (vx_int32)eqrWidth; if (xe < 0) xe += eqrWidth;
+			vx_uint32 pos = row + xe;
+			vx_float32 x_src = -1, y_src = -1;
+			vx_uint32 camId = camIndexBuf[pos];
+			if (prevCamIndexBuf) {
+				// only the pixels from or to updated cameras change
+				vx_uint32 prevCamId = prevCamIndexBuf[pos];
+				if (!(camId < numCamera && (camUpdateMask & (1 << camId))) && !(prevCamId < numCamera && (camUpdateMask & (1 << prevCamId))))
+					continue;
+			}
+			if (camId < numCamera) {
+				const StitchCoord2dFloat * mapEntry = &srcMap[pos + camId * pixelsPerEqrImage];
+				x_src = mapEntry->x + x_offset[camId];
+				y_src = mapEntry->y + y_offset[camId];
+			}
+			vxSetRemapPoint(remap, x, y, x_src, y_src);
+		}
+	}
+}
+// LOOM_REINIT_CHECK=1: after an incremental update of the lens distortion and warp maps, compute the maps of all
+// cameras from scratch and report the pixels that differ (lsReinitialize fails on a mismatch).
+static vx_status CheckUpdatedLensDistortionAndWarpMaps(vx_uint32 numCamera, vx_uint32 camWidth, vx_uint32 camHeight,
+	vx_uint32 eqrWidth, vx_uint32 eqrHeight, vx_uint32 projection, const rig_params * rig_par, const camera_params * cam_par,
+	const vx_uint32 * validPixelCamMap, vx_uint32 paddingPixelCount, const vx_uint32 * paddedPixelCamMap,
+	const StitchCoord2dFloat * camSrcMap, const vx_float32 * camIndexTmpBuf, const vx_uint8 * camIndexBuf)
+{
+	char textBuffer[256];
+	if (!StitchGetEnvironmentVariable("LOOM_REINIT_CHECK", textBuffer, sizeof(textBuffer)) || !atoi(textBuffer))
+		return VX_SUCCESS;
+	vx_uint32 pixelCount = eqrWidth * eqrHeight;
+	std::vector<vx_uint32> validMap(pixelCount, 0), paddedMap(paddedPixelCamMap ? pixelCount : 0, 0);
+	std::vector<StitchCoord2dFloat> srcMap((size_t)numCamera * pixelCount);
+	std::vector<vx_float32> zBuf(pixelCount);
+	std::vector<vx_uint8> indexBuf(pixelCount);
+	vx_status status = CalculateLensDistortionAndWarpMaps(nullptr, numCamera, camWidth, camHeight, eqrWidth, eqrHeight, projection,
+		rig_par, cam_par, validMap.data(), paddingPixelCount, paddedPixelCamMap ? paddedMap.data() : nullptr,
+		srcMap.data(), camIndexTmpBuf ? zBuf.data() : nullptr, camIndexBuf ? indexBuf.data() : nullptr);
+	if (status != VX_SUCCESS)
+		return status;
+	vx_uint32 validMismatch = 0, paddedMismatch = 0, srcMismatch = 0, indexMismatch = 0;
+	for (vx_uint32 i = 0; i < pixelCount; i++) {
+		if (validPixelCamMap[i] != validMap[i]) validMismatch++;
+		if (paddedPixelCamMap && paddedPixelCamMap[i] != paddedMap[i]) paddedMismatch++;
+		if (camIndexBuf && (camIndexBuf[i] != indexBuf[i] || camIndexTmpBuf[i] != zBuf[i])) indexMismatch++;
+		for (vx_uint32 cam = 0; cam < numCamera; cam++) {
+			const StitchCoord2dFloat& a = camSrcMap[cam * pixelCount + i], & b = srcMap[cam * pixelCount + i];
+			if (a.x != b.x || a.y != b.y) { srcMismatch++; break; }
+		}
+	}
+	if (validMismatch || paddedMismatch || srcMismatch || indexMismatch) {
+		ls_printf("ERROR: LOOM_REINIT_CHECK: incremental maps differ from full compute: valid %d padded %d source %d default-camera %d pixels\n",
+			validMismatch, paddedMismatch, srcMismatch, indexMismatch);
+		return VX_FAILURE;
+	}
+	ls_printf("OK: LOOM_REINIT_CHECK: incremental maps match full compute (%dx%d, %d cameras)\n", eqrWidth, eqrHeight, numCamera);
+	return VX_SUCCESS;
+}
 static vx_status InitializeInternalTablesForRemap(ls_context stitch, vx_remap remap,
 	vx_uint32 numCamera, vx_uint32 numCameraColumns, vx_uint32 camWidth, vx_uint32 camHeight, vx_uint32 eqrWidth, vx_uint32 eqrHeight,
 	const rig_params * rig_par, const camera_params * cam_par,
-	StitchCoord2dFloat * srcMap, vx_uint32 * validPixelMap, vx_float32 * camIndexTmpBuf, vx_uint8 * camIndexBuf)
+	StitchCoord2dFloat * srcMap, vx_uint32 * validPixelMap, vx_float32 * camIndexTmpBuf, vx_uint8 * camIndexBuf,
+	vx_uint32 camUpdateMask, const ls_tile_job * tileJobs = nullptr, vx_uint32 numTileJobs = 0)
 {
-	// compute lens distortion and warp models
-	vx_status status = CalculateLensDistortionAndWarpMaps(stitch->stitchInitData, numCamera, camWidth, camHeight, eqrWidth, eqrHeight,
-		rig_par, cam_par, validPixelMap, 0, nullptr, srcMap, camIndexTmpBuf, camIndexBuf);
+	// compute lens distortion and warp models: only for cameras in camUpdateMask when the maps from CPU are available
+	vx_uint32 allCameraMask = (numCamera < 32) ? ((1u << numCamera) - 1) : 0xffffffff;
+	bool updateAll = ((camUpdateMask & allCameraMask) == allCameraMask) || !stitch->initialized ||
+		(stitch->stitchInitData && stitch->stitchInitData->graphInitialize);
+	std::vector<vx_uint8> prevCamIndexBuf;
+	vx_status status;
+	if (updateAll) {
+		status = CalculateLensDistortionAndWarpMaps(stitch->stitchInitData, numCamera, camWidth, camHeight, eqrWidth, eqrHeight, stitch->output_projection,
+			rig_par, cam_par, validPixelMap, 0, nullptr, srcMap, camIndexTmpBuf, camIndexBuf);
+	}
+	else {
+		prevCamIndexBuf.assign(camIndexBuf, camIndexBuf + eqrWidth * eqrHeight);
+		status = UpdateLensDistortionAndWarpMaps(numCamera, camWidth, camHeight, eqrWidth, eqrHeight, stitch->output_projection,
+			rig_par, cam_par, camUpdateMask, validPixelMap, 0, nullptr, srcMap, camIndexTmpBuf, camIndexBuf);
+		if (status == VX_SUCCESS) {
+			status = CheckUpdatedLensDistortionAndWarpMaps(numCamera, camWidth, camHeight, eqrWidth, eqrHeight, stitch->output_projection,
+				rig_par, cam_par, validPixelMap, 0, nullptr, srcMap, camIndexTmpBuf, camIndexBuf);
+		}
+	}
 
 	if (status != VX_SUCCESS) {
-		vxAddLogEntry((vx_reference)remap, status, "ERROR: InitializeInternalTablesForRemap: CalculateLensDistortionAndWarpMaps() failed (%d)\n", status);
+		vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: InitializeInternalTablesForRemap: CalculateLensDistortionAndWarpMaps() failed (%d)\n", status);
 		return status;
 	}
 
-	{ // initialize remap table
-		vx_uint32 pixelsPerEqrImage = eqrWidth * eqrHeight;
+	{ // initialize remap table of the complete output and/or the remap tables of the output tile jobs
 		vx_uint32 x_offset[256], y_offset[256];
 		for (vx_uint32 camId = 0; camId < numCamera; camId++) {
 			x_offset[camId] = (camId % numCameraColumns) * camWidth;
 			y_offset[camId] = (camId / numCameraColumns) * camHeight;
 		}
-		for (vx_uint32 y = 0, pos = 0; y < eqrHeight; y++) {
-			for (vx_uint32 x = 0; x < eqrWidth; x++, pos++) {
-				vx_float32 x_src = -1, y_src = -1;
-				vx_uint32 camId = camIndexBuf[pos];
-				if (camId < numCamera) {
-					const StitchCoord2dFloat * mapEntry = &srcMap[pos + camId * pixelsPerEqrImage];
-					x_src = mapEntry->x + x_offset[camId];
-					y_src = mapEntry->y + y_offset[camId];
-				}
-				vxSetRemapPoint(remap, x, y, x_src, y_src);
-			}
+		const vx_uint8 * prevCamIndex = updateAll ? nullptr : prevCamIndexBuf.data();
+		if (remap) {
+			SetRemapPointsForRegion(remap, 0, 0, eqrWidth, eqrHeight, numCamera, x_offset, y_offset, eqrWidth, eqrHeight,
+				srcMap, camIndexBuf, prevCamIndex, camUpdateMask);
+		}
+		for (vx_uint32 i = 0; i < numTileJobs; i++) {
+			const ls_tile_job * job = &tileJobs[i];
+			SetRemapPointsForRegion(job->remap, job->start_x, job->start_y, job->width, job->height, numCamera, x_offset, y_offset, eqrWidth, eqrHeight,
+				srcMap, camIndexBuf, prevCamIndex, camUpdateMask);
 		}
 	}
 
 	return VX_SUCCESS;
 }
-static vx_status InitializeInternalTablesForCamera(ls_context stitch)
+// Initialize the camera buffers that start with a constant value: the blend mask and the warp/exposure comp outputs
+static vx_status InitializeConstantBuffersForCamera(ls_context stitch)
 {
 	vx_uint32 numCamera = stitch->num_cameras;
 	vx_uint32 eqrWidth = stitch->output_rgb_buffer_width;
 	vx_uint32 eqrHeight = stitch->output_rgb_buffer_height;
-	const vx_uint32 * validPixelCamMap = stitch->validPixelCamMap;
-	const vx_uint32 * paddedPixelCamMap = stitch->paddedPixelCamMap;
-	const StitchCoord2dFloat * camSrcMap = stitch->camSrcMap;
-	const vx_rectangle_t * const * overlapValid = stitch->overlapValid;
-	const vx_rectangle_t * const * overlapPadded = stitch->overlapPadded;
-	const vx_uint32 * validCamOverlapInfo = stitch->validCamOverlapInfo;
-	const vx_uint32 * paddedCamOverlapInfo = stitch->paddedCamOverlapInfo;
-	const vx_uint8 * camIndexBuf = stitch->camIndexBuf;
 
-	if (stitch->feature_enable_reinitialize)
-	{
-		// compute lens distortion and warp models
-		vx_status status = CalculateLensDistortionAndWarpMaps(!stitch->USE_CPU_INIT ? stitch->stitchInitData : nullptr, stitch->num_cameras,
-			stitch->camera_rgb_buffer_width / stitch->num_camera_columns,
-			stitch->camera_rgb_buffer_height / stitch->num_camera_rows,
-			stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
-			&stitch->rig_par, stitch->camera_par,
-			stitch->validPixelCamMap, stitch->paddingPixelCount, stitch->paddedPixelCamMap,
-			stitch->camSrcMap, stitch->camIndexTmpBuf, stitch->camIndexBuf);
-		if (status != VX_SUCCESS) {
-			vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: CalculateLensDistortionAndWarpMaps() failed (%d)\n", status);
-			return status;
-		}
-		stitch->overlapCount = CalculateValidOverlapRegions(stitch->num_cameras,
-			stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
-			stitch->validPixelCamMap, stitch->overlapValid, stitch->validCamOverlapInfo,
-			stitch->paddedPixelCamMap, stitch->overlapPadded, stitch->paddedCamOverlapInfo);
-		if (stitch->overlapCount > 6) {
-			vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: number of overlaps (%d) greater than 6 not supported\n", stitch->overlapCount);
-			return VX_ERROR_NOT_SUPPORTED;
-		}
+	// initialize blend mask image
+	if (stitch->blend_mask_image) {
+		vx_rectangle_t rectMask = { 0, 0, eqrWidth, eqrHeight * numCamera };
+		vx_imagepatch_addressing_t addrMask;
+		vx_map_id map_id_mask;
+		vx_uint8 * ptr_mask;
+		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->blend_mask_image, &rectMask, 0, &map_id_mask, &addrMask, (void **)&ptr_mask, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+		memset(ptr_mask, 255, addrMask.stride_y * addrMask.dim_y);
+		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->blend_mask_image, map_id_mask));
 	}
-
-	{ // initialize warp tables
+	{ // initialize RGBY1 & RGBY2 to invalid pixels and sync to GPU
+		vx_rectangle_t rect = { 0, 0, eqrWidth, eqrHeight * numCamera };
+		vx_imagepatch_addressing_t addr;
+		vx_map_id map_id;
+		vx_uint32 * ptr;
+		const __m128i r0 = _mm_set1_epi32(0x80000000);
+		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->RGBY1, &rect, 0, &map_id, &addr, (void **)&ptr, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+		__m128i *dst = (__m128i*) ptr;
+		vx_size size_in_bytes = (addr.stride_y * addr.dim_y)&~127;
+		for (vx_uint32 i = 0; i < size_in_bytes; i += 128){
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+			_mm_store_si128(dst++, r0);
+		}
+		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->RGBY1, map_id));
+		if (stitch->RGBY2) {
+			ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->RGBY2, &rect, 0, &map_id, &addr, (void **)&ptr, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+			__m128i *dst = (__m128i*) ptr;
+			vx_size size_in_bytes = (addr.stride_y * addr.dim_y)&~127;
+			for (vx_uint32 i = 0; i < size_in_bytes; i += 128){
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+				_mm_store_si128(dst++, r0);
+			}
+			ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->RGBY2, map_id));
+		}
+	}
+	return VX_SUCCESS;
+}
+// Multiband blend images: with cube outputs the two face rows of each camera image are blended as separate
+// images, so that the pyramids don't mix the faces across the seam between the rows. The blend images keep
+// the memory layout of the camera images: image (camId * 2 + row) is face row 'row' of camera camId.
+static vx_uint32 GetMultibandImageCount(ls_context stitch)
+{
+	return stitch->num_cameras * ((stitch->output_projection != output_projection_equirectangular) ? 2 : 1);
+}
+static void GetMultibandOverlapRegions(ls_context stitch, std::vector<vx_rectangle_t>& rects, std::vector<const vx_rectangle_t *>& overlap)
+{
+	vx_uint32 numImages = GetMultibandImageCount(stitch), numRows = numImages / stitch->num_cameras;
+	vx_uint32 imageHeight = stitch->output_rgb_buffer_height / numRows;
+	rects.assign(numImages * numImages, vx_rectangle_t { 0, 0, 0, 0 });
+	overlap.resize(numImages);
+	for (vx_uint32 i = 0; i < numImages; i++) {
+		// only the regions of the images are used by the blend tables
+		const vx_rectangle_t& rc = stitch->overlapPadded[i / numRows][i / numRows];
+		vx_uint32 y0 = (i % numRows) * imageHeight;
+		vx_rectangle_t& dst = rects[i * numImages + i];
+		if (rc.end_x > rc.start_x && rc.end_y > y0 && rc.start_y < y0 + imageHeight) {
+			dst.start_x = rc.start_x;
+			dst.end_x = rc.end_x;
+			dst.start_y = std::max(rc.start_y, y0) - y0;
+			dst.end_y = std::min(rc.end_y, y0 + imageHeight) - y0;
+		}
+		overlap[i] = &rects[i * numImages];
+	}
+}
+static vx_status InitializeInternalTablesForCamera(ls_context stitch, vx_uint32 camUpdateMask)
+{
+	vx_uint32 numCamera = stitch->num_cameras;
+	vx_uint32 eqrWidth = stitch->output_rgb_buffer_width;
+	vx_uint32 eqrHeight = stitch->output_rgb_buffer_height;
+	const vx_uint32 * validPixelCamMap = stitch->validPixelCamMap;
+	const vx_uint32 * paddedPixelCamMap = stitch->paddedPixelCamMap;
+	const StitchCoord2dFloat * camSrcMap = stitch->camSrcMap;
+	const vx_rectangle_t * const * overlapValid = stitch->overlapValid;
+	const vx_rectangle_t * const * overlapPadded = stitch->overlapPadded;
+	const vx_uint32 * validCamOverlapInfo = stitch->validCamOverlapInfo;
+	const vx_uint32 * paddedCamOverlapInfo = stitch->paddedCamOverlapInfo;
+	const vx_uint8 * camIndexBuf = stitch->camIndexBuf;
+
+	if (stitch->feature_enable_reinitialize)
+	{
+		// compute lens distortion and warp models: after initialize, only the cameras in camUpdateMask
+		// are recomputed when the maps are calculated on CPU
+		StitchInitializeData * initData = !stitch->USE_CPU_INIT ? stitch->stitchInitData : nullptr;
+		vx_uint32 allCameraMask = (numCamera < 32) ? ((1u << numCamera) - 1) : 0xffffffff;
+		vx_status status;
+		if ((camUpdateMask & allCameraMask) == allCameraMask || !stitch->initialized || (initData && initData->graphInitialize)) {
+			status = CalculateLensDistortionAndWarpMaps(initData, stitch->num_cameras,
+				stitch->camera_rgb_buffer_width / stitch->num_camera_columns,
+				stitch->camera_rgb_buffer_height / stitch->num_camera_rows,
+				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, stitch->output_projection,
+				&stitch->rig_par, stitch->camera_par,
+				stitch->validPixelCamMap, stitch->paddingPixelCount, stitch->paddedPixelCamMap,
+				stitch->camSrcMap, stitch->camIndexTmpBuf, stitch->camIndexBuf);
+		}
+		else {
+			status = UpdateLensDistortionAndWarpMaps(stitch->num_cameras,
+				stitch->camera_rgb_buffer_width / stitch->num_camera_columns,
+				stitch->camera_rgb_buffer_height / stitch->num_camera_rows,
+				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, stitch->output_projection,
+				&stitch->rig_par, stitch->camera_par, camUpdateMask,
+				stitch->validPixelCamMap, stitch->paddingPixelCount, stitch->paddedPixelCamMap,
+				stitch->camSrcMap, stitch->camIndexTmpBuf, stitch->camIndexBuf);
+			if (status == VX_SUCCESS) {
+				status = CheckUpdatedLensDistortionAndWarpMaps(stitch->num_cameras,
+					stitch->camera_rgb_buffer_width / stitch->num_camera_columns,
+					stitch->camera_rgb_buffer_height / stitch->num_camera_rows,
+					stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, stitch->output_projection,
+					&stitch->rig_par, stitch->camera_par,
+					stitch->validPixelCamMap, stitch->paddingPixelCount, stitch->paddedPixelCamMap,
+					stitch->camSrcMap, stitch->camIndexTmpBuf, stitch->camIndexBuf);
+			}
+		}
+		if (status != VX_SUCCESS) {
+			vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: CalculateLensDistortionAndWarpMaps() failed (%d)\n", status);
+			return status;
+		}
+		stitch->overlapCount = CalculateValidOverlapRegions(stitch->num_cameras,
+			stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
+			stitch->validPixelCamMap, stitch->overlapValid, stitch->validCamOverlapInfo,
+			stitch->paddedPixelCamMap, stitch->overlapPadded, stitch->paddedCamOverlapInfo);
+		if (stitch->overlapCount > 6) {
+			vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: number of overlaps (%d) greater than 6 not supported\n", stitch->overlapCount);
+			return VX_ERROR_NOT_SUPPORTED;
+		}
+	}
+
+	{ // initialize warp tables
 		StitchValidPixelEntry validPixelEntry = { 0 }, *validPixelBuf = nullptr;
 		StitchWarpRemapEntry warpRemapEntry = { 0 }, *warpRemapBuf = nullptr;
 		ERROR_CHECK_STATUS_(vxTruncateArray(stitch->ValidPixelEntry, 0));
@@ -1194,6 +1901,42 @@ static vx_status InitializeInternalTablesForCamera(ls_context stitch)
 			return status;
 		}
 	}
+	if (stitch->MergeRemapEntry)
+	{ // move the warp entries of single camera pixels to merge remap table
+		vx_size warpEntryCount = 0, mergeEntryCount = 0;
+		ERROR_CHECK_STATUS_(vxQueryArray(stitch->ValidPixelEntry, VX_ARRAY_ATTRIBUTE_NUMITEMS, &warpEntryCount, sizeof(warpEntryCount)));
+		StitchWarpRemapEntry mergeRemapEntry = { 0 }, *mergeRemapBuf = nullptr, *warpRemapBuf = nullptr;
+		StitchValidPixelEntry * validPixelBuf = nullptr;
+		ERROR_CHECK_STATUS_(vxTruncateArray(stitch->MergeRemapEntry, 0));
+		ERROR_CHECK_STATUS_(vxAddArrayItems(stitch->MergeRemapEntry, warpEntryCount, &mergeRemapEntry, 0));
+		vx_size stride = 0; vx_map_id map_id_valid = 0, map_id_warp = 0, map_id_merge = 0;
+		ERROR_CHECK_STATUS_(vxMapArrayRange(stitch->ValidPixelEntry, 0, warpEntryCount, &map_id_valid, &stride, (void **)&validPixelBuf, VX_READ_AND_WRITE, VX_MEMORY_TYPE_HOST, 0));
+		ERROR_CHECK_STATUS_(vxMapArrayRange(stitch->WarpRemapEntry, 0, warpEntryCount, &map_id_warp, &stride, (void **)&warpRemapBuf, VX_READ_AND_WRITE, VX_MEMORY_TYPE_HOST, 0));
+		ERROR_CHECK_STATUS_(vxMapArrayRange(stitch->MergeRemapEntry, 0, warpEntryCount, &map_id_merge, &stride, (void **)&mergeRemapBuf, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, 0));
+		vx_rectangle_t rectId = { 0, 0, eqrWidth >> 3, eqrHeight };
+		vx_imagepatch_addressing_t addrId, addrG1, addrG2;
+		vx_map_id map_id_camId, map_id_camG1, map_id_camG2;
+		vx_uint8 * ptr_camId; vx_uint16 * ptr_camG1, *ptr_camG2;
+		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->cam_id_image, &rectId, 0, &map_id_camId, &addrId, (void **)&ptr_camId, VX_READ_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->group1_image, &rectId, 0, &map_id_camG1, &addrG1, (void **)&ptr_camG1, VX_READ_AND_WRITE, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->group2_image, &rectId, 0, &map_id_camG2, &addrG2, (void **)&ptr_camG2, VX_READ_AND_WRITE, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+		vx_status status = GenerateMergeSingleCameraBuffers(eqrWidth, eqrHeight,
+			addrId.stride_y, addrG1.stride_y, addrG2.stride_y, ptr_camId, ptr_camG1, ptr_camG2,
+			validPixelBuf, warpRemapBuf, &warpEntryCount, mergeRemapBuf, &mergeEntryCount);
+		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->cam_id_image, map_id_camId));
+		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->group1_image, map_id_camG1));
+		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->group2_image, map_id_camG2));
+		ERROR_CHECK_STATUS_(vxUnmapArrayRange(stitch->ValidPixelEntry, map_id_valid));
+		ERROR_CHECK_STATUS_(vxUnmapArrayRange(stitch->WarpRemapEntry, map_id_warp));
+		ERROR_CHECK_STATUS_(vxUnmapArrayRange(stitch->MergeRemapEntry, map_id_merge));
+		if (status != VX_SUCCESS) {
+			ls_printf("ERROR: InitializeInternalTablesForCamera: GenerateMergeSingleCameraBuffers() failed (%d)\n", status);
+			return status;
+		}
+		ERROR_CHECK_STATUS_(vxTruncateArray(stitch->ValidPixelEntry, warpEntryCount));
+		ERROR_CHECK_STATUS_(vxTruncateArray(stitch->WarpRemapEntry, warpEntryCount));
+		ERROR_CHECK_STATUS_(vxTruncateArray(stitch->MergeRemapEntry, mergeEntryCount));
+	}
 	{ // initialize weight and valid mask images
 		vx_rectangle_t rectMask = { 0, 0, eqrWidth, eqrHeight * numCamera };
 		vx_imagepatch_addressing_t addrMask;
@@ -1218,7 +1961,7 @@ static vx_status InitializeInternalTablesForCamera(ls_context stitch)
 		}
 		vx_status status = GenerateExpCompBuffers(numCamera, eqrWidth, eqrHeight,
 			validPixelCamMap, overlapValid, validCamOverlapInfo,
-			paddedPixelCamMap, overlapPadded, paddedCamOverlapInfo,
+			paddedPixelCamMap, overlapPadded, paddedCamOverlapInfo, stitch->EXPO_COMP_SUBSAMPLE,
 			stitch->table_sizes.expCompValidTableSize,
 			stitch->table_sizes.expCompOverlapTableSize,
 			validBuf, overlapBuf, &validEntryCount, &overlapEntryCount, stitch->overlapMatrixBuf);
@@ -1355,8 +2098,12 @@ static vx_status InitializeInternalTablesForCamera(ls_context stitch)
 		ERROR_CHECK_STATUS_(vxTruncateArray(stitch->blend_offsets, 0));
 		ERROR_CHECK_STATUS_(vxAddArrayItems(stitch->blend_offsets, stitch->table_sizes.blendOffsetTableSize, &blendValidEntry, 0));
 		ERROR_CHECK_STATUS_(vxMapArrayRange(stitch->blend_offsets, 0, stitch->table_sizes.blendOffsetTableSize, &mapIdValid, &stride, (void **)&blendOffsetTable, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
-		vx_status status = GenerateBlendBuffers(numCamera, eqrWidth, eqrHeight, stitch->num_bands,
-			validPixelCamMap, paddedPixelCamMap, overlapPadded, paddedCamOverlapInfo,
+		std::vector<vx_rectangle_t> blendRects;
+		std::vector<const vx_rectangle_t *> blendOverlap;
+		GetMultibandOverlapRegions(stitch, blendRects, blendOverlap);
+		vx_uint32 numBlendImages = GetMultibandImageCount(stitch);
+		vx_status status = GenerateBlendBuffers(numBlendImages, eqrWidth, eqrHeight * numCamera / numBlendImages, stitch->num_bands,
+			validPixelCamMap, paddedPixelCamMap, blendOverlap.data(), paddedCamOverlapInfo,
 			stitch->multibandBlendOffsetIntoBuffer, stitch->table_sizes.blendOffsetTableSize, blendOffsetTable);
 		ERROR_CHECK_STATUS_(vxUnmapArrayRange(stitch->blend_offsets, mapIdValid));
 		if (status != VX_SUCCESS) {
@@ -1376,59 +2123,13 @@ static vx_status InitializeInternalTablesForCamera(ls_context stitch)
 		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->valid_mask_image, map_id_mask));
 	}
 
-	// initialize blend mask image
-	if (stitch->blend_mask_image) {
-		vx_rectangle_t rectMask = { 0, 0, eqrWidth, eqrHeight * numCamera };
-		vx_imagepatch_addressing_t addrMask;
-		vx_map_id map_id_mask;
-		vx_uint8 * ptr_mask;
-		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->blend_mask_image, &rectMask, 0, &map_id_mask, &addrMask, (void **)&ptr_mask, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
-		memset(ptr_mask, 255, addrMask.stride_y * addrMask.dim_y);
-		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->blend_mask_image, map_id_mask));
-	}
-	{ // initialize RGBY1 & RGBY2 to invalid pixels and sync to GPU
-		vx_rectangle_t rect = { 0, 0, eqrWidth, eqrHeight * numCamera };
-		vx_imagepatch_addressing_t addr;
-		vx_map_id map_id;
-		vx_uint32 * ptr;
-		const __m128i r0 = _mm_set1_epi32(0x80000000);
-		ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->RGBY1, &rect, 0, &map_id, &addr, (void **)&ptr, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
-		__m128i *dst = (__m128i*) ptr;
-		vx_size size_in_bytes = (addr.stride_y * addr.dim_y)&~127;
-		for (vx_uint32 i = 0; i < size_in_bytes; i += 128){
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-			_mm_store_si128(dst++, r0);
-		}
-		ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->RGBY1, map_id));
-		if (stitch->RGBY2) {
-			ERROR_CHECK_STATUS_(vxMapImagePatch(stitch->RGBY2, &rect, 0, &map_id, &addr, (void **)&ptr, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
-			__m128i *dst = (__m128i*) ptr;
-			vx_size size_in_bytes = (addr.stride_y * addr.dim_y)&~127;
-			for (vx_uint32 i = 0; i < size_in_bytes; i += 128){
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-				_mm_store_si128(dst++, r0);
-			}
-			ERROR_CHECK_STATUS_(vxUnmapImagePatch(stitch->RGBY2, map_id));
-		}
-	}
+	ERROR_CHECK_STATUS_(InitializeConstantBuffersForCamera(stitch));
 	return VX_SUCCESS;
 }
 static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 {
-	// make sure to allocate internal buffers for initialize atleast once
-	if (!stitch->camSrcMap) {
+	// make sure to allocate internal buffers for initialize atleast once (not needed with shared tables)
+	if (!stitch->camSrcMap && !stitch->sharedTables) {
 		vx_status status = AllocateLensModelBuffersForCamera(stitch);
 		if (status)
 			return status;
@@ -1444,7 +2145,7 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 			vx_status status = CalculateLensDistortionAndWarpMaps(!stitch->USE_CPU_INIT ? stitch->stitchInitData : nullptr, stitch->num_cameras,
 				stitch->camera_rgb_buffer_width / stitch->num_camera_columns,
 				stitch->camera_rgb_buffer_height / stitch->num_camera_rows,
-				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
+				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, stitch->output_projection,
 				&stitch->rig_par, stitch->camera_par,
 				stitch->validPixelCamMap, stitch->paddingPixelCount, stitch->paddedPixelCamMap,
 				stitch->camSrcMap, stitch->camIndexTmpBuf, stitch->camIndexBuf);
@@ -1466,7 +2167,7 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 			if (stitch->EXPO_COMP) {
 				CalculateSmallestExpCompBufferSizes(stitch->num_cameras, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
 					stitch->validPixelCamMap, stitch->overlapValid, stitch->validCamOverlapInfo,
-					stitch->paddedPixelCamMap, stitch->overlapPadded, stitch->paddedCamOverlapInfo,
+					stitch->paddedPixelCamMap, stitch->overlapPadded, stitch->paddedCamOverlapInfo, stitch->EXPO_COMP_SUBSAMPLE,
 					&stitch->table_sizes.expCompValidTableSize, &stitch->table_sizes.expCompOverlapTableSize);
 				if (stitch->EXPO_COMP >= 3) {
 					// no overlap table needed
@@ -1481,27 +2182,28 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 					&stitch->table_sizes.seamFindPrefInfoTableSize, &stitch->table_sizes.seamFindPathTableSize);
 			}
 			if (stitch->MULTIBAND_BLEND) {
+				std::vector<vx_rectangle_t> blendRects;
+				std::vector<const vx_rectangle_t *> blendOverlap;
+				GetMultibandOverlapRegions(stitch, blendRects, blendOverlap);
+				vx_uint32 numBlendImages = GetMultibandImageCount(stitch);
 				ERROR_CHECK_ALLOC_(stitch->multibandBlendOffsetIntoBuffer = new vx_size[stitch->num_bands]());
-				CalculateSmallestBlendBufferSizes(stitch->num_cameras, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, stitch->num_bands,
-					stitch->validPixelCamMap, stitch->paddedPixelCamMap, stitch->overlapPadded, stitch->paddedCamOverlapInfo,
+				CalculateSmallestBlendBufferSizes(numBlendImages, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras / numBlendImages, stitch->num_bands,
+					stitch->validPixelCamMap, stitch->paddedPixelCamMap, blendOverlap.data(), stitch->paddedCamOverlapInfo,
 					stitch->multibandBlendOffsetIntoBuffer, &stitch->table_sizes.blendOffsetTableSize);
 			}
-			//If load Buffer - dump table sizes
-			if (stitch->SETUP_LOAD){
-				status = quickSetupDumpTableSizes(stitch);
-				if (status != VX_SUCCESS) {
-					vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: quickSetupDumpTableSizes() failed (%d)\n", status);
-					return status;
-				}
-			}
 		}
 		else{
-			//If load Buffer - load table sizes
+			// table sizes from the quick setup table cache
 			vx_status status = quickSetupLoadTableSizes(stitch);
 			if (status != VX_SUCCESS) {
 				vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: quickSetupLoadTableSizes() failed (%d)\n", status);
 				return status;
 			}
+			if (stitch->MULTIBAND_BLEND && stitch->sharedTables) {
+				ERROR_CHECK_ALLOC_(stitch->multibandBlendOffsetIntoBuffer = new vx_size[stitch->num_bands]());
+				const std::vector<vx_size>& blendOffsets = stitch->sharedTables->blendOffsets;
+				std::copy(blendOffsets.begin(), blendOffsets.begin() + std::min(blendOffsets.size(), (size_t)stitch->num_bands), stitch->multibandBlendOffsetIntoBuffer);
+			}
 		}
 	}
 	else
@@ -1520,7 +2222,8 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 		}
 		if (stitch->MULTIBAND_BLEND) {
 			ERROR_CHECK_ALLOC_(stitch->multibandBlendOffsetIntoBuffer = new vx_size[stitch->num_bands]());
-			CalculateLargestBlendBufferSizes(stitch->num_cameras, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, stitch->num_bands,
+			vx_uint32 numBlendImages = GetMultibandImageCount(stitch);
+			CalculateLargestBlendBufferSizes(numBlendImages, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras / numBlendImages, stitch->num_bands,
 				stitch->multibandBlendOffsetIntoBuffer, &stitch->table_sizes.blendOffsetTableSize);
 		}
 	}
@@ -1558,6 +2261,14 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 	ERROR_CHECK_TYPE_(StitchWarpRemapEntryType = vxRegisterUserStruct(stitch->context, sizeof(StitchWarpRemapEntry)));
 	ERROR_CHECK_OBJECT_(stitch->ValidPixelEntry = vxCreateArray(stitch->context, StitchValidPixelEntryType, stitch->table_sizes.warpTableSize));
 	ERROR_CHECK_OBJECT_(stitch->WarpRemapEntry = vxCreateArray(stitch->context, StitchWarpRemapEntryType, stitch->table_sizes.warpTableSize));
+	if (stitch->live_stitch_attr[LIVE_STITCH_ATTR_FUSED_WARP_MERGE] == 1.0f && stitch->EXPO_COMP < 3 && !stitch->MULTIBAND_BLEND && !stitch->SEAM_FIND) {
+		// the merge kernel samples the single camera pixels with these remap entries, so that the warp
+		// only processes the overlap pixels: exposure comp only reads the pixels valid in both cameras
+		// of an overlap, and the merge applies the gains of modes 1 and 2 to its samples (the block gains
+		// of modes 3 and 4, the multiband pyramids, and the 3x3 sobel of the seam find cost read the
+		// warped pixels around the overlaps as well)
+		ERROR_CHECK_OBJECT_(stitch->MergeRemapEntry = vxCreateArray(stitch->context, StitchWarpRemapEntryType, stitch->table_sizes.warpTableSize));
+	}
 	ERROR_CHECK_OBJECT_(stitch->RGBY1 = vxCreateImage(stitch->context, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras, VX_DF_IMAGE_RGBX));
 	// create data objects needed by merge kernel
 	ERROR_CHECK_OBJECT_(stitch->weight_image = vxCreateImage(stitch->context, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras, VX_DF_IMAGE_U8));
@@ -1575,7 +2286,9 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 			ERROR_CHECK_OBJECT_(stitch->OverlapPixelEntry = vxCreateArray(stitch->context, StitchOverlapPixelEntryType, stitch->table_sizes.expCompOverlapTableSize));
 		}
 		ERROR_CHECK_OBJECT_(stitch->overlap_matrix = vxCreateMatrix(stitch->context, VX_TYPE_INT32, stitch->num_cameras, stitch->num_cameras));
-		ERROR_CHECK_OBJECT_(stitch->RGBY2 = vxCreateImage(stitch->context, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras, VX_DF_IMAGE_RGBX));
+		if (!stitch->WARP_GAINS) {
+			ERROR_CHECK_OBJECT_(stitch->RGBY2 = vxCreateImage(stitch->context, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras, VX_DF_IMAGE_RGBX));
+		}
 		if (stitch->EXPO_COMP == 1) {
 			ERROR_CHECK_OBJECT_(stitch->A_matrix = vxCreateMatrix(stitch->context, VX_TYPE_INT32, stitch->num_cameras, stitch->num_cameras));
 			ERROR_CHECK_ALLOC_(stitch->A_matrix_initial_value = new vx_int32[stitch->num_cameras * stitch->num_cameras]());
@@ -1589,6 +2302,14 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 		// create gain array
 		ERROR_CHECK_OBJECT_(stitch->gain_array = vxCreateArray(stitch->context, VX_TYPE_FLOAT32, stitch->num_cameras * stitch->EXPO_COMP_GAINW * stitch->EXPO_COMP_GAINH*stitch->EXPO_COMP_GAINC));
 		ERROR_CHECK_STATUS_(vxAddArrayItems(stitch->gain_array, stitch->num_cameras*stitch->EXPO_COMP_GAINW * stitch->EXPO_COMP_GAINC *stitch->EXPO_COMP_GAINH, &one, 0));
+		if (stitch->WARP_GAINS && stitch->EXPO_COMP < 3) {
+			// the warp runs before the gains of the frame are solved, so it applies the gains solved for the previous frame
+			ERROR_CHECK_OBJECT_(stitch->gain_delay = vxCreateDelay(stitch->context, (vx_reference)stitch->gain_array, 2));
+			for (vx_int32 slot = 0; slot > -2; slot--) {
+				vx_array arr = (vx_array)vxGetReferenceFromDelay(stitch->gain_delay, slot);
+				ERROR_CHECK_STATUS_(vxAddArrayItems(arr, stitch->num_cameras*stitch->EXPO_COMP_GAINW * stitch->EXPO_COMP_GAINC *stitch->EXPO_COMP_GAINH, &one, 0));
+			}
+		}
 	}
 	// create data objects needed by seamfind kernel
 	if (stitch->SEAM_FIND) {
@@ -1636,12 +2357,13 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 		ERROR_CHECK_ALLOC_(stitch->pStitchMultiband = new StitchMultibandData[stitch->num_bands]());
 		memset(stitch->pStitchMultiband, 0, sizeof(StitchMultibandData)*stitch->num_bands);
 		stitch->pStitchMultiband[0].WeightPyrImgGaussian = stitch->SEAM_FIND ? stitch->seamfind_weight_image : stitch->weight_image;	// for level#0: weight image is mask image after seem find
-		stitch->pStitchMultiband[0].DstPyrImgGaussian = stitch->EXPO_COMP ? stitch->RGBY2 : stitch->RGBY1;			// for level#0: dst image is image after exposure_comp
+		stitch->pStitchMultiband[0].DstPyrImgGaussian = stitch->RGBY2 ? stitch->RGBY2 : stitch->RGBY1;			// for level#0: dst image is image after exposure_comp
 		ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[0].DstPyrImgLaplacian = CreateAlignedImage(stitch, stitch->output_rgb_buffer_width, (stitch->output_rgb_buffer_height * stitch->num_cameras), 8, VX_DF_IMAGE_RGB4_AMD, VX_MEMORY_TYPE_OPENCL));
 		ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[0].DstPyrImgLaplacianRec = CreateAlignedImage(stitch, stitch->output_rgb_buffer_width, (stitch->output_rgb_buffer_height * stitch->num_cameras), 8, VX_DF_IMAGE_RGBX, VX_MEMORY_TYPE_OPENCL));
+		vx_uint32 numBlendImages = GetMultibandImageCount(stitch), blendImageHeight = stitch->output_rgb_buffer_height * stitch->num_cameras / numBlendImages;
 		for (vx_int32 level = 1, levelAlign = 1; level < stitch->num_bands; level++, levelAlign = ((levelAlign << 1) | 1)) {
 			vx_uint32 width_l = (stitch->output_rgb_buffer_width + levelAlign) >> level;
-			vx_uint32 height_l = ((stitch->output_rgb_buffer_height + levelAlign) >> level) * stitch->num_cameras;
+			vx_uint32 height_l = ((blendImageHeight + levelAlign) >> level) * numBlendImages;
 			ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[level].WeightPyrImgGaussian = CreateAlignedImage(stitch, width_l, height_l, 16, VX_DF_IMAGE_U8, VX_MEMORY_TYPE_OPENCL));
 			ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[level].DstPyrImgGaussian = CreateAlignedImage(stitch, width_l, height_l, 8, VX_DF_IMAGE_RGBX, VX_MEMORY_TYPE_OPENCL));
 			ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[level].DstPyrImgLaplacian = CreateAlignedImage(stitch, width_l, height_l, 8, VX_DF_IMAGE_RGB4_AMD, VX_MEMORY_TYPE_OPENCL));
@@ -1659,7 +2381,7 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 
 	if (!stitch->SETUP_LOAD_FILES_FOUND){
 		// initialize internal tables
-		status = InitializeInternalTablesForCamera(stitch);
+		status = InitializeInternalTablesForCamera(stitch, 0xffffffff);
 		if (status != VX_SUCCESS) {
 			vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: InitializeInternalTablesForCamera() failed (%d)\n", status);
 			return status;
@@ -1671,13 +2393,27 @@ static vx_status AllocateInternalTablesForCamera(ls_context stitch)
 				return status;
 			}
 		}
+		if (stitch->SHARE_TABLES){
+			status = SharedTablesPublish(stitch);
+			if (status != VX_SUCCESS) {
+				vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: SharedTablesPublish() failed (%d)\n", status);
+				return status;
+			}
+		}
 	}
 	else{
+		if (SharedTablesHaveObjects(stitch)) {
+			ERROR_CHECK_STATUS_(SharedTablesUseObjects(stitch));
+		}
 		status = quickSetupLoadTables(stitch);
 		if (status != VX_SUCCESS) {
 			vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: AllocateInternalTablesForCamera: quickSetupLoadTables() failed (%d)\n", status);
 			return status;
 		}
+		if (stitch->sharedTables) {
+			// the shared tables don't include the buffers that start with a constant value
+			ERROR_CHECK_STATUS_(InitializeConstantBuffersForCamera(stitch));
+		}
 	}
 
 	if (!stitch->feature_enable_reinitialize) {
@@ -1788,10 +2524,1100 @@ static vx_status EncodeProcessImage(ls_context stitch)
 		} 
 		src_tile_start_y += src_tile_height;
 	}
-	stitch->num_encode_sections = roi_img;
-	
+	stitch->num_encode_sections = roi_img;
+	
+	return VX_SUCCESS;
+}
+/*****************************************************************************************************************************************
+functions for output tile jobs
+*****************************************************************************************************************************************/
+static vx_status CreateTileJobs(ls_context stitch)
+{
+	vx_uint32 numX = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_X];
+	vx_uint32 numY = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_Y];
+	vx_uint32 width = stitch->output_rgb_buffer_width, height = stitch->output_rgb_buffer_height;
+	bool encode = (stitch->output_encode_tiles > 1);
+	if (numX < 1 || numY < 1 || numX * numY > LS_MAX_TILE_JOBS || width / numX < 2 || height / numY < 2) {
+		ls_printf("ERROR: lsInitialize: tile jobs: invalid number of tiles %dx%d for %dx%d output (max %d tiles)\n", numX, numY, width, height, LS_MAX_TILE_JOBS);
+		return VX_ERROR_INVALID_PARAMETERS;
+	}
+	// tile regions: with encode, the encode tile rectangles with overlap (see EncodeProcessImage), otherwise
+	// the output split at even pixel positions (for the YUV formats) without overlap
+	vx_uint32 overlap = encode ? (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_src_tile_overlap] : 0;
+	vx_uint32 dst_tile_width = encode ? (vx_uint32)(stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_ENCODER_WIDTH] / numX) : width;
+	vx_uint32 dst_tile_height = encode ? (vx_uint32)(stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_ENCODER_HEIGHT] / numY) : height;
+	stitch->numTileJobs = numX * numY;
+	ERROR_CHECK_ALLOC_(stitch->tileJobs = new ls_tile_job[stitch->numTileJobs]);
+	memset(stitch->tileJobs, 0, stitch->numTileJobs * sizeof(ls_tile_job));
+	for (vx_uint32 j = 0; j < numY; j++) {
+		for (vx_uint32 i = 0; i < numX; i++) {
+			ls_tile_job * job = &stitch->tileJobs[j * numX + i];
+			vx_int32 start_x, end_x, start_y, end_y;
+			if (encode) {
+				vx_int32 src_tile_width = (vx_int32)(width / numX), src_tile_height = (vx_int32)(height / numY);
+				start_x = (vx_int32)i * src_tile_width - (vx_int32)overlap; end_x = (vx_int32)(i + 1) * src_tile_width + (vx_int32)overlap;
+				start_y = std::max(0, (vx_int32)j * src_tile_height - (vx_int32)overlap);
+				end_y = std::min((vx_int32)height, (vx_int32)(j + 1) * src_tile_height + (vx_int32)overlap);
+			}
+			else {
+				start_x = (i * width / numX) & ~1; end_x = (i + 1 == numX) ? width : (((i + 1) * width / numX) & ~1);
+				start_y = (j * height / numY) & ~1; end_y = (j + 1 == numY) ? height : (((j + 1) * height / numY) & ~1);
+			}
+			job->start_x = start_x; job->start_y = start_y;
+			job->width = end_x - start_x; job->height = end_y - start_y;
+			if (job->width > dst_tile_width || job->height > dst_tile_height) {
+				ls_printf("ERROR: lsInitialize: tile jobs: tile %dx%d with overlap doesn't fit in %dx%d encoder tile\n", job->width, job->height, dst_tile_width, dst_tile_height);
+				return VX_ERROR_INVALID_PARAMETERS;
+			}
+			// tile graph: remap from camera images, and color conversion into the tile region of the output
+			ERROR_CHECK_OBJECT_(job->graph = vxCreateGraph(stitch->context));
+			if (stitch->live_stitch_attr[LIVE_STITCH_ATTR_PROFILER] == 2.0f) {
+				ERROR_CHECK_STATUS_(vxDirective((vx_reference)job->graph, VX_DIRECTIVE_AMD_ENABLE_PROFILE_CAPTURE));
+			}
+			ERROR_CHECK_OBJECT_(job->remap = vxCreateRemap(stitch->context, stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height, job->width, job->height));
+			vx_rectangle_t rect = { (vx_uint32)start_x, (vx_uint32)start_y, (vx_uint32)end_x, (vx_uint32)end_y };
+			if (encode) {
+				rect.start_x = 0; rect.start_y = 0; rect.end_x = job->width; rect.end_y = job->height;
+				ERROR_CHECK_OBJECT_(job->output = vxCreateImageFromROI(stitch->encodetileOutput[j * numX + i], &rect));
+			}
+			else {
+				ERROR_CHECK_OBJECT_(job->output = vxCreateImageFromROI(stitch->Img_output, &rect));
+			}
+			if (stitch->output_buffer_format == VX_DF_IMAGE_RGB) {
+				ERROR_CHECK_OBJECT_(job->remapNode = vxRemapNode(job->graph, stitch->rgb_input, job->remap, VX_INTERPOLATION_TYPE_BILINEAR, job->output));
+			}
+			else {
+				ERROR_CHECK_OBJECT_(job->rgb = vxCreateVirtualImage(job->graph, job->width, job->height, VX_DF_IMAGE_RGB));
+				ERROR_CHECK_OBJECT_(job->remapNode = vxRemapNode(job->graph, stitch->rgb_input, job->remap, VX_INTERPOLATION_TYPE_BILINEAR, job->rgb));
+				if (stitch->output_buffer_format == VX_DF_IMAGE_NV12 || stitch->output_buffer_format == VX_DF_IMAGE_IYUV)
+					job->colorConvertNode = vxColorConvertNode(job->graph, job->rgb, job->output);
+				else
+					job->colorConvertNode = stitchColorConvertNode(job->graph, job->rgb, job->output);
+				ERROR_CHECK_OBJECT_(job->colorConvertNode);
+			}
+		}
+	}
+	// one thread per core at most: the pool hands out the remaining tiles as the threads get free
+	vx_uint32 numThreads = std::max(1u, std::min(stitch->numTileJobs, (vx_uint32)std::thread::hardware_concurrency()));
+	ERROR_CHECK_ALLOC_(stitch->tileJobPool = new StitchThreadPool(numThreads));
+	return VX_SUCCESS;
+}
+static vx_status ProcessTileJobs(ls_context stitch)
+{
+	// input color conversion and noise filter of the complete camera images, then the tile graphs
+	if (stitch->InputColorConvertNode || stitch->noiseFilterNode) {
+		ERROR_CHECK_STATUS_(vxProcessGraph(stitch->graphStitch));
+	}
+	ls_tile_job * tileJobs = stitch->tileJobs;
+	stitch->tileJobPool->Run(stitch->numTileJobs, [tileJobs](vx_uint32 i) {
+		tileJobs[i].status = vxProcessGraph(tileJobs[i].graph);
+	});
+	for (vx_uint32 i = 0; i < stitch->numTileJobs; i++) {
+		if (tileJobs[i].status != VX_SUCCESS) {
+			ls_printf("ERROR: tile job %d failed (%d)\n", i, tileJobs[i].status);
+			return tileJobs[i].status;
+		}
+	}
+	return VX_SUCCESS;
+}
+static vx_status ReleaseTileJobs(ls_context stitch)
+{
+	if (stitch->tileJobPool) { delete stitch->tileJobPool; stitch->tileJobPool = nullptr; }
+	if (stitch->tileJobs) {
+		for (vx_uint32 i = 0; i < stitch->numTileJobs; i++) {
+			ls_tile_job * job = &stitch->tileJobs[i];
+			if (job->remapNode) ERROR_CHECK_STATUS_(vxReleaseNode(&job->remapNode));
+			if (job->colorConvertNode) ERROR_CHECK_STATUS_(vxReleaseNode(&job->colorConvertNode));
+			if (job->rgb) ERROR_CHECK_STATUS_(vxReleaseImage(&job->rgb));
+			if (job->output) ERROR_CHECK_STATUS_(vxReleaseImage(&job->output));
+			if (job->remap) ERROR_CHECK_STATUS_(vxReleaseRemap(&job->remap));
+			if (job->graph) ERROR_CHECK_STATUS_(vxReleaseGraph(&job->graph));
+		}
+		delete[] stitch->tileJobs;
+		stitch->tileJobs = nullptr;
+		stitch->numTileJobs = 0;
+	}
+	return VX_SUCCESS;
+}
+
+/*****************************************************************************************************************************************
+functions for overlay regions
+*****************************************************************************************************************************************/
+// Calculate the output regions covered by the overlays from the overlay index map: the bounding rectangles of the
+// connected tiles with overlay pixels, merged until none overlap and at most LS_MAX_OVERLAY_REGIONS are left
+static void CalculateOverlayRegions(ls_context stitch, std::vector<vx_rectangle_t>& regions)
+{
+	vx_uint32 width = stitch->output_rgb_buffer_width, height = stitch->output_rgb_buffer_height;
+	vx_uint32 numX = (width + LS_OVERLAY_REGION_TILE_WIDTH - 1) / LS_OVERLAY_REGION_TILE_WIDTH;
+	vx_uint32 numY = (height + LS_OVERLAY_REGION_TILE_HEIGHT - 1) / LS_OVERLAY_REGION_TILE_HEIGHT;
+	std::vector<vx_uint8> tileCovered(numX * numY, 0);
+	for (vx_uint32 y = 0; y < height; y++) {
+		const vx_uint8 * overlayIndex = stitch->overlayIndexBuf + y * width;
+		vx_uint8 * tileRow = tileCovered.data() + (y / LS_OVERLAY_REGION_TILE_HEIGHT) * numX;
+		for (vx_uint32 x = 0; x < width; x++) {
+			if (overlayIndex[x] < stitch->num_overlays)
+				tileRow[x / LS_OVERLAY_REGION_TILE_WIDTH] = 1;
+		}
+	}
+	// bounding rectangles of the connected tiles (in tile units)
+	regions.clear();
+	std::vector<vx_uint32> stack;
+	for (vx_uint32 tile = 0; tile < numX * numY; tile++) {
+		if (tileCovered[tile] != 1) continue;
+		vx_rectangle_t rect = { tile % numX, tile / numX, tile % numX + 1, tile / numX + 1 };
+		tileCovered[tile] = 2;
+		stack.push_back(tile);
+		while (!stack.empty()) {
+			vx_uint32 tx = stack.back() % numX, ty = stack.back() / numX;
+			stack.pop_back();
+			rect.start_x = std::min(rect.start_x, tx); rect.end_x = std::max(rect.end_x, tx + 1);
+			rect.start_y = std::min(rect.start_y, ty); rect.end_y = std::max(rect.end_y, ty + 1);
+			for (vx_uint32 ny = (ty > 0 ? ty - 1 : 0); ny <= std::min(ty + 1, numY - 1); ny++) {
+				for (vx_uint32 nx = (tx > 0 ? tx - 1 : 0); nx <= std::min(tx + 1, numX - 1); nx++) {
+					if (tileCovered[ny * numX + nx] == 1) {
+						tileCovered[ny * numX + nx] = 2;
+						stack.push_back(ny * numX + nx);
+					}
+				}
+			}
+		}
+		regions.push_back(rect);
+	}
+	// merge the overlapping rectangles, then the rectangles with least area increase
+	auto area = [](const vx_rectangle_t& r) { return (vx_uint64)(r.end_x - r.start_x) * (r.end_y - r.start_y); };
+	auto merge = [](const vx_rectangle_t& a, const vx_rectangle_t& b) {
+		vx_rectangle_t r = { std::min(a.start_x, b.start_x), std::min(a.start_y, b.start_y), std::max(a.end_x, b.end_x), std::max(a.end_y, b.end_y) };
+		return r;
+	};
+	if (regions.size() > 16 * LS_MAX_OVERLAY_REGIONS) {
+		for (size_t i = 1; i < regions.size(); i++)
+			regions[0] = merge(regions[0], regions[i]);
+		regions.resize(1);
+	}
+	for (;;) {
+		size_t bestI = 0, bestJ = 0; vx_uint64 bestCost = ~0ull; bool overlap = false;
+		for (size_t i = 0; i < regions.size() && !overlap; i++) {
+			for (size_t j = i + 1; j < regions.size() && !overlap; j++) {
+				const vx_rectangle_t& a = regions[i], & b = regions[j];
+				overlap = a.start_x < b.end_x && b.start_x < a.end_x && a.start_y < b.end_y && b.start_y < a.end_y;
+				vx_uint64 cost = overlap ? 0 : area(merge(a, b)) - area(a) - area(b);
+				if (cost < bestCost) { bestI = i; bestJ = j; bestCost = cost; }
+			}
+		}
+		if (!overlap && regions.size() <= LS_MAX_OVERLAY_REGIONS)
+			break;
+		regions[bestI] = merge(regions[bestI], regions[bestJ]);
+		regions.erase(regions.begin() + bestJ);
+	}
+	// tile units to pixels
+	for (vx_rectangle_t& rect : regions) {
+		rect.start_x *= LS_OVERLAY_REGION_TILE_WIDTH; rect.end_x = std::min(width, rect.end_x * LS_OVERLAY_REGION_TILE_WIDTH);
+		rect.start_y *= LS_OVERLAY_REGION_TILE_HEIGHT; rect.end_y = std::min(height, rect.end_y * LS_OVERLAY_REGION_TILE_HEIGHT);
+	}
+}
+// Set the overlay remap points of an output region from the overlay lens models
+static void SetRemapPointsForOverlayRegion(ls_context stitch, vx_remap remap, const vx_rectangle_t& rect)
+{
+	vx_uint32 overlayWidth = stitch->overlay_buffer_width / stitch->num_overlay_columns;
+	vx_uint32 overlayHeight = stitch->overlay_buffer_height / stitch->num_overlay_rows;
+	vx_uint32 x_offset[LIVE_STITCH_MAX_CAMERAS], y_offset[LIVE_STITCH_MAX_CAMERAS];
+	for (vx_uint32 i = 0; i < stitch->num_overlays; i++) {
+		x_offset[i] = (i % stitch->num_overlay_columns) * overlayWidth;
+		y_offset[i] = (i / stitch->num_overlay_columns) * overlayHeight;
+	}
+	SetRemapPointsForRegion(remap, (vx_int32)rect.start_x, rect.start_y, rect.end_x - rect.start_x, rect.end_y - rect.start_y,
+		stitch->num_overlays, x_offset, y_offset, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
+		stitch->overlaySrcMap, stitch->overlayIndexBuf, nullptr, 0xffffffff);
+}
+// Create the overlay regions from the overlay lens models: when the regions cover most of the output (or nothing),
+// the complete output is warped with overlay_remap instead
+static vx_status CreateOverlayRegions(ls_context stitch)
+{
+	vx_uint32 width = stitch->output_rgb_buffer_width, height = stitch->output_rgb_buffer_height;
+	std::vector<vx_rectangle_t> regions;
+	CalculateOverlayRegions(stitch, regions);
+	vx_uint64 regionArea = 0;
+	for (const vx_rectangle_t& rect : regions)
+		regionArea += (vx_uint64)(rect.end_x - rect.start_x) * (rect.end_y - rect.start_y);
+	if (regions.empty() || regionArea * 4 > (vx_uint64)width * height * 3) {
+		vx_rectangle_t rect = { 0, 0, width, height };
+		ERROR_CHECK_OBJECT_(stitch->overlay_remap = vxCreateRemap(stitch->context, stitch->overlay_buffer_width, stitch->overlay_buffer_height, width, height));
+		ERROR_CHECK_OBJECT_(stitch->Img_overlay_rgba = vxCreateVirtualImage(stitch->graphStitch, width, height, VX_DF_IMAGE_RGBX));
+		SetRemapPointsForOverlayRegion(stitch, stitch->overlay_remap, rect);
+		return VX_SUCCESS;
+	}
+	// warped overlay image: only the region ROIs are written by the remap nodes and read by the alpha blend
+	stitch->numOverlayRegions = (vx_uint32)regions.size();
+	ERROR_CHECK_ALLOC_(stitch->overlayRegions = new ls_overlay_region[stitch->numOverlayRegions]);
+	memset(stitch->overlayRegions, 0, stitch->numOverlayRegions * sizeof(ls_overlay_region));
+	ERROR_CHECK_OBJECT_(stitch->Img_overlay_rgba = vxCreateImage(stitch->context, width, height, VX_DF_IMAGE_RGBX));
+	// room for the dirty rectangles of a frame: the parts of a region in several dirty rectangles are separate items
+	ERROR_CHECK_OBJECT_(stitch->overlay_region_array = vxCreateArray(stitch->context, VX_TYPE_RECTANGLE, 2 * stitch->numOverlayRegions));
+	ERROR_CHECK_STATUS_(vxAddArrayItems(stitch->overlay_region_array, stitch->numOverlayRegions, regions.data(), sizeof(vx_rectangle_t)));
+	for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++) {
+		ls_overlay_region * region = &stitch->overlayRegions[i];
+		region->rect = regions[i];
+		ERROR_CHECK_OBJECT_(region->remap = vxCreateRemap(stitch->context, stitch->overlay_buffer_width, stitch->overlay_buffer_height,
+			region->rect.end_x - region->rect.start_x, region->rect.end_y - region->rect.start_y));
+		ERROR_CHECK_OBJECT_(region->output = vxCreateImageFromROI(stitch->Img_overlay_rgba, &region->rect));
+		SetRemapPointsForOverlayRegion(stitch, region->remap, region->rect);
+	}
+	return VX_SUCCESS;
+}
+static vx_status ReleaseOverlayRegions(ls_context stitch)
+{
+	if (stitch->overlayRegions) {
+		for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++) {
+			ls_overlay_region * region = &stitch->overlayRegions[i];
+			if (region->remapNode) ERROR_CHECK_STATUS_(vxReleaseNode(&region->remapNode));
+			if (region->output) ERROR_CHECK_STATUS_(vxReleaseImage(&region->output));
+			if (region->remap) ERROR_CHECK_STATUS_(vxReleaseRemap(&region->remap));
+		}
+		delete[] stitch->overlayRegions;
+		stitch->overlayRegions = nullptr;
+		stitch->numOverlayRegions = 0;
+	}
+	if (stitch->overlay_region_array) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->overlay_region_array));
+	return VX_SUCCESS;
+}
+// Set the rectangles blended by the alpha blend of the frame: the parts of the overlay regions in the dirty rectangles
+// of the frame, or the complete regions when no dirty rectangles were set
+static vx_status ApplyOverlayDirtyRects(ls_context stitch)
+{
+	if (!stitch->overlay_region_array || (!stitch->overlayDirtyRequested && !stitch->overlayDirtyApplied))
+		return VX_SUCCESS;
+	vx_size capacity = 0;
+	ERROR_CHECK_STATUS_(vxQueryArray(stitch->overlay_region_array, VX_ARRAY_ATTRIBUTE_CAPACITY, &capacity, sizeof(capacity)));
+	std::vector<vx_rectangle_t> rects;
+	for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++) {
+		const vx_rectangle_t& region = stitch->overlayRegions[i].rect;
+		if (!stitch->overlayDirtyRequested) {
+			rects.push_back(region);
+			continue;
+		}
+		// when the array capacity would be exceeded, use the bounding rectangle of the parts of the region
+		size_t first = rects.size();
+		for (vx_uint32 j = 0; j < stitch->overlayDirty.count; j++) {
+			const vx_rectangle_t& dirty = stitch->overlayDirty.rect[j];
+			vx_rectangle_t rect = {
+				std::max(region.start_x, dirty.start_x), std::max(region.start_y, dirty.start_y),
+				std::min(region.end_x, dirty.end_x), std::min(region.end_y, dirty.end_y)
+			};
+			if (rect.start_x < rect.end_x && rect.start_y < rect.end_y)
+				rects.push_back(rect);
+		}
+		if (rects.size() - first > 1 && rects.size() + stitch->numOverlayRegions - i - 1 > capacity) {
+			for (size_t k = first + 1; k < rects.size(); k++) {
+				rects[first].start_x = std::min(rects[first].start_x, rects[k].start_x);
+				rects[first].start_y = std::min(rects[first].start_y, rects[k].start_y);
+				rects[first].end_x = std::max(rects[first].end_x, rects[k].end_x);
+				rects[first].end_y = std::max(rects[first].end_y, rects[k].end_y);
+			}
+			rects.resize(first + 1);
+		}
+	}
+	ERROR_CHECK_STATUS_(vxTruncateArray(stitch->overlay_region_array, 0));
+	if (!rects.empty()) {
+		ERROR_CHECK_STATUS_(vxAddArrayItems(stitch->overlay_region_array, rects.size(), rects.data(), sizeof(vx_rectangle_t)));
+	}
+	stitch->overlayDirtyApplied = stitch->overlayDirtyRequested;
+	stitch->overlayDirtyRequested = false;
+	return VX_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Preview output: the stitched RGB output is downscaled by 1/N with an area downscale node averaging every
+// NxN block, so the preview is free of aliasing and shares the seams, gains, and overlays of the frame
+static vx_status CreatePreview(ls_context stitch, vx_image source)
+{
+	vx_uint32 scale = stitch->preview_scale;
+	stitch->preview_buffer_width = stitch->output_rgb_buffer_width / scale;
+	stitch->preview_buffer_height = stitch->output_rgb_buffer_height / scale;
+	if (stitch->preview_buffer_width < 1 || stitch->preview_buffer_height < 1) {
+		ls_printf("ERROR: lsInitialize: preview scale 1/%d of %dx%d output is empty\n", scale, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height);
+		return VX_ERROR_INVALID_DIMENSION;
+	}
+	// preview buffer from the user OpenCL buffer
+	vx_imagepatch_addressing_t addr_preview = { 0 };
+	void *ptr[1] = { nullptr };
+	addr_preview.dim_x = stitch->preview_buffer_width;
+	addr_preview.dim_y = stitch->preview_buffer_height;
+	addr_preview.stride_x = 3;
+	addr_preview.stride_y = stitch->preview_buffer_width * 3;
+	ERROR_CHECK_OBJECT_(stitch->Img_preview = vxCreateImageFromHandle(stitch->context, VX_DF_IMAGE_RGB, &addr_preview, ptr, VX_MEMORY_TYPE_OPENCL));
+	ERROR_CHECK_OBJECT_(stitch->nodePreviewDownscale = stitchAreaDownscaleNode(stitch->graphStitch, scale, source, stitch->Img_preview));
+	return VX_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Viewport restriction: trim the warp, exposure comp apply, and blend tables to the selected output tiles
+static void ViewportCalculateTileMask(ls_context stitch, const ls_viewport_params& par, vx_uint8 * tileMask)
+{
+	const ls_viewport& vp = stitch->viewport;
+	vx_uint32 width = stitch->output_rgb_buffer_width, height = stitch->output_rgb_buffer_height;
+	vx_float32 margin = stitch->live_stitch_attr[LIVE_STITCH_ATTR_VIEWPORT_MARGIN];
+	const float deg2rad = (float)M_PI / 180.0f;
+	float maxAz = std::min(180.0f, par.hfov * 0.5f + margin) * deg2rad;
+	float maxEl = std::min(90.0f, par.vfov * 0.5f + margin) * deg2rad;
+	float cy = cosf(par.yaw * deg2rad), sy = sinf(par.yaw * deg2rad);
+	float cp = cosf(par.pitch * deg2rad), sp = sinf(par.pitch * deg2rad);
+	memset(tileMask, 0, vp.tileCountX * vp.tileCountY);
+	// sample each continuous region of the output projection separately: the cube faces are not continuous
+	vx_rectangle_t regions[6];
+	vx_uint32 regionCount = GetOutputProjectionRegions(stitch->output_projection, width, height, regions);
+	for (vx_uint32 region = 0; region < regionCount; region++) {
+		const vx_rectangle_t& rc = regions[region];
+		for (vx_uint32 ys = rc.start_y; ys < rc.end_y + LS_VIEWPORT_SAMPLE_STEP; ys += LS_VIEWPORT_SAMPLE_STEP) {
+			vx_uint32 y = std::min(ys, rc.end_y);
+			for (vx_uint32 xs = rc.start_x; xs < rc.end_x + LS_VIEWPORT_SAMPLE_STEP; xs += LS_VIEWPORT_SAMPLE_STEP) {
+				vx_uint32 x = std::min(xs, rc.end_x);
+				// rotate the direction of the sample into viewport coordinates (+Y up): yaw first, then pitch
+				float dir[3];
+				CalculateOutputDirection(stitch->output_projection, width, height, rc, (float)x, (float)y, dir);
+				float dx = dir[0], dy = -dir[1], dz = dir[2];
+				float vx = dx * cy - dz * sy, vz = dx * sy + dz * cy;
+				float vy = dy * cp - vz * sp; vz = dy * sp + vz * cp;
+				float az = atan2f(vx, vz), el = atan2f(vy, sqrtf(vx * vx + vz * vz));
+				if (fabsf(az) <= maxAz && fabsf(el) <= maxEl) {
+					// mark all tiles of the region that share the sample
+					vx_uint32 tx0 = ((x > rc.start_x) ? x - 1 : x) / LS_VIEWPORT_TILE_WIDTH, tx1 = std::min(x, rc.end_x - 1) / LS_VIEWPORT_TILE_WIDTH;
+					vx_uint32 ty0 = ((y > rc.start_y) ? y - 1 : y) / LS_VIEWPORT_TILE_HEIGHT, ty1 = std::min(y, rc.end_y - 1) / LS_VIEWPORT_TILE_HEIGHT;
+					for (vx_uint32 ty = ty0; ty <= ty1; ty++)
+						for (vx_uint32 tx = tx0; tx <= tx1; tx++)
+							tileMask[ty * vp.tileCountX + tx] = 1;
+				}
+			}
+		}
+	}
+}
+static bool ViewportTilesSelected(const ls_viewport& vp, vx_uint32 x0, vx_uint32 y0, vx_uint32 x1, vx_uint32 y1)
+{
+	// check if any tile touched by the output rectangle [x0,x1)x[y0,y1) is selected
+	vx_uint32 tx1 = std::min((x1 - 1) / LS_VIEWPORT_TILE_WIDTH, vp.tileCountX - 1);
+	vx_uint32 ty1 = std::min((y1 - 1) / LS_VIEWPORT_TILE_HEIGHT, vp.tileCountY - 1);
+	for (vx_uint32 ty = y0 / LS_VIEWPORT_TILE_HEIGHT; ty <= ty1; ty++)
+		for (vx_uint32 tx = x0 / LS_VIEWPORT_TILE_WIDTH; tx <= tx1; tx++)
+			if (vp.tileMask[ty * vp.tileCountX + tx])
+				return true;
+	return false;
+}
+template <typename F>
+static vx_size ViewportSelectEntries(vx_size count, vx_size * index, F isSelected)
+{
+	// keep at least one entry so that the kernel work size stays non-zero
+	vx_size numSelected = 0;
+	for (vx_size i = 0; i < count; i++)
+		if (isSelected(i))
+			index[numSelected++] = i;
+	if (numSelected == 0 && count > 0)
+		index[numSelected++] = 0;
+	return numSelected;
+}
+template <typename T>
+static vx_status ViewportSaveArray(vx_array arr, T *& items, vx_size& count)
+{
+	ERROR_CHECK_STATUS_(vxQueryArray(arr, VX_ARRAY_ATTRIBUTE_NUMITEMS, &count, sizeof(count)));
+	ERROR_CHECK_ALLOC_(items = new T[count > 0 ? count : 1]);
+	if (count > 0) {
+		vx_map_id map_id = 0;
+		vx_size stride = 0;
+		T * ptr = nullptr;
+		ERROR_CHECK_STATUS_(vxMapArrayRange(arr, 0, count, &map_id, &stride, (void **)&ptr, VX_READ_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+		memcpy(items, ptr, count * sizeof(T));
+		ERROR_CHECK_STATUS_(vxUnmapArrayRange(arr, map_id));
+	}
+	return VX_SUCCESS;
+}
+template <typename T>
+static vx_status ViewportWriteArray(vx_array arr, const T * items, const vx_size * index, vx_size count)
+{
+	// replace the array contents with items[index[i]] or items[i] without index
+	ERROR_CHECK_STATUS_(vxTruncateArray(arr, 0));
+	if (count > 0) {
+		if (index) {
+			T * buf = nullptr;
+			ERROR_CHECK_ALLOC_(buf = new T[count]);
+			for (vx_size i = 0; i < count; i++)
+				buf[i] = items[index[i]];
+			vx_status status = vxAddArrayItems(arr, count, buf, sizeof(T));
+			delete[] buf;
+			if (status != VX_SUCCESS)
+				return status;
+		}
+		else {
+			ERROR_CHECK_STATUS_(vxAddArrayItems(arr, count, items, sizeof(T)));
+		}
+	}
+	return VX_SUCCESS;
+}
+static vx_status ViewportWriteTables(ls_context stitch, bool trim)
+{
+	const ls_viewport& vp = stitch->viewport;
+	if (!trim) {
+		// restore the complete tables
+		ERROR_CHECK_STATUS_(ViewportWriteArray(stitch->ValidPixelEntry, vp.warpValid, nullptr, vp.warpCount));
+		ERROR_CHECK_STATUS_(ViewportWriteArray(stitch->WarpRemapEntry, vp.warpRemap, nullptr, vp.warpCount));
+		if (vp.expCompValid) ERROR_CHECK_STATUS_(ViewportWriteArray(stitch->valid_array, vp.expCompValid, nullptr, vp.expCompCount));
+		if (vp.blendOffsets) ERROR_CHECK_STATUS_(ViewportWriteArray(stitch->blend_offsets, vp.blendOffsets, nullptr, vp.blendCount));
+		return VX_SUCCESS;
+	}
+	vx_size * index = nullptr;
+	ERROR_CHECK_ALLOC_(index = new vx_size[std::max(std::max(vp.warpCount, vp.expCompCount), (vx_size)1)]);
+	// warp entries: 8 pixels of a row
+	vx_size count = ViewportSelectEntries(vp.warpCount, index, [&](vx_size i) {
+		const StitchValidPixelEntry& e = vp.warpValid[i];
+		return ViewportTilesSelected(vp, e.dstX << 3, e.dstY, (e.dstX << 3) + 8, e.dstY + 1);
+	});
+	vx_status status = ViewportWriteArray(stitch->ValidPixelEntry, vp.warpValid, index, count);
+	if (status == VX_SUCCESS)
+		status = ViewportWriteArray(stitch->WarpRemapEntry, vp.warpRemap, index, count);
+	// exposure comp apply entries: pixels within a 128x32 block
+	if (status == VX_SUCCESS && vp.expCompValid) {
+		count = ViewportSelectEntries(vp.expCompCount, index, [&](vx_size i) {
+			const StitchExpCompCalcEntry& e = vp.expCompValid[i];
+			vx_uint32 x = (e.dstX << 3) + e.start_x, y = (e.dstY << 1) + e.start_y;
+			return ViewportTilesSelected(vp, x, y, x + e.end_x + 1, y + e.end_y + 1);
+		});
+		status = ViewportWriteArray(stitch->valid_array, vp.expCompValid, index, count);
+	}
+	delete[] index;
+	if (status != VX_SUCCESS)
+		return status;
+	// blend entries: 64x16 blocks of each pyramid level compacted in place, with entry count before the level offset
+	if (vp.blendOffsets) {
+		StitchBlendValidEntry * blendOffsets = nullptr;
+		ERROR_CHECK_ALLOC_(blendOffsets = new StitchBlendValidEntry[vp.blendCount]);
+		memcpy(blendOffsets, vp.blendOffsets, vp.blendCount * sizeof(StitchBlendValidEntry));
+		for (vx_int32 level = 0; level < stitch->num_bands; level++) {
+			vx_size offset = stitch->multibandBlendOffsetIntoBuffer[level];
+			const StitchBlendValidEntry * entry = &vp.blendOffsets[offset];
+			vx_size numEntries = *(const vx_uint32 *)&entry[-1], numSelected = 0;
+			for (vx_size i = 0; i < numEntries; i++) {
+				const StitchBlendValidEntry& e = entry[i];
+				if (ViewportTilesSelected(vp, e.dstX << level, e.dstY << level, (e.dstX + e.last_x + 1) << level, (e.dstY + e.last_y + 1) << level))
+					blendOffsets[offset + numSelected++] = e;
+			}
+			if (numSelected == 0 && numEntries > 0)
+				numSelected = 1;
+			*((vx_uint64 *)&blendOffsets[offset - 1]) = numSelected;
+		}
+		status = ViewportWriteArray(stitch->blend_offsets, blendOffsets, nullptr, vp.blendCount);
+		delete[] blendOffsets;
+		if (status != VX_SUCCESS)
+			return status;
+	}
+	return VX_SUCCESS;
+}
+//! \brief Freeze the exposure comp gains and the seams while the tables are trimmed: the warp only updates the
+//  selected tiles of the warped images, so the gains and seams would be computed from stale pixels elsewhere.
+static vx_status ViewportFreezeGainsAndSeams(ls_context stitch, bool freeze)
+{
+	ls_viewport& vp = stitch->viewport;
+	// exposure comp: the solver keeps the gains of the previous frame with smoothing 1
+	if (stitch->ExpcompSolveGainNode) {
+		vx_scalar smoothing = (vx_scalar)avxGetNodeParamRef(stitch->ExpcompSolveGainNode, 5);
+		ERROR_CHECK_OBJECT_(smoothing);
+		vx_float32 value = freeze ? 1.0f : stitch->gain_smoothing;
+		vx_status status = vxWriteScalarValue(smoothing, &value);
+		vxReleaseScalar(&smoothing);
+		if (status != VX_SUCCESS)
+			return status;
+	}
+	// seam find: the overlaps with priority -1 keep their seams
+	if (stitch->seamfind_pref_array && freeze != (vp.seamPriority != nullptr)) {
+		vx_size count = 0;
+		ERROR_CHECK_STATUS_(vxQueryArray(stitch->seamfind_pref_array, VX_ARRAY_ATTRIBUTE_NUMITEMS, &count, sizeof(count)));
+		if (freeze) {
+			ERROR_CHECK_ALLOC_(vp.seamPriority = new vx_int16[std::max(count, (vx_size)1)]);
+			vp.seamCount = count;
+		}
+		if (count > 0 && count == vp.seamCount) {
+			vx_map_id map_id;
+			vx_size stride = 0;
+			StitchSeamFindPreference * pref = nullptr;
+			ERROR_CHECK_STATUS_(vxMapArrayRange(stitch->seamfind_pref_array, 0, count, &map_id, &stride, (void **)&pref, VX_READ_AND_WRITE, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+			for (vx_size i = 0; i < count; i++) {
+				if (freeze) {
+					vp.seamPriority[i] = pref[i].priority;
+					pref[i].priority = -1;
+				}
+				else pref[i].priority = vp.seamPriority[i];
+			}
+			ERROR_CHECK_STATUS_(vxUnmapArrayRange(stitch->seamfind_pref_array, map_id));
+		}
+		if (!freeze) {
+			delete[] vp.seamPriority;
+			vp.seamPriority = nullptr;
+		}
+	}
+	return VX_SUCCESS;
+}
+static vx_status ViewportReleaseTables(ls_context stitch, bool restore)
+{
+	ls_viewport& vp = stitch->viewport;
+	if (restore && vp.restricted) {
+		ERROR_CHECK_STATUS_(ViewportWriteTables(stitch, false));
+		ERROR_CHECK_STATUS_(ViewportFreezeGainsAndSeams(stitch, false));
+	}
+	vp.restricted = false;
+	vp.saved = false;
+	if (vp.warpValid) { delete[] vp.warpValid; vp.warpValid = nullptr; }
+	if (vp.warpRemap) { delete[] vp.warpRemap; vp.warpRemap = nullptr; }
+	if (vp.expCompValid) { delete[] vp.expCompValid; vp.expCompValid = nullptr; }
+	if (vp.blendOffsets) { delete[] vp.blendOffsets; vp.blendOffsets = nullptr; }
+	if (vp.seamPriority) { delete[] vp.seamPriority; vp.seamPriority = nullptr; }
+	if (vp.tileMask) { delete[] vp.tileMask; vp.tileMask = nullptr; }
+	if (vp.tileMaskNext) { delete[] vp.tileMaskNext; vp.tileMaskNext = nullptr; }
+	return VX_SUCCESS;
+}
+static vx_status ApplyViewport(ls_context stitch)
+{
+	ls_viewport& vp = stitch->viewport;
+	const ls_viewport_params& par = vp.requested;
+	if (par.hfov <= 0 || par.vfov <= 0) {
+		// complete output
+		if (vp.restricted) {
+			ERROR_CHECK_STATUS_(ViewportWriteTables(stitch, false));
+			ERROR_CHECK_STATUS_(ViewportFreezeGainsAndSeams(stitch, false));
+			vp.restricted = false;
+		}
+		return VX_SUCCESS;
+	}
+	if (!stitch->ValidPixelEntry || (vp.restricted && !memcmp(&par, &vp.applied, sizeof(par)))) {
+		// nothing to trim in simple stitch mode or tables are already trimmed for this viewport
+		return VX_SUCCESS;
+	}
+	if (SharedTablesHaveObjects(stitch)) {
+		// the tables are used by other contexts too
+		ls_printf("ERROR: lsSetViewport: viewport is not supported with tables shared by LIVE_STITCH_ATTR_SHARE_INIT_TABLES\n");
+		return VX_ERROR_NOT_SUPPORTED;
+	}
+	if (!vp.saved) {
+		// save the complete tables before the first trim
+		vp.tileCountX = (stitch->output_rgb_buffer_width + LS_VIEWPORT_TILE_WIDTH - 1) / LS_VIEWPORT_TILE_WIDTH;
+		vp.tileCountY = (stitch->output_rgb_buffer_height + LS_VIEWPORT_TILE_HEIGHT - 1) / LS_VIEWPORT_TILE_HEIGHT;
+		ERROR_CHECK_ALLOC_(vp.tileMask = new vx_uint8[vp.tileCountX * vp.tileCountY]);
+		ERROR_CHECK_ALLOC_(vp.tileMaskNext = new vx_uint8[vp.tileCountX * vp.tileCountY]);
+		ERROR_CHECK_STATUS_(ViewportSaveArray(stitch->ValidPixelEntry, vp.warpValid, vp.warpCount));
+		ERROR_CHECK_STATUS_(ViewportSaveArray(stitch->WarpRemapEntry, vp.warpRemap, vp.warpCount));
+		if (stitch->EXPO_COMP && stitch->valid_array) ERROR_CHECK_STATUS_(ViewportSaveArray(stitch->valid_array, vp.expCompValid, vp.expCompCount));
+		if (stitch->MULTIBAND_BLEND && stitch->blend_offsets) ERROR_CHECK_STATUS_(ViewportSaveArray(stitch->blend_offsets, vp.blendOffsets, vp.blendCount));
+		vp.saved = true;
+	}
+	// rewrite the tables only when the tile selection changes
+	ViewportCalculateTileMask(stitch, par, vp.tileMaskNext);
+	bool changed = !vp.restricted || memcmp(vp.tileMask, vp.tileMaskNext, vp.tileCountX * vp.tileCountY) != 0;
+	std::swap(vp.tileMask, vp.tileMaskNext);
+	if (changed) {
+		ERROR_CHECK_STATUS_(ViewportWriteTables(stitch, true));
+	}
+	if (!vp.restricted) {
+		ERROR_CHECK_STATUS_(ViewportFreezeGainsAndSeams(stitch, true));
+	}
+	vp.restricted = true;
+	vp.applied = par;
+	return VX_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Frame processing helpers shared by lsScheduleFrame/lsWaitForCompletion and the frame pipeline
+static vx_status SwapCameraBuffer(ls_context stitch, const cl_mem * input_buffer)
+{
+	// switch the user specified OpenCL buffer into image
+	if (stitch->camera_buffer_format == VX_DF_IMAGE_NV12) {
+		void * ptr_in[] = { input_buffer ? input_buffer[0] : nullptr, input_buffer ? input_buffer[1] : nullptr };
+		ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_input, ptr_in, nullptr, 2));
+	}
+	else {
+		void * ptr_in[] = { input_buffer ? input_buffer[0] : nullptr };
+		ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_input, ptr_in, nullptr, 1));
+	}
+	return VX_SUCCESS;
+}
+static vx_status SwapOutputBuffer(ls_context stitch, const cl_mem * output_buffer)
+{
+	// switch the user specified OpenCL buffer into image
+	if (stitch->output_buffer_format == VX_DF_IMAGE_NV12) {
+		if (stitch->output_encode_tiles > 1) {
+			for (vx_uint32 i = 0; i < stitch->output_encode_tiles; i++){
+				void * ptr_out[] = { output_buffer ? output_buffer[(i * 2)] : nullptr, output_buffer ? output_buffer[(i * 2) + 1] : nullptr };
+				ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->encodetileOutput[i], ptr_out, nullptr, 2));
+			}
+		}
+		else {
+			void * ptr_out[] = { output_buffer ? output_buffer[0] : nullptr, output_buffer ? output_buffer[1] : nullptr };
+			ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_output, ptr_out, nullptr, 2));
+		}
+	}
+	else {
+		void * ptr_out[] = { output_buffer ? output_buffer[0] : nullptr };
+		ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_output, ptr_out, nullptr, 1));
+	}
+	return VX_SUCCESS;
+}
+static vx_status SwapImageBuffer(vx_image img, const cl_mem * buffer)
+{
+	// switch the user specified OpenCL buffer into image
+	void * ptr[] = { buffer ? buffer[0] : nullptr };
+	ERROR_CHECK_STATUS_(vxSwapImageHandle(img, ptr, nullptr, 1));
+	return VX_SUCCESS;
+}
+static vx_status PrepareFrame(ls_context stitch)
+{
+	// trim the tables to the viewport of the frame
+	ERROR_CHECK_STATUS_(ApplyViewport(stitch));
+
+	// blend the overlays only in the dirty rectangles of the frame
+	ERROR_CHECK_STATUS_(ApplyOverlayDirtyRects(stitch));
+
+	// seamfind needs frame counter values to be incremented
+	if (stitch->SEAM_FIND) {
+		ERROR_CHECK_STATUS_(vxWriteScalarValue(stitch->current_frame, &stitch->current_frame_value));
+		stitch->current_frame_value++;
+	}
+
+	// exposure comp expects A_matrix to be initialized to ZERO on GPU
+	if ((stitch->EXPO_COMP <= 2) && stitch->A_matrix) {
+		ERROR_CHECK_STATUS_(vxWriteMatrix(stitch->A_matrix, stitch->A_matrix_initial_value));
+		ERROR_CHECK_STATUS_(vxDirective((vx_reference)stitch->A_matrix, VX_DIRECTIVE_AMD_COPY_TO_OPENCL));
+	}
+
+	// age delay element if temporal noise filter activated
+	if (stitch->NOISE_FILTER){
+		ERROR_CHECK_STATUS_(vxAgeDelay(stitch->noiseFilterImageDelay));
+	}
+
+	// the gains solved by the previous frame become the gains applied by the warp
+	if (stitch->gain_delay) {
+		ERROR_CHECK_STATUS_(vxAgeDelay(stitch->gain_delay));
+	}
+	return VX_SUCCESS;
+}
+//////////////////////////////////////////////////////////////////////
+// Graph nodes of the stitch with their stage (see ls_stage_times):
+// nodes with index refer to multiband levels and encode sections
+enum { STAGE_WARP, STAGE_MERGE, STAGE_EXPCOMP, STAGE_SEAMFIND, STAGE_MULTIBAND, STAGE_OTHER };
+struct StitchGraphNode {
+	const char * name;
+	vx_node node;
+	vx_int32 index;
+	vx_uint32 stage;
+};
+static const vx_uint32 maxGraphNodes = 64 + MAX_TILE_IMG + 2 * LS_MAX_TILE_JOBS + LS_MAX_OVERLAY_REGIONS;
+static vx_uint32 GetGraphNodes(ls_context stitch, StitchGraphNode * list)
+{
+	vx_uint32 count = 0;
+	auto add = [&](const char * n, vx_node nd, vx_int32 i, vx_uint32 stage) { if (nd && count < maxGraphNodes) { list[count].name = n; list[count].node = nd; list[count].index = i; list[count].stage = stage; count++; } };
+	add("InputColorConvert", stitch->InputColorConvertNode, -1, STAGE_OTHER);
+	add("NoiseFilter", stitch->noiseFilterNode, -1, STAGE_OTHER);
+	add("LoomIoCamera", stitch->nodeLoomIoCamera, -1, STAGE_OTHER);
+	add("LoomIoOverlay", stitch->nodeLoomIoOverlay, -1, STAGE_OTHER);
+	add("SimpleStitchRemap", stitch->SimpleStitchRemapNode, -1, STAGE_WARP);
+	for (vx_uint32 i = 0; i < stitch->numTileJobs; i++) {
+		add("TileRemap", stitch->tileJobs[i].remapNode, (vx_int32)i, STAGE_WARP);
+		add("TileColorConvert", stitch->tileJobs[i].colorConvertNode, (vx_int32)i, STAGE_OTHER);
+	}
+	add("OverlayRemap", stitch->nodeOverlayRemap, -1, STAGE_OTHER);
+	for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++)
+		add("OverlayRegionRemap", stitch->overlayRegions[i].remapNode, (vx_int32)i, STAGE_OTHER);
+	add("Warp", stitch->WarpNode, -1, STAGE_WARP);
+	add("ExpcompComputeGain", stitch->ExpcompComputeGainNode, -1, STAGE_EXPCOMP);
+	add("ExpcompSolveGain", stitch->ExpcompSolveGainNode, -1, STAGE_EXPCOMP);
+	add("ExpcompApplyGain", stitch->ExpcompApplyGainNode, -1, STAGE_EXPCOMP);
+	add("Merge", stitch->MergeNode, -1, STAGE_MERGE);
+	add("Sobel", stitch->SobelNode, -1, STAGE_SEAMFIND);
+	add("Magnitude", stitch->MagnitudeNode, -1, STAGE_SEAMFIND);
+	add("Phase", stitch->PhaseNode, -1, STAGE_SEAMFIND);
+	add("ConvertDepth", stitch->ConvertDepthNode, -1, STAGE_SEAMFIND);
+	add("SeamfindAnalyze", stitch->SeamfindAnalyzeNode, -1, STAGE_SEAMFIND);
+	add("SeamfindStep1", stitch->SeamfindStep1Node, -1, STAGE_SEAMFIND);
+	add("SeamfindStep2", stitch->SeamfindStep2Node, -1, STAGE_SEAMFIND);
+	add("SeamfindStep3", stitch->SeamfindStep3Node, -1, STAGE_SEAMFIND);
+	add("SeamfindStep4", stitch->SeamfindStep4Node, -1, STAGE_SEAMFIND);
+	add("SeamfindStep5", stitch->SeamfindStep5Node, -1, STAGE_SEAMFIND);
+	if (stitch->pStitchMultiband) {
+		for (vx_int32 level = 0; level < stitch->num_bands; level++) {
+			const StitchMultibandData& mb = stitch->pStitchMultiband[level];
+			add("MultibandWeightHSG", mb.WeightHSGNode, level, STAGE_MULTIBAND);
+			add("MultibandSourceHSG", mb.SourceHSGNode, level, STAGE_MULTIBAND);
+			add("MultibandUpscaleSubtract", mb.UpscaleSubtractNode, level, STAGE_MULTIBAND);
+			add("MultibandBlend", mb.BlendNode, level, STAGE_MULTIBAND);
+			add("MultibandUpscaleAdd", mb.UpscaleAddNode, level, STAGE_MULTIBAND);
+			add("MultibandLaplacianRecon", mb.LaplacianReconNode, level, STAGE_MULTIBAND);
+		}
+	}
+	add("OverlayBlend", stitch->nodeOverlayBlend, -1, STAGE_OTHER);
+	add("ChromaKeyMask", stitch->chromaKey_mask_generation_node, -1, STAGE_OTHER);
+	add("ChromaKeyErode", stitch->chromaKey_erode_node, -1, STAGE_OTHER);
+	add("ChromaKeyDilate", stitch->chromaKey_dilate_node, -1, STAGE_OTHER);
+	add("ChromaKeyMerge", stitch->chromaKey_merge_node, -1, STAGE_OTHER);
+	add("OutputColorConvert", stitch->OutputColorConvertNode, -1, STAGE_OTHER);
+	add("PreviewDownscale", stitch->nodePreviewDownscale, -1, STAGE_OTHER);
+	for (vx_uint32 i = 0; i < stitch->num_encode_sections && i < MAX_TILE_IMG; i++)
+		add("EncodeColorConvert", stitch->encode_color_convert_nodes[i], (vx_int32)i, STAGE_OTHER);
+	add("LoomIoOutput", stitch->nodeLoomIoOutput, -1, STAGE_OTHER);
+	add("LoomIoViewing", stitch->nodeLoomIoViewing, -1, STAGE_OTHER);
+	return count;
+}
+
+// Query the OpenVX node timings of the last processed frame: nodes without timings get num = 0
+static void QueryGraphNodePerf(const StitchGraphNode * list, vx_uint32 count, vx_perf_t * perf)
+{
+	for (vx_uint32 i = 0; i < count; i++) {
+		if (vxQueryNode(list[i].node, VX_NODE_ATTRIBUTE_PERFORMANCE, &perf[i], sizeof(perf[i])) != VX_SUCCESS || perf[i].num == 0 || perf[i].end < perf[i].beg)
+			perf[i].num = 0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Memory usage (see lsGetMemoryUsage): OpenVX data objects are counted once, in the first category that
+// lists them, in device memory when the kernels using them run on the GPU and in host memory otherwise.
+// Tables initialized on the host keep a host copy as well. Images of user OpenCL buffers and image ROIs
+// don't own memory and aren't listed.
+static vx_uint64 GetImageMemorySize(vx_df_image format, vx_uint32 width, vx_uint32 height)
+{
+	vx_uint64 pixels = (vx_uint64)width * height;
+	switch (format) {
+	case VX_DF_IMAGE_U1_AMD: return (vx_uint64)((width + 7) >> 3) * height;
+	case VX_DF_IMAGE_U8: return pixels;
+	case VX_DF_IMAGE_NV12: case VX_DF_IMAGE_NV21: case VX_DF_IMAGE_IYUV: return pixels * 3 / 2;
+	case VX_DF_IMAGE_U16: case VX_DF_IMAGE_S16: case VX_DF_IMAGE_UYVY: case VX_DF_IMAGE_YUYV: return pixels * 2;
+	case VX_DF_IMAGE_RGB: case VX_DF_IMAGE_YUV4: return pixels * 3;
+	case VX_DF_IMAGE_RGB4_AMD: return pixels * 6;
+	default: return pixels * 4;
+	}
+}
+static vx_status GetReferenceMemorySize(vx_reference ref, vx_uint64& size)
+{
+	vx_enum type;
+	ERROR_CHECK_STATUS_(vxQueryReference(ref, VX_REFERENCE_TYPE, &type, sizeof(type)));
+	size = 0;
+	if (type == VX_TYPE_IMAGE) {
+		vx_df_image format = VX_DF_IMAGE_VIRT;
+		vx_uint32 width = 0, height = 0;
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_FORMAT, &format, sizeof(format)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_WIDTH, &width, sizeof(width)));
+		ERROR_CHECK_STATUS_(vxQueryImage((vx_image)ref, VX_IMAGE_ATTRIBUTE_HEIGHT, &height, sizeof(height)));
+		size = GetImageMemorySize(format, width, height);
+	}
+	else if (type == VX_TYPE_ARRAY) {
+		vx_size capacity = 0, itemSize = 0;
+		ERROR_CHECK_STATUS_(vxQueryArray((vx_array)ref, VX_ARRAY_ITEMSIZE, &itemSize, sizeof(itemSize)));
+		ERROR_CHECK_STATUS_(vxQueryArray((vx_array)ref, VX_ARRAY_CAPACITY, &capacity, sizeof(capacity)));
+		size = (vx_uint64)capacity * itemSize;
+	}
+	else if (type == VX_TYPE_MATRIX) {
+		vx_size matSize = 0;
+		ERROR_CHECK_STATUS_(vxQueryMatrix((vx_matrix)ref, VX_MATRIX_SIZE, &matSize, sizeof(matSize)));
+		size = matSize;
+	}
+	else if (type == VX_TYPE_REMAP) {
+		vx_uint32 dstWidth = 0, dstHeight = 0;
+		ERROR_CHECK_STATUS_(vxQueryRemap((vx_remap)ref, VX_REMAP_DESTINATION_WIDTH, &dstWidth, sizeof(dstWidth)));
+		ERROR_CHECK_STATUS_(vxQueryRemap((vx_remap)ref, VX_REMAP_DESTINATION_HEIGHT, &dstHeight, sizeof(dstHeight)));
+		size = (vx_uint64)dstWidth * dstHeight * 2 * sizeof(vx_float32);
+	}
+	return VX_SUCCESS;
+}
+static bool IsKernelTargetCpu(const char * envName)
+{
+	char textBuffer[256];
+	return StitchGetEnvironmentVariable(envName, textBuffer, sizeof(textBuffer)) && atoi(textBuffer) != 0;
+}
+static vx_status GetMemoryUsage(ls_context stitch, ls_memory_usage * usage)
+{
+	memset(usage, 0, sizeof(*usage));
+	cl_context opencl_context = nullptr;
+	bool gpu = vxQueryContext(stitch->context, VX_CONTEXT_ATTRIBUTE_AMD_OPENCL_CONTEXT, &opencl_context, sizeof(opencl_context)) == VX_SUCCESS && opencl_context;
+	std::vector<vx_reference> counted;
+	vx_status status = VX_SUCCESS;
+	// onGpu: the kernels using the object run on the GPU; hostCopy: the object is initialized on the host
+	auto addRef = [&](ls_memory_size& m, vx_reference ref, bool onGpu, bool hostCopy) {
+		if (!ref || status != VX_SUCCESS || std::find(counted.begin(), counted.end(), ref) != counted.end()) return;
+		counted.push_back(ref);
+		vx_uint64 size = 0;
+		status = GetReferenceMemorySize(ref, size);
+		if (gpu && onGpu) m.device += size;
+		if (!(gpu && onGpu) || hostCopy) m.host += size;
+	};
+	auto addHost = [&](ls_memory_size& m, const void * buf, vx_uint64 size) { if (buf) m.host += size; };
+	const vx_uint64 pixels = (vx_uint64)stitch->output_rgb_buffer_width * stitch->output_rgb_buffer_height;
+	const vx_uint64 numCamSq = (vx_uint64)stitch->num_cameras * stitch->num_cameras;
+	const ls_viewport& vp = stitch->viewport;
+
+	// warp tables, remap tables, lens model buffers, and GPU initialize data
+	bool warpGpu = !IsKernelTargetCpu("WARP_TARGET");
+	addRef(usage->warp, (vx_reference)stitch->ValidPixelEntry, warpGpu, true);
+	addRef(usage->warp, (vx_reference)stitch->WarpRemapEntry, warpGpu, true);
+	// warp and exposure comp output images (counted before the multiband level 0 images that alias them)
+	addRef(usage->intermediate, (vx_reference)stitch->RGBY1, warpGpu, true);
+	addRef(usage->intermediate, (vx_reference)stitch->RGBY2, true, true);
+	addRef(usage->warp, (vx_reference)stitch->camera_remap, true, true);
+	addRef(usage->warp, (vx_reference)stitch->overlay_remap, true, true);
+	for (vx_uint32 i = 0; i < stitch->numTileJobs; i++)
+		addRef(usage->warp, (vx_reference)stitch->tileJobs[i].remap, true, true);
+	for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++)
+		addRef(usage->warp, (vx_reference)stitch->overlayRegions[i].remap, true, true);
+	if (stitch->stitchInitData) {
+		addRef(usage->warp, (vx_reference)stitch->stitchInitData->ValidPixelMap, true, false);
+		addRef(usage->warp, (vx_reference)stitch->stitchInitData->PaddedPixMap, true, false);
+		addRef(usage->warp, (vx_reference)stitch->stitchInitData->DefaultCamMap, true, false);
+		addRef(usage->warp, (vx_reference)stitch->stitchInitData->SrcCoordMap, true, false);
+		addRef(usage->warp, (vx_reference)stitch->stitchInitData->CameraParamsArr, true, true);
+		addRef(usage->warp, (vx_reference)stitch->stitchInitData->CameraZBuffArr, true, false);
+	}
+	addHost(usage->warp, stitch->camSrcMap, pixels * stitch->num_cameras * sizeof(StitchCoord2dFloat));
+	addHost(usage->warp, stitch->validPixelCamMap, pixels * sizeof(vx_uint32));
+	addHost(usage->warp, stitch->paddedPixelCamMap, pixels * sizeof(vx_uint32));
+	addHost(usage->warp, stitch->camIndexTmpBuf, pixels * sizeof(vx_float32));
+	addHost(usage->warp, stitch->camIndexBuf, pixels * sizeof(vx_uint8));
+	addHost(usage->warp, stitch->overlapRectBuf, 2 * numCamSq * sizeof(vx_rectangle_t));
+	addHost(usage->warp, stitch->overlaySrcMap, pixels * stitch->num_overlays * sizeof(StitchCoord2dFloat));
+	addHost(usage->warp, stitch->validPixelOverlayMap, pixels * sizeof(vx_uint32));
+	addHost(usage->warp, stitch->overlayIndexTmpBuf, pixels * sizeof(vx_float32));
+	addHost(usage->warp, stitch->overlayIndexBuf, pixels * sizeof(vx_uint8));
+	addHost(usage->warp, vp.tileMask, (vx_uint64)vp.tileCountX * vp.tileCountY);
+	addHost(usage->warp, vp.tileMaskNext, (vx_uint64)vp.tileCountX * vp.tileCountY);
+	addHost(usage->warp, vp.warpValid, vp.warpCount * sizeof(StitchValidPixelEntry));
+	addHost(usage->warp, vp.warpRemap, vp.warpCount * sizeof(StitchWarpRemapEntry));
+
+	// merge tables
+	addRef(usage->merge, (vx_reference)stitch->cam_id_image, true, true);
+	addRef(usage->merge, (vx_reference)stitch->group1_image, true, true);
+	addRef(usage->merge, (vx_reference)stitch->group2_image, true, true);
+	addRef(usage->merge, (vx_reference)stitch->MergeRemapEntry, true, true);
+	addRef(usage->merge, (vx_reference)stitch->weight_image, true, true);
+
+	// exposure compensation tables, matrices, and gains: the gain solver runs on the CPU
+	addRef(usage->expcomp, (vx_reference)stitch->valid_array, true, true);
+	addRef(usage->expcomp, (vx_reference)stitch->OverlapPixelEntry, true, true);
+	addRef(usage->expcomp, (vx_reference)stitch->overlap_matrix, false, true);
+	addRef(usage->expcomp, (vx_reference)stitch->A_matrix, false, true);
+	addRef(usage->expcomp, (vx_reference)stitch->gain_array, true, true);
+	if (stitch->gain_delay) {
+		addRef(usage->expcomp, vxGetReferenceFromDelay(stitch->gain_delay, 0), true, true);
+		addRef(usage->expcomp, vxGetReferenceFromDelay(stitch->gain_delay, -1), true, true);
+	}
+	addHost(usage->expcomp, stitch->overlapMatrixBuf, numCamSq * sizeof(vx_int32));
+	addHost(usage->expcomp, stitch->A_matrix_initial_value, numCamSq * (stitch->EXPO_COMP == 2 ? 3 : 1) * sizeof(vx_int32));
+	addHost(usage->expcomp, vp.expCompValid, vp.expCompCount * sizeof(StitchExpCompCalcEntry));
+	if (stitch->ExpcompSolveGainNode) {
+		// gain solver buffers of the node
+		CExpCompensator * exp_comp = nullptr;
+		if (vxQueryNode(stitch->ExpcompSolveGainNode, VX_NODE_ATTRIBUTE_LOCAL_DATA_PTR, &exp_comp, sizeof(exp_comp)) == VX_SUCCESS && exp_comp)
+			usage->expcomp.host += exp_comp->GetHostMemorySize();
+	}
+
+	// seam find tables and images
+	bool seamGpu = !IsKernelTargetCpu("SEAM_FIND_TARGET");
+	addRef(stitch->SEAM_FIND ? usage->seamfind : usage->expcomp, (vx_reference)stitch->valid_mask_image, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->overlap_rect_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_valid_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_weight_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_accum_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_pref_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_info_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_path_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_scene_array, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->seamfind_weight_image, seamGpu, true);
+	addRef(usage->seamfind, (vx_reference)stitch->warp_luma_image, true, false);
+	addRef(usage->seamfind, (vx_reference)stitch->sobelx_image, true, false);
+	addRef(usage->seamfind, (vx_reference)stitch->sobely_image, true, false);
+	addRef(usage->seamfind, (vx_reference)stitch->sobel_magnitude_s16_image, true, false);
+	addRef(usage->seamfind, (vx_reference)stitch->sobel_magnitude_image, true, false);
+	addRef(usage->seamfind, (vx_reference)stitch->sobel_phase_image, true, false);
+
+	// multiband blend pyramids, masks, and offsets: level 0 gaussian images are the merge/seam find weights and the warp/expcomp output
+	bool blendGpu = GetBlendTargetAffinity() != AGO_TARGET_AFFINITY_CPU;
+	addRef(usage->multiband, (vx_reference)stitch->blend_offsets, blendGpu, true);
+	addRef(usage->multiband, (vx_reference)stitch->blend_mask_image, blendGpu, true);
+	if (stitch->pStitchMultiband) {
+		for (vx_int32 level = 0; level < stitch->num_bands; level++) {
+			const StitchMultibandData& mb = stitch->pStitchMultiband[level];
+			addRef(usage->multiband, (vx_reference)mb.WeightPyrImgGaussian, blendGpu, false);
+			addRef(usage->multiband, (vx_reference)mb.DstPyrImgGaussian, blendGpu, false);
+			addRef(usage->multiband, (vx_reference)mb.DstPyrImgLaplacian, blendGpu, false);
+			addRef(usage->multiband, (vx_reference)mb.DstPyrImgLaplacianRec, blendGpu, false);
+		}
+	}
+	addHost(usage->multiband, stitch->multibandBlendOffsetIntoBuffer, stitch->num_bands * sizeof(vx_size));
+	addHost(usage->multiband, vp.blendOffsets, vp.blendCount * sizeof(StitchBlendValidEntry));
+
+	// LoomIO buffers: the images of the user OpenCL buffers aren't counted
+	if (stitch->nodeLoomIoCamera) addRef(usage->loomio, (vx_reference)stitch->Img_input, true, false);
+	if (stitch->nodeLoomIoOverlay) addRef(usage->loomio, (vx_reference)stitch->Img_overlay, true, false);
+	if (stitch->nodeLoomIoOutput) addRef(usage->loomio, (vx_reference)stitch->Img_output, true, false);
+	addRef(usage->loomio, (vx_reference)stitch->loomioCameraAuxData, false, true);
+	addRef(usage->loomio, (vx_reference)stitch->loomioOverlayAuxData, false, true);
+	addRef(usage->loomio, (vx_reference)stitch->loomioOutputAuxData, false, true);
+	addRef(usage->loomio, (vx_reference)stitch->loomioViewingAuxData, false, true);
+
+	// intermediate images
+	bool colorConvertGpu = GetColorConvertTargetAffinity() != AGO_TARGET_AFFINITY_CPU;
+	addRef(usage->intermediate, (vx_reference)stitch->Img_input_rgb, colorConvertGpu, false);
+	addRef(usage->intermediate, (vx_reference)stitch->Img_output_rgb, colorConvertGpu, false);
+	bool alphaBlendGpu = !IsKernelTargetCpu("ALPHA_BLEND_TARGET");
+	addRef(usage->intermediate, (vx_reference)stitch->Img_overlay_rgb, alphaBlendGpu, false);
+	addRef(usage->intermediate, (vx_reference)stitch->Img_overlay_rgba, true, !alphaBlendGpu);
+	addRef(usage->other, (vx_reference)stitch->overlay_region_array, alphaBlendGpu, true);
+	if (stitch->noiseFilterImageDelay) {
+		bool noiseFilterGpu = !IsKernelTargetCpu("NOISE_FILTER_TARGET");
+		addRef(usage->intermediate, vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, 0), noiseFilterGpu, false);
+		addRef(usage->intermediate, vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, -1), noiseFilterGpu, false);
+	}
+	bool chromaKeyGpu = GetChromaKeyTargetAffinity() != AGO_TARGET_AFFINITY_CPU;
+	addRef(usage->intermediate, (vx_reference)stitch->chroma_key_input_RGB_img, chromaKeyGpu, false);
+	addRef(usage->intermediate, (vx_reference)stitch->chroma_key_mask_img, chromaKeyGpu, false);
+	addRef(usage->intermediate, (vx_reference)stitch->chroma_key_dilate_mask_img, chromaKeyGpu, false);
+	addRef(usage->intermediate, (vx_reference)stitch->chroma_key_erode_mask_img, chromaKeyGpu, false);
+	for (vx_uint32 i = 0; i < stitch->numTileJobs; i++)
+		addRef(usage->intermediate, (vx_reference)stitch->tileJobs[i].rgb, colorConvertGpu, false);
+
+	// quick setup table cache mapping and shared tables (counted by each context using them)
+	addHost(usage->other, stitch->tableCache.data, stitch->tableCache.size);
+	if (stitch->sharedTables) {
+		addHost(usage->other, stitch->sharedTables->record.data(), stitch->sharedTables->record.size());
+		addHost(usage->other, stitch->sharedTables->blendOffsets.data(), stitch->sharedTables->blendOffsets.size() * sizeof(vx_size));
+	}
+	if (status != VX_SUCCESS)
+		return status;
+
+	for (const ls_memory_size * m = &usage->warp; m < &usage->total; m++) {
+		usage->total.host += m->host;
+		usage->total.device += m->device;
+	}
+	return VX_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Profiler: add the OpenVX node timings of the last processed frame on per node tracks,
+// with the timestamps of the OpenVX implementation shifted to end at the frame completion
+static void ProfileGraphNodes(ls_context stitch)
+{
+	if (!PROFILER_RECORDING()) return;
+	StitchGraphNode list[maxGraphNodes];
+	vx_perf_t perf[maxGraphNodes];
+	vx_uint32 count = GetGraphNodes(stitch, list);
+	QueryGraphNodePerf(list, count, perf);
+	vx_uint64 endMax = 0;
+	for (vx_uint32 i = 0; i < count; i++) {
+		if (perf[i].num > 0)
+			endMax = std::max(endMax, perf[i].end);
+	}
+	__int64 shift = PROFILER_CLOCK() - (__int64)endMax;
+	for (vx_uint32 i = 0; i < count; i++) {
+		if (perf[i].num > 0) {
+			char trackName[64];
+			if (list[i].index >= 0)
+				sprintf(trackName, "%s[%d]", list[i].name, list[i].index);
+			else
+				sprintf(trackName, "%s", list[i].name);
+			PROFILER_NODE(PROFILER_TRACK(trackName), (__int64)perf[i].beg + shift, perf[i].end - perf[i].beg);
+		}
+	}
+}
+
+static vx_status CompleteFrame(ls_context stitch)
+{
+	// profile: node timings of the frame
+	if (stitch->live_stitch_attr[LIVE_STITCH_ATTR_PROFILER]) {
+		ProfileGraphNodes(stitch);
+	}
+	// debug: dump auxiliary data
+	if (stitch->loomioAuxDumpFile) {
+		vx_array auxList[] = { stitch->loomioCameraAuxData, stitch->loomioOverlayAuxData, stitch->loomioOutputAuxData, stitch->loomioViewingAuxData };
+		for (size_t i = 0; i < sizeof(auxList) / sizeof(auxList[0]); i++) {
+			if (auxList[i]) {
+				vx_size numItems = 0;
+				ERROR_CHECK_STATUS_(vxQueryArray(auxList[i], VX_ARRAY_NUMITEMS, &numItems, sizeof(numItems)));
+				if (numItems > 0) {
+					vx_map_id map_id = 0;
+					vx_size stride = 0;
+					char * ptr = nullptr;
+					ERROR_CHECK_STATUS_(vxMapArrayRange(auxList[i], 0, numItems, &map_id, &stride, (void **)&ptr, VX_READ_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
+					fwrite(ptr, 1, numItems * stride, stitch->loomioAuxDumpFile);
+					fflush(stitch->loomioAuxDumpFile);
+					ERROR_CHECK_STATUS_(vxUnmapArrayRange(auxList[i], map_id));
+				}
+			}
+		}
+	}
+	return VX_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Frame pipeline: the worker thread applies the buffers of each scheduled frame and processes the graph in order
+static vx_status ProcessPipelineFrame(ls_context stitch, const ls_frame_buffers& buffers)
+{
+	if (buffers.setCamera) ERROR_CHECK_STATUS_(SwapCameraBuffer(stitch, buffers.nullCamera ? nullptr : buffers.camera));
+	if (buffers.setOutput) ERROR_CHECK_STATUS_(SwapOutputBuffer(stitch, buffers.nullOutput ? nullptr : buffers.output));
+	if (buffers.setOverlay) ERROR_CHECK_STATUS_(SwapImageBuffer(stitch->Img_overlay, buffers.nullOverlay ? nullptr : buffers.overlay));
+	if (buffers.setChromaKey) ERROR_CHECK_STATUS_(SwapImageBuffer(stitch->chroma_key_input_img, buffers.nullChromaKey ? nullptr : buffers.chromaKey));
+	if (buffers.setPreview) ERROR_CHECK_STATUS_(SwapImageBuffer(stitch->Img_preview, buffers.nullPreview ? nullptr : buffers.preview));
+	if (buffers.setViewport) stitch->viewport.requested = buffers.viewport;
+	if (buffers.setOverlayDirty) {
+		stitch->overlayDirtyRequested = true;
+		stitch->overlayDirty = buffers.overlayDirty;
+	}
+	ERROR_CHECK_STATUS_(PrepareFrame(stitch));
+	if (stitch->tileJobs) {
+		ERROR_CHECK_STATUS_(ProcessTileJobs(stitch));
+	}
+	else {
+		ERROR_CHECK_STATUS_(vxProcessGraph(stitch->graphStitch));
+	}
+	ERROR_CHECK_STATUS_(CompleteFrame(stitch));
+	return VX_SUCCESS;
+}
+static void PipelineWorker(ls_context stitch)
+{
+	ls_frame_pipeline * pipeline = stitch->pipeline;
+	std::unique_lock<std::mutex> lock(pipeline->mutex);
+	for (;;) {
+		pipeline->cv.wait(lock, [pipeline] { return pipeline->terminate || pipeline->numCompleted < pipeline->numScheduled; });
+		if (pipeline->numCompleted == pipeline->numScheduled)
+			break;
+		vx_uint32 slot = (vx_uint32)(pipeline->numCompleted % pipeline->depth);
+		ls_frame_buffers buffers = pipeline->frame[slot];
+		lock.unlock();
+		vx_status status = ProcessPipelineFrame(stitch, buffers);
+		lock.lock();
+		pipeline->status[slot] = status;
+		pipeline->numCompleted++;
+		pipeline->cv.notify_all();
+	}
+}
+static vx_status StartPipeline(ls_context stitch)
+{
+	vx_uint32 depth = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_PIPELINE_DEPTH];
+	if (depth > LS_MAX_PIPELINE_DEPTH) {
+		ls_printf("WARNING: pipeline depth %d is limited to %d\n", depth, LS_MAX_PIPELINE_DEPTH);
+		depth = LS_MAX_PIPELINE_DEPTH;
+	}
+	if (stitch->tileJobs) {
+		// the tile graphs are run from the worker thread, so that lsScheduleFrame doesn't block
+		depth = std::max(depth, 1u);
+	}
+	if (depth > 1 || stitch->tileJobs) {
+		ERROR_CHECK_ALLOC_(stitch->pipeline = new ls_frame_pipeline());
+		stitch->pipeline->depth = depth;
+		stitch->pipeline->worker = std::thread(PipelineWorker, stitch);
+	}
 	return VX_SUCCESS;
 }
+static void StopPipeline(ls_context stitch)
+{
+	if (stitch->pipeline) {
+		{
+			std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+			stitch->pipeline->terminate = true;
+		}
+		stitch->pipeline->cv.notify_all();
+		stitch->pipeline->worker.join();
+		delete stitch->pipeline;
+		stitch->pipeline = nullptr;
+	}
+}
 
 ////////////////////////////////////////////////////////////////////////////
 // Stitch API implementation
@@ -1838,6 +3664,20 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalGetAttributes(vx_uint32 attr
 	return VX_SUCCESS;
 }
 
+//! \brief Enable or disable the profiler ring buffer mode.
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalSetProfilerRingBuffer(vx_bool enable)
+{
+	PROFILER_SET_RING_BUFFER(enable ? true : false);
+	return VX_SUCCESS;
+}
+
+//! \brief Dump the profiler events recorded so far in Chrome trace format.
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalDumpProfilerTrace(const char * fileName)
+{
+	if (!fileName) return VX_ERROR_INVALID_PARAMETERS;
+	return PROFILER_DUMP_TRACE(fileName) ? VX_SUCCESS : VX_FAILURE;
+}
+
 //! \brief Create stitch context.
 LIVE_STITCH_API_ENTRY ls_context VX_API_CALL lsCreateContext()
 {
@@ -1868,7 +3708,7 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetAttributes(ls_context stitch, v
 	for (vx_uint32 attr = attr_offset; attr < (attr_offset + attr_count); attr++) {
 		if (attr == LIVE_STITCH_ATTR_SEAM_THRESHOLD) {
 			// update scalar of seafind k0 kernel
-			stitch->scene_threshold_value = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_SEAM_THRESHOLD];
+			stitch->scene_threshold_value = (vx_uint32)attr_ptr[attr - attr_offset];
 			if (stitch->scene_threshold) {
 				vx_status status = vxWriteScalarValue(stitch->scene_threshold, &stitch->scene_threshold_value);
 				if (status != VX_SUCCESS)
@@ -1876,14 +3716,27 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetAttributes(ls_context stitch, v
 			}
 		}
 		else if (attr == LIVE_STITCH_ATTR_NOISE_FILTER_LAMBDA) {
-			// update scalar of seafind k0 kernel
-			stitch->noiseFilterLambda = (vx_float32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_NOISE_FILTER_LAMBDA];
+			// update scalar of noise filter kernel
+			stitch->noiseFilterLambda = (vx_float32)attr_ptr[attr - attr_offset];
 			if (stitch->filterLambda) {
 				vx_status status = vxWriteScalarValue(stitch->filterLambda, &stitch->noiseFilterLambda);
 				if (status != VX_SUCCESS)
 					return status;
 			}
 		}
+		else if (attr == LIVE_STITCH_ATTR_NOISE_FILTER_MOTION) {
+			// update scalar of noise filter kernel: the scalar is only added when lsInitialize has a non-zero threshold
+			if (stitch->initialized && !stitch->filterMotion && attr_ptr[attr - attr_offset] != 0.0f) {
+				ls_printf("ERROR: lsSetAttributes: LIVE_STITCH_ATTR_NOISE_FILTER_MOTION needs a non-zero value at lsInitialize\n");
+				return VX_ERROR_NOT_SUPPORTED;
+			}
+			stitch->noiseFilterMotion = (vx_float32)attr_ptr[attr - attr_offset];
+			if (stitch->filterMotion) {
+				vx_status status = vxWriteScalarValue(stitch->filterMotion, &stitch->noiseFilterMotion);
+				if (status != VX_SUCCESS)
+					return status;
+			}
+		}
 		else {
 			// not all attributes are supported
 			return VX_ERROR_NOT_SUPPORTED;
@@ -1998,8 +3851,8 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOutputConfig(ls_context stitch,
 		ls_printf("ERROR: lsSetOutputConfig: only UYVY/YUYV/RGB/NV12/IYUV buffer formats are allowed\n");
 		return VX_ERROR_INVALID_FORMAT;
 	}
-	if (buffer_width != (buffer_height * 2)) {
-		ls_printf("ERROR: lsSetOutputConfig: buffer_width should be 2 times buffer_height\n");
+	if (buffer_width != (buffer_height * 2) && (buffer_width * 2) != (buffer_height * 3)) {
+		ls_printf("ERROR: lsSetOutputConfig: buffer_width should be 2 times (equirectangular) or 1.5 times (cubemap/EAC) buffer_height\n");
 		return VX_ERROR_INVALID_DIMENSION;
 	}
 	// check that dimensions are multiples of 16x2
@@ -2071,12 +3924,13 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetCameraParams(ls_context stitch,
 		ls_printf("ERROR: lsSetCameraParams: lsReinitialize has been disabled\n");
 		return VX_ERROR_NOT_SUPPORTED;
 	}
-	memcpy(&stitch->camera_par[cam_index], par, sizeof(camera_params));
-	// check and mark whether reinitialize is required
-	if (stitch->initialized) {
+	// check and mark whether reinitialize is required for this camera
+	if (stitch->initialized && memcmp(&stitch->camera_par[cam_index], par, sizeof(camera_params))) {
 		stitch->reinitialize_required = true;
 		stitch->camera_params_updated = true;
+		stitch->camera_params_dirty_mask |= 1 << cam_index;
 	}
+	memcpy(&stitch->camera_par[cam_index], par, sizeof(camera_params));
 	return VX_SUCCESS;
 }
 
@@ -2091,12 +3945,13 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOverlayParams(ls_context stitch
 		ls_printf("ERROR: lsSetOverlayParams: lsReinitialize has been disabled\n");
 		return VX_ERROR_NOT_SUPPORTED;
 	}
-	memcpy(&stitch->overlay_par[overlay_index], par, sizeof(camera_params));
-	// check and mark whether reinitialize is required
-	if (stitch->initialized) {
+	// check and mark whether reinitialize is required for this overlay
+	if (stitch->initialized && memcmp(&stitch->overlay_par[overlay_index], par, sizeof(camera_params))) {
 		stitch->reinitialize_required = true;
 		stitch->overlay_params_updated = true;
+		stitch->overlay_params_dirty_mask |= 1 << overlay_index;
 	}
+	memcpy(&stitch->overlay_par[overlay_index], par, sizeof(camera_params));
 	return VX_SUCCESS;
 }
 
@@ -2182,6 +4037,38 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		stitch->stitching_mode = stitching_mode_quick_and_dirty;
 	if (stitch->live_stitch_attr[LIVE_STITCH_ATTR_ENABLE_REINITIALIZE] == 1.0f)
 		stitch->feature_enable_reinitialize = true;
+	stitch->output_projection = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_PROJECTION];
+	if (stitch->output_projection > output_projection_eac) {
+		ls_printf("ERROR: lsInitialize: invalid LIVE_STITCH_ATTR_OUTPUT_PROJECTION value (%d)\n", stitch->output_projection);
+		return VX_ERROR_INVALID_PARAMETERS;
+	}
+	if ((stitch->output_projection == output_projection_equirectangular) != (stitch->output_buffer_width == stitch->output_buffer_height * 2)) {
+		ls_printf("ERROR: lsInitialize: output buffer should be %s for the output projection: got %dx%d\n",
+			stitch->output_projection == output_projection_equirectangular ? "2:1" : "3:2", stitch->output_buffer_width, stitch->output_buffer_height);
+		return VX_ERROR_INVALID_DIMENSION;
+	}
+	if (stitch->output_projection != output_projection_equirectangular) {
+		// the seam find special case for circular fisheye on equator places seams using equirectangular angles
+		stitch->live_stitch_attr[LIVE_STITCH_ATTR_SEAM_COEQUSH_ENABLE] = 0;
+		// the chroma key kernels only accept 2:1 equirectangular images
+		if (stitch->live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY] != 0.0f) {
+			ls_printf("ERROR: lsInitialize: LIVE_STITCH_ATTR_CHROMA_KEY requires equirectangular output projection\n");
+			return VX_ERROR_NOT_SUPPORTED;
+		}
+	}
+	bool tileJobs = (stitch->live_stitch_attr[LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS] == 1.0f);
+	if (tileJobs) {
+		// each tile graph writes its region of the output: only the per pixel remap of quick stitch mode
+		// works on tiles. Normal stitch mode isn't supported: exposure compensation, seam find, and blend
+		// work on the complete warped camera images and would need per tile sub-tables with a halo.
+		if (stitch->stitching_mode != stitching_mode_quick_and_dirty || stitch->num_overlays > 0 ||
+			stitch->live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY] != 0.0f ||
+			strlen(stitch->loomio_output.kernelName) > 0 || strlen(stitch->loomio_viewing.kernelName) > 0)
+		{
+			ls_printf("ERROR: lsInitialize: LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS requires quick stitch mode without overlays, chroma key, and LoomIO output/viewing\n");
+			return VX_ERROR_NOT_SUPPORTED;
+		}
+	}
 	stitch->loomioOutputAuxSelection = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_IO_OUTPUT_AUX_SELECTION];
 	stitch->loomioCameraAuxDataLength = std::min((vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_IO_CAMERA_AUX_DATA_SIZE], (vx_uint32)LOOMIO_MIN_AUX_DATA_CAPACITY);
 	stitch->loomioOverlayAuxDataLength = std::min((vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_IO_OVERLAY_AUX_DATA_SIZE], (vx_uint32)LOOMIO_MIN_AUX_DATA_CAPACITY);
@@ -2258,6 +4145,8 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 	}
 	// check attribute for fast init code
 	stitch->USE_CPU_INIT = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_USE_CPU_FOR_INIT];
+	// the GPU initialize kernels only generate equirectangular maps
+	if (stitch->output_projection != output_projection_equirectangular) stitch->USE_CPU_INIT = 1;
 	stitch->stitchInitData = nullptr;
 
 	if (stitch->num_overlays > 0) {
@@ -2293,19 +4182,32 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 			if (addr_overlay.stride_y == 0) addr_overlay.stride_y = addr_overlay.stride_x * addr_overlay.dim_x;
 			ERROR_CHECK_OBJECT_(stitch->Img_overlay = vxCreateImageFromHandle(stitch->context, VX_DF_IMAGE_RGBX, &addr_overlay, ptr_overlay, VX_MEMORY_TYPE_OPENCL));
 		}
-		// create remap table object and image for overlay warp
-		ERROR_CHECK_OBJECT_(stitch->overlay_remap = vxCreateRemap(stitch->context, stitch->overlay_buffer_width, stitch->overlay_buffer_height, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height));
 		ERROR_CHECK_OBJECT_(stitch->Img_overlay_rgb = vxCreateVirtualImage(stitch->graphStitch, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, VX_DF_IMAGE_RGB));
-		ERROR_CHECK_OBJECT_(stitch->Img_overlay_rgba = vxCreateVirtualImage(stitch->graphStitch, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, VX_DF_IMAGE_RGBX));
-		// initialize remap using lens model
 		ERROR_CHECK_STATUS_(AllocateLensModelBuffersForOverlay(stitch));
-		ERROR_CHECK_STATUS_(InitializeInternalTablesForRemap(stitch, stitch->overlay_remap,
-			stitch->num_overlays, stitch->num_overlay_columns,
-			stitch->overlay_buffer_width / stitch->num_overlay_columns,
-			stitch->overlay_buffer_height / stitch->num_overlay_rows,
-			stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
-			&stitch->rig_par, stitch->overlay_par, stitch->overlaySrcMap, stitch->validPixelOverlayMap,
-			stitch->overlayIndexTmpBuf, stitch->overlayIndexBuf));
+		if (!stitch->feature_enable_reinitialize && stitch->live_stitch_attr[LIVE_STITCH_ATTR_OVERLAY_REGIONS] == 1.0f) {
+			// compute the overlay lens models, then create the remap tables of the output regions covered by overlays
+			ERROR_CHECK_STATUS_(InitializeInternalTablesForRemap(stitch, nullptr,
+				stitch->num_overlays, stitch->num_overlay_columns,
+				stitch->overlay_buffer_width / stitch->num_overlay_columns,
+				stitch->overlay_buffer_height / stitch->num_overlay_rows,
+				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
+				&stitch->rig_par, stitch->overlay_par, stitch->overlaySrcMap, stitch->validPixelOverlayMap,
+				stitch->overlayIndexTmpBuf, stitch->overlayIndexBuf, 0xffffffff));
+			ERROR_CHECK_STATUS_(CreateOverlayRegions(stitch));
+		}
+		else {
+			// create remap table object and image for overlay warp
+			ERROR_CHECK_OBJECT_(stitch->overlay_remap = vxCreateRemap(stitch->context, stitch->overlay_buffer_width, stitch->overlay_buffer_height, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height));
+			ERROR_CHECK_OBJECT_(stitch->Img_overlay_rgba = vxCreateVirtualImage(stitch->graphStitch, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height, VX_DF_IMAGE_RGBX));
+			// initialize remap using lens model
+			ERROR_CHECK_STATUS_(InitializeInternalTablesForRemap(stitch, stitch->overlay_remap,
+				stitch->num_overlays, stitch->num_overlay_columns,
+				stitch->overlay_buffer_width / stitch->num_overlay_columns,
+				stitch->overlay_buffer_height / stitch->num_overlay_rows,
+				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
+				&stitch->rig_par, stitch->overlay_par, stitch->overlaySrcMap, stitch->validPixelOverlayMap,
+				stitch->overlayIndexTmpBuf, stitch->overlayIndexBuf, 0xffffffff));
+		}
 		if (!stitch->feature_enable_reinitialize) {
 			if (stitch->overlaySrcMap) { delete[] stitch->overlaySrcMap; stitch->overlaySrcMap = nullptr; }
 			if (stitch->validPixelOverlayMap) { delete[] stitch->validPixelOverlayMap; stitch->validPixelOverlayMap = nullptr; }
@@ -2428,9 +4330,15 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 	if (stitch->output_encode_tiles > 4){ ls_printf("ERROR: lsInitialize: Max Encode Tiles supported is 4\n"); return VX_ERROR_INVALID_PARAMETERS;}
 	// create temporary images when extra color conversion is needed
 	if (stitch->camera_buffer_format != VX_DF_IMAGE_RGB) {
-		ERROR_CHECK_OBJECT_(stitch->Img_input_rgb = vxCreateVirtualImage(stitch->graphStitch, stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height, VX_DF_IMAGE_RGB));
+		if (tileJobs) {
+			// shared by the tile graphs
+			ERROR_CHECK_OBJECT_(stitch->Img_input_rgb = vxCreateImage(stitch->context, stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height, VX_DF_IMAGE_RGB));
+		}
+		else {
+			ERROR_CHECK_OBJECT_(stitch->Img_input_rgb = vxCreateVirtualImage(stitch->graphStitch, stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height, VX_DF_IMAGE_RGB));
+		}
 	}
-	if (stitch->output_buffer_format != VX_DF_IMAGE_RGB) {
+	if (stitch->output_buffer_format != VX_DF_IMAGE_RGB && !tileJobs) {
 		vx_uint32 output_img_width =  stitch->output_buffer_width;
 		vx_uint32 output_img_height = stitch->output_buffer_height;
 		ERROR_CHECK_OBJECT_(stitch->Img_output_rgb = vxCreateImage(stitch->context, output_img_width, output_img_height, VX_DF_IMAGE_RGB));
@@ -2447,13 +4355,17 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		addr_out.stride_y = stitch->output_buffer_width * 3;
 		if (addr_out.stride_y == 0) addr_out.stride_y = addr_out.stride_x * addr_out.dim_x;
 		ERROR_CHECK_OBJECT_(stitch->chroma_key_input_img = vxCreateImageFromHandle(stitch->context, VX_DF_IMAGE_RGB, &addr_out, ptr, VX_MEMORY_TYPE_OPENCL));
-		// create chroma key mask U8 buffer
+		// create chroma key intermediate buffers
 		vx_uint32 output_img_width = stitch->output_buffer_width;
 		vx_uint32 output_img_height = stitch->output_buffer_height;
-		ERROR_CHECK_OBJECT_(stitch->chroma_key_mask_img = vxCreateVirtualImage(stitch->graphStitch, output_img_width, output_img_height, VX_DF_IMAGE_U8));
 		ERROR_CHECK_OBJECT_(stitch->chroma_key_input_RGB_img = vxCreateVirtualImage(stitch->graphStitch, output_img_width, output_img_height, VX_DF_IMAGE_RGB));
 		stitch->CHROMA_KEY_EED = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY_EED];
-		if (stitch->CHROMA_KEY_EED){
+		// the fused CPU kernel needs no intermediate mask images
+		bool chroma_key_fused = (GetChromaKeyTargetAffinity() == AGO_TARGET_AFFINITY_CPU);
+		if (!chroma_key_fused){
+			ERROR_CHECK_OBJECT_(stitch->chroma_key_mask_img = vxCreateVirtualImage(stitch->graphStitch, output_img_width, output_img_height, VX_DF_IMAGE_U8));
+		}
+		if (stitch->CHROMA_KEY_EED && !chroma_key_fused){
 			ERROR_CHECK_OBJECT_(stitch->chroma_key_dilate_mask_img = vxCreateVirtualImage(stitch->graphStitch, output_img_width, output_img_height, VX_DF_IMAGE_U8));
 			ERROR_CHECK_OBJECT_(stitch->chroma_key_erode_mask_img = vxCreateVirtualImage(stitch->graphStitch, output_img_width, output_img_height, VX_DF_IMAGE_U8));
 		}
@@ -2463,7 +4375,9 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 	stitch->rgb_input = stitch->Img_input;
 	if (stitch->camera_buffer_format != VX_DF_IMAGE_RGB) {
 		// needs input color conversion
-		if (stitch->camera_buffer_format == VX_DF_IMAGE_NV12 || stitch->camera_buffer_format == VX_DF_IMAGE_IYUV){
+		if ((stitch->camera_buffer_format == VX_DF_IMAGE_NV12 || stitch->camera_buffer_format == VX_DF_IMAGE_IYUV) &&
+			GetColorConvertTargetAffinity() != AGO_TARGET_AFFINITY_CPU)
+		{
 			stitch->InputColorConvertNode = vxColorConvertNode(stitch->graphStitch, stitch->rgb_input, stitch->Img_input_rgb);
 		}
 		else{
@@ -2477,15 +4391,20 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 	if (stitch->NOISE_FILTER){
 		stitch->noiseFilterLambda = (vx_float32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_NOISE_FILTER_LAMBDA];
 		ERROR_CHECK_OBJECT_(stitch->filterLambda = vxCreateScalar(stitch->context, VX_TYPE_FLOAT32, &stitch->noiseFilterLambda));
+		stitch->noiseFilterMotion = (vx_float32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_NOISE_FILTER_MOTION];
+		if (stitch->noiseFilterMotion > 0.0f) {
+			// the motion threshold runs the noise filter on CPU
+			ERROR_CHECK_OBJECT_(stitch->filterMotion = vxCreateScalar(stitch->context, VX_TYPE_FLOAT32, &stitch->noiseFilterMotion));
+		}
 		ERROR_CHECK_OBJECT_(stitch->noiseFilterInput_image = vxCreateImage(stitch->context, stitch->camera_buffer_width, stitch->camera_buffer_height, VX_DF_IMAGE_RGB));
 		ERROR_CHECK_OBJECT_(stitch->noiseFilterImageDelay = vxCreateDelay(stitch->context, (vx_reference)stitch->noiseFilterInput_image, 2));
-		stitch->noiseFilterNode = stitchNoiseFilterNode(stitch->graphStitch, stitch->filterLambda, stitch->rgb_input, (vx_image)vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, -1), (vx_image)vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, 0));
+		stitch->noiseFilterNode = stitchNoiseFilterNode(stitch->graphStitch, stitch->filterLambda, stitch->rgb_input, (vx_image)vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, -1), (vx_image)vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, 0), stitch->filterMotion);
 		ERROR_CHECK_OBJECT_(stitch->noiseFilterNode);
 		stitch->rgb_input = (vx_image)vxGetReferenceFromDelay(stitch->noiseFilterImageDelay, 0);
 	}
 	stitch->rgb_output = stitch->Img_output;
-	if (stitch->output_buffer_format != VX_DF_IMAGE_RGB) {
-		// needs output color conversion
+	if (stitch->output_buffer_format != VX_DF_IMAGE_RGB && !tileJobs) {
+		// needs output color conversion (done by the tile graphs with tile jobs)
 		if (stitch->output_buffer_format == VX_DF_IMAGE_NV12 || stitch->output_buffer_format == VX_DF_IMAGE_IYUV){
 			if (stitch->output_encode_tiles == 1){ 
 				stitch->OutputColorConvertNode = vxColorConvertNode(stitch->graphStitch, stitch->Img_output_rgb, stitch->rgb_output); 
@@ -2506,26 +4425,39 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 	if (stitch->CHROMA_KEY){
 		vx_uint32 ChromaKey_value = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY_VALUE];
 		vx_uint32 ChromaKey_Tol = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_CHROMA_KEY_TOL];
-		stitch->chromaKey_mask_generation_node = stitchChromaKeyMaskGeneratorNode(stitch->graphStitch, ChromaKey_value, ChromaKey_Tol, stitch->chroma_key_input_RGB_img, stitch->chroma_key_mask_img);
-		ERROR_CHECK_OBJECT_(stitch->chromaKey_mask_generation_node);
-		if (stitch->CHROMA_KEY_EED){
-			stitch->chromaKey_erode_node = vxErode3x3Node(stitch->graphStitch, stitch->chroma_key_mask_img, stitch->chroma_key_erode_mask_img);
-			ERROR_CHECK_OBJECT_(stitch->chromaKey_erode_node);
-			stitch->chromaKey_dilate_node = vxDilate3x3Node(stitch->graphStitch, stitch->chroma_key_erode_mask_img, stitch->chroma_key_dilate_mask_img);
-			ERROR_CHECK_OBJECT_(stitch->chromaKey_dilate_node);
-			stitch->chromaKey_merge_node = stitchChromaKeyMergeNode(stitch->graphStitch, stitch->chroma_key_input_RGB_img, stitch->chroma_key_input_img, stitch->chroma_key_dilate_mask_img, stitch->rgb_output);
+		if (!stitch->chroma_key_mask_img){
+			// mask generation, erode/dilate, and merge in a single CPU pass
+			stitch->chromaKey_merge_node = stitchChromaKeyFusedNode(stitch->graphStitch, ChromaKey_value, ChromaKey_Tol, stitch->CHROMA_KEY_EED, stitch->chroma_key_input_RGB_img, stitch->chroma_key_input_img, stitch->rgb_output);
 			ERROR_CHECK_OBJECT_(stitch->chromaKey_merge_node);
 		}
 		else{
-			stitch->chromaKey_merge_node = stitchChromaKeyMergeNode(stitch->graphStitch, stitch->chroma_key_input_RGB_img, stitch->chroma_key_input_img, stitch->chroma_key_mask_img, stitch->rgb_output);
-			ERROR_CHECK_OBJECT_(stitch->chromaKey_merge_node);
+			stitch->chromaKey_mask_generation_node = stitchChromaKeyMaskGeneratorNode(stitch->graphStitch, ChromaKey_value, ChromaKey_Tol, stitch->chroma_key_input_RGB_img, stitch->chroma_key_mask_img);
+			ERROR_CHECK_OBJECT_(stitch->chromaKey_mask_generation_node);
+			if (stitch->CHROMA_KEY_EED){
+				stitch->chromaKey_erode_node = vxErode3x3Node(stitch->graphStitch, stitch->chroma_key_mask_img, stitch->chroma_key_erode_mask_img);
+				ERROR_CHECK_OBJECT_(stitch->chromaKey_erode_node);
+				stitch->chromaKey_dilate_node = vxDilate3x3Node(stitch->graphStitch, stitch->chroma_key_erode_mask_img, stitch->chroma_key_dilate_mask_img);
+				ERROR_CHECK_OBJECT_(stitch->chromaKey_dilate_node);
+				stitch->chromaKey_merge_node = stitchChromaKeyMergeNode(stitch->graphStitch, stitch->chroma_key_input_RGB_img, stitch->chroma_key_input_img, stitch->chroma_key_dilate_mask_img, stitch->rgb_output);
+				ERROR_CHECK_OBJECT_(stitch->chromaKey_merge_node);
+			}
+			else{
+				stitch->chromaKey_merge_node = stitchChromaKeyMergeNode(stitch->graphStitch, stitch->chroma_key_input_RGB_img, stitch->chroma_key_input_img, stitch->chroma_key_mask_img, stitch->rgb_output);
+				ERROR_CHECK_OBJECT_(stitch->chromaKey_merge_node);
+			}
 		}
 		stitch->rgb_output = stitch->chroma_key_input_RGB_img;
 	}
 	if (stitch->Img_overlay) {
-		// need add overlay
-		ERROR_CHECK_OBJECT_(stitch->nodeOverlayRemap = vxRemapNode(stitch->graphStitch, stitch->Img_overlay, stitch->overlay_remap, VX_INTERPOLATION_TYPE_BILINEAR, stitch->Img_overlay_rgba));
-		ERROR_CHECK_OBJECT_(stitch->nodeOverlayBlend = stitchAlphaBlendNode(stitch->graphStitch, stitch->Img_overlay_rgb, stitch->Img_overlay_rgba, stitch->rgb_output));
+		// need add overlay: warp the complete output or only the overlay regions
+		if (stitch->overlay_remap) {
+			ERROR_CHECK_OBJECT_(stitch->nodeOverlayRemap = vxRemapNode(stitch->graphStitch, stitch->Img_overlay, stitch->overlay_remap, VX_INTERPOLATION_TYPE_BILINEAR, stitch->Img_overlay_rgba));
+		}
+		for (vx_uint32 i = 0; i < stitch->numOverlayRegions; i++) {
+			ls_overlay_region * region = &stitch->overlayRegions[i];
+			ERROR_CHECK_OBJECT_(region->remapNode = vxRemapNode(stitch->graphStitch, stitch->Img_overlay, region->remap, VX_INTERPOLATION_TYPE_BILINEAR, region->output));
+		}
+		ERROR_CHECK_OBJECT_(stitch->nodeOverlayBlend = stitchAlphaBlendNode(stitch->graphStitch, stitch->Img_overlay_rgb, stitch->Img_overlay_rgba, stitch->rgb_output, stitch->overlay_region_array));
 		stitch->rgb_output = stitch->Img_overlay_rgb;
 	}
 	if (strlen(stitch->loomio_viewing.kernelName) > 0) {
@@ -2549,14 +4481,32 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		};
 		ERROR_CHECK_OBJECT_(stitch->nodeLoomIoViewing = stitchCreateNode(stitch->graphStitch, stitch->loomio_viewing.kernelName, params, dimof(params)));
 	}
+	// low resolution preview downscaled from the stitched output after chroma key and overlays
+	stitch->preview_scale = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_PREVIEW_SCALE];
+	if (stitch->preview_scale) {
+		if (stitch->preview_scale < 2 || stitch->preview_scale > 16) {
+			ls_printf("ERROR: lsInitialize: preview scale must be 2..16: got %d\n", stitch->preview_scale);
+			return VX_ERROR_INVALID_PARAMETERS;
+		}
+		if (tileJobs) {
+			ls_printf("ERROR: lsInitialize: preview output is not supported with output tile jobs\n");
+			return VX_ERROR_NOT_SUPPORTED;
+		}
+		ERROR_CHECK_STATUS_(CreatePreview(stitch, stitch->Img_output_rgb ? stitch->Img_output_rgb : stitch->Img_output));
+	}
 
 	/***********************************************************************************************************************************
 	Quick Stitch Mode -> Simple stitch
 	************************************************************************************************************************************/
 	if (stitch->stitching_mode == stitching_mode_quick_and_dirty)
 	{
-		// create remap table object
-		ERROR_CHECK_OBJECT_(stitch->camera_remap = vxCreateRemap(stitch->context, stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height));
+		// create remap table object: one for the complete output, or one per output tile job
+		if (tileJobs) {
+			ERROR_CHECK_STATUS_(CreateTileJobs(stitch));
+		}
+		else {
+			ERROR_CHECK_OBJECT_(stitch->camera_remap = vxCreateRemap(stitch->context, stitch->camera_rgb_buffer_width, stitch->camera_rgb_buffer_height, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height));
+		}
 		// initialize remap using lens model
 		ERROR_CHECK_STATUS_(AllocateLensModelBuffersForCamera(stitch));
 		ERROR_CHECK_STATUS_(InitializeInternalTablesForRemap(stitch, stitch->camera_remap,
@@ -2565,7 +4515,7 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 			stitch->camera_buffer_height / stitch->num_camera_rows,
 			stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
 			&stitch->rig_par, stitch->camera_par, stitch->camSrcMap, stitch->validPixelCamMap,
-			stitch->camIndexTmpBuf, stitch->camIndexBuf));
+			stitch->camIndexTmpBuf, stitch->camIndexBuf, 0xffffffff, stitch->tileJobs, stitch->numTileJobs));
 		if (!stitch->feature_enable_reinitialize) {
 			if (stitch->camSrcMap) { delete[] stitch->camSrcMap; stitch->camSrcMap = nullptr; }
 			if (stitch->validPixelCamMap) { delete[] stitch->validPixelCamMap; stitch->validPixelCamMap = nullptr; }
@@ -2576,8 +4526,19 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		////////////////////////////////////////////////////////////////////////
 		// create and verify graphStitch using simple remap kernel
 		////////////////////////////////////////////////////////////////////////
-		ERROR_CHECK_OBJECT_(stitch->SimpleStitchRemapNode = vxRemapNode(stitch->graphStitch, stitch->rgb_input, stitch->camera_remap, VX_INTERPOLATION_TYPE_BILINEAR, stitch->rgb_output));
-		ERROR_CHECK_STATUS_(vxVerifyGraph(stitch->graphStitch));
+		if (tileJobs) {
+			// graphStitch has only the input color conversion and noise filter, if any
+			if (stitch->InputColorConvertNode || stitch->noiseFilterNode) {
+				ERROR_CHECK_STATUS_(vxVerifyGraph(stitch->graphStitch));
+			}
+			for (vx_uint32 i = 0; i < stitch->numTileJobs; i++) {
+				ERROR_CHECK_STATUS_(vxVerifyGraph(stitch->tileJobs[i].graph));
+			}
+		}
+		else {
+			ERROR_CHECK_OBJECT_(stitch->SimpleStitchRemapNode = vxRemapNode(stitch->graphStitch, stitch->rgb_input, stitch->camera_remap, VX_INTERPOLATION_TYPE_BILINEAR, stitch->rgb_output));
+			ERROR_CHECK_STATUS_(vxVerifyGraph(stitch->graphStitch));
+		}
 		ERROR_CHECK_STATUS_(SyncInternalTables(stitch));
 	}
 	/***********************************************************************************************************************************
@@ -2606,9 +4567,12 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 				stitch->num_bands = 0;
 			}
 			if (stitch->MULTIBAND_BLEND){
-				// general protection for odd sized equirectangle
+				// general protection for odd sized equirectangle: with cube outputs the face rows are blended as
+				// separate images, so the face size has to halve instead (the width holds three faces)
 				vx_uint32 MAX_BAND = 10; // Max bands for multiband blend
 				vx_uint32 MAX_BAND_ALLOWED = 0, half_width = stitch->output_rgb_buffer_width;
+				if (stitch->output_projection != output_projection_equirectangular)
+					half_width = stitch->output_rgb_buffer_height / 2;
 				for (vx_uint32 i = 0; i < MAX_BAND; i++){
 					if (half_width % 2 == 0){ half_width = half_width / 2; MAX_BAND_ALLOWED++; }
 					else{ break; }
@@ -2617,6 +4581,12 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 					stitch->num_bands = (vx_int32)MAX_BAND_ALLOWED;
 					ls_printf("WARNING: Max allowed MULTIBAND BLEND bands for the set output equirectangle is %d\n", MAX_BAND_ALLOWED);
 				}
+				if (stitch->output_projection != output_projection_equirectangular && stitch->num_cameras > 16) {
+					// the blend tables hold 5-bit image indices: two face rows per camera fit only up to 16 cameras
+					ls_printf("WARNING: MULTIBAND BLEND is disabled for cube outputs with more than 16 cameras\n");
+					stitch->MULTIBAND_BLEND = 0;
+					stitch->num_bands = 0;
+				}
 			}
 			stitch->EXPO_COMP_GAINW = 1;
 			stitch->EXPO_COMP_GAINH = 1;
@@ -2627,10 +4597,14 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 				stitch->EXPO_COMP_GAINC = (vx_uint32)std::max(1.0f, stitch->live_stitch_attr[LIVE_STITCH_ATTR_EXPCOMP_GAIN_IMG_C]);
 				if (stitch->EXPO_COMP == 4) stitch->EXPO_COMP_GAINC = 12;	// override the default value since kernel expects 12.
 			}
+			stitch->WARP_GAINS = (stitch->EXPO_COMP && stitch->live_stitch_attr[LIVE_STITCH_ATTR_WARP_EXPCOMP_GAINS] == 1.0f) ? 1 : 0;
 			if (stitch->EXPO_COMP < 3) {
 				stitch->alpha = (vx_float32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_EXPCOMP_ALPHA_VALUE];
 				stitch->beta = (vx_float32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_EXPCOMP_BETA_VALUE];
+				stitch->gain_smoothing = std::min(std::max((vx_float32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_EXPCOMP_GAIN_SMOOTHING], 0.0f), 0.99f);
 			}
+			vx_float32 subsample = (stitch->EXPO_COMP < 3) ? stitch->live_stitch_attr[LIVE_STITCH_ATTR_EXPCOMP_SUBSAMPLE] : 1.0f;
+			stitch->EXPO_COMP_SUBSAMPLE = (subsample >= 4.0f) ? 4 : ((subsample >= 2.0f) ? 2 : 1);
 			// option to disable seam find with environment variable
 			char value[256] = { 0 };
 			if (StitchGetEnvironmentVariable("LOOM_SEAM_FIND_DISABLE", value, sizeof(value))) {
@@ -2643,7 +4617,13 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 			stitch->SETUP_LOAD = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_SAVE_AND_LOAD_INIT];
 			stitch->SETUP_LOAD_FILES_FOUND = vx_false_e;
 			if (stitch->MULTIBAND_BLEND || stitch->EXPO_COMP){ stitch->SETUP_LOAD = 0; }
-			if (stitch->SETUP_LOAD){ 	
+			// tables shared by another context with the same configuration
+			stitch->SHARE_TABLES = (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_SHARE_INIT_TABLES];
+			if (stitch->feature_enable_reinitialize){ stitch->SHARE_TABLES = 0; }
+			if (stitch->SHARE_TABLES){
+				SharedTablesLookup(stitch);
+			}
+			if (stitch->SETUP_LOAD && !stitch->SETUP_LOAD_FILES_FOUND){ 	
 				vx_status status = quickSetupFilesLookup(stitch);
 				if (status != VX_SUCCESS) {
 					vxAddLogEntry((vx_reference)stitch->context, status, "ERROR: lsInitialize: quickSetupFilesLookup() failed (%d)\n", status);
@@ -2660,24 +4640,34 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		////////////////////////////////////////////////////////////////////////
 		// create and verify graphStitch using low-level kernels
 		////////////////////////////////////////////////////////////////////////
-		// warping
-		ERROR_CHECK_OBJECT_(stitch->WarpNode = stitchWarpNode(stitch->graphStitch, 1, stitch->num_cameras, stitch->ValidPixelEntry, stitch->WarpRemapEntry, stitch->rgb_input, stitch->RGBY1, stitch->warp_luma_image, stitch->num_camera_columns));
+		// warping: applies the exposure comp gains with WARP_GAINS (solved gains of the previous frame)
+		vx_array solved_gains = stitch->gain_delay ? (vx_array)vxGetReferenceFromDelay(stitch->gain_delay, 0) : stitch->gain_array;
+		vx_array warp_gains = nullptr;
+		if (stitch->WARP_GAINS) {
+			warp_gains = stitch->gain_delay ? (vx_array)vxGetReferenceFromDelay(stitch->gain_delay, -1) : stitch->gain_array;
+		}
+		ERROR_CHECK_OBJECT_(stitch->WarpNode = stitchWarpNode(stitch->graphStitch, 1, stitch->num_cameras, stitch->ValidPixelEntry, stitch->WarpRemapEntry, stitch->rgb_input, stitch->RGBY1, stitch->warp_luma_image, stitch->num_camera_columns,
+			warp_gains, stitch->EXPO_COMP_GAINW, stitch->EXPO_COMP_GAINH));
 
 		// exposure comp
 		vx_image merge_input = stitch->RGBY1;
 		vx_image merge_weight = stitch->weight_image;
 		if (stitch->EXPO_COMP) {
 			if (stitch->EXPO_COMP == 1) {
-				ERROR_CHECK_OBJECT_(stitch->ExpcompComputeGainNode = stitchExposureCompCalcErrorFnNode(stitch->graphStitch, stitch->num_cameras, stitch->RGBY1, stitch->OverlapPixelEntry, stitch->valid_mask_image, stitch->A_matrix));
-				ERROR_CHECK_OBJECT_(stitch->ExpcompSolveGainNode = stitchExposureCompSolveForGainNode(stitch->graphStitch, stitch->alpha, stitch->beta, stitch->A_matrix, stitch->overlap_matrix, stitch->gain_array));
+				// the error function reads the luma byte, which the warp gains don't scale
+				ERROR_CHECK_OBJECT_(stitch->ExpcompComputeGainNode = stitchExposureCompCalcErrorFnNode(stitch->graphStitch, stitch->num_cameras, stitch->RGBY1, stitch->OverlapPixelEntry, stitch->valid_mask_image, stitch->A_matrix, stitch->EXPO_COMP_SUBSAMPLE));
+				ERROR_CHECK_OBJECT_(stitch->ExpcompSolveGainNode = stitchExposureCompSolveForGainNode(stitch->graphStitch, stitch->alpha, stitch->beta, stitch->A_matrix, stitch->overlap_matrix, solved_gains, stitch->gain_smoothing, nullptr));
 			}
 			else if (stitch->EXPO_COMP == 2) {
-				ERROR_CHECK_OBJECT_(stitch->ExpcompComputeGainNode = stitchExposureCompCalcErrorFnRGBNode(stitch->graphStitch, stitch->num_cameras, stitch->RGBY1, stitch->OverlapPixelEntry, stitch->valid_mask_image, stitch->A_matrix));
-				ERROR_CHECK_OBJECT_(stitch->ExpcompSolveGainNode = stitchExposureCompSolveForGainNode(stitch->graphStitch, stitch->alpha, stitch->beta, stitch->A_matrix, stitch->overlap_matrix, stitch->gain_array));
+				// with WARP_GAINS the RGB sums include the gains of the previous frame: the solver divides them out
+				ERROR_CHECK_OBJECT_(stitch->ExpcompComputeGainNode = stitchExposureCompCalcErrorFnRGBNode(stitch->graphStitch, stitch->num_cameras, stitch->RGBY1, stitch->OverlapPixelEntry, stitch->valid_mask_image, stitch->A_matrix, stitch->EXPO_COMP_SUBSAMPLE));
+				ERROR_CHECK_OBJECT_(stitch->ExpcompSolveGainNode = stitchExposureCompSolveForGainNode(stitch->graphStitch, stitch->alpha, stitch->beta, stitch->A_matrix, stitch->overlap_matrix, solved_gains, stitch->gain_smoothing, warp_gains));
+			}
+			if (!stitch->WARP_GAINS) {
+				ERROR_CHECK_OBJECT_(stitch->ExpcompApplyGainNode = stitchExposureCompApplyGainNode(stitch->graphStitch, stitch->RGBY1, stitch->gain_array, stitch->valid_array, stitch->num_cameras, stitch->EXPO_COMP_GAINW, stitch->EXPO_COMP_GAINH, stitch->RGBY2));
+				// update merge input
+				merge_input = stitch->RGBY2;
 			}
-			ERROR_CHECK_OBJECT_(stitch->ExpcompApplyGainNode = stitchExposureCompApplyGainNode(stitch->graphStitch, stitch->RGBY1, stitch->gain_array, stitch->valid_array, stitch->num_cameras, stitch->EXPO_COMP_GAINW, stitch->EXPO_COMP_GAINH, stitch->RGBY2));
-			// update merge input
-			merge_input = stitch->RGBY2;
 		}
 		if (stitch->SEAM_FIND) {
 			if (stitch->SEAM_REFRESH)
@@ -2704,7 +4694,7 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 			//SeamFind Step 3 - Cost Accumulate
 			stitch->SeamfindStep3Node = stitchSeamFindCostAccumulateNode(stitch->graphStitch, stitch->current_frame, stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
 				stitch->sobel_magnitude_image, stitch->sobel_phase_image, stitch->valid_mask_image, stitch->seamfind_valid_array, stitch->seamfind_pref_array,
-				stitch->seamfind_info_array, stitch->seamfind_accum_array);
+				stitch->seamfind_info_array, stitch->seamfind_accum_array, (vx_uint32)stitch->live_stitch_attr[LIVE_STITCH_ATTR_SEAM_COARSE_SCALE]);
 			ERROR_CHECK_OBJECT_(stitch->SeamfindStep3Node);
 			//SeamFind Step 4 - Path Trace
 			stitch->SeamfindStep4Node = stitchSeamFindPathTraceNode(stitch->graphStitch, stitch->current_frame, stitch->weight_image, stitch->seamfind_info_array, 
@@ -2719,31 +4709,32 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		}
 		// create data objects and nodes for multiband blending
 		if (stitch->MULTIBAND_BLEND){
+			vx_uint32 numBlendImages = GetMultibandImageCount(stitch);
 			// create Laplacian pyramids.
 			for (int i = 1; i < stitch->num_bands; i++) {
-				stitch->pStitchMultiband[i].WeightHSGNode = stitchMultiBandHalfScaleGaussianNode(stitch->graphStitch, stitch->num_cameras, stitch->pStitchMultiband[i].valid_array_offset,
+				stitch->pStitchMultiband[i].WeightHSGNode = stitchMultiBandHalfScaleGaussianNode(stitch->graphStitch, numBlendImages, stitch->pStitchMultiband[i].valid_array_offset,
 					stitch->blend_offsets, stitch->pStitchMultiband[i - 1].WeightPyrImgGaussian, stitch->pStitchMultiband[i].WeightPyrImgGaussian);
 				ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[i].WeightHSGNode);
-				stitch->pStitchMultiband[i].SourceHSGNode = stitchMultiBandHalfScaleGaussianNode(stitch->graphStitch, stitch->num_cameras, stitch->pStitchMultiband[i].valid_array_offset,
+				stitch->pStitchMultiband[i].SourceHSGNode = stitchMultiBandHalfScaleGaussianNode(stitch->graphStitch, numBlendImages, stitch->pStitchMultiband[i].valid_array_offset,
 					stitch->blend_offsets, stitch->pStitchMultiband[i - 1].DstPyrImgGaussian, stitch->pStitchMultiband[i].DstPyrImgGaussian);
 				ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[i].SourceHSGNode);
-				stitch->pStitchMultiband[i - 1].UpscaleSubtractNode = stitchMultiBandUpscaleGaussianSubtractNode(stitch->graphStitch, stitch->num_cameras, stitch->pStitchMultiband[i - 1].valid_array_offset,
+				stitch->pStitchMultiband[i - 1].UpscaleSubtractNode = stitchMultiBandUpscaleGaussianSubtractNode(stitch->graphStitch, numBlendImages, stitch->pStitchMultiband[i - 1].valid_array_offset,
 					stitch->pStitchMultiband[i - 1].DstPyrImgGaussian, stitch->pStitchMultiband[i].DstPyrImgGaussian, stitch->blend_offsets, stitch->pStitchMultiband[i-1].WeightPyrImgGaussian, stitch->pStitchMultiband[i - 1].DstPyrImgLaplacian);
 				ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[i - 1].UpscaleSubtractNode);
 			}
 			// reconstruct Laplacian after blending with corresponding weights: for band = num_bands-1, laplacian and gaussian is the same
 			int i = stitch->num_bands - 1;
-			stitch->pStitchMultiband[i].BlendNode = stitchMultiBandMergeNode(stitch->graphStitch, stitch->num_cameras, stitch->pStitchMultiband[i].valid_array_offset,
+			stitch->pStitchMultiband[i].BlendNode = stitchMultiBandMergeNode(stitch->graphStitch, numBlendImages, stitch->pStitchMultiband[i].valid_array_offset,
 				stitch->pStitchMultiband[i].DstPyrImgGaussian, stitch->pStitchMultiband[i].WeightPyrImgGaussian, stitch->blend_offsets, stitch->pStitchMultiband[i].DstPyrImgLaplacianRec);
 			ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[i].BlendNode);
 			--i;
 			for (; i > 0; --i){
-				stitch->pStitchMultiband[i].UpscaleAddNode = stitchMultiBandUpscaleGaussianAddNode(stitch->graphStitch, stitch->num_cameras, stitch->pStitchMultiband[i].valid_array_offset,
+				stitch->pStitchMultiband[i].UpscaleAddNode = stitchMultiBandUpscaleGaussianAddNode(stitch->graphStitch, numBlendImages, stitch->pStitchMultiband[i].valid_array_offset,
 					stitch->pStitchMultiband[i].DstPyrImgLaplacian, stitch->pStitchMultiband[i + 1].DstPyrImgLaplacianRec, stitch->blend_offsets, stitch->pStitchMultiband[i].DstPyrImgLaplacianRec);
 				ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[i].UpscaleAddNode);
 			}
 			// for the lowest level
-			stitch->pStitchMultiband[0].UpscaleAddNode = stitchMultiBandLaplacianReconstructNode(stitch->graphStitch, stitch->num_cameras, stitch->pStitchMultiband[0].valid_array_offset,
+			stitch->pStitchMultiband[0].UpscaleAddNode = stitchMultiBandLaplacianReconstructNode(stitch->graphStitch, numBlendImages, stitch->pStitchMultiband[0].valid_array_offset,
 				stitch->pStitchMultiband[0].DstPyrImgLaplacian, stitch->pStitchMultiband[1].DstPyrImgLaplacianRec, stitch->blend_offsets, stitch->pStitchMultiband[0].DstPyrImgLaplacianRec);
 			ERROR_CHECK_OBJECT_(stitch->pStitchMultiband[0].UpscaleAddNode);
 			// update merge input and weight images
@@ -2752,7 +4743,9 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		}
 		// merge node
 		ERROR_CHECK_OBJECT_(stitch->MergeNode = stitchMergeNode(stitch->graphStitch,
-			stitch->cam_id_image, stitch->group1_image, stitch->group2_image, merge_input, merge_weight, stitch->rgb_output));
+			stitch->cam_id_image, stitch->group1_image, stitch->group2_image, merge_input, merge_weight, stitch->rgb_output,
+			stitch->MergeRemapEntry ? stitch->rgb_input : nullptr, stitch->MergeRemapEntry, stitch->num_camera_columns,
+			(stitch->MergeRemapEntry && stitch->EXPO_COMP) ? (stitch->WARP_GAINS ? warp_gains : stitch->gain_array) : nullptr));
 
 		// verify the graph
 		ERROR_CHECK_STATUS_(vxVerifyGraph(stitch->graphStitch));
@@ -2766,6 +4759,9 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch)
 		return VX_ERROR_NO_RESOURCES;
 	}
 
+	// start the frame pipeline, if requested
+	ERROR_CHECK_STATUS_(StartPipeline(stitch));
+
 	// mark that initialization is successful
 	stitch->initialized = true;
 
@@ -2801,6 +4797,12 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsReinitialize(ls_context stitch)
 		return VX_ERROR_GRAPH_SCHEDULED;
 	}
 
+	// restore the complete tables: the viewport trim is applied again on the next frame
+	ERROR_CHECK_STATUS_(ViewportReleaseTables(stitch, true));
+
+	// only the tables of cameras/overlays with updated parameters are recomputed, unless rig parameters are updated
+	vx_uint32 cameraUpdateMask = stitch->rig_params_updated ? 0xffffffff : stitch->camera_params_dirty_mask;
+	vx_uint32 overlayUpdateMask = stitch->rig_params_updated ? 0xffffffff : stitch->overlay_params_dirty_mask;
 	if (stitch->rig_params_updated || stitch->camera_params_updated) {
 
 		// Quick Initailize enabled
@@ -2809,17 +4811,17 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsReinitialize(ls_context stitch)
 		}
 
 		// re-initialize tables for camera
-		if (stitch->camera_remap){
+		if (stitch->camera_remap || stitch->tileJobs){
 			ERROR_CHECK_STATUS_(InitializeInternalTablesForRemap(stitch, stitch->camera_remap,
 				stitch->num_cameras, stitch->num_camera_columns,
 				stitch->camera_buffer_width / stitch->num_camera_columns,
 				stitch->camera_buffer_height / stitch->num_camera_rows,
 				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
 				&stitch->rig_par, stitch->camera_par, stitch->camSrcMap, stitch->validPixelCamMap,
-				stitch->camIndexTmpBuf, stitch->camIndexBuf));
+				stitch->camIndexTmpBuf, stitch->camIndexBuf, cameraUpdateMask, stitch->tileJobs, stitch->numTileJobs));
 		}
 		else{
-			ERROR_CHECK_STATUS_(InitializeInternalTablesForCamera(stitch));
+			ERROR_CHECK_STATUS_(InitializeInternalTablesForCamera(stitch, cameraUpdateMask));
 		}
 		ERROR_CHECK_STATUS_(SyncInternalTables(stitch));
 	}
@@ -2832,7 +4834,7 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsReinitialize(ls_context stitch)
 				stitch->overlay_buffer_height / stitch->num_overlay_rows,
 				stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height,
 				&stitch->rig_par, stitch->overlay_par, stitch->overlaySrcMap, stitch->validPixelOverlayMap,
-				stitch->overlayIndexTmpBuf, stitch->overlayIndexBuf));
+				stitch->overlayIndexTmpBuf, stitch->overlayIndexBuf, overlayUpdateMask));
 			ERROR_CHECK_STATUS_(SyncInternalTables(stitch));
 		}	
 	}
@@ -2842,6 +4844,8 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsReinitialize(ls_context stitch)
 	stitch->rig_params_updated = false;
 	stitch->camera_params_updated = false;
 	stitch->overlay_params_updated = false;
+	stitch->camera_params_dirty_mask = 0;
+	stitch->overlay_params_dirty_mask = 0;
 	PROFILER_STOP(LoomSL, ReinitializeGraph);
 	return VX_SUCCESS;
 }
@@ -2855,6 +4859,9 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 	else {
 		ls_context stitch = *pStitch;
 		ERROR_CHECK_STATUS_(IsValidContext(stitch));
+		// complete the frames in flight
+		StopPipeline(stitch);
+		ViewportReleaseTables(stitch, false);
 		// graph profile dump if requested
 		if (stitch->live_stitch_attr[LIVE_STITCH_ATTR_PROFILER]) {
 			if (stitch->graphStitch) {
@@ -2867,6 +4874,10 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 		if (stitch->camera_par) delete[] stitch->camera_par;
 		if (stitch->overlay_par) delete[] stitch->overlay_par;
 
+		// release tile jobs and overlay regions
+		ERROR_CHECK_STATUS_(ReleaseTileJobs(stitch));
+		ERROR_CHECK_STATUS_(ReleaseOverlayRegions(stitch));
+
 		// release image objects
 		if (stitch->Img_input) ERROR_CHECK_STATUS_(vxReleaseImage(&stitch->Img_input));
 		if (stitch->Img_output) ERROR_CHECK_STATUS_(vxReleaseImage(&stitch->Img_output));
@@ -2897,12 +4908,14 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 		if (stitch->chroma_key_erode_mask_img) ERROR_CHECK_STATUS_(vxReleaseImage(&stitch->chroma_key_erode_mask_img));
 		if (stitch->chroma_key_input_RGB_img) ERROR_CHECK_STATUS_(vxReleaseImage(&stitch->chroma_key_input_RGB_img));
 		if (stitch->noiseFilterInput_image) ERROR_CHECK_STATUS_(vxReleaseImage(&stitch->noiseFilterInput_image));
+		if (stitch->Img_preview) ERROR_CHECK_STATUS_(vxReleaseImage(&stitch->Img_preview));
 
 		// release scalar objects
 		if (stitch->current_frame) ERROR_CHECK_STATUS_(vxReleaseScalar(&stitch->current_frame));
 		if (stitch->scene_threshold) ERROR_CHECK_STATUS_(vxReleaseScalar(&stitch->scene_threshold));
 		if (stitch->seam_cost_enable) ERROR_CHECK_STATUS_(vxReleaseScalar(&stitch->seam_cost_enable));
 		if (stitch->filterLambda) ERROR_CHECK_STATUS_(vxReleaseScalar(&stitch->filterLambda));
+		if (stitch->filterMotion) ERROR_CHECK_STATUS_(vxReleaseScalar(&stitch->filterMotion));
 
 		// release remap objects
 		if (stitch->overlay_remap) ERROR_CHECK_STATUS_(vxReleaseRemap(&stitch->overlay_remap));
@@ -2916,6 +4929,7 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 		// release arrays
 		if (stitch->ValidPixelEntry) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->ValidPixelEntry));
 		if (stitch->WarpRemapEntry) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->WarpRemapEntry));
+		if (stitch->MergeRemapEntry) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->MergeRemapEntry));
 		if (stitch->OverlapPixelEntry) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->OverlapPixelEntry));
 		if (stitch->valid_array) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->valid_array));
 		if (stitch->gain_array) ERROR_CHECK_STATUS_(vxReleaseArray(&stitch->gain_array));
@@ -2929,6 +4943,7 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 
 		// release delay element
 		if (stitch->noiseFilterImageDelay) ERROR_CHECK_STATUS_(vxReleaseDelay(&stitch->noiseFilterImageDelay));
+		if (stitch->gain_delay) ERROR_CHECK_STATUS_(vxReleaseDelay(&stitch->gain_delay));
 
 		// release node objects
 		if (stitch->InputColorConvertNode) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->InputColorConvertNode));
@@ -2936,6 +4951,7 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 		if (stitch->OutputColorConvertNode) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->OutputColorConvertNode));
 		if (stitch->nodeOverlayRemap) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->nodeOverlayRemap));
 		if (stitch->nodeOverlayBlend) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->nodeOverlayBlend));
+		if (stitch->nodePreviewDownscale) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->nodePreviewDownscale));
 		if (stitch->WarpNode) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->WarpNode));
 		if (stitch->ExpcompComputeGainNode) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->ExpcompComputeGainNode));
 		if (stitch->ExpcompSolveGainNode) ERROR_CHECK_STATUS_(vxReleaseNode(&stitch->ExpcompSolveGainNode));
@@ -3027,6 +5043,8 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 		if (stitch->validPixelOverlayMap) { delete[] stitch->validPixelOverlayMap; stitch->validPixelOverlayMap = nullptr; }
 		if (stitch->overlayIndexTmpBuf) { delete[] stitch->overlayIndexTmpBuf; stitch->overlayIndexTmpBuf = nullptr; }
 		if (stitch->overlayIndexBuf) { delete[] stitch->overlayIndexBuf; stitch->overlayIndexBuf = nullptr; }
+		TableCacheUnmapFile(stitch->tableCache);
+		SharedTablesRelease(stitch);
 
 		// debug aux dumps
 		if (stitch->loomioAuxDumpFile) {
@@ -3052,6 +5070,7 @@ SHARED_PUBLIC vx_status VX_API_CALL lsReleaseContext(ls_context * pStitch)
 //     overlay_buffer - overlay opencl buffer with all images
 //     output_buffer  - output opencl buffer for output equirectangular image
 //     chromaKey_buffer  - chroma key opencl buffer for equirectangular image
+//     preview_buffer - preview opencl buffer for downscaled RGB output image
 //   Use of nullptr will return the control of previously set buffer
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetCameraBuffer(ls_context stitch, cl_mem * input_buffer)
 {
@@ -3060,14 +5079,17 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetCameraBuffer(ls_context stitch,
 	// check to make sure that LoomIO for camera is not active
 	if (stitch->nodeLoomIoCamera) return VX_ERROR_NOT_ALLOCATED;
 
-	// switch the user specified OpenCL buffer into image
-	if (stitch->camera_buffer_format == VX_DF_IMAGE_NV12) {
-		void * ptr_in[] = { input_buffer ? input_buffer[0] : nullptr, input_buffer ? input_buffer[1] : nullptr };
-		ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_input, ptr_in, nullptr, 2));
+	if (stitch->pipeline) {
+		// use the buffer for the next scheduled frame
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setCamera = true;
+		pending.nullCamera = !input_buffer;
+		for (vx_uint32 i = 0; input_buffer && i < (stitch->camera_buffer_format == VX_DF_IMAGE_NV12 ? 2u : 1u); i++)
+			pending.camera[i] = input_buffer[i];
 	}
 	else {
-		void * ptr_in[] = { input_buffer ? input_buffer[0] : nullptr };
-		ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_input, ptr_in, nullptr, 1));
+		ERROR_CHECK_STATUS_(SwapCameraBuffer(stitch, input_buffer));
 	}
 	PROFILER_STOP(LoomSL, SetInputBuffer);
 	return VX_SUCCESS;
@@ -3079,22 +5101,20 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOutputBuffer(ls_context stitch,
 	// check to make sure that LoomIO for output is not active
 	if (stitch->nodeLoomIoOutput) return VX_ERROR_NOT_ALLOCATED;
 
-	// switch the user specified OpenCL buffer into image
-	if (stitch->output_buffer_format == VX_DF_IMAGE_NV12) {
-		if (stitch->output_encode_tiles > 1) {
-			for (vx_uint32 i = 0; i < stitch->output_encode_tiles; i++){
-				void * ptr_out[] = { output_buffer ? output_buffer[(i * 2)] : nullptr, output_buffer ? output_buffer[(i * 2) + 1] : nullptr };
-				ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->encodetileOutput[i], ptr_out, nullptr, 2));
-			}
-		}
-		else {
-			void * ptr_out[] = { output_buffer ? output_buffer[0] : nullptr, output_buffer ? output_buffer[1] : nullptr };
-			ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_output, ptr_out, nullptr, 2));
-		}
+	if (stitch->pipeline) {
+		// use the buffer for the next scheduled frame
+		vx_uint32 numBuffers = 1;
+		if (stitch->output_buffer_format == VX_DF_IMAGE_NV12)
+			numBuffers = (stitch->output_encode_tiles > 1) ? stitch->output_encode_tiles * 2 : 2;
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setOutput = true;
+		pending.nullOutput = !output_buffer;
+		for (vx_uint32 i = 0; output_buffer && i < numBuffers; i++)
+			pending.output[i] = output_buffer[i];
 	}
 	else {
-		void * ptr_out[] = { output_buffer ? output_buffer[0] : nullptr };
-		ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_output, ptr_out, nullptr, 1));
+		ERROR_CHECK_STATUS_(SwapOutputBuffer(stitch, output_buffer));
 	}
 	PROFILER_STOP(LoomSL, SetOutputBuffer);
 	return VX_SUCCESS;
@@ -3105,9 +5125,17 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOverlayBuffer(ls_context stitch
 	// check to make sure that LoomIO for overlay is not active
 	if (stitch->nodeLoomIoOverlay) return VX_ERROR_NOT_ALLOCATED;
 
-	// switch the user specified OpenCL buffer into image
-	void * ptr_overlay[] = { overlay_buffer ? overlay_buffer[0] : nullptr };
-	ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->Img_overlay, ptr_overlay, nullptr, 1));
+	if (stitch->pipeline) {
+		// use the buffer for the next scheduled frame
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setOverlay = true;
+		pending.nullOverlay = !overlay_buffer;
+		if (overlay_buffer) pending.overlay[0] = overlay_buffer[0];
+	}
+	else {
+		ERROR_CHECK_STATUS_(SwapImageBuffer(stitch->Img_overlay, overlay_buffer));
+	}
 
 	return VX_SUCCESS;
 }
@@ -3116,9 +5144,92 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetChromaKeyBuffer(ls_context stit
 	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
 	if (!stitch->CHROMA_KEY) return VX_ERROR_NOT_ALLOCATED;
 
-	// switch the user specified OpenCL buffer into image
-	void * ptr_chroma[] = { chromaKey_buffer ? chromaKey_buffer[0] : nullptr };
-	ERROR_CHECK_STATUS_(vxSwapImageHandle(stitch->chroma_key_input_img, ptr_chroma, nullptr, 1));
+	if (stitch->pipeline) {
+		// use the buffer for the next scheduled frame
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setChromaKey = true;
+		pending.nullChromaKey = !chromaKey_buffer;
+		if (chromaKey_buffer) pending.chromaKey[0] = chromaKey_buffer[0];
+	}
+	else {
+		ERROR_CHECK_STATUS_(SwapImageBuffer(stitch->chroma_key_input_img, chromaKey_buffer));
+	}
+
+	return VX_SUCCESS;
+}
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetPreviewBuffer(ls_context stitch, cl_mem * preview_buffer)
+{
+	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
+	if (!stitch->Img_preview) return VX_ERROR_NOT_ALLOCATED;
+
+	if (stitch->pipeline) {
+		// use the buffer for the next scheduled frame
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setPreview = true;
+		pending.nullPreview = !preview_buffer;
+		if (preview_buffer) pending.preview[0] = preview_buffer[0];
+	}
+	else {
+		ERROR_CHECK_STATUS_(SwapImageBuffer(stitch->Img_preview, preview_buffer));
+	}
+
+	return VX_SUCCESS;
+}
+
+//! \brief Set viewport for next frame
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetViewport(ls_context stitch, vx_float32 yaw, vx_float32 pitch, vx_float32 hfov, vx_float32 vfov)
+{
+	ERROR_CHECK_STATUS_(IsValidContext(stitch));
+	if (hfov > 0 && (yaw < -180 || yaw > 180 || pitch < -90 || pitch > 90 || vfov <= 0)) {
+		ls_printf("ERROR: lsSetViewport: invalid viewport: yaw=%g pitch=%g hfov=%g vfov=%g\n", yaw, pitch, hfov, vfov);
+		return VX_ERROR_INVALID_PARAMETERS;
+	}
+	ls_viewport_params par = { yaw, pitch, hfov > 0 ? hfov : 0, hfov > 0 ? vfov : 0 };
+
+	if (stitch->pipeline) {
+		// use the viewport for the next scheduled frame
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setViewport = true;
+		pending.viewport = par;
+	}
+	else {
+		stitch->viewport.requested = par;
+	}
+
+	return VX_SUCCESS;
+}
+
+//! \brief Set overlay dirty rectangles for next frame
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOverlayDirtyRects(ls_context stitch, vx_uint32 rect_count, const vx_rectangle_t * rect_list)
+{
+	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
+	if (!stitch->overlay_region_array) {
+		ls_printf("ERROR: lsSetOverlayDirtyRects: needs overlay regions (see LIVE_STITCH_ATTR_OVERLAY_REGIONS)\n");
+		return VX_ERROR_NOT_SUPPORTED;
+	}
+	if (rect_count > LS_MAX_OVERLAY_DIRTY_RECTS || (rect_count > 0 && !rect_list)) {
+		ls_printf("ERROR: lsSetOverlayDirtyRects: invalid rectangles: %d (max %d)\n", rect_count, LS_MAX_OVERLAY_DIRTY_RECTS);
+		return VX_ERROR_INVALID_PARAMETERS;
+	}
+	ls_overlay_dirty_rects dirty = { 0 };
+	dirty.count = rect_count;
+	for (vx_uint32 i = 0; i < rect_count; i++)
+		dirty.rect[i] = rect_list[i];
+
+	if (stitch->pipeline) {
+		// use the dirty rectangles for the next scheduled frame
+		std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+		ls_frame_buffers& pending = stitch->pipeline->pending;
+		pending.setOverlayDirty = true;
+		pending.overlayDirty = dirty;
+	}
+	else {
+		stitch->overlayDirtyRequested = true;
+		stitch->overlayDirty = dirty;
+	}
 
 	return VX_SUCCESS;
 }
@@ -3128,31 +5239,39 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsScheduleFrame(ls_context stitch)
 {
 	PROFILER_START(LoomSL, ScheduleGraph);
 	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
-	if (stitch->scheduled) {
-		ls_printf("ERROR: lsScheduleFrame: already scheduled\n");
-		return VX_ERROR_GRAPH_SCHEDULED;
-	}
 	if (stitch->reinitialize_required) {
 		ls_printf("ERROR: lsScheduleFrame: reinitialize required\n");
 		return VX_FAILURE;
 	}
 
-	// seamfind needs frame counter values to be incremented
-	if (stitch->SEAM_FIND) {
-		ERROR_CHECK_STATUS_(vxWriteScalarValue(stitch->current_frame, &stitch->current_frame_value));
-		stitch->current_frame_value++;
-	}
-
-	// exposure comp expects A_matrix to be initialized to ZERO on GPU
-	if ((stitch->EXPO_COMP <= 2) && stitch->A_matrix) {
-		ERROR_CHECK_STATUS_(vxWriteMatrix(stitch->A_matrix, stitch->A_matrix_initial_value));
-		ERROR_CHECK_STATUS_(vxDirective((vx_reference)stitch->A_matrix, VX_DIRECTIVE_AMD_COPY_TO_OPENCL));
+	if (stitch->pipeline) {
+		// queue the frame with its buffers for the worker thread
+		ls_frame_pipeline * pipeline = stitch->pipeline;
+		{
+			std::lock_guard<std::mutex> lock(pipeline->mutex);
+			if (pipeline->numScheduled - pipeline->numWaited >= pipeline->depth) {
+				ls_printf("ERROR: lsScheduleFrame: already scheduled %d frames\n", pipeline->depth);
+				return VX_ERROR_GRAPH_SCHEDULED;
+			}
+			pipeline->frame[pipeline->numScheduled % pipeline->depth] = pipeline->pending;
+			pipeline->pending.setCamera = pipeline->pending.setOutput = false;
+			pipeline->pending.setOverlay = pipeline->pending.setChromaKey = false;
+			pipeline->pending.setPreview = false;
+			pipeline->pending.setViewport = false;
+			pipeline->pending.setOverlayDirty = false;
+			pipeline->numScheduled++;
+		}
+		pipeline->cv.notify_all();
+		stitch->scheduled = true;
+		PROFILER_STOP(LoomSL, ScheduleGraph);
+		return VX_SUCCESS;
 	}
 
-	// age delay element if temporal noise filter activated
-	if (stitch->NOISE_FILTER){
-		ERROR_CHECK_STATUS_(vxAgeDelay(stitch->noiseFilterImageDelay));
+	if (stitch->scheduled) {
+		ls_printf("ERROR: lsScheduleFrame: already scheduled\n");
+		return VX_ERROR_GRAPH_SCHEDULED;
 	}
+	ERROR_CHECK_STATUS_(PrepareFrame(stitch));
 
 	// start the graph schedule
 	ERROR_CHECK_STATUS_(vxScheduleGraph(stitch->graphStitch));
@@ -3161,7 +5280,7 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsScheduleFrame(ls_context stitch)
 	return VX_SUCCESS;
 }
 
-//! \brief Schedule next frame
+//! \brief Wait for completion of the oldest scheduled frame
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsWaitForCompletion(ls_context stitch)
 {
 	PROFILER_START(LoomSL, WaitForCompletionGraph);
@@ -3171,33 +5290,49 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsWaitForCompletion(ls_context stitc
 		return VX_ERROR_GRAPH_SCHEDULED;
 	}
 
+	if (stitch->pipeline) {
+		// wait for the worker thread to complete the oldest frame
+		ls_frame_pipeline * pipeline = stitch->pipeline;
+		std::unique_lock<std::mutex> lock(pipeline->mutex);
+		pipeline->cv.wait(lock, [pipeline] { return pipeline->numCompleted > pipeline->numWaited; });
+		vx_status status = pipeline->status[pipeline->numWaited % pipeline->depth];
+		pipeline->numWaited++;
+		stitch->scheduled = (pipeline->numWaited < pipeline->numScheduled);
+		if (status != VX_SUCCESS) {
+			ls_printf("ERROR: lsWaitForCompletion: frame processing failed (%d)\n", status);
+			PROFILER_STOP(LoomSL, WaitForCompletionGraph);
+			return status;
+		}
+		PROFILER_STOP(LoomSL, WaitForCompletionGraph);
+		return VX_SUCCESS;
+	}
+
 	// wait for graph completion
 	ERROR_CHECK_STATUS_(vxWaitGraph(stitch->graphStitch));
 	stitch->scheduled = false;
 
-	// debug: dump auxiliary data
-	if (stitch->loomioAuxDumpFile) {
-		vx_array auxList[] = { stitch->loomioCameraAuxData, stitch->loomioOverlayAuxData, stitch->loomioOutputAuxData, stitch->loomioViewingAuxData };
-		for (size_t i = 0; i < sizeof(auxList) / sizeof(auxList[0]); i++) {
-			if (auxList[i]) {
-				vx_size numItems = 0;
-				ERROR_CHECK_STATUS_(vxQueryArray(auxList[i], VX_ARRAY_NUMITEMS, &numItems, sizeof(numItems)));
-				if (numItems > 0) {
-					vx_map_id map_id = 0;
-					vx_size stride = 0;
-					char * ptr = nullptr;
-					ERROR_CHECK_STATUS_(vxMapArrayRange(auxList[i], 0, numItems, &map_id, &stride, (void **)&ptr, VX_READ_ONLY, VX_MEMORY_TYPE_HOST, VX_NOGAP_X));
-					fwrite(ptr, 1, numItems * stride, stitch->loomioAuxDumpFile);
-					fflush(stitch->loomioAuxDumpFile);
-					ERROR_CHECK_STATUS_(vxUnmapArrayRange(auxList[i], map_id));
-				}
-			}
-		}
-	}
+	ERROR_CHECK_STATUS_(CompleteFrame(stitch));
 	PROFILER_STOP(LoomSL, WaitForCompletionGraph);
 	return VX_SUCCESS;
 }
 
+//! \brief Check completion of the oldest scheduled frame without waiting
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsQueryCompletion(ls_context stitch, vx_bool * completed)
+{
+	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
+	if (!stitch->pipeline) {
+		ls_printf("ERROR: lsQueryCompletion: needs pipeline depth > 1\n");
+		return VX_ERROR_NOT_SUPPORTED;
+	}
+	if (!stitch->scheduled) {
+		ls_printf("ERROR: lsQueryCompletion: not scheduled\n");
+		return VX_ERROR_GRAPH_SCHEDULED;
+	}
+	std::lock_guard<std::mutex> lock(stitch->pipeline->mutex);
+	*completed = (stitch->pipeline->numCompleted > stitch->pipeline->numWaited) ? vx_true_e : vx_false_e;
+	return VX_SUCCESS;
+}
+
 //! \brief query functions.
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetOpenVXContext(ls_context stitch, vx_context  * openvx_context)
 {
@@ -3261,6 +5396,14 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetOverlayConfig(ls_context stitch
 	*buffer_height = stitch->overlay_buffer_height;
 	return VX_SUCCESS;
 }
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetPreviewConfig(ls_context stitch, vx_df_image * buffer_format, vx_uint32 * buffer_width, vx_uint32 * buffer_height)
+{
+	ERROR_CHECK_STATUS_(IsValidContext(stitch));
+	*buffer_format = VX_DF_IMAGE_RGB;
+	*buffer_width = stitch->preview_buffer_width;
+	*buffer_height = stitch->preview_buffer_height;
+	return VX_SUCCESS;
+}
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetCameraParams(ls_context stitch, vx_uint32 cam_index, camera_params * par)
 {
 	ERROR_CHECK_STATUS_(IsValidContext(stitch));
@@ -3569,6 +5712,18 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsExportConfiguration(ls_context sti
 	}
 	else if (!_stricmp(exportType, "gdf")) {
 		ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
+		if (stitch->overlayRegions) {
+			ls_printf("ERROR: lsExportConfiguration: gdf: overlay regions are not supported: set LIVE_STITCH_ATTR_OVERLAY_REGIONS to 0\n");
+			return VX_ERROR_NOT_SUPPORTED;
+		}
+		if (stitch->gain_delay) {
+			ls_printf("ERROR: lsExportConfiguration: gdf: solved gains applied by warp are not supported: set LIVE_STITCH_ATTR_WARP_EXPCOMP_GAINS to 0\n");
+			return VX_ERROR_NOT_SUPPORTED;
+		}
+		if (stitch->Img_preview) {
+			ls_printf("ERROR: lsExportConfiguration: gdf: preview output is not supported: set LIVE_STITCH_ATTR_PREVIEW_SCALE to 0\n");
+			return VX_ERROR_NOT_SUPPORTED;
+		}
 		if (_stricmp(fileName + strlen(fileName) - 4, ".gdf")) {
 			ls_printf("ERROR: lsExportConfiguration: gdf: requires fileName extension to be .gdf\n");
 			return VX_ERROR_INVALID_PARAMETERS;
@@ -3659,6 +5814,10 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsExportConfiguration(ls_context sti
 			refNameList[(vx_reference)stitch->cam_id_image] = "cam_id_image";
 			refNameList[(vx_reference)stitch->group1_image] = "group1_image";
 			refNameList[(vx_reference)stitch->group2_image] = "group2_image";
+			if (stitch->MergeRemapEntry) {
+				fprintf(fp, "data mergeRemapTable = array:WarpRemapEntryType,%d\n", (int)stitch->table_sizes.warpTableSize);
+				refNameList[(vx_reference)stitch->MergeRemapEntry] = "mergeRemapTable";
+			}
 			if (stitch->EXPO_COMP) {
 				fprintf(fp, "type ExpCompValidEntryType userstruct:%d\n", (int)sizeof(StitchOverlapPixelEntry));
 				fprintf(fp, "type ExpCompCalcEntryType userstruct:%d\n", (int)sizeof(StitchExpCompCalcEntry));
@@ -3667,13 +5826,13 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsExportConfiguration(ls_context sti
 				fprintf(fp, "data expCompGain = array:VX_TYPE_FLOAT32,%d\n", (int)stitch->num_cameras);
 				fprintf(fp, "data expCompAMat = matrix:VX_TYPE_INT32,%d,%d\n", stitch->num_cameras, stitch->num_cameras);
 				fprintf(fp, "data expCompCountMat = matrix:VX_TYPE_INT32,%d,%d\n", stitch->num_cameras, stitch->num_cameras);
-				fprintf(fp, "data RGBY2 = image:%d,%d,RGBA\n", stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras);
+				if (stitch->RGBY2) fprintf(fp, "data RGBY2 = image:%d,%d,RGBA\n", stitch->output_rgb_buffer_width, stitch->output_rgb_buffer_height * stitch->num_cameras);
 				refNameList[(vx_reference)stitch->valid_array] = "expCompValidTable";
 				if (stitch->EXPO_COMP < 3) refNameList[(vx_reference)stitch->OverlapPixelEntry] = "expCompCalcTable";
 				refNameList[(vx_reference)stitch->gain_array] = "expCompGain";
 				refNameList[(vx_reference)stitch->A_matrix] = "expCompAMat";
 				refNameList[(vx_reference)stitch->overlap_matrix] = "expCompCountMat";
-				refNameList[(vx_reference)stitch->RGBY2] = "RGBY2";
+				if (stitch->RGBY2) refNameList[(vx_reference)stitch->RGBY2] = "RGBY2";
 			}
 			if (stitch->SEAM_FIND) {
 				fprintf(fp, "type SeamFindValidEntryType userstruct:%d\n", (int)sizeof(StitchSeamFindValidEntry));
@@ -4014,13 +6173,15 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetExpCompGains(ls_context stitch,
 	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
 	if (!stitch->EXPO_COMP || !stitch->gain_array)
 		return VX_ERROR_NOT_SUPPORTED;
+	// with the gain delay, the gains of the current frame are applied by the warp of the next frame
+	vx_array gain_array = stitch->gain_delay ? (vx_array)vxGetReferenceFromDelay(stitch->gain_delay, 0) : stitch->gain_array;
 	vx_size count;
-	ERROR_CHECK_STATUS_(vxQueryArray(stitch->gain_array, VX_ARRAY_NUMITEMS, &count, sizeof(count)));
+	ERROR_CHECK_STATUS_(vxQueryArray(gain_array, VX_ARRAY_NUMITEMS, &count, sizeof(count)));
 	if (num_entries != count) {
 		ls_printf("ERROR: lsSetExpCompGains: expects num_entries to be %d: got %d\n", (vx_uint32)count, (vx_uint32)num_entries);
 		return VX_ERROR_INVALID_PARAMETERS;
 	}
-	ERROR_CHECK_STATUS_(vxCopyArrayRange(stitch->gain_array, 0, num_entries, sizeof(vx_float32), gains, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST));
+	ERROR_CHECK_STATUS_(vxCopyArrayRange(gain_array, 0, num_entries, sizeof(vx_float32), gains, VX_WRITE_ONLY, VX_MEMORY_TYPE_HOST));
 	return VX_SUCCESS;
 }
 
@@ -4029,16 +6190,51 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetExpCompGains(ls_context stitch,
 	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
 	if (!stitch->EXPO_COMP || !stitch->gain_array) 
 		return VX_ERROR_NOT_SUPPORTED;
+	vx_array gain_array = stitch->gain_delay ? (vx_array)vxGetReferenceFromDelay(stitch->gain_delay, 0) : stitch->gain_array;
 	vx_size count;
-	ERROR_CHECK_STATUS_(vxQueryArray(stitch->gain_array, VX_ARRAY_NUMITEMS, &count, sizeof(count)));
+	ERROR_CHECK_STATUS_(vxQueryArray(gain_array, VX_ARRAY_NUMITEMS, &count, sizeof(count)));
 	if (num_entries != count) {
 		ls_printf("ERROR: lsGetExpCompGains: expects num_entries to be %d: got %d\n", (vx_uint32)count, (vx_uint32)num_entries);
 		return VX_ERROR_INVALID_PARAMETERS;
 	}
-	ERROR_CHECK_STATUS_(vxCopyArrayRange(stitch->gain_array, 0, num_entries, sizeof(vx_float32), gains, VX_READ_ONLY, VX_MEMORY_TYPE_HOST));
+	ERROR_CHECK_STATUS_(vxCopyArrayRange(gain_array, 0, num_entries, sizeof(vx_float32), gains, VX_READ_ONLY, VX_MEMORY_TYPE_HOST));
+	return VX_SUCCESS;
+}
+
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetStageTimes(ls_context stitch, ls_stage_times * times)
+{
+	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
+	if (!times)
+		return VX_ERROR_INVALID_PARAMETERS;
+	StitchGraphNode list[maxGraphNodes];
+	vx_perf_t perf[maxGraphNodes];
+	vx_uint32 count = GetGraphNodes(stitch, list);
+	QueryGraphNodePerf(list, count, perf);
+	float stage[STAGE_OTHER + 1] = { 0 };
+	for (vx_uint32 i = 0; i < count; i++) {
+		if (perf[i].num > 0)
+			stage[list[i].stage] += (float)((perf[i].end - perf[i].beg) * 1e-6);
+	}
+	times->warp = stage[STAGE_WARP];
+	times->merge = stage[STAGE_MERGE];
+	times->expcomp = stage[STAGE_EXPCOMP];
+	times->seamfind = stage[STAGE_SEAMFIND];
+	times->multiband = stage[STAGE_MULTIBAND];
+	times->other = stage[STAGE_OTHER];
+	times->total = 0;
+	for (vx_uint32 i = 0; i <= STAGE_OTHER; i++)
+		times->total += stage[i];
 	return VX_SUCCESS;
 }
 
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetMemoryUsage(ls_context stitch, ls_memory_usage * usage)
+{
+	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
+	if (!usage)
+		return VX_ERROR_INVALID_PARAMETERS;
+	return GetMemoryUsage(stitch, usage);
+}
+
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetBlendWeights(ls_context stitch, vx_uint8 * weights, size_t size)
 {
 	ERROR_CHECK_STATUS_(IsValidContextAndInitialized(stitch));
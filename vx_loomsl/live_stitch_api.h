@@ -54,6 +54,8 @@ enum {
 	LIVE_STITCH_ATTR_MULTIBAND                =    5,   // multiband attribute: 0:OFF 1:ON
 	LIVE_STITCH_ATTR_MULTIBAND_NUMBANDS       =    6,   // multiband attribute: numbands 2-6
 	LIVE_STITCH_ATTR_STITCH_MODE              =    7,   // stitch mode: 0:normal 1:quick (default: normal)
+	LIVE_STITCH_ATTR_PIPELINE_DEPTH           =    8,   // number of frames in flight per context: 1 - 4 (default: 1)
+	LIVE_STITCH_ATTR_VIEWPORT_MARGIN          =    9,   // margin around the lsSetViewport viewport in degrees: 0 - 90 (default: 10)
 	LIVE_STITCH_ATTR_ENABLE_REINITIALIZE      =   10,   // enable lsReinitialize (default disabled)
 	LIVE_STITCH_ATTR_REDUCE_OVERLAP_REGION    =   11,   // Reduces the overlap region by n*n pixels (default: 0)
 	LIVE_STITCH_ATTR_SEAM_VERT_PRIORITY       =   12,   // Vertical seam priority: -1 to N Flag. -1:Disable 1:highest N:Lowest. (default 1)
@@ -71,6 +73,7 @@ enum {
 	LIVE_STITCH_ATTR_SEAM_COEQUSH_OVERLAP_VD  =   25,   // max vertical overlap in degrees (default: 20)
 	LIVE_STITCH_ATTR_SEAM_COEQUSH_TOPBOT_TOL  =   26,   // top and bottom camera pitch tolerance (default: 5)
 	LIVE_STITCH_ATTR_SEAM_COEQUSH_TOPBOT_VGD  =   27,   // top and bottom camera vertical overlap clamp in degrees for equaor cameras (default: 0)
+	LIVE_STITCH_ATTR_SEAM_COARSE_SCALE        =   28,   // coarse-to-fine seam search on 1/N cost (CPU): 0:OFF 2 - 64:N, larger values are clamped to 64 (default: 0)
 	LIVE_STITCH_ATTR_MULTIBAND_PAD_PIXELS     =   29,   // multiband attribute: padding pixel count (default: 0)
 	LIVE_STITCH_ATTR_EXPCOMP_GAIN_IMG_W       =   30,   // exp-comp attribute: gain image width (default: 1)
 	LIVE_STITCH_ATTR_EXPCOMP_GAIN_IMG_H       =   31,   // exp-comp attribute: gain image height (default: 1)
@@ -81,6 +84,7 @@ enum {
 	LIVE_STITCH_ATTR_EXPCOMP_GAIN_IMG_C		  =	  36,   // exp-comp attribute: gain image num channels (default: 1)
 	LIVE_STITCH_ATTR_EXPCOMP_ALPHA_VALUE	  =	  37,   // exp-comp attribute: alpha value (variance of gain)
 	LIVE_STITCH_ATTR_EXPCOMP_BETA_VALUE		  =   38,   // exp-comp attribute: beta value (variance of mean intensity)
+	LIVE_STITCH_ATTR_OUTPUT_PROJECTION        =   39,   // output projection: 0:equirectangular 1:cubemap 2:EAC (default: 0) -- see lsSetOutputConfig
 	LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_X		  =	  40,   // number of horizontal tiles in the output (default: 1)
 	LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_Y		  =   41,   // number of veritical tiles in the output (default: 1)
 	LIVE_STITCH_ATTR_OUTPUT_src_tile_overlap  =   42,   // overlap pixel count (default: 0)
@@ -88,16 +92,25 @@ enum {
 	LIVE_STITCH_ATTR_OUTPUT_ENCODER_WIDTH     =   44,   // encoder buffer width (default: 3840)
 	LIVE_STITCH_ATTR_OUTPUT_ENCODER_HEIGHT    =   45,   // encoder buffer height (default: 2160)
 	LIVE_STITCH_ATTR_OUTPUT_ENCODER_STRIDE_Y  =   46,   // encoder buffer stride_y (default: 2160)
+	LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS         =   47,   // process the output tiles as concurrent jobs in quick stitch mode: 0:OFF 1:ON (default: 0) -- see lsInitialize
+	LIVE_STITCH_ATTR_OVERLAY_REGIONS          =   48,   // warp and blend overlays only in the output regions they cover: 0:OFF 1:ON (default: 1) -- see lsInitialize
+	LIVE_STITCH_ATTR_FUSED_WARP_MERGE         =   49,   // merge samples the pixels covered by a single camera from the camera input: 0:OFF 1:ON (default: 0) -- see lsInitialize
 	LIVE_STITCH_ATTR_CHROMA_KEY				  =   50,   // chroma key enable: 0:OFF 1:ON (default:0)
 	LIVE_STITCH_ATTR_CHROMA_KEY_VALUE		  =   51,   // chroma key value: 0 - N (default: 8454016 - Green 0x80FF80)
 	LIVE_STITCH_ATTR_CHROMA_KEY_TOL			  =	  52,   // chroma key tol: 0 - N (default: 25)
 	LIVE_STITCH_ATTR_CHROMA_KEY_EED			  =	  53,   // chroma key enable erode and dilate mask: 0:OFF 1:ON (default:0)
+	LIVE_STITCH_ATTR_WARP_EXPCOMP_GAINS       =   54,   // warp applies the exposure comp gains as it writes the pixels: 0:OFF 1:ON (default: 0) -- see lsInitialize
 	LIVE_STITCH_ATTR_NOISE_FILTER			  =   55,   // temporal filter to account for the camera noise: 0:OFF 1:ON (default:0)
 	LIVE_STITCH_ATTR_USE_CPU_FOR_INIT         =   56,   // use CPU kernels for initialize stitch: 0:OFF 1:ON (default:0)
-	LIVE_STITCH_ATTR_SAVE_AND_LOAD_INIT		  =	  57,   // save initialized stitch tables for quick load&run: 0:OFF 1:ON (default:0)
+	LIVE_STITCH_ATTR_SAVE_AND_LOAD_INIT		  =	  57,   // save initialized stitch tables in table cache file (LOOM_TABLE_CACHE) for quick load&run: 0:OFF 1:ON (default:0)
+	LIVE_STITCH_ATTR_SHARE_INIT_TABLES        =   58,   // share initialized stitch tables between contexts of the process with the same configuration: 0:OFF 1:ON (default:0)
+	LIVE_STITCH_ATTR_EXPCOMP_GAIN_SMOOTHING   =   59,   // exp-comp attribute: temporal smoothing of the solved gains: weight of the previous frame gains 0 - 0.99 (default:0)
+	LIVE_STITCH_ATTR_EXPCOMP_SUBSAMPLE        =   60,   // exp-comp attribute: subsample step of the overlap statistics of modes 1 and 2: 1, 2, or 4 (default:1)
+	LIVE_STITCH_ATTR_PREVIEW_SCALE            =   61,   // low resolution preview output downscaled from the stitched output by 1/N: 0:OFF 2 - 16 (default: 0) -- see lsSetPreviewBuffer
 	// Dynamic LoomSL attributes
 	LIVE_STITCH_ATTR_SEAM_THRESHOLD           =   64,   // seamfind seam refresh Threshold: 0 - 100 percentage change (default:25)
 	LIVE_STITCH_ATTR_NOISE_FILTER_LAMBDA	  =   65,   // temporal filter variable: 0 - 1 (default:1)
+	LIVE_STITCH_ATTR_NOISE_FILTER_MOTION	  =   66,   // temporal filter motion threshold: mean abs difference per 16x16 block at which lambda reaches 1, 0:OFF (default:0) -- non-zero at lsInitialize runs the filter on CPU
 	// ... reserved for LoomSL internal attributes
 	LIVE_STITCH_ATTR_RESERVED_CORE_END        =  127,   // reserved first 128 attributes for LoomSL internal attributes
 	LIVE_STITCH_ATTR_RESERVED_EXT_BEGIN       =  128,   // start of reserved attributes for extensions
@@ -148,6 +161,36 @@ typedef struct {
     float d;                // focus sphere radius in depth pixel units (default: 0.0 for infinity)
 } rig_params;
 
+//! \brief The processing time of the stitch stages (in milliseconds).
+typedef struct {
+	float warp;      // warp and simple stitch remap
+	float merge;     // merge
+	float expcomp;   // exposure compensation: gain computation, solver and apply
+	float seamfind;  // seam find including its sobel/magnitude/phase preprocessing
+	float multiband; // multiband blend of all levels
+	float other;     // color conversions, noise filter, overlay, chroma key and LoomIO modules
+	float total;     // sum of all stages
+} ls_stage_times;
+
+//! \brief The memory size of a part of the stitch context (in bytes).
+typedef struct {
+	vx_uint64 host;   // host memory
+	vx_uint64 device; // device (OpenCL) memory
+} ls_memory_size;
+
+//! \brief The memory usage of the stitch context by category.
+typedef struct {
+	ls_memory_size warp;         // warp and remap tables, lens model buffers, and GPU initialize data
+	ls_memory_size merge;        // merge tables
+	ls_memory_size expcomp;      // exposure compensation tables, matrices, gains, and gain solver buffers
+	ls_memory_size seamfind;     // seam find tables and images
+	ls_memory_size multiband;    // multiband blend pyramids, masks, and offsets
+	ls_memory_size intermediate; // color conversion, warp, exposure comp, overlay, noise filter, chroma key, and tile images
+	ls_memory_size loomio;       // LoomIO camera, overlay, and output images and auxiliary data
+	ls_memory_size other;        // quick setup table cache mapping and shared tables
+	ls_memory_size total;        // sum of all categories
+} ls_memory_usage;
+
 
 //////////////////////////////////////////////////////////////////////
 //! \brief The log callback function
@@ -182,6 +225,21 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalSetAttributes(vx_uint32 attr
 //  - return VX_SUCCESS or error code (see log messages for further details)
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalGetAttributes(vx_uint32 attr_offset, vx_uint32 attr_count, vx_float32 * attr_ptr);
 
+//! \brief Enable or disable the profiler ring buffer mode.
+//  - in ring buffer mode the profiler keeps the latest events instead of stopping when its event buffer is full,
+//    so that it can stay enabled on a running stitcher and be dumped on demand using lsGlobalDumpProfilerTrace
+//  - the recording restarts when the mode is changed (VISUAL_PROFILER_RING_BUFFER=1 enables it at startup)
+//  - builds without visual profile (PROFILER_MODE 0) record events only once the ring buffer mode is enabled
+//  - return VX_SUCCESS or error code (see log messages for further details)
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalSetProfilerRingBuffer(vx_bool enable);
+
+//! \brief Dump the profiler events recorded so far in Chrome trace format (trace_event JSON) without stopping the profiler.
+//  - the trace has a track per thread with the PROFILER_START/STOP events, PROFILER_DATA values as counter tracks,
+//    and a track per OpenVX graph node when LIVE_STITCH_ATTR_PROFILER is enabled on the stitch context
+//  - the trace is also written next to the visual profile when the profiler shuts down (PROFILER_MODE 1)
+//  - return VX_SUCCESS or error code (see log messages for further details)
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGlobalDumpProfilerTrace(const char * fileName);
+
 //! \brief Create stitch context.
 //  - create a stitch context using the feature dictated by global attributes prior to this call
 //  - returns NULL on error (see log messages for further details)
@@ -197,6 +255,13 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsReleaseContext(ls_context * pStitc
 //  - buffer_width must be multiple of 16
 //  - buffer_height must be multiple of 2
 //  - Note that output scale factor attribute is not supported when output format is VX_DF_IMAGE_RGB
+//  - buffer_width must be 2 times buffer_height for equirectangular output and 1.5 times buffer_height for
+//    cubemap and EAC outputs (checked by lsInitialize)
+//  - LIVE_STITCH_ATTR_OUTPUT_PROJECTION selects the projection of the output buffer: cubemap and EAC outputs are
+//    generated directly by the warp as a 3x2 grid of square faces of size buffer_height/2 (top row: left, front,
+//    right; bottom row: down, back, up rotated to form a continuous strip); multiband blend processes the two
+//    face rows as separate images, so that the pyramids don't mix the faces across the seam between the rows;
+//    LIVE_STITCH_ATTR_CHROMA_KEY is only supported with equirectangular output
 //  - Note that this function must be called before lsInitialize call
 //  - return VX_SUCCESS or error code (see log messages for further details)
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOutputConfig(ls_context stitch, vx_df_image buffer_format, vx_uint32 buffer_width, vx_uint32 buffer_height);
@@ -285,6 +350,30 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOpenVXContext(ls_context stitch
 //! \brief initialize the stitch context.
 //  - shall be called after all the configuration parameters are set and before scheduling a frame for stitching
 //  - can be called only once after creating the context
+//  - with LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS, each of the LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_X x LIVE_STITCH_ATTR_OUTPUT_TILE_NUM_Y
+//    output tiles is stitched by its own graph and the tile graphs of a frame run concurrently on up to one thread per
+//    core: only quick stitch mode without overlays, chroma key, and LoomIO output/viewing is supported. Normal stitch
+//    mode is not supported and lsInitialize fails with VX_ERROR_NOT_SUPPORTED. For NV12/IYUV output with more than one
+//    tile, each tile (with LIVE_STITCH_ATTR_OUTPUT_src_tile_overlap) goes to its encoder buffer as without tile jobs.
+//  - with LIVE_STITCH_ATTR_OVERLAY_REGIONS and without LIVE_STITCH_ATTR_ENABLE_REINITIALIZE, the overlays are warped and
+//    blended only in the output regions they cover (transparent overlay pixels are copied without blending): see
+//    lsSetOverlayDirtyRects. The gdf export of lsExportConfiguration isn't supported with overlay regions.
+//  - with LIVE_STITCH_ATTR_FUSED_WARP_MERGE in normal stitch mode without seam find, multiband blend, and exposure comp modes 3 and 4,
+//    the output pixels covered by a single camera are sampled by the merge kernel directly from the camera input
+//    (with the exposure comp gains applied): only the overlap pixels are warped into the intermediate image.
+//  - with LIVE_STITCH_ATTR_WARP_EXPCOMP_GAINS and exposure comp, the warp kernel applies the gains as it writes the
+//    warped pixels instead of a separate pass over the warped image. The gains solved by modes 1 and 2 are applied
+//    from the next frame on (the first frame uses gains of 1.0): the gdf export of lsExportConfiguration isn't
+//    supported for these modes.
+//  - with LIVE_STITCH_ATTR_EXPCOMP_GAIN_SMOOTHING, the gains solved by exposure comp modes 1 and 2 are blended with
+//    the gains of the previous frame to reduce flicker: a higher weight reacts slower to exposure changes.
+//  - with LIVE_STITCH_ATTR_EXPCOMP_SUBSAMPLE of 2 or 4, exposure comp modes 1 and 2 gather the overlap statistics
+//    from every 2nd or 4th pixel of every 2nd or 4th row.
+//  - with LIVE_STITCH_ATTR_PREVIEW_SCALE, a RGB preview of the stitched output (after chroma key and overlays) downscaled
+//    by 1/N is written into the buffer set by lsSetPreviewBuffer (see lsGetPreviewConfig). Each preview pixel is the
+//    average of a NxN block of the output, computed by a node of the same graph, so it shares the seams and gains of
+//    the frame. Not supported with
+//    LIVE_STITCH_ATTR_OUTPUT_TILE_JOBS and the gdf export of lsExportConfiguration.
 //  - return VX_SUCCESS or error code (see log messages for further details)
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsInitialize(ls_context stitch);
 
@@ -301,19 +390,52 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsReinitialize(ls_context stitch);
 //     overlay_buffer - overlay opencl buffer with all images
 //     output_buffer  - output opencl buffer for output equirectangular image
 //     chromaKey_buffer  - chroma key opencl buffer for equirectangular image
+//     preview_buffer - preview opencl buffer for downscaled RGB output image (needs LIVE_STITCH_ATTR_PREVIEW_SCALE)
 //   Use of nullptr will return the control of previously set buffer
 //  - return VX_SUCCESS or error code (see log messages for further details)
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetCameraBuffer(ls_context stitch, cl_mem * input_buffer);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOutputBuffer(ls_context stitch, cl_mem * output_buffer);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOverlayBuffer(ls_context stitch, cl_mem * overlay_buffer);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetChromaKeyBuffer(ls_context stitch, cl_mem * chromaKey_buffer);
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetPreviewBuffer(ls_context stitch, cl_mem * preview_buffer);
 
 //! \brief Schedule a frame
-//  - only one frame can be scheduled at a time
-//  - every lsScheduleFrame call should be followed by lsWaitForCompletion call
+//  - upto LIVE_STITCH_ATTR_PIPELINE_DEPTH frames can be scheduled at a time (only one by default)
+//  - every lsScheduleFrame call should be followed by lsWaitForCompletion call: frames complete in schedule order
+//  - with pipeline depth > 1, the buffers set after an lsScheduleFrame call are used for the next scheduled frame,
+//    so the buffers of a frame can be reused only after its lsWaitForCompletion call
+//  - lsQueryCompletion returns whether the oldest scheduled frame has completed without waiting (needs pipeline depth > 1)
 //  - return VX_SUCCESS or error code (see log messages for further details)
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsScheduleFrame(ls_context stitch);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsWaitForCompletion(ls_context stitch);
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsQueryCompletion(ls_context stitch, vx_bool * completed);
+
+//! \brief Set the viewport for viewport-restricted stitching (interactive viewing)
+//     yaw   - viewing direction longitude in degrees: -180 (left edge of output) to 180 (right edge of output)
+//     pitch - viewing direction latitude in degrees: -90 (bottom of output) to 90 (top of output)
+//     hfov  - horizontal field of view in degrees (use 0 to stitch the complete output)
+//     vfov  - vertical field of view in degrees
+//  - warp, exposure comp gain apply, and multiband blend are restricted to the output tiles that intersect
+//    the viewport expanded by LIVE_STITCH_ATTR_VIEWPORT_MARGIN: the output pixels outside these tiles are undefined
+//  - while a viewport is set, the exposure comp gains and the seams of the last complete frame are kept, as the
+//    pixels outside the selected tiles aren't warped
+//  - the viewport is used from the next lsScheduleFrame call (per frame when pipeline depth > 1)
+//  - not supported when the context shares its table objects with other contexts (LIVE_STITCH_ATTR_SHARE_INIT_TABLES
+//    with a shared OpenVX context): the frame fails with VX_ERROR_NOT_SUPPORTED
+//  - return VX_SUCCESS or error code (see log messages for further details)
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetViewport(ls_context stitch, vx_float32 yaw, vx_float32 pitch, vx_float32 hfov, vx_float32 vfov);
+
+//! \brief Set the output rectangles where the overlays of the next frame have pixels that aren't transparent
+//     rect_count - number of rectangles: 0 - 16 (0: nothing is blended)
+//     rect_list  - rectangles in output pixels
+//  - the overlays are blended only in the parts of the overlay regions inside these rectangles, so that frames with
+//    small or no overlay content (e.g. captions that come and go) cost less
+//  - applies only to the next lsScheduleFrame call (per frame when pipeline depth > 1): the frames after it blend the
+//    complete overlay regions until the next call
+//  - needs the overlay regions of LIVE_STITCH_ATTR_OVERLAY_REGIONS: returns VX_ERROR_NOT_SUPPORTED when the complete
+//    output is warped and blended instead
+//  - return VX_SUCCESS or error code (see log messages for further details)
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetOverlayDirtyRects(ls_context stitch, vx_uint32 rect_count, const vx_rectangle_t * rect_list);
 #endif
 
 //! \brief access to context specific attributes.
@@ -323,10 +445,13 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetAttributes(ls_context stitch, v
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetAttributes(ls_context stitch, vx_uint32 attr_offset, vx_uint32 attr_count, vx_float32 * attr_ptr);
 
 //! \brief Query configuration.
+//  - lsGetPreviewConfig gives the preview buffer of lsSetPreviewBuffer after lsInitialize: RGB with a stride of
+//    buffer_width * 3 bytes (the width and height are 0 without LIVE_STITCH_ATTR_PREVIEW_SCALE)
 //  - return VX_SUCCESS or error code (see log messages for further details)
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetOutputConfig(ls_context stitch, vx_df_image * buffer_format, vx_uint32 * buffer_width, vx_uint32 * buffer_height);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetCameraConfig(ls_context stitch, vx_uint32 * num_camera_rows, vx_uint32 * num_camera_columns, vx_df_image * buffer_format, vx_uint32 * buffer_width, vx_uint32 * buffer_height);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetOverlayConfig(ls_context stitch, vx_uint32 * num_overlay_rows, vx_uint32 * num_overlay_columns, vx_df_image * buffer_format, vx_uint32 * buffer_width, vx_uint32 * buffer_height);
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetPreviewConfig(ls_context stitch, vx_df_image * buffer_format, vx_uint32 * buffer_width, vx_uint32 * buffer_height);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetCameraParams(ls_context stitch, vx_uint32 cam_index, camera_params * par);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetOverlayParams(ls_context stitch, vx_uint32 overlay_index, camera_params * par);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetRigParams(ls_context stitch, rig_params * par);
@@ -360,6 +485,19 @@ LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsExportConfiguration(ls_context sti
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsSetExpCompGains(ls_context stitch, size_t num_entries, vx_float32 * gains);
 LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetExpCompGains(ls_context stitch, size_t num_entries, vx_float32 * gains);
 
+//! \brief Get the processing time of the stitch stages on the last completed frame.
+//  - uses the OpenVX node performance of the graph nodes of each stage
+//  - call after lsWaitForCompletion
+//  - return VX_SUCCESS or error code (see log messages for further details)
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetStageTimes(ls_context stitch, ls_stage_times * times);
+
+//! \brief Get the memory used by the tables, images, and buffers of the stitch context.
+//  - OpenVX objects count as device memory when the kernels using them run on the GPU, and as host memory
+//    otherwise or when they are initialized on the host; virtual images count with their full size
+//  - images of the user OpenCL buffers are not counted; shared tables count in each context using them
+//  - return VX_SUCCESS or error code (see log messages for further details)
+LIVE_STITCH_API_ENTRY vx_status VX_API_CALL lsGetMemoryUsage(ls_context stitch, ls_memory_usage * usage);
+
 //! \brief set custom blend weights.
 //  - valid when seam find is not active
 //  - weights: array of weights in output_width * output_height * num_camera
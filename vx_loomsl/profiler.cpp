@@ -2,7 +2,6 @@
 #define _CRT_SECURE_NO_DEPRECATE
 #include "profiler.h"
 #include <iostream>
-#if PROFILER_MODE
 
 #if _WIN32
 #include <windows.h>
@@ -12,9 +11,16 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <cstring>
-#include <chrono>
 #endif
 #include <stdio.h>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
 
 #undef PROFILER_DEFINE_EVENT
 #define PROFILER_DEFINE_EVENT(g,e) #g "-" #e,
@@ -23,14 +29,34 @@ const char * ProfilerEventName[] = {
 	""
 };
 
+// profiler events are stored in a record buffer shared by all threads: seq is set to (index + 1)
+// once the record of an event index is complete, so that the buffer can be copied consistently
+// while other threads keep adding events (needed for dumps from the ring buffer mode)
+struct ProfilerEvent {
+	int data;              // (event << 2) | type -- type: 0:start 1:stop 2:data 3:graph node
+	int track;             // thread track (type 0-2) or graph node track (type 3)
+	__int64 clock;         // time in nanoseconds
+	__int64 value;         // data value (type 2) or graph node duration in nanoseconds (type 3)
+};
+struct ProfilerRecord {
+	std::atomic<__int64> seq;
+	ProfilerEvent event;
+};
+static int MAX_PROFILER_EVENTS = 16000;
 static int profiler_init = 0;
-
-#if PROFILER_MODE
-static int MAX_PROFILER_EVENTS = 0;
-static int profiler_count = 0;
-static int * profiler_data = 0;
-static __int64 * profiler_clock = 0;
-static inline __int64 my_rdtsc(){ return __rdtsc(); }
+static std::mutex profiler_mutex;                  // allocation, mode changes, snapshots, and release of the records
+static std::atomic<ProfilerRecord *> profiler_records(nullptr);
+static std::atomic<int> profiler_writers(0);       // threads adding an event to profiler_records
+static std::atomic<__int64> profiler_count(0);     // events added since the records were allocated
+static std::atomic<__int64> profiler_begin(0);     // profiler_count at the start of the current recording
+static std::atomic<bool> profiler_ring(false);
+static std::atomic<bool> profiler_full(false);     // the recording stopped with a full buffer (no ring buffer mode)
+std::atomic<bool> _profiler_recording(false);       // profiler_records allocated and not full
+static std::atomic<int> profiler_thread_count(0);
+static std::mutex profiler_track_mutex;
+static std::vector<std::string> profiler_track_names;
+static inline __int64 my_clock(){ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+static inline int my_thread_track(){ static thread_local int track = ++profiler_thread_count; return track; }
 extern void ls_printf(const char * format, ...);
 bool ls_getEnvironmentVariable(const char * name, char * value, size_t valueSize)
 {
@@ -47,6 +73,7 @@ bool ls_getEnvironmentVariable(const char * name, char * value, size_t valueSize
 	return v ? true : false;
 #endif
 }
+#if PROFILER_MODE
 const char * header =
 "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\">\n"
 "<html>\n"
@@ -97,7 +124,135 @@ const char * colorlist[] = {
 };
 
 char default_profiler_name[1024] = "profiler";
+#endif
+
+// the event buffer is kept until the last PROFILER_SHUTDOWN: a full buffer only stops the recording
+static void profiler_add(int data, int track, __int64 clock, __int64 value)
+{
+	if (!profiler_records.load(std::memory_order_relaxed) || profiler_full.load(std::memory_order_relaxed)) return;
+	profiler_writers++;
+	ProfilerRecord * records = profiler_records.load();
+	if (records) {
+		__int64 k = profiler_count.fetch_add(1);
+		bool ring = profiler_ring.load(std::memory_order_relaxed);
+		if (!ring && k - profiler_begin.load(std::memory_order_relaxed) >= MAX_PROFILER_EVENTS) {
+			profiler_full = true;
+			_profiler_recording = false;
+		}
+		else {
+			ProfilerRecord& r = records[k % MAX_PROFILER_EVENTS];
+			r.seq.store(0, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			r.event.data = data;
+			r.event.track = track;
+			r.event.clock = clock;
+			r.event.value = value;
+			r.seq.store(k + 1, std::memory_order_release);
+		}
+	}
+	profiler_writers--;
+}
+
+// allocate the event buffer (called with profiler_mutex locked)
+static void profiler_allocate()
+{
+	if (!profiler_records) {
+		ProfilerRecord * records = new ProfilerRecord[MAX_PROFILER_EVENTS];
+		for (int k = 0; k < MAX_PROFILER_EVENTS; k++) records[k].seq = 0;
+		profiler_count = 0;
+		profiler_begin = 0;
+		profiler_full = false;
+		profiler_records = records;
+	}
+	_profiler_recording = true;
+}
+
+// release the event buffer once no thread is adding an event (called with profiler_mutex locked)
+static void profiler_release()
+{
+	_profiler_recording = false;
+	ProfilerRecord * records = profiler_records.exchange(nullptr);
+	while (profiler_writers.load() > 0)
+		std::this_thread::yield();
+	delete[] records;
+}
+
+// copy the complete events in the order of recording: the oldest events are skipped in ring buffer mode
+// (called with profiler_mutex locked)
+static void profiler_snapshot(std::vector<ProfilerEvent>& events)
+{
+	events.clear();
+	ProfilerRecord * records = profiler_records.load();
+	if (!records) return;
+	__int64 end = profiler_count.load(std::memory_order_acquire), begin = profiler_begin.load();
+	if (profiler_ring) begin = std::max(begin, end - MAX_PROFILER_EVENTS);
+	else end = std::min(end, begin + MAX_PROFILER_EVENTS);
+	events.reserve((size_t)std::max(end - begin, (__int64)0));
+	for (__int64 k = begin; k < end; k++) {
+		ProfilerRecord& r = records[k % MAX_PROFILER_EVENTS];
+		if (r.seq.load(std::memory_order_acquire) != k + 1) continue;
+		ProfilerEvent e = r.event;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (r.seq.load(std::memory_order_relaxed) == k + 1) events.push_back(e);
+	}
+}
+
+// write events in Chrome trace format (load in chrome://tracing or Perfetto):
+// process 1 has a track per thread with start/stop events and the data events as counters,
+// process 2 has a track per OpenVX graph node
+static bool dump_trace(const char * fileName, const std::vector<ProfilerEvent>& events)
+{
+	FILE * fp = fopen(fileName, "w"); if (!fp) { ls_printf("ERROR: unable to create '%s'\n", fileName); return false; }
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LoomSL\"}}");
+	fprintf(fp, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"LoomSL OpenVX graph\"}}");
+	int numThreads = profiler_thread_count;
+	for (int tid = 1; tid <= numThreads; tid++) {
+		fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", tid, tid);
+	}
+	std::vector<std::string> trackNames;
+	{
+		std::lock_guard<std::mutex> lock(profiler_track_mutex);
+		trackNames = profiler_track_names;
+	}
+	for (size_t tid = 0; tid < trackNames.size(); tid++) {
+		fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", (int)tid, trackNames[tid].c_str());
+	}
+	__int64 t0 = 0;
+	for (size_t k = 0; k < events.size(); k++) {
+		if (k == 0 || events[k].clock < t0) t0 = events[k].clock;
+	}
+	// skip the stop events whose start was dropped from the ring buffer
+	std::map<__int64, int> open;
+	for (size_t k = 0; k < events.size(); k++) {
+		const ProfilerEvent& ev = events[k];
+		int e = ev.data >> 2, t = ev.data & 3;
+		double ts = (double)(ev.clock - t0) * 1e-3;
+		__int64 key = ((__int64)ev.track << 32) | e;
+		if (t == 0) {
+			open[key]++;
+			fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"LoomSL\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", ProfilerEventName[e], ev.track, ts);
+		}
+		else if (t == 1) {
+			if (open[key] > 0) {
+				open[key]--;
+				fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"LoomSL\",\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", ProfilerEventName[e], ev.track, ts);
+			}
+		}
+		else if (t == 2) {
+			fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%lld}}", ProfilerEventName[e], ts, (long long int)ev.value);
+		}
+		else {
+			const char * name = (ev.track >= 0 && ev.track < (int)trackNames.size()) ? trackNames[ev.track].c_str() : "node";
+			fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"OpenVX\",\"ph\":\"X\",\"pid\":2,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", name, ev.track, ts, (double)ev.value * 1e-3);
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+	return true;
+}
 
+#if PROFILER_MODE
 static void dump_profile_log()
 {
 #if _WIN32
@@ -111,6 +266,11 @@ static void dump_profile_log()
 	if (ls_getEnvironmentVariable("VISUAL_PROFILER_LOCATION", textBuffer, sizeof(textBuffer))){sprintf(profiler, "%s/LoomSL-profile", textBuffer);}
 	char plogfile[1024]; sprintf(plogfile, "%s-data.log", profiler);
 	char phtmfile[1024]; sprintf(phtmfile, "%s-visual.html", profiler);
+	char ptrcfile[1024]; sprintf(ptrcfile, "%s-trace.json", profiler);
+	std::vector<ProfilerEvent> events;
+	profiler_snapshot(events);
+	int profiler_count = (int)events.size();
+	if (profiler_count == 0) return;
 	FILE * fp = fopen(plogfile, "w"); if (!fp) { ls_printf("ERROR: unable to create '%s'\n", plogfile); return; }
 	FILE * fh = fopen(phtmfile, "w"); if (!fh) { ls_printf("ERROR: unable to create '%s'\n", phtmfile); return; }
 
@@ -126,27 +286,14 @@ static void dump_profile_log()
 	int ncolors = (int)(sizeof(colorlist) / sizeof(colorlist[0]));
 	memset(idlist, -1, sizeof(idlist));
 	memset(tcount, 0, sizeof(tcount));
-	float freq = 0.0;
-#if _WIN32
-	LARGE_INTEGER li, l2;
-	QueryPerformanceFrequency(&li);
-	freq = (float)li.QuadPart;
-	QueryPerformanceCounter(&li);
-	__int64 stime = my_rdtsc();
-	Sleep(1000);
-	QueryPerformanceCounter(&l2);
-	__int64 etime = my_rdtsc();
-	freq *= ((float)(etime - stime)) / ((float)(l2.QuadPart - li.QuadPart));
-#else
-    freq = std::chrono::high_resolution_clock::period::den / std::chrono::high_resolution_clock::period::num;
-#endif
+	float freq = 1.0e9f; // profiler clock is in nanoseconds
 	int xstart = 280;
 	for (int k = 0; k < profiler_count; k++) {
-		int e = profiler_data[k] >> 2;
-		int t = profiler_data[k] & 3;
+		int e = events[k].data >> 2;
+		int t = events[k].data & 3;
 		if (t == 0) {
 			for (int j = k + 1; j < profiler_count; j++) {
-				if ((profiler_data[k] ^ profiler_data[j]) == 1) {
+				if ((events[k].data ^ events[j].data) == 1 && events[k].track == events[j].track) {
 					if (idlist[e][0] == -1) {
 						idlist[e][0] = -2;
 					}
@@ -161,7 +308,7 @@ static void dump_profile_log()
 			nidlist++;
 		}
 	}
-	int max_time = 10 + (int)((float)(profiler_clock[profiler_count - 1] - profiler_clock[0])*1000.0f / freq);
+	int max_time = 10 + (int)((float)(events[profiler_count - 1].clock - events[0].clock)*1000.0f / freq);
 	for (int k = 0; k <= max_time; k += 20) {
 		int barx = xstart + (int)(k * 10);
 		fprintf(fh, "    d = document.createElement('div'); d.title = '%d ms'; d.className='time0'; d.style.backgroundColor='#FFFFFF'; d.style.top='%dpx'; d.style.left='%dpx'; d.style.width='%dpx'; document.getElementsByTagName('body')[0].appendChild(d);\n",
@@ -170,18 +317,18 @@ static void dump_profile_log()
 			k, 50, barx + 2);
 	}
 	for (int k = 0; k < profiler_count; k++) {
-		float fclock = (float)(profiler_clock[k] - profiler_clock[0])*1000.0f / freq;
-		int e = profiler_data[k] >> 2;
-		int t = profiler_data[k] & 3;
+		float fclock = (float)(events[k].clock - events[0].clock)*1000.0f / freq;
+		int e = events[k].data >> 2;
+		int t = events[k].data & 3;
 		if (t == 0) {
 			char data[128]; data[0] = 0;
 			for (int j = k + 1; j < profiler_count; j++) {
-				if ((profiler_data[k] ^ profiler_data[j]) == 2) {
-					union { __int64 a; int b[2]; } u; u.a = profiler_clock[j];
+				if ((events[k].data ^ events[j].data) == 2) {
+					union { __int64 a; int b[2]; } u; u.a = events[j].value;
 					sprintf(data, " DATA[%d,%d]", u.b[0], u.b[1]);
 				}
-				if ((profiler_data[k] ^ profiler_data[j]) == 1) {
-					float fclockj = (float)(profiler_clock[j] - profiler_clock[0])*1000.0f / freq;
+				if ((events[k].data ^ events[j].data) == 1 && events[k].track == events[j].track) {
+					float fclockj = (float)(events[j].clock - events[0].clock)*1000.0f / freq;
 					float start = fclock, duration = fclockj - fclock; int id = e; const char * name = ProfilerEventName[e];
 					int barx = xstart + (int)(start * 10);
 					int barw = (int)(duration * 10);
@@ -208,7 +355,10 @@ static void dump_profile_log()
 			}
 		}
 		if (t == 2) {
-            fprintf(fp, "DATA %20lld %3d %s\n", (long long int)profiler_clock[k], e, ProfilerEventName[e]);
+            fprintf(fp, "DATA %20lld %3d %s\n", (long long int)events[k].value, e, ProfilerEventName[e]);
+		}
+		else if (t == 3) {
+			fprintf(fp, "%12.3f %-12s %3d %.3fms\n", fclock, "node", events[k].track, (float)events[k].value * 1000.0f / freq);
 		}
 		else {
 			fprintf(fp, "%12.3f %-12s %3d %s\n", fclock, t ? "stop" : "start", e, ProfilerEventName[e]);
@@ -226,70 +376,99 @@ static void dump_profile_log()
 	height = 60 + nidlist * 50 + 100;
 	fprintf(fh, footer, xstart - 30, width - xstart + 50, height);
 	fclose(fh);
-	ls_printf("LoomSL Visual Profile:Dumped profiler log from %d events into %s and %s\n", profiler_count, plogfile, phtmfile);
+	dump_trace(ptrcfile, events);
+	ls_printf("LoomSL Visual Profile:Dumped profiler log from %d events into %s, %s, and %s\n", profiler_count, plogfile, phtmfile, ptrcfile);
 }
+#endif
 
 void __stdcall _PROFILER_START(ProfilerEventEnum e)
 {
-	if (profiler_data && profiler_count < MAX_PROFILER_EVENTS) {
-		int k = profiler_count++;
-		profiler_data[k] = (((int)e) << 2) | 0;
-		profiler_clock[k] = my_rdtsc();
-		if (profiler_count == MAX_PROFILER_EVENTS) PROFILER_SHUTDOWN();
-	}
+	profiler_add((((int)e) << 2) | 0, my_thread_track(), my_clock(), 0);
 }
 
 void __stdcall _PROFILER_STOP(ProfilerEventEnum e)
 {
-	if (profiler_data && profiler_count < MAX_PROFILER_EVENTS) {
-		int k = profiler_count++;
-		profiler_data[k] = (((int)e) << 2) | 1;
-		profiler_clock[k] = my_rdtsc();
-		if (profiler_count == MAX_PROFILER_EVENTS) PROFILER_SHUTDOWN();
-	}
+	profiler_add((((int)e) << 2) | 1, my_thread_track(), my_clock(), 0);
 }
 
 void __stdcall _PROFILER_DATA(ProfilerEventEnum e, __int64 value)
 {
-	if (profiler_data && profiler_count < MAX_PROFILER_EVENTS) {
-		int k = profiler_count++;
-		profiler_data[k] = (((int)e) << 2) | 2;
-		profiler_clock[k] = value;
-		if (profiler_count == MAX_PROFILER_EVENTS) PROFILER_SHUTDOWN();
+	profiler_add((((int)e) << 2) | 2, my_thread_track(), my_clock(), value);
+}
+
+__int64 __stdcall _PROFILER_CLOCK()
+{
+	return my_clock();
+}
+
+int __stdcall _PROFILER_TRACK(const char * name)
+{
+	std::lock_guard<std::mutex> lock(profiler_track_mutex);
+	for (size_t i = 0; i < profiler_track_names.size(); i++) {
+		if (profiler_track_names[i] == name) return (int)i;
 	}
+	profiler_track_names.push_back(name);
+	return (int)profiler_track_names.size() - 1;
+}
+
+void __stdcall _PROFILER_NODE(int track, __int64 start, __int64 duration)
+{
+	profiler_add(3, track, start, duration);
+}
+
+void __stdcall PROFILER_SET_RING_BUFFER(bool enable)
+{
+	// restart the recording in the new mode: the buffer is allocated here when the profiler
+	// isn't recording yet, so that the ring buffer mode can be enabled on a running stitcher
+	std::lock_guard<std::mutex> lock(profiler_mutex);
+	profiler_ring = enable;
+	if (enable && profiler_init > 0) profiler_allocate();
+	profiler_begin = profiler_count.load();
+	profiler_full = false;
+	_profiler_recording = (profiler_records.load() != nullptr);
+}
+
+bool __stdcall PROFILER_DUMP_TRACE(const char * fileName)
+{
+	std::vector<ProfilerEvent> events;
+	{
+		std::lock_guard<std::mutex> lock(profiler_mutex);
+		if (!profiler_records) { ls_printf("ERROR: profiler is not recording: enable the ring buffer mode\n"); return false; }
+		profiler_snapshot(events);
+	}
+	if (!dump_trace(fileName, events)) return false;
+	ls_printf("LoomSL Visual Profile:Dumped %d events into %s\n", (int)events.size(), fileName);
+	return true;
 }
-#endif
 
 void __stdcall PROFILER_INITIALIZE()
 {
+	std::lock_guard<std::mutex> lock(profiler_mutex);
+#if PROFILER_MODE
 	ls_printf("LoomSL Visual Profile:Start\n");
+#endif
 	if (profiler_init++ == 0)
 	{
-		int EnableProfiler = 16000;
-		profiler_count = 0;
-		if (EnableProfiler) {
-			MAX_PROFILER_EVENTS = EnableProfiler;
-			if (MAX_PROFILER_EVENTS < 1024) MAX_PROFILER_EVENTS = 1024;
-			profiler_data = new int[MAX_PROFILER_EVENTS + 64];
-			profiler_clock = new __int64[MAX_PROFILER_EVENTS + 64];
-		}
+		// VISUAL_PROFILER_RING_BUFFER: keep the latest events for dumps on demand
+		char textBuffer[64];
+		if (ls_getEnvironmentVariable("VISUAL_PROFILER_RING_BUFFER", textBuffer, sizeof(textBuffer)) && atoi(textBuffer) != 0)
+			profiler_ring = true;
+		if (PROFILER_MODE || profiler_ring)
+			profiler_allocate();
 	}
 }
 
 void __stdcall PROFILER_SHUTDOWN()
 {
+	std::lock_guard<std::mutex> lock(profiler_mutex);
+#if PROFILER_MODE
 	ls_printf("LoomSL Visual Profile:Stop \n");
+#endif
 	if (--profiler_init == 0)
 	{
-		if (profiler_data)
-		{
-			dump_profile_log();
-			delete profiler_data;
-			delete profiler_clock;
-			profiler_data = 0;
-			profiler_clock = 0;
-		}
+#if PROFILER_MODE
+		dump_profile_log();
+#endif
+		profiler_release();
 	}
 }
-
-#endif
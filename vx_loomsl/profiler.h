@@ -3,11 +3,11 @@
 
 
 // PROFILER_MODE:
-//   0 - no profiling
-//   1 - default profiling
+//   0 - no visual profile: events are recorded only when the ring buffer mode is enabled at run-time
+//   1 - default profiling: events are recorded from PROFILER_INITIALIZE and dumped as visual profile at shutdown
 #define PROFILER_MODE 0
 
-#if PROFILER_MODE
+#include <atomic>
 #ifndef _WIN32
 #include <inttypes.h>
 #define __stdcall
@@ -21,32 +21,31 @@ enum ProfilerEventEnum {
 };
 void __stdcall PROFILER_INITIALIZE();
 void __stdcall PROFILER_SHUTDOWN();
-#else
-#define PROFILER_INITIALIZE()
-#define PROFILER_SHUTDOWN()
-#endif
+// ring buffer mode keeps the latest events instead of stopping when the event buffer is full
+void __stdcall PROFILER_SET_RING_BUFFER(bool enable);
+// write the recorded events as Chrome trace (trace_event JSON) while the profiler keeps running
+bool __stdcall PROFILER_DUMP_TRACE(const char * fileName);
 
-#if PROFILER_MODE
+// set while events are recorded: the event macros check it before reading the clock and calling into the profiler
+extern std::atomic<bool> _profiler_recording;
+#define PROFILER_RECORDING() _profiler_recording.load(std::memory_order_relaxed)
 void __stdcall _PROFILER_START(ProfilerEventEnum e);
 void __stdcall _PROFILER_STOP(ProfilerEventEnum e);
 void __stdcall _PROFILER_DATA(ProfilerEventEnum e, __int64 value);
-#define PROFILER_START(g,e)  _PROFILER_START(ePROFILER_EVENT_ENUM_ ## g ## e);
-#define PROFILER_STOP(g,e)   _PROFILER_STOP(ePROFILER_EVENT_ENUM_ ## g ## e);
-#define PROFILER_DATA(g,e,v) _PROFILER_DATA(ePROFILER_EVENT_ENUM_ ## g ## e, (__int64)v);
-#define PROFILER_DATA2(g,e,v0,v1) _PROFILER_DATA(ePROFILER_EVENT_ENUM_ ## g ## e, (__int64)(v0)|((__int64)(v1)<<32));
-#define PROFILER_START_INDEX(g,e,i)  _PROFILER_START((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i)));
-#define PROFILER_STOP_INDEX(g,e,i)   _PROFILER_STOP((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i)));
-#define PROFILER_DATA_INDEX(g,e,i,v) _PROFILER_DATA((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i)), (__int64)v);
-#define PROFILER_DATA2_INDEX(g,e,i,v0,v1) _PROFILER_DATA((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i)), (__int64)(v0)|((__int64)(v1)<<32));
-#else
-#define PROFILER_START(g,e)
-#define PROFILER_STOP(g,e)
-#define PROFILER_DATA(g,e,v)
-#define PROFILER_DATA2(g,e,v0,v1)
-#define PROFILER_START_INDEX(g,e,i)
-#define PROFILER_STOP_INDEX(g,e,i)
-#define PROFILER_DATA_INDEX(g,e,i,v)
-#define PROFILER_DATA2_INDEX(g,e,i,v0,v1)
-#endif
+__int64 __stdcall _PROFILER_CLOCK();
+int __stdcall _PROFILER_TRACK(const char * name);
+void __stdcall _PROFILER_NODE(int track, __int64 start, __int64 duration);
+#define PROFILER_START(g,e)  { if (PROFILER_RECORDING()) _PROFILER_START(ePROFILER_EVENT_ENUM_ ## g ## e); }
+#define PROFILER_STOP(g,e)   { if (PROFILER_RECORDING()) _PROFILER_STOP(ePROFILER_EVENT_ENUM_ ## g ## e); }
+#define PROFILER_DATA(g,e,v) { if (PROFILER_RECORDING()) _PROFILER_DATA(ePROFILER_EVENT_ENUM_ ## g ## e, (__int64)v); }
+#define PROFILER_DATA2(g,e,v0,v1) { if (PROFILER_RECORDING()) _PROFILER_DATA(ePROFILER_EVENT_ENUM_ ## g ## e, (__int64)(v0)|((__int64)(v1)<<32)); }
+#define PROFILER_START_INDEX(g,e,i)  { if (PROFILER_RECORDING()) _PROFILER_START((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i))); }
+#define PROFILER_STOP_INDEX(g,e,i)   { if (PROFILER_RECORDING()) _PROFILER_STOP((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i))); }
+#define PROFILER_DATA_INDEX(g,e,i,v) { if (PROFILER_RECORDING()) _PROFILER_DATA((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i)), (__int64)v); }
+#define PROFILER_DATA2_INDEX(g,e,i,v0,v1) { if (PROFILER_RECORDING()) _PROFILER_DATA((ProfilerEventEnum)(ePROFILER_EVENT_ENUM_ ## g ## e + (i)), (__int64)(v0)|((__int64)(v1)<<32)); }
+// OpenVX graph node timings: profiler clock is in nanoseconds, tracks are named with PROFILER_TRACK
+#define PROFILER_CLOCK()             _PROFILER_CLOCK()
+#define PROFILER_TRACK(name)         _PROFILER_TRACK(name)
+#define PROFILER_NODE(track,start,duration) { if (PROFILER_RECORDING()) _PROFILER_NODE(track, (__int64)(start), (__int64)(duration)); }
 
 #endif
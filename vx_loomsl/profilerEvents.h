@@ -3,4 +3,6 @@ PROFILER_DEFINE_EVENT(LoomSL, ReinitializeGraph)
 PROFILER_DEFINE_EVENT(LoomSL, SetInputBuffer)
 PROFILER_DEFINE_EVENT(LoomSL, SetOutputBuffer)
 PROFILER_DEFINE_EVENT(LoomSL, ScheduleGraph)
-PROFILER_DEFINE_EVENT(LoomSL, WaitForCompletionGraph)
\ No newline at end of file
+PROFILER_DEFINE_EVENT(LoomSL, WaitForCompletionGraph)
+PROFILER_DEFINE_EVENT(ExpComp, ApplyGains)
+PROFILER_DEFINE_EVENT(ExpComp, ApplyBlockGains)
\ No newline at end of file